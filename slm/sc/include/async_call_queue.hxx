@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2022 The VxEngine Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Queue of calls from a host thread into the simulation context
+ */
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <systemc.h>
+#pragma once
+
+
+// Queue of calls from a host thread into the simulation context
+// (single caller thread, calls are executed one at a time)
+class async_call_queue : public sc_prim_channel {
+public:
+	explicit async_call_queue(const char *name)
+		: sc_prim_channel(name)
+		, m_call(nullptr), m_done(false), m_closed(false)
+	{}
+
+	/**
+	 * Run function in simulation context and wait for its completion
+	 * (called from host thread)
+	 * @param fn function to run
+	 */
+	void call(const std::function<void()>& fn)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_call = &fn;
+		m_done = false;
+		m_cv.notify_all();
+		async_request_update();
+		m_cv.wait(lock, [this]{ return m_done; });
+	}
+
+	/**
+	 * Notify that no more calls will be made (called from host thread)
+	 */
+	void close()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_closed = true;
+		m_cv.notify_all();
+		async_request_update();
+	}
+
+	/**
+	 * Reopen queue for a new caller (called from simulation context)
+	 */
+	void reopen()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_call = nullptr;
+		m_closed = false;
+	}
+
+	/**
+	 * Execute pending call if there is one (called from simulation context)
+	 * @return true if call was executed
+	 */
+	bool execute()
+	{
+		const std::function<void()> *fn;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			fn = m_call;
+			m_call = nullptr;
+		}
+
+		if(!fn)
+			return false;
+
+		(*fn)();
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_done = true;
+		m_cv.notify_all();
+
+		return true;
+	}
+
+	/**
+	 * Block simulation until a call arrives or queue is closed
+	 * (called from simulation context when there is nothing to simulate)
+	 */
+	void wait_blocking()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_cv.wait(lock, [this]{ return m_call != nullptr || m_closed; });
+	}
+
+	/**
+	 * Queue is closed and has no pending calls
+	 */
+	bool closed()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_closed && m_call == nullptr;
+	}
+
+	/**
+	 * Event notified when a call arrives or queue is closed
+	 */
+	const sc_event& call_event() const { return m_call_event; }
+
+private:
+	void update() override
+	{
+		m_call_event.notify(SC_ZERO_TIME);
+	}
+
+private:
+	std::mutex m_mutex;
+	std::condition_variable m_cv;
+	const std::function<void()> *m_call;	// Pending call
+	bool m_done;				// Pending call is completed
+	bool m_closed;				// No more calls
+	sc_event m_call_event;			// Call arrived
+};
@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2022 The VxEngine Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Model state checkpoint streams
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <type_traits>
+#pragma once
+
+
+namespace ckpt {
+
+	// Section tag length
+	constexpr size_t TAG_LEN = 4;
+
+	/**
+	 * Checkpoint writer
+	 * Values are stored in host byte order.
+	 */
+	class writer {
+		std::ostream& m_os;
+	public:
+		explicit writer(std::ostream& os) : m_os(os) {}
+
+		/**
+		 * Write value
+		 * @param v value (trivially copyable type or array of such)
+		 */
+		template<typename T>
+		void put(const T& v)
+		{
+			static_assert(std::is_trivially_copyable<T>::value, "Type is not trivially copyable!");
+			put_bytes(&v, sizeof(T));
+		}
+
+		/**
+		 * Write raw bytes
+		 * @param p pointer to data
+		 * @param size data size
+		 */
+		void put_bytes(const void *p, size_t size)
+		{
+			m_os.write(reinterpret_cast<const char*>(p), size);
+		}
+
+		/**
+		 * Write section tag
+		 * @param tag 4-character tag
+		 */
+		void put_tag(const char (&tag)[TAG_LEN + 1])
+		{
+			put_bytes(tag, TAG_LEN);
+		}
+
+		/**
+		 * Check stream state
+		 * @return true if no errors
+		 */
+		bool good() const { return m_os.good(); }
+	};
+
+
+	/**
+	 * Checkpoint reader
+	 */
+	class reader {
+		std::istream& m_is;
+	public:
+		explicit reader(std::istream& is) : m_is(is) {}
+
+		/**
+		 * Read value
+		 * @param v value (trivially copyable type or array of such)
+		 * @return true on success
+		 */
+		template<typename T>
+		bool get(T& v)
+		{
+			static_assert(std::is_trivially_copyable<T>::value, "Type is not trivially copyable!");
+			return get_bytes(&v, sizeof(T));
+		}
+
+		/**
+		 * Read raw bytes
+		 * @param p pointer to data
+		 * @param size data size
+		 * @return true on success
+		 */
+		bool get_bytes(void *p, size_t size)
+		{
+			m_is.read(reinterpret_cast<char*>(p), size);
+			return m_is.good();
+		}
+
+		/**
+		 * Read and check section tag
+		 * @param tag expected 4-character tag
+		 * @return true if tag matches
+		 */
+		bool expect_tag(const char (&tag)[TAG_LEN + 1])
+		{
+			char t[TAG_LEN];
+			return get_bytes(t, TAG_LEN) && !memcmp(t, tag, TAG_LEN);
+		}
+
+		/**
+		 * Check stream state
+		 * @return true if no errors
+		 */
+		bool good() const { return m_is.good(); }
+	};
+
+} // namespace ckpt
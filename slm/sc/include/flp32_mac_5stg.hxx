@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) 2022 The VxEngine Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Native single precision 5-stage floating point multiply-accumulate
+ */
+
+#include <cstdint>
+#include <iostream>
+#include <systemc.h>
+#include "flp/hwfp.hxx"
+#include "flp/hwfmac.hxx"
+#include "vxe_clock_sync.hxx"
+#pragma once
+
+
+// FMAC32 unit (drop-in replacement for Verilated flp32_mac_5stg)
+SC_MODULE(flp32_mac_5stg) {
+	static constexpr unsigned NSTAGES = 5;		// Default number of pipeline stages (as in RTL)
+	static constexpr unsigned MAX_STAGES = 16;	// Maximum number of pipeline stages
+
+	sc_in<bool> clk;
+	sc_in<bool> nrst;
+
+	// Input operands
+	sc_in<uint32_t> i_a;	// Accumulator
+	sc_in<uint32_t> i_b;
+	sc_in<uint32_t> i_c;
+	sc_in<bool> i_valid;	// Inputs valid
+
+	// Result
+	sc_out<uint32_t> o_p;	// Result
+	sc_out<bool> o_sign;	// Negative result
+	sc_out<bool> o_zero;	// Result is zero
+	sc_out<bool> o_nan;	// Result is NaN
+	sc_out<bool> o_inf;	// Result is Inf
+	sc_out<bool> o_valid;	// Outputs valid
+
+	SC_HAS_PROCESS(flp32_mac_5stg);
+
+	/**
+	 * Constructor
+	 * @param name module name
+	 * @param nstages number of pipeline stages (1 to MAX_STAGES)
+	 */
+	flp32_mac_5stg(::sc_core::sc_module_name name, unsigned nstages = NSTAGES)
+		: ::sc_core::sc_module(name)
+		, clk("clk"), nrst("nrst"), i_a("i_a"), i_b("i_b"), i_c("i_c"), i_valid("i_valid")
+		, o_p("o_p"), o_sign("o_sign"), o_zero("o_zero"), o_nan("o_nan"), o_inf("o_inf")
+		, o_valid("o_valid"), m_nstages(nstages)
+	{
+		SC_METHOD(pipe_method);
+			sensitive << clk.pos() << nrst.neg();
+
+		if(m_nstages == 0 || m_nstages > MAX_STAGES) {
+			std::cerr << this->name() << ": invalid number of stages " << m_nstages
+				<< ", using " << NSTAGES << "!" << std::endl;
+			m_nstages = NSTAGES;
+		}
+
+		for(unsigned i = 0; i < MAX_STAGES; ++i) {
+			m_valid[i] = false;
+			m_result[i] = 0;
+		}
+	}
+
+private:
+	void end_of_elaboration() override
+	{
+		// Events to wake up from idle state
+		m_wakeup |= i_valid.value_changed_event();
+		m_wakeup |= nrst.negedge_event();
+	}
+
+	/**
+	 * Pipeline method
+	 * Result is computed when operands enter the first stage and then
+	 * travels through the pipe. Same as in RTL, data registers are updated
+	 * only for valid operations, so the result stays on outputs until next
+	 * valid operation reaches the last stage.
+	 */
+	void pipe_method()
+	{
+		if(!nrst.read()) {
+			for(unsigned i = 0; i < m_nstages; ++i)
+				m_valid[i] = false;
+			o_valid.write(false);
+			return;
+		}
+
+		if(!clk.posedge())
+			return;
+
+		// Advance pipe
+		for(unsigned i = m_nstages - 1; i > 0; --i) {
+			if(m_valid[i - 1])
+				m_result[i] = m_result[i - 1];
+			m_valid[i] = m_valid[i - 1];
+		}
+
+		// Sample inputs
+		m_valid[0] = i_valid.read();
+		if(m_valid[0])
+			hwfmac::mac<uint32_t, uint64_t, 8, 23, 23>(i_a.read(), i_b.read(), i_c.read(), m_result[0]);
+
+		update_outputs();
+
+		// Sleep while pipe is empty and no new operands arrive
+		if(vxe_clock_sync::enabled() && idle())
+			next_trigger(m_wakeup);
+	}
+
+	// Returns true if pipe is empty and inputs are not valid
+	bool idle() const
+	{
+		if(i_valid.read())
+			return false;
+		for(unsigned i = 0; i < m_nstages; ++i)
+			if(m_valid[i])
+				return false;
+		return true;
+	}
+
+	/**
+	 * Update outputs from the last pipeline stage
+	 */
+	void update_outputs()
+	{
+		const uint32_t r = m_result[m_nstages - 1];
+		bool sn, zero, nan, inf;
+		uint32_t ex, sg;
+
+		// Result flags are derived from the packed result. Unlike RTL,
+		// only one of NaN, Inf or Zero can be set (in this priority).
+		// VPU does not use these flags.
+		hwfp::unpack<uint32_t, 8, 23>(r, sn, ex, sg, zero, nan, inf);
+
+		o_p.write(r);
+		o_sign.write(sn);
+		o_zero.write(zero);
+		o_nan.write(nan);
+		o_inf.write(inf);
+		o_valid.write(m_valid[m_nstages - 1]);
+	}
+
+private:
+	unsigned m_nstages;		// Number of pipeline stages
+	bool m_valid[MAX_STAGES];	// Stage valid bits
+	uint32_t m_result[MAX_STAGES];	// Stage results
+	sc_event_or_list m_wakeup;	// Events to wake up from idle state
+};
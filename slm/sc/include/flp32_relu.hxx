@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2022 The VxEngine Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Native single precision floating point ReLU
+ */
+
+#include <cstdint>
+#include <systemc.h>
+#include "relu/hwrelu.hxx"
+#pragma once
+
+
+// FReLU32 unit (drop-in replacement for Verilated flp32_relu)
+SC_MODULE(flp32_relu) {
+	sc_in<uint32_t> i_v;	// Input value
+	sc_in<bool> i_l;	// Leaky ReLU
+	sc_in<uint32_t> i_e;	// Exponent difference for leaky ReLU
+	sc_out<uint32_t> o_r;	// Result
+
+	SC_CTOR(flp32_relu)
+		: i_v("i_v"), i_l("i_l"), i_e("i_e"), o_r("o_r")
+	{
+		SC_METHOD(relu_method);
+			sensitive << i_v << i_l << i_e;
+	}
+
+private:
+	/**
+	 * Combinational ReLU logic
+	 */
+	void relu_method()
+	{
+		uint32_t r = 0;
+		// Exponent difference port is 7-bit wide in RTL
+		hwrelu::relu<uint32_t, 8, 23>(i_v.read(), r, i_l.read(), i_e.read() & 0x7F);
+		o_r.write(r);
+	}
+};
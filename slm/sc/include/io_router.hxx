@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2022 The VxEngine Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * MMIO router model
+ * Decodes CPU I/O address space into equal windows, one per VxEngine
+ * instance. Window i starts at i * window_size and accesses are forwarded
+ * with window offset as address.
+ */
+
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <systemc.h>
+#include <tlm.h>
+#pragma once
+
+
+// MMIO router model template
+template<unsigned IO_WIDTH>
+SC_MODULE(io_router), public virtual tlm::tlm_fw_transport_if<>
+		, public virtual tlm::tlm_bw_transport_if<> {
+	tlm::tlm_target_socket<IO_WIDTH> io_target;	// CPU I/O port
+
+	/**
+	 * Constructor
+	 * @param name module name
+	 * @param num_windows number of address windows
+	 * @param window_size size of address window
+	 */
+	io_router(::sc_core::sc_module_name name, unsigned num_windows, uint64_t window_size)
+		: ::sc_core::sc_module(name), io_target("io_target"), m_window_size(window_size)
+	{
+		for(unsigned i = 0; i < num_windows; ++i) {
+			m_initiators.emplace_back(new tlm::tlm_initiator_socket<IO_WIDTH>(
+				("io_initiator_" + std::to_string(i)).c_str()));
+			(*m_initiators.back())(*this);
+		}
+
+		io_target(*this);
+	}
+
+	/**
+	 * Initiator socket of address window
+	 * @param i window index
+	 * @return initiator socket
+	 */
+	tlm::tlm_initiator_socket<IO_WIDTH>& initiator(unsigned i)
+	{
+		return *m_initiators.at(i);
+	}
+
+	void b_transport(tlm::tlm_generic_payload& trans, sc_time& t) override
+	{
+		const sc_dt::uint64 addr = trans.get_address();
+		const sc_dt::uint64 win = addr / m_window_size;
+
+		if(win >= m_initiators.size()) {
+			std::cerr << name() << ": no target at address 0x" << std::hex << addr
+				<< std::dec << "!" << std::endl;
+			trans.set_response_status(tlm::TLM_ADDRESS_ERROR_RESPONSE);
+			return;
+		}
+
+		trans.set_address(addr - win * m_window_size);
+		(*m_initiators[win])->b_transport(trans, t);
+		trans.set_address(addr);
+	}
+
+	tlm::tlm_sync_enum nb_transport_fw(tlm::tlm_generic_payload& trans, tlm::tlm_phase& phase, sc_time& t) override
+	{
+		// Non-blocking transfers are not used for MMIO
+		std::cerr << name() << ": non-blocking transport is not supported!" << std::endl;
+		trans.set_response_status(tlm::TLM_COMMAND_ERROR_RESPONSE);
+		return tlm::TLM_COMPLETED;
+	}
+
+	bool get_direct_mem_ptr(tlm::tlm_generic_payload& trans, tlm::tlm_dmi& dmi_data) override
+	{
+		return false;
+	}
+
+	unsigned int transport_dbg(tlm::tlm_generic_payload& trans) override
+	{
+		return 0;
+	}
+
+	tlm::tlm_sync_enum nb_transport_bw(tlm::tlm_generic_payload& trans, tlm::tlm_phase& phase, sc_time& t) override
+	{
+		return tlm::TLM_COMPLETED;
+	}
+
+	void invalidate_direct_mem_ptr(sc_dt::uint64 start_range, sc_dt::uint64 end_range) override
+	{
+	}
+
+private:
+	std::vector<std::unique_ptr<tlm::tlm_initiator_socket<IO_WIDTH>>> m_initiators;	// Window ports
+	const uint64_t m_window_size;	// Address window size
+};
@@ -0,0 +1,260 @@
+/*
+ * Copyright (c) 2022 The VxEngine Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Memory interconnect model
+ * Connects memory masters of several VxEngine instances to a shared memory
+ * port. Requests are granted in round-robin order, one per clock cycle.
+ * DMI is not granted to masters to keep accesses arbitrated.
+ */
+
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <systemc.h>
+#include <tlm.h>
+#include "vxe_profiler.hxx"
+#pragma once
+
+
+// Memory interconnect model template
+template<unsigned MEM_WIDTH>
+VXE_MODULE(mem_interconnect), public virtual tlm::tlm_bw_transport_if<> {
+	sc_in<bool> clk;
+	sc_in<bool> nrst;
+
+	tlm::tlm_initiator_socket<MEM_WIDTH> mem_initiator;	// Shared memory port
+
+	SC_HAS_PROCESS(mem_interconnect);
+
+	/**
+	 * Constructor
+	 * @param name module name
+	 * @param num_masters number of connected masters
+	 */
+	mem_interconnect(::sc_core::sc_module_name name, unsigned num_masters)
+		: vxe_prof_module(name), clk("clk"), nrst("nrst"), mem_initiator("mem_initiator")
+		, m_lt_mode(false), m_next(0), m_queued(0)
+	{
+		for(unsigned i = 0; i < num_masters; ++i)
+			m_masters.emplace_back(new master_port(*this, i));
+
+		mem_initiator(*this);
+
+		SC_THREAD(arbiter_thread);
+			sensitive << clk.pos();
+	}
+
+	/**
+	 * Master target socket
+	 * @param i master index
+	 * @return target socket
+	 */
+	tlm::tlm_target_socket<MEM_WIDTH>& target(unsigned i)
+	{
+		return m_masters.at(i)->socket;
+	}
+
+	/**
+	 * Number of connected masters
+	 */
+	unsigned masters() const { return m_masters.size(); }
+
+	/**
+	 * Number of granted requests
+	 * @param i master index
+	 */
+	uint64_t grants(unsigned i) const { return m_masters.at(i)->grants; }
+
+	/**
+	 * Number of cycles master requests waited for grant
+	 * @param i master index
+	 */
+	uint64_t stalls(unsigned i) const { return m_masters.at(i)->stalls; }
+
+	/**
+	 * Set loosely-timed mode
+	 * In this mode blocking transport accesses occupy shared port for one
+	 * clock cycle each and contending accesses are delayed.
+	 * @param enable =true to enable loosely-timed mode
+	 * @param clk_period clock period
+	 */
+	void set_lt_mode(bool enable, const sc_time& clk_period)
+	{
+		m_lt_mode = enable;
+		m_clk_period = clk_period;
+	}
+
+	tlm::tlm_sync_enum nb_transport_bw(tlm::tlm_generic_payload& trans, tlm::tlm_phase& phase, sc_time& t) override
+	{
+		auto it = m_owners.find(&trans);
+		if(it == m_owners.end()) {
+			std::cerr << name() << ": response to unknown request!" << std::endl;
+			return tlm::TLM_COMPLETED;
+		}
+
+		unsigned i = it->second;
+		m_owners.erase(it);
+
+		tlm::tlm_sync_enum r = m_masters[i]->socket->nb_transport_bw(trans, phase, t);
+		trans.release();
+
+		return r;
+	}
+
+	void invalidate_direct_mem_ptr(sc_dt::uint64 start_range, sc_dt::uint64 end_range) override
+	{
+		for(auto& m : m_masters)
+			m->socket->invalidate_direct_mem_ptr(start_range, end_range);
+	}
+
+private:
+	// Target side of a master connection
+	struct master_port : public virtual tlm::tlm_fw_transport_if<> {
+		mem_interconnect& ic;				// Interconnect
+		const unsigned index;				// Master index
+		tlm::tlm_target_socket<MEM_WIDTH> socket;	// Target socket
+		std::deque<tlm::tlm_generic_payload*> queue;	// Requests waiting for grant
+		uint64_t grants;				// Granted requests
+		uint64_t stalls;				// Cycles spent waiting for grant
+
+		master_port(mem_interconnect& parent, unsigned i)
+			: ic(parent), index(i)
+			, socket(("target_" + std::to_string(i)).c_str())
+			, grants(0), stalls(0)
+		{
+			socket(*this);
+		}
+
+		tlm::tlm_sync_enum nb_transport_fw(tlm::tlm_generic_payload& trans, tlm::tlm_phase& phase, sc_time& t) override
+		{
+			if(phase != tlm::BEGIN_REQ) {
+				std::cerr << ic.name() << ": invalid transaction phase!" << std::endl;
+				return tlm::TLM_COMPLETED;
+			}
+
+			// Hold request until it is granted
+			trans.acquire();
+			queue.push_back(&trans);
+			++ic.m_queued;
+			ic.m_request_event.notify(t);
+
+			return tlm::TLM_ACCEPTED;
+		}
+
+		void b_transport(tlm::tlm_generic_payload& trans, sc_time& t) override
+		{
+			// Delay access until shared port is free
+			if(ic.m_lt_mode) {
+				const sc_time start = sc_time_stamp() + t;
+				if(ic.m_port_free > start) {
+					t += ic.m_port_free - start;
+					stalls += static_cast<uint64_t>((ic.m_port_free - start) / ic.m_clk_period);
+				}
+				ic.m_port_free = sc_time_stamp() + t + ic.m_clk_period;
+			}
+			++grants;
+			ic.mem_initiator->b_transport(trans, t);
+		}
+
+		bool get_direct_mem_ptr(tlm::tlm_generic_payload& trans, tlm::tlm_dmi& dmi_data) override
+		{
+			// DMI accesses would bypass arbitration, deny whole address range
+			(void)trans;
+			dmi_data.init();
+			return false;
+		}
+
+		unsigned int transport_dbg(tlm::tlm_generic_payload& trans) override
+		{
+			return ic.mem_initiator->transport_dbg(trans);
+		}
+	};
+
+	// Round-robin arbiter
+	[[noreturn]] void arbiter_thread()
+	{
+		while(true) {
+			if(!m_queued) {
+				wait(m_request_event);
+				continue;
+			}
+
+			wait();
+
+			// Pick next master with pending request
+			const unsigned n = m_masters.size();
+			unsigned sel = n;
+			for(unsigned k = 0; k < n; ++k) {
+				unsigned i = (m_next + k) % n;
+				if(!m_masters[i]->queue.empty()) {
+					sel = i;
+					break;
+				}
+			}
+
+			if(sel == n)
+				continue;
+
+			// Account cycles of masters left waiting
+			for(unsigned i = 0; i < n; ++i)
+				if(i != sel && !m_masters[i]->queue.empty())
+					++m_masters[i]->stalls;
+
+			master_port& mp = *m_masters[sel];
+			tlm::tlm_generic_payload *trans = mp.queue.front();
+			mp.queue.pop_front();
+			--m_queued;
+			++mp.grants;
+			m_next = (sel + 1) % n;
+
+			// Forward request to shared port
+			m_owners[trans] = sel;
+			tlm::tlm_phase phase = tlm::BEGIN_REQ;
+			sc_time t;
+			tlm::tlm_sync_enum r = mem_initiator->nb_transport_fw(*trans, phase, t);
+			if(r == tlm::TLM_COMPLETED) {
+				m_owners.erase(trans);
+				phase = tlm::BEGIN_RESP;
+				mp.socket->nb_transport_bw(*trans, phase, t);
+				trans->release();
+			}
+		}
+	}
+
+private:
+	std::vector<std::unique_ptr<master_port>> m_masters;	// Master connections
+	std::unordered_map<tlm::tlm_generic_payload*, unsigned> m_owners;	// Masters of forwarded requests
+	bool m_lt_mode;			// Loosely-timed mode
+	sc_time m_clk_period;		// Clock period
+	sc_time m_port_free;		// Time when shared port is free (loosely-timed mode)
+	unsigned m_next;		// Master with the highest priority
+	unsigned m_queued;		// Number of requests waiting for grant
+	sc_event m_request_event;	// New request is queued
+};
@@ -27,7 +27,12 @@
  * Memory model
  */
 
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include "sparse_mem.hxx"
 #include "memory_port.hxx"
+#include "checkpoint.hxx"
 #pragma once
 
 
@@ -38,38 +43,159 @@ SC_MODULE(memory) {
 	sc_in<bool> nrst;
 
 	tlm::tlm_target_socket<MEM_WIDTH> cpu_target;
-	tlm::tlm_target_socket<MEM_WIDTH> vxe_target0;
-	tlm::tlm_target_socket<MEM_WIDTH> vxe_target1;
+	sc_vector<tlm::tlm_target_socket<MEM_WIDTH>> vxe_target;
 
-	SC_CTOR(memory)
-		: clk("clk"), nrst("nrst")
+	/**
+	 * Constructor
+	 * @param name module name
+	 * @param vxe_ports number of VxEngine memory ports
+	 */
+	explicit memory(::sc_core::sc_module_name name, unsigned vxe_ports = 2)
+		: ::sc_core::sc_module(name), clk("clk"), nrst("nrst")
+		, vxe_target("vxe_target", vxe_ports)
 		, cpu_port("cpu_port", mem, cpu_target)
-		, vxe_port0("vxe_port0", mem, vxe_target0)
-		, vxe_port1("vxe_port1", mem, vxe_target1)
+		, vxe_port("vxe_port", vxe_ports, port_creator(mem, vxe_target))
 	{
 		// Connect clock and reset signals
 		cpu_port.clk(clk);
 		cpu_port.nrst(nrst);
-		vxe_port0.clk(clk);
-		vxe_port0.nrst(nrst);
-		vxe_port1.clk(clk);
-		vxe_port1.nrst(nrst);
+		for(auto& p : vxe_port) {
+			p.clk(clk);
+			p.nrst(nrst);
+		}
 
 		// Init ports
 		cpu_target(cpu_port);
-		vxe_target0(vxe_port0);
-		vxe_target1(vxe_port1);
+		for(unsigned i = 0; i < vxe_port.size(); ++i)
+			vxe_target[i](vxe_port[i]);
 
 		mem.resize(0x1000); // default size
 	}
 
+	/**
+	 * Set loosely-timed mode
+	 * In this mode each blocking transport access takes one clock cycle.
+	 * @param enable =true to enable loosely-timed mode
+	 * @param clk_period clock period
+	 */
+	void set_lt_mode(bool enable, const sc_time& clk_period)
+	{
+		const sc_time latency = (enable ? clk_period : SC_ZERO_TIME);
+		cpu_port.set_bt_latency(latency);
+		for(auto& p : vxe_port)
+			p.set_bt_latency(latency);
+	}
+
+	/**
+	 * Set additional access latency
+	 * @param latency access latency
+	 */
+	void set_latency(const sc_time& latency)
+	{
+		cpu_port.set_latency(latency);
+		for(auto& p : vxe_port)
+			p.set_latency(latency);
+	}
+
+	/**
+	 * Load binary image into memory (no memory accesses must be in flight)
+	 * @param path image file path
+	 * @param addr load address
+	 * @return true on success
+	 */
+	bool load_image(const std::string& path, uint64_t addr)
+	{
+		std::string err;
+		if(!mem.load_file(path, addr, err)) {
+			std::cerr << name() << ": failed to load " << path << ": " << err << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	/**
+	 * Save memory contents. Only non-zero pages are stored.
+	 * @param wr checkpoint writer
+	 */
+	void save_state(ckpt::writer& wr) const
+	{
+		const uint64_t page = sparse_mem::page_size();
+
+		wr.put_tag("RAM ");
+		wr.put(uint64_t(mem.size()));
+		wr.put(page);
+		for(uint64_t addr = 0; addr < mem.size(); addr += page) {
+			const uint64_t len = std::min<uint64_t>(page, mem.size() - addr);
+			if(is_zero(&mem[addr], len))
+				continue;
+			wr.put(addr);
+			wr.put_bytes(&mem[addr], len);
+		}
+		wr.put(END_OF_PAGES);
+	}
+
+	/**
+	 * Restore memory contents (memory size must match)
+	 * @param rd checkpoint reader
+	 * @return true on success
+	 */
+	bool load_state(ckpt::reader& rd)
+	{
+		uint64_t size = 0;
+		if(!rd.expect_tag("RAM ") || !rd.get(size))
+			return false;
+		if(size != mem.size()) {
+			std::cerr << name() << ": checkpoint memory size mismatch!" << std::endl;
+			return false;
+		}
+
+		uint64_t page = 0;
+		if(!rd.get(page) || !page || !mem.clear())
+			return false;
+
+		while(true) {
+			uint64_t addr;
+			if(!rd.get(addr))
+				return false;
+			if(addr == END_OF_PAGES)
+				return true;
+			if(addr >= mem.size())
+				return false;
+			if(!rd.get_bytes(&mem[addr], std::min<uint64_t>(page, mem.size() - addr)))
+				return false;
+		}
+	}
+
+private:
+	/**
+	 * Creator of VxEngine memory ports
+	 */
+	struct port_creator {
+		sparse_mem& mem;
+		sc_vector<tlm::tlm_target_socket<MEM_WIDTH>>& target;
+		port_creator(sparse_mem& m, sc_vector<tlm::tlm_target_socket<MEM_WIDTH>>& t)
+			: mem(m), target(t) {}
+		memory_port<MEM_WIDTH> *operator()(const char *name, size_t i) const
+		{
+			return new memory_port<MEM_WIDTH>(name, mem, target[i]);
+		}
+	};
+
+	// End of pages marker in checkpoint
+	static constexpr uint64_t END_OF_PAGES = ~uint64_t(0);
+
+	// Returns true if memory range is filled with zeros
+	static bool is_zero(const uint8_t *p, size_t len)
+	{
+		return len == 0 || (p[0] == 0 && !memcmp(p, p + 1, len - 1));
+	}
+
 public:
 	// Storage
-	std::vector<uint8_t> mem;
+	sparse_mem mem;
 
 private:
 	// Ports
 	memory_port<MEM_WIDTH> cpu_port;
-	memory_port<MEM_WIDTH> vxe_port0;
-	memory_port<MEM_WIDTH> vxe_port1;
+	sc_vector<memory_port<MEM_WIDTH>> vxe_port;
 };
@@ -28,23 +28,26 @@
  */
 
 #include <cstdint>
+#include <deque>
 #include <iostream>
-#include <vector>
 #include <systemc.h>
 #include <tlm.h>
+#include "vxe_profiler.hxx"
+#include "sparse_mem.hxx"
 #pragma once
 
 
 // Memory port model template
 template<unsigned MEM_WIDTH>
-SC_MODULE(memory_port), public virtual tlm::tlm_fw_transport_if<> {
+VXE_MODULE(memory_port), public virtual tlm::tlm_fw_transport_if<> {
 	sc_in<bool> clk;
 	sc_in<bool> nrst;
 
 	SC_HAS_PROCESS(memory_port);
 
-	memory_port(::sc_core::sc_module_name name, std::vector<uint8_t>& m, tlm::tlm_target_socket<MEM_WIDTH>& s)
-		: ::sc_core::sc_module(name), clk("clk"), nrst("nrst"), mem(m), socket(s)
+	memory_port(::sc_core::sc_module_name name, sparse_mem& m, tlm::tlm_target_socket<MEM_WIDTH>& s)
+		: vxe_prof_module(name), clk("clk"), nrst("nrst"), mem(m), socket(s)
+		, m_mem_req_pipe("m_mem_req_pipe")
 	{
 		SC_THREAD(mem_req_pipe_thread);
 			sensitive << clk.pos();
@@ -61,6 +64,10 @@ SC_MODULE(memory_port), public virtual tlm::tlm_fw_transport_if<> {
 		// Handle memory access
 		handle_access(trans);
 
+		// Response is not sent before additional latency expires
+		if(m_latency != SC_ZERO_TIME)
+			m_ready_times.push_back(sc_time_stamp() + t + m_latency);
+
 		// Acquire transaction object and put to requests pipe
 		trans.acquire();
 		m_mem_req_pipe.write(&trans);
@@ -71,6 +78,7 @@ SC_MODULE(memory_port), public virtual tlm::tlm_fw_transport_if<> {
 	void b_transport(tlm::tlm_generic_payload& trans, sc_time& t) override
 	{
 		handle_access(trans);
+		t += m_bt_latency + m_latency;
 	}
 
 	bool get_direct_mem_ptr(tlm::tlm_generic_payload& trans, tlm::tlm_dmi& dmi_data) override
@@ -80,6 +88,8 @@ SC_MODULE(memory_port), public virtual tlm::tlm_fw_transport_if<> {
 		dmi_data.set_start_address(0);
 		dmi_data.set_end_address(mem.size()-1);
 		dmi_data.allow_read_write();
+		dmi_data.set_read_latency(m_bt_latency + m_latency);
+		dmi_data.set_write_latency(m_bt_latency + m_latency);
 		return true;
 	}
 
@@ -88,6 +98,24 @@ SC_MODULE(memory_port), public virtual tlm::tlm_fw_transport_if<> {
 		return 0;
 	}
 
+	/**
+	 * Set access latency annotated by blocking transport
+	 * @param latency access latency
+	 */
+	void set_bt_latency(const sc_time& latency)
+	{
+		m_bt_latency = latency;
+	}
+
+	/**
+	 * Set additional access latency (applies to all transport types and DMI)
+	 * @param latency access latency
+	 */
+	void set_latency(const sc_time& latency)
+	{
+		m_latency = latency;
+	}
+
 private:
 	void handle_access(tlm::tlm_generic_payload& trans)
 	{
@@ -147,6 +175,12 @@ private:
 			wait();
 			// Handle response
 			trans = m_mem_req_pipe.read();
+			if(m_latency != SC_ZERO_TIME) {
+				const sc_time ready = m_ready_times.front();
+				m_ready_times.pop_front();
+				while(sc_time_stamp() < ready)
+					wait();
+			}
 			tlm::tlm_phase phase = tlm::BEGIN_RESP;
 			sc_time t;
 			tlm::tlm_sync_enum r= socket->nb_transport_bw(*trans, phase, t);
@@ -157,7 +191,10 @@ private:
 	}
 
 private:
-	std::vector<uint8_t>& mem;				// Memory reference
+	sparse_mem& mem;				// Memory reference
 	tlm::tlm_target_socket<MEM_WIDTH>& socket;		// Socket reference
-	sc_fifo<tlm::tlm_generic_payload*> m_mem_req_pipe;	// Requests pipe
+	vxe_fifo<tlm::tlm_generic_payload*> m_mem_req_pipe;	// Requests pipe
+	sc_time m_bt_latency;					// Blocking transport latency
+	sc_time m_latency;					// Additional access latency
+	std::deque<sc_time> m_ready_times;			// Response times of piped requests
 };
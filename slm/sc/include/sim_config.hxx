@@ -0,0 +1,238 @@
+/*
+ * Copyright (c) 2022 The VxEngine Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * System model configuration
+ * Parameters are loaded from a text file with "key = value" lines.
+ * Empty lines and lines starting with '#' are ignored.
+ */
+
+#include <climits>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#pragma once
+
+
+// System model configuration
+struct sim_config {
+	unsigned clk_period_ns = 10;	// System clock period
+	unsigned mem_latency = 0;	// Additional memory access latency (cycles)
+	unsigned fifo_depth = 16;	// Depth of VxEngine interconnect FIFOs
+	unsigned vpu_fifo_depth = 16;	// Depth of VPU 64-to-32 operand FIFOs
+	unsigned fmac_stages = 5;	// FMAC pipeline depth
+	unsigned fmac_lanes = 1;	// Number of FMAC lanes per VPU
+	unsigned vpu_count = 2;		// Number of VPUs per VxEngine
+	unsigned vpu_threads = 8;	// Number of threads per VPU
+	unsigned mem_ports = 2;		// Number of VxEngine memory master ports
+	std::string hub_route = "arg";	// Memory hub routing policy (arg, interleave or table)
+	unsigned hub_granule = 64;	// Memory hub interleaving granule (bytes)
+	std::vector<unsigned> hub_table;	// Memory hub master port per client (CU is client 0)
+	unsigned burst_len = 1;		// Maximum length of VPU load bursts (beats)
+	unsigned vxe_count = 1;		// Number of VxEngine instances
+	unsigned vxe_mmio_size = 0x1000;	// Size of VxEngine MMIO window
+
+	static constexpr unsigned FMAC_RTL_STAGES = 5;	// Pipeline depth of Verilated FMAC
+
+	/**
+	 * Set parameter value
+	 * @param key parameter name
+	 * @param value parameter value
+	 * @return false if parameter is unknown or value is not valid
+	 */
+	bool set(const std::string& key, const std::string& value)
+	{
+		if(key == "hub_route") {
+			if(value != "arg" && value != "interleave" && value != "table") {
+				std::cerr << key << ": unknown routing policy." << std::endl;
+				return false;
+			}
+			hub_route = value;
+			return true;
+		} else if(key == "hub_table")
+			return set_table(key, value, hub_table);
+
+		const struct {
+			const char *key;
+			unsigned *value;
+			unsigned min;
+			unsigned max;
+		} params[] = {
+			{ "clk_period_ns", &clk_period_ns, 1, UINT_MAX },
+			{ "mem_latency", &mem_latency, 0, UINT_MAX },
+			{ "fifo_depth", &fifo_depth, 1, UINT_MAX },
+			{ "vpu_fifo_depth", &vpu_fifo_depth, 1, 64 },	// vxe_vector_unit::MAX_FIFO_DEPTH
+			{ "fmac_stages", &fmac_stages, 1, 16 },
+			{ "fmac_lanes", &fmac_lanes, 1, 4 },
+			{ "vpu_count", &vpu_count, 1, 32 },	// 5-bit VPU number in instructions
+			{ "vpu_threads", &vpu_threads, 1, 8 },	// 3-bit thread id in instructions
+			{ "mem_ports", &mem_ports, 1, 8 },
+			{ "hub_granule", &hub_granule, 8, 0x80000000 },
+			{ "burst_len", &burst_len, 1, 16 },
+			{ "vxe_count", &vxe_count, 1, UINT_MAX },
+			{ "vxe_mmio_size", &vxe_mmio_size, 0x100, UINT_MAX }
+		};
+
+		for(const auto& p : params) {
+			if(key != p.key)
+				continue;
+			unsigned long v;
+			try {
+				size_t pos;
+				v = std::stoul(value, &pos, 0);
+				if(pos != value.size())
+					throw std::invalid_argument("trailing characters");
+			}
+			catch(const std::exception& e)
+			{
+				std::cerr << key << ": " << e.what() << std::endl;
+				return false;
+			}
+			if(v < p.min) {
+				std::cerr << key << ": value is too small." << std::endl;
+				return false;
+			}
+			if(v > p.max) {
+				std::cerr << key << ": value is too large." << std::endl;
+				return false;
+			}
+			if(p.value == &fmac_lanes && (v & (v - 1))) {
+				std::cerr << key << ": must be 1, 2 or 4." << std::endl;
+				return false;
+			}
+#ifndef VXE_NATIVE_FPU
+			if(p.value == &fmac_stages && v != FMAC_RTL_STAGES) {
+				std::cerr << key << ": Verilated FMAC has " << FMAC_RTL_STAGES
+					<< " stages." << std::endl;
+				return false;
+			}
+#endif
+			*p.value = static_cast<unsigned>(v);
+			return true;
+		}
+
+		std::cerr << key << ": unknown parameter." << std::endl;
+		return false;
+	}
+
+	/**
+	 * Set list of numbers from comma-separated value
+	 * @param key parameter name
+	 * @param value parameter value
+	 * @param table destination list
+	 * @return false if value is not valid
+	 */
+	static bool set_table(const std::string& key, const std::string& value,
+		std::vector<unsigned>& table)
+	{
+		std::vector<unsigned> t;
+		std::istringstream is(value);
+		std::string item;
+		while(std::getline(is, item, ',')) {
+			try {
+				size_t pos;
+				unsigned long v = std::stoul(item, &pos, 0);
+				if(pos != item.size())
+					throw std::invalid_argument("trailing characters");
+				t.push_back(static_cast<unsigned>(v));
+			}
+			catch(const std::exception& e)
+			{
+				std::cerr << key << ": " << e.what() << std::endl;
+				return false;
+			}
+		}
+		table.swap(t);
+		return true;
+	}
+
+	/**
+	 * Load parameters from a file
+	 * @param file configuration file
+	 * @return false on error
+	 */
+	bool load(const std::string& file)
+	{
+		std::ifstream is(file);
+		if(!is) {
+			std::cerr << "failed to open config file: " << file << std::endl;
+			return false;
+		}
+
+		std::string line;
+		unsigned lineno = 0;
+		bool ok = true;
+		while(std::getline(is, line)) {
+			++lineno;
+			size_t b = line.find_first_not_of(" \t\r");
+			if(b == std::string::npos || line[b] == '#')
+				continue;
+
+			size_t eq = line.find('=');
+			if(eq == std::string::npos) {
+				std::cerr << file << ":" << lineno << ": missing '='." << std::endl;
+				ok = false;
+				continue;
+			}
+
+			std::string key, value;
+			std::istringstream(line.substr(0, eq)) >> key;
+			std::istringstream(line.substr(eq + 1)) >> value;
+			if(!set(key, value)) {
+				std::cerr << file << ":" << lineno << ": invalid parameter." << std::endl;
+				ok = false;
+			}
+		}
+
+		return validate() && ok;
+	}
+
+	/**
+	 * Check consistency of parameters
+	 * @return false if parameters contradict each other
+	 */
+	bool validate() const
+	{
+		bool ok = true;
+
+		if(hub_granule & (hub_granule - 1)) {
+			std::cerr << "hub_granule: must be a power of two." << std::endl;
+			ok = false;
+		}
+
+		for(unsigned m : hub_table) {
+			if(m >= mem_ports) {
+				std::cerr << "hub_table: master port " << m << " is out of range (mem_ports = "
+					<< mem_ports << ")." << std::endl;
+				ok = false;
+			}
+		}
+
+		return ok;
+	}
+};
@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2022 The VxEngine Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Simulation server
+ * Runs application jobs received over a local UNIX socket on already
+ * elaborated system model. Line-based protocol:
+ *   run <so_file> [-arg <value>]... [-load <file@addr>]...
+ *     -> ok exit=<code> cycles=<n> sim_ns=<n> wall_us=<n>
+ *     -> error <message>
+ *   quit
+ *     -> bye
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include <systemc.h>
+#include "sys_top.hxx"
+#pragma once
+
+
+// Simulation server
+class sim_server {
+public:
+	// Memory images (file, load address)
+	using image_list = std::vector<std::pair<std::string, uint64_t>>;
+
+	/**
+	 * Constructor
+	 * @param top system top to run jobs on
+	 * @param clk_period system clock period
+	 * @param images memory images to load before each job
+	 */
+	sim_server(sys_top& top, const sc_time& clk_period, const image_list& images);
+
+	~sim_server();
+
+	sim_server(const sim_server&) = delete;
+	sim_server& operator=(const sim_server&) = delete;
+
+	/**
+	 * Open server socket
+	 * @param path UNIX socket path
+	 * @return true on success
+	 */
+	bool open(const std::string& path);
+
+	/**
+	 * Wait for next job and reset system for it (called from CPU thread)
+	 * @param job next job
+	 * @return false if server should stop
+	 */
+	bool next_job(simple_cpu::app_job& job);
+
+	/**
+	 * Report job completion to the client (called from CPU thread)
+	 * @param job completed job
+	 * @param started =true if app was started
+	 * @param exit_code app exit code
+	 */
+	void job_done(const simple_cpu::app_job& job, bool started, int exit_code);
+
+	/**
+	 * Number of completed jobs
+	 */
+	unsigned jobs() const { return m_jobs; }
+
+private:
+	// Max. number of cycles to wait for VxEngine to become idle before reset
+	static constexpr unsigned DRAIN_CYCLES = 100000;
+
+	// Read next request line (accepts new client if needed)
+	bool read_line(std::string& line);
+	// Send reply line to current client
+	void reply(const std::string& msg);
+	// Parse job request arguments
+	bool parse_job(std::istream& is, simple_cpu::app_job& job, image_list& images,
+		std::string& err);
+	// Prepare system for a job
+	bool setup_job(const image_list& images, std::string& err);
+
+	sys_top& m_top;			// System top
+	sc_time m_clk_period;		// Clock period
+	image_list m_images;		// Images loaded for each job
+	std::string m_path;		// Socket path
+	int m_listen_fd;		// Listening socket
+	int m_conn_fd;			// Client connection
+	std::string m_rx;		// Received data not yet processed
+	unsigned m_jobs;		// Completed jobs
+	sc_time m_job_start;		// Simulation time when job started
+	std::chrono::steady_clock::time_point m_wall_start;	// Wall time when job started
+};
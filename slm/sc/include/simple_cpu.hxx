@@ -27,10 +27,14 @@
  * Simple CPU model
  */
 
+#include <functional>
 #include <string>
+#include <vector>
 #include <systemc.h>
 #include <tlm.h>
+#include <tlm_utils/tlm_quantumkeeper.h>
 #include "simple_cpu_if.h"
+#include "async_call_queue.hxx"
 #pragma once
 
 
@@ -43,6 +47,12 @@ SC_MODULE(simple_cpu), public virtual tlm::tlm_bw_transport_if<> {
 	sc_in<bool> nrst;
 	sc_in<bool> i_intr;
 
+	// Application job
+	struct app_job {
+		std::string so_file;		// App. shared object
+		std::vector<std::string> args;	// App. arguments
+	};
+
 	tlm::tlm_initiator_socket<IO_WIDTH> io_initiator;
 	tlm::tlm_initiator_socket<MEM_WIDTH> mem_initiator;
 
@@ -55,9 +65,72 @@ SC_MODULE(simple_cpu), public virtual tlm::tlm_bw_transport_if<> {
 	tlm::tlm_sync_enum nb_transport_bw(tlm::tlm_generic_payload& trans, tlm::tlm_phase& phase, sc_time& t) override;
 	void invalidate_direct_mem_ptr(sc_dt::uint64 start_range, sc_dt::uint64 end_range) override;
 
+	/**
+	 * Set loosely-timed mode
+	 * In this mode CPU runs ahead of simulation time using quantum keeper.
+	 * @param enable =true to enable loosely-timed mode
+	 * @param clk_period clock period
+	 */
+	void set_lt_mode(bool enable, const sc_time& clk_period);
+
+	/**
+	 * Set handler of application checkpoint requests
+	 * @param handler function that takes checkpoint operation and returns result
+	 */
+	void set_checkpoint_handler(std::function<int(int)> handler);
+
+	/**
+	 * Set source of application jobs (server mode)
+	 * CPU runs jobs until the source is drained instead of a single so_file.
+	 * @param source function that blocks until next job is available (returns false to finish)
+	 * @param done function that takes completed job, app start status and exit code
+	 */
+	void set_job_source(std::function<bool(app_job&)> source,
+		std::function<void(const app_job&, bool, int)> done);
+
+	/**
+	 * Set application thread mode
+	 * In this mode application runs on its own host thread and its CPU interface
+	 * calls are executed in simulation context, so that application compute
+	 * overlaps simulation of the rest of the system.
+	 * @param enable =true to run application on a separate host thread
+	 */
+	void set_app_thread(bool enable);
+
+	/**
+	 * Set check for pending work in the rest of the system (application thread mode)
+	 * Simulation is blocked while application computes and system has no work.
+	 * @param check function that returns true if system is busy
+	 */
+	void set_busy_check(std::function<bool()> check);
+
+	/**
+	 * Load and run application
+	 * @param job application job
+	 * @param exit_code app exit code
+	 * @return true if app was started
+	 */
+	bool run_app(const app_job& job, int& exit_code);
+
+private:
+	// Execute application thread calls until it terminates
+	void serve_app_thread();
+
 public:
 	bool m_allow_stop;		// If =true simulation will end when program returns
+	bool m_lt_mode;			// Loosely-timed mode
+	sc_time m_clk_period;		// Clock period
+	tlm_utils::tlm_quantumkeeper m_qk;	// Quantum keeper for loosely-timed mode
 	std::string so_file;		// App. shared object
+	std::vector<std::string> app_args;	// App. arguments
 	struct simple_cpu_dmi dmi;	// Direct memory interface info
+	struct simple_cpu_vxe_info vxe_info;	// VxEngine instances info
 	struct simple_cpu_if cpu_if;	// CPU/App interface
+	std::function<int(int)> checkpoint_handler;	// Checkpoint requests handler
+	std::function<bool(app_job&)> job_source;	// Jobs source (server mode)
+	std::function<void(const app_job&, bool, int)> job_done;	// Jobs completion handler
+	bool m_app_thread;		// Application thread mode
+	struct simple_cpu_if app_if;	// CPU/App interface for application thread
+	async_call_queue m_app_calls;	// Calls from application thread
+	std::function<bool()> busy_check;	// System busy check
 };
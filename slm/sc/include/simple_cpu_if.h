@@ -44,6 +44,16 @@ extern "C" {
 typedef int (*simple_cpu_entry_t)(struct simple_cpu_if *cpu_if);
 
 
+/* Checkpoint operations */
+#define SIMPLE_CPU_CKPT_RESTORE	0	/* Restore model state */
+#define SIMPLE_CPU_CKPT_SAVE	1	/* Save model state */
+
+/* Checkpoint results */
+#define SIMPLE_CPU_CKPT_ERROR	(-1)	/* Operation failed */
+#define SIMPLE_CPU_CKPT_NONE	0	/* No checkpoint file configured */
+#define SIMPLE_CPU_CKPT_DONE	1	/* State saved or restored */
+
+
 /* Direct memory interface info */
 struct simple_cpu_dmi {
 	void *ptr;	/* Pointer to memory */
@@ -52,6 +62,16 @@ struct simple_cpu_dmi {
 };
 
 
+/* VxEngine instances info */
+struct simple_cpu_vxe_info {
+	unsigned count;		/* Number of VxEngine instances */
+	uint64_t mmio_base;	/* MMIO address of instance 0 */
+	uint64_t mmio_size;	/* MMIO window size (instance i is at mmio_base + i * mmio_size) */
+	unsigned vpu_count;	/* Number of VPUs per instance */
+	unsigned vpu_threads;	/* Number of threads per VPU (destination is (vpu << 3) | thread) */
+};
+
+
 /* CPU/Application interface */
 struct simple_cpu_if {
 	void *cpuid;
@@ -98,6 +118,26 @@ struct simple_cpu_if {
 	 * @return 0 if DMI is not supported
 	 */
 	int (*get_dmi)(void *cpuid, struct simple_cpu_dmi *dmi);
+
+	/**
+	 * Save or restore model state (memory, VxEngine registers and units).
+	 * VxEngine must be idle. Checkpoint files are set by the model.
+	 * @param cpuid CPU interface to use
+	 * @param op SIMPLE_CPU_CKPT_SAVE or SIMPLE_CPU_CKPT_RESTORE
+	 * @return SIMPLE_CPU_CKPT_DONE, SIMPLE_CPU_CKPT_NONE or SIMPLE_CPU_CKPT_ERROR
+	 */
+	int (*checkpoint)(void *cpuid, int op);
+
+	/**
+	 * Get VxEngine instances info
+	 * @param cpuid CPU interface to use
+	 * @param info VxEngine instances info
+	 */
+	void (*get_vxe_info)(void *cpuid, struct simple_cpu_vxe_info *info);
+
+	/* Application arguments (valid during entry call) */
+	int argc;
+	const char * const *argv;
 };
 
 
@@ -123,6 +163,12 @@ struct simple_cpu_if {
 #define mmio_wreg32(addr, value)	\
 	SIMPLE_CPU_IF->mmio_wreg32(SIMPLE_CPU_IF->cpuid, (addr), (value))
 
+#define checkpoint(op)	\
+	SIMPLE_CPU_IF->checkpoint(SIMPLE_CPU_IF->cpuid, (op))
+
+#define get_vxe_info(info)	\
+	SIMPLE_CPU_IF->get_vxe_info(SIMPLE_CPU_IF->cpuid, (info))
+
 #endif /* SIMPLE_CPU_IF_SHORTCUTS */
 
 
@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2022 The VxEngine Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Sparse memory storage
+ */
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#pragma once
+
+
+/**
+ * Sparse memory storage.
+ * Storage is a private anonymous mapping, so host pages are allocated
+ * lazily on first write and untouched pages read as zeros. Storage stays
+ * contiguous and can be exposed through DMI. File images can be mapped
+ * directly into storage (copy-on-write) without copying.
+ */
+class sparse_mem {
+public:
+	sparse_mem() : m_ptr(nullptr), m_size(0) {}
+
+	~sparse_mem()
+	{
+		if(m_ptr)
+			munmap(m_ptr, m_size);
+	}
+
+	sparse_mem(const sparse_mem&) = delete;
+	sparse_mem& operator=(const sparse_mem&) = delete;
+
+	/**
+	 * Resize storage. Contents are preserved up to the new size, added
+	 * space reads as zeros. Storage address may change.
+	 * @param size new size in bytes
+	 */
+	void resize(size_t size)
+	{
+		void *p;
+
+		if(size == m_size)
+			return;
+
+		if(!m_ptr)
+			p = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+				MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+		else if(size)
+			p = mremap(m_ptr, m_size, size, MREMAP_MAYMOVE);
+		else {
+			munmap(m_ptr, m_size);
+			p = nullptr;
+		}
+
+		if(p == MAP_FAILED)
+			throw std::bad_alloc();
+
+		m_ptr = static_cast<uint8_t*>(p);
+		m_size = size;
+	}
+
+	/**
+	 * Drop all contents (storage reads as zeros, address is preserved)
+	 * @return true on success
+	 */
+	bool clear()
+	{
+		if(!m_ptr)
+			return true;
+		void *p = mmap(m_ptr, m_size, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED, -1, 0);
+		return p != MAP_FAILED;
+	}
+
+	/**
+	 * Load file image into storage. Whole pages of the file are mapped
+	 * directly if address is page aligned, the rest is read.
+	 * @param path file path
+	 * @param addr storage offset
+	 * @param err error description on failure
+	 * @return true on success
+	 */
+	bool load_file(const std::string& path, uint64_t addr, std::string& err)
+	{
+		int fd = open(path.c_str(), O_RDONLY);
+		if(fd < 0) {
+			err = std::string("cannot open file: ") + strerror(errno);
+			return false;
+		}
+
+		bool ok = load_fd(fd, addr, err);
+		close(fd);
+		return ok;
+	}
+
+	/**
+	 * Host page size
+	 * @return page size in bytes
+	 */
+	static size_t page_size()
+	{
+		static const size_t s_page_size = sysconf(_SC_PAGESIZE);
+		return s_page_size;
+	}
+
+	uint8_t *data() { return m_ptr; }
+	const uint8_t *data() const { return m_ptr; }
+	size_t size() const { return m_size; }
+	uint8_t& operator[](size_t i) { return m_ptr[i]; }
+	const uint8_t& operator[](size_t i) const { return m_ptr[i]; }
+
+private:
+	bool load_fd(int fd, uint64_t addr, std::string& err)
+	{
+		struct stat st;
+		if(fstat(fd, &st) < 0) {
+			err = std::string("cannot stat file: ") + strerror(errno);
+			return false;
+		}
+
+		const uint64_t size = st.st_size;
+		if(addr > m_size || size > m_size - addr) {
+			err = "image does not fit into memory";
+			return false;
+		}
+
+		// Map whole pages
+		uint64_t mapped = 0;
+		if(addr % page_size() == 0)
+			mapped = size - size % page_size();
+		if(mapped) {
+			void *p = mmap(m_ptr + addr, mapped, PROT_READ | PROT_WRITE,
+				MAP_PRIVATE | MAP_FIXED, fd, 0);
+			if(p == MAP_FAILED) {
+				err = std::string("cannot map file: ") + strerror(errno);
+				return false;
+			}
+		}
+
+		// Read the rest
+		for(uint64_t off = mapped; off < size; ) {
+			ssize_t n = pread(fd, m_ptr + addr + off, size - off, off);
+			if(n <= 0) {
+				err = std::string("cannot read file: ") + (n < 0 ? strerror(errno) : "unexpected end");
+				return false;
+			}
+			off += n;
+		}
+
+		return true;
+	}
+
+private:
+	uint8_t *m_ptr;		// Storage
+	size_t m_size;		// Storage size
+};
@@ -28,49 +28,335 @@
  */
 
 #include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
 #include <systemc.h>
 #include "simple_cpu.hxx"
 #include "memory.hxx"
+#include "io_router.hxx"
+#include "mem_interconnect.hxx"
 #include "vxe_top.hxx"
+#include "checkpoint.hxx"
+#include "sim_config.hxx"
 #pragma once
 
 
 // System top module
 SC_MODULE(sys_top) {
+	static constexpr unsigned IO_WIDTH = 32;
 	static constexpr unsigned MEM_WIDTH = 64;
 
 	sc_in<bool> clk;
 	sc_in<bool> nrst;
 
-	simple_cpu cpu;		// CPU
-	memory<MEM_WIDTH> ram;	// RAM
-	vxe_top vxe;		// VxEngine
+	simple_cpu cpu;			// CPU
+	memory<MEM_WIDTH> ram;		// RAM
+	io_router<IO_WIDTH> io;		// MMIO router
+	sc_vector<vxe_top> vxe;		// VxEngine instances
 
-	SC_CTOR(sys_top)
-		: clk("clk"), nrst("nrst")
-		, cpu("cpu"), ram("ram"), vxe("vxe")
+	SC_HAS_PROCESS(sys_top);
+
+	/**
+	 * Constructor
+	 * @param name module name
+	 * @param cfg model configuration
+	 */
+	explicit sys_top(::sc_core::sc_module_name name, const sim_config& cfg = sim_config())
+		: ::sc_core::sc_module(name), clk("clk"), nrst("nrst")
+		, cpu("cpu"), ram("ram", vxe_top::mem_ports(cfg)), io("io", cfg.vxe_count, cfg.vxe_mmio_size)
+		, vxe("vxe", cfg.vxe_count, vxe_creator(cfg))
+		, s_vxe_intr("s_vxe_intr", cfg.vxe_count)
 	{
 		// Connect clock and reset signals
 		cpu.clk(clk);
 		cpu.nrst(nrst);
 		ram.clk(clk);
 		ram.nrst(nrst);
-		vxe.clk(clk);
-		vxe.nrst(nrst);
+		for(auto& v : vxe) {
+			v.clk(clk);
+			v.nrst(nrst);
+		}
 
 		// Connect RAM to CPU
 		ram.cpu_target(cpu.mem_initiator);
 
-		// Connect VxEngine to CPU and RAM
-		vxe.io_target(cpu.io_initiator);
-		ram.vxe_target0(vxe.mem_initiator0);
-		ram.vxe_target1(vxe.mem_initiator1);
+		// Connect VxEngine instances to CPU through MMIO windows
+		io.io_target(cpu.io_initiator);
+		for(unsigned i = 0; i < vxe.size(); ++i)
+			vxe[i].io_target(io.initiator(i));
+
+		// Connect VxEngine instances to RAM. Single instance is connected
+		// directly, several instances share RAM ports through interconnect.
+		for(unsigned p = 0; p < ram.vxe_target.size(); ++p) {
+			if(vxe.size() == 1) {
+				ram.vxe_target[p](vxe[0].mem_initiator[p]);
+				continue;
+			}
+			const std::string ic = "ic" + std::to_string(p);
+			m_ic.emplace_back(new mem_interconnect<MEM_WIDTH>(ic.c_str(), vxe.size()));
+			m_ic[p]->clk(clk);
+			m_ic[p]->nrst(nrst);
+			ram.vxe_target[p](m_ic[p]->mem_initiator);
+			for(unsigned i = 0; i < vxe.size(); ++i)
+				m_ic[p]->target(i)(vxe[i].mem_initiator[p]);
+		}
 
-		// Connect interrupt signal
+		// Connect interrupt signals (CPU interrupt is asserted by any instance)
 		cpu.i_intr(s_intr);
-		vxe.o_intr(s_intr);
+		for(unsigned i = 0; i < vxe.size(); ++i)
+			vxe[i].o_intr(s_vxe_intr[i]);
+
+		SC_METHOD(intr_method);
+			for(auto& s : s_vxe_intr)
+				sensitive << s;
+
+		// VxEngine instances info for applications
+		cpu.vxe_info.count = vxe.size();
+		cpu.vxe_info.mmio_base = 0;
+		cpu.vxe_info.mmio_size = cfg.vxe_mmio_size;
+		cpu.vxe_info.vpu_count = vxe_top::vpu_count(cfg);
+		cpu.vxe_info.vpu_threads = cfg.vpu_threads;
+
+		// Additional memory latency
+		ram.set_latency(sc_time(cfg.clk_period_ns, SC_NS) * cfg.mem_latency);
+
+		// Handle application checkpoint requests
+		cpu.set_checkpoint_handler(
+			[this](int op) -> int
+			{
+				return checkpoint(op);
+			}
+		);
+
+		// Application thread keeps simulation running while VxEngine is busy
+		cpu.set_busy_check(
+			[this]() -> bool
+			{
+				return !vxe_idle();
+			}
+		);
+	}
+
+	/**
+	 * Check that all VxEngine instances are idle
+	 * @return true if idle
+	 */
+	bool vxe_idle() const
+	{
+		for(const auto& v : vxe)
+			if(!v.idle())
+				return false;
+		return true;
+	}
+
+	/**
+	 * Number of RAM ports used by VxEngine instances
+	 */
+	unsigned mem_ports() const { return ram.vxe_target.size(); }
+
+	/**
+	 * Shared RAM port interconnect (not used with a single VxEngine instance)
+	 * @param port RAM port
+	 * @return interconnect or nullptr
+	 */
+	const mem_interconnect<MEM_WIDTH> *interconnect(unsigned port) const
+	{
+		return port < m_ic.size() ? m_ic[port].get() : nullptr;
+	}
+
+	/**
+	 * Set loosely-timed mode for CPU, RAM and VxEngine memory masters
+	 * @param enable =true to enable loosely-timed mode
+	 * @param clk_period clock period
+	 */
+	void set_lt_mode(bool enable, const sc_time& clk_period)
+	{
+		cpu.set_lt_mode(enable, clk_period);
+		ram.set_lt_mode(enable, clk_period);
+		for(auto& v : vxe)
+			v.set_lt_mode(enable, clk_period);
+		for(auto& ic : m_ic)
+			ic->set_lt_mode(enable, clk_period);
+	}
+
+	/**
+	 * Set application thread mode for CPU
+	 * @param enable =true to run application on a separate host thread
+	 */
+	void set_app_thread(bool enable)
+	{
+		cpu.set_app_thread(enable);
+	}
+
+	/**
+	 * Set DMI mode for VxEngine memory masters
+	 * @param enable =true to enable DMI mode
+	 * @param latency additional access latency
+	 */
+	void set_dmi_mode(bool enable, const sc_time& latency)
+	{
+		for(auto& v : vxe)
+			v.set_dmi_mode(enable, latency);
+	}
+
+	/**
+	 * Select CU to VPU command interface of VxEngine
+	 * @param tlm =true to use transaction-level channel
+	 */
+	void set_cmd_channel(bool tlm)
+	{
+		for(auto& v : vxe)
+			v.set_cmd_channel(tlm);
+	}
+
+	/**
+	 * Set sampled simulation mode for VxEngine
+	 * @param ffwd number of functional runs per sampling period
+	 * @param warmup number of detailed warm-up runs per sampling period
+	 * @param detail number of detailed measured runs per sampling period (0 disables sampling)
+	 */
+	void set_sampling(unsigned ffwd, unsigned warmup, unsigned detail)
+	{
+		for(auto& v : vxe)
+			v.set_sampling(ffwd, warmup, detail);
+	}
+
+	/**
+	 * Run VPUs on separate host threads during functional runs of VxEngine
+	 * @param enable true to enable
+	 */
+	void set_parallel(bool enable)
+	{
+		for(auto& v : vxe)
+			v.set_parallel(enable);
+	}
+
+	/**
+	 * Set checkpoint files used on application requests
+	 * @param load_file file to restore state from (empty if not used)
+	 * @param save_file file to save state to (empty if not used)
+	 */
+	void set_checkpoint_files(const std::string& load_file, const std::string& save_file)
+	{
+		m_ckpt_load = load_file;
+		m_ckpt_save = save_file;
+	}
+
+	/**
+	 * Reset memory and VxEngine to power-on state without re-elaboration
+	 * @return true on success (false if VxEngine is busy)
+	 */
+	bool reset_state()
+	{
+		if(!vxe_idle()) {
+			std::cerr << name() << ": VxEngine is busy, reset is not possible!" << std::endl;
+			return false;
+		}
+
+		for(auto& v : vxe)
+			v.reset_state();
+
+		return ram.mem.clear();
+	}
+
+private:
+	/**
+	 * Creator of VxEngine instances with given configuration
+	 */
+	struct vxe_creator {
+		const sim_config& cfg;
+		explicit vxe_creator(const sim_config& c) : cfg(c) {}
+		vxe_top *operator()(const char *name, size_t) const
+		{
+			return new vxe_top(name, cfg);
+		}
+	};
+
+	// Checkpoint file signature
+	static constexpr char CKPT_MAGIC[] = "VXECKPT1";
+
+	// Handle checkpoint request
+	int checkpoint(int op)
+	{
+		const std::string& file = (op == SIMPLE_CPU_CKPT_SAVE ? m_ckpt_save : m_ckpt_load);
+		if(file.empty())
+			return SIMPLE_CPU_CKPT_NONE;
+
+		if(!vxe_idle()) {
+			std::cerr << name() << ": VxEngine is busy, checkpoint is not possible!" << std::endl;
+			return SIMPLE_CPU_CKPT_ERROR;
+		}
+
+		bool ok = (op == SIMPLE_CPU_CKPT_SAVE ? save_checkpoint(file) : load_checkpoint(file));
+
+		return ok ? SIMPLE_CPU_CKPT_DONE : SIMPLE_CPU_CKPT_ERROR;
+	}
+
+	// Save model state to a file
+	bool save_checkpoint(const std::string& file)
+	{
+		std::ofstream os(file, std::ios::binary);
+		ckpt::writer wr(os);
+
+		wr.put_bytes(CKPT_MAGIC, sizeof(CKPT_MAGIC) - 1);
+		wr.put(sc_time_stamp().to_seconds());
+		ram.save_state(wr);
+		for(const auto& v : vxe)
+			v.save_state(wr);
+
+		if(!wr.good()) {
+			std::cerr << name() << ": failed to save checkpoint: " << file << std::endl;
+			return false;
+		}
+
+		std::cout << name() << ": checkpoint saved to " << file << std::endl;
+		return true;
+	}
+
+	// Restore model state from a file
+	bool load_checkpoint(const std::string& file)
+	{
+		std::ifstream is(file, std::ios::binary);
+		ckpt::reader rd(is);
+		char magic[sizeof(CKPT_MAGIC) - 1];
+		double saved_at = 0;
+
+		if(!rd.get(magic) || memcmp(magic, CKPT_MAGIC, sizeof(magic)) || !rd.get(saved_at)) {
+			std::cerr << name() << ": not a checkpoint file: " << file << std::endl;
+			return false;
+		}
+
+		bool ok = ram.load_state(rd);
+		for(auto& v : vxe)
+			ok = ok && v.load_state(rd);
+		if(!ok) {
+			std::cerr << name() << ": failed to restore checkpoint: " << file << std::endl;
+			return false;
+		}
+
+		std::cout << name() << ": checkpoint restored from " << file
+			<< " (saved at " << sc_time(saved_at, SC_SEC) << ")" << std::endl;
+		return true;
+	}
+
+	// Combine interrupt lines of VxEngine instances
+	void intr_method()
+	{
+		bool intr = false;
+		for(const auto& s : s_vxe_intr)
+			intr = intr || s.read();
+		s_intr.write(intr);
 	}
 
 private:
 	sc_signal<bool> s_intr;
+	sc_vector<sc_signal<bool>> s_vxe_intr;		// Interrupt lines of VxEngine instances
+	std::vector<std::unique_ptr<mem_interconnect<MEM_WIDTH>>> m_ic;	// RAM ports interconnects
+	// Checkpoint files
+	std::string m_ckpt_load;
+	std::string m_ckpt_save;
 };
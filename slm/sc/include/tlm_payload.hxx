@@ -27,17 +27,32 @@
  * TLM payloads management
  */
 
+#include <cstdint>
 #include <tlm.h>
 #pragma once
 
 
 namespace tlm_pl {
 
+	/**
+	 * Payload pool allocation statistics
+	 */
+	struct alloc_stats {
+		uint64_t gp_allocs;	// Payload objects allocated on heap
+		uint64_t gp_reuses;	// Payload objects taken from the pool
+		uint64_t buf_allocs;	// Data and byte enable buffers allocated on heap
+		uint64_t ext_allocs;	// Extensions allocated on heap
+		uint64_t gp_pooled;	// Payload objects currently in the pool
+	};
+
 	/**
 	 * Allocate generic payload
 	 *
 	 * Notes:
 	 * - To release memory call release() method of the payload object.
+	 *   Released payloads are returned to the pool together with their
+	 *   buffers and extensions and recycled by following allocations of the
+	 *   same size.
 	 * - Data and byte enable lengths are not set by default.
 	 *
 	 * @param data_size size of payload data
@@ -46,4 +61,33 @@ namespace tlm_pl {
 	 */
 	tlm::tlm_generic_payload* alloc_gp(size_t data_size = 0, size_t be_length = 0);
 
+	/**
+	 * Get pool allocation statistics
+	 * @return statistics
+	 */
+	const alloc_stats& get_stats();
+
+	/**
+	 * Count extension allocation (used by get_ext())
+	 */
+	void count_ext_alloc();
+
+	/**
+	 * Get extension of pooled payload. The extension is allocated on the
+	 * first use and stays attached to the payload while it is recycled.
+	 * @param gp pointer to a payload
+	 * @return pointer to an extension
+	 */
+	template<typename T>
+	T* get_ext(tlm::tlm_generic_payload *gp)
+	{
+		T *ext = gp->get_extension<T>();
+		if(!ext) {
+			ext = new T();
+			gp->set_extension(ext);
+			count_ext_alloc();
+		}
+		return ext;
+	}
+
 } // namespace tlm_pl
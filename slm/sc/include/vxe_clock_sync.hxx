@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2022 The VxEngine Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Clock synchronization helper for event-driven clocked processes
+ */
+
+#include <cstdint>
+#include <systemc.h>
+#include "vxe_profiler.hxx"
+#pragma once
+
+
+/**
+ * Clock synchronization helper.
+ * Lets clocked threads sleep on events instead of polling on every clock
+ * edge and reports how many positive clock edges passed while sleeping.
+ * Clock input must be bound to sc_clock, otherwise the helper is not valid
+ * and the process should fall back to polling. Event-driven sleeping can
+ * also be disabled globally with set_enabled(false).
+ */
+class vxe_clock_sync {
+public:
+	/**
+	 * Constructor
+	 * @param clk clock input
+	 */
+	explicit vxe_clock_sync(sc_in<bool>& clk)
+		: m_clk(clk), m_valid(false), m_period(0), m_first(0)
+	{}
+
+	/**
+	 * Resolve clock parameters (must be called after elaboration)
+	 * @return true if clock input is bound to sc_clock
+	 */
+	bool init()
+	{
+		const auto *clock = dynamic_cast<const sc_clock*>(m_clk.get_interface());
+		if(!enabled() || !clock || clock->period() == SC_ZERO_TIME)
+			return (m_valid = false);
+
+		m_period = clock->period().value();
+		m_first = clock->start_time().value();
+		if(!clock->posedge_first())
+			m_first += (clock->period() * (1.0 - clock->duty_cycle())).value();
+
+		return (m_valid = true);
+	}
+
+	/**
+	 * Check if helper is initialized
+	 * @return true if clock parameters are resolved
+	 */
+	bool valid() const
+	{
+		return m_valid;
+	}
+
+	/**
+	 * Index of the current positive clock edge
+	 * (valid only in the delta cycle of a positive edge)
+	 * @return clock cycle number
+	 */
+	uint64_t cycle() const
+	{
+		return (sc_time_stamp().value() - m_first) / m_period;
+	}
+
+	/**
+	 * Index of the positive clock edge that plain wait() on clock resumes at
+	 * @return clock cycle number
+	 */
+	uint64_t next_cycle() const
+	{
+		const uint64_t now = sc_time_stamp().value();
+		if(now < m_first)
+			return 0;
+
+		const uint64_t n = (now - m_first) / m_period;
+		if((now - m_first) % m_period)
+			return n + 1;
+
+		// Positive edge at this time is still pending if clock is low
+		return m_clk.read() ? n + 1 : n;
+	}
+
+	/**
+	 * Sleep until any of events is triggered and resume on a positive
+	 * clock edge. Calling process must be a thread.
+	 * @param events event or list of events to wait for
+	 * @return number of positive clock edges skipped before the one
+	 *         the process resumed at
+	 */
+	template<typename EV>
+	uint64_t sleep(const EV& events)
+	{
+		const uint64_t next = next_cycle();
+
+		vxe_profiler::wait(events);
+		if(!m_clk.posedge())
+			vxe_profiler::wait(m_clk.posedge_event());
+
+		return cycle() - next;
+	}
+
+	/**
+	 * Wait for the next positive clock edge. If process is idle and helper
+	 * is valid then sleep until any of events is triggered instead.
+	 * Process must stay idle on skipped clock edges unless events are
+	 * triggered.
+	 * @param idle process is idle
+	 * @param events event or list of events to wake up on
+	 */
+	template<typename EV>
+	void wait_cycle(bool idle, const EV& events)
+	{
+		if(idle && m_valid)
+			sleep(events);
+		else
+			vxe_profiler::wait();
+	}
+
+	/**
+	 * Enable or disable event-driven sleeping globally
+	 * (must be called before simulation start)
+	 * @param enable =false to poll on every clock edge
+	 */
+	static void set_enabled(bool enable)
+	{
+		enabled() = enable;
+	}
+
+	/**
+	 * Check if event-driven sleeping is enabled globally
+	 * @return reference to global flag
+	 */
+	static bool& enabled()
+	{
+		static bool s_enabled = true;
+		return s_enabled;
+	}
+
+private:
+	sc_in<bool>& m_clk;	// Clock input
+	bool m_valid;		// Clock parameters are resolved
+	uint64_t m_period;	// Clock period (in time resolution units)
+	uint64_t m_first;	// First positive edge time (in time resolution units)
+};
@@ -36,6 +36,10 @@ namespace vxe {
 	// Hardware ID
 	static constexpr uint32_t VXENGINE_ID	= 0xFEFEFAFA;
 
+	// Limits of the instruction destination field
+	static constexpr unsigned MAX_VPUS		= 32;	// 5-bit VPU number
+	static constexpr unsigned MAX_VPU_THREADS	= 8;	// 3-bit thread id
+
 	// Register indexes
 	namespace regi {
 		static constexpr unsigned REG_ID			= 0;	// HW ID (r/o)
@@ -89,7 +93,7 @@ namespace vxe {
 		static constexpr unsigned REG_FAULT_INSTR_ADDR_HI	= 0x000000FF;
 		static constexpr unsigned REG_FAULT_INSTR_LO		= 0xFFFFFFFF;
 		static constexpr unsigned REG_FAULT_INSTR_HI		= 0x000000FF;
-		static constexpr unsigned REG_FAULT_VPU_MASK0		= 0x00000003;
+		static constexpr unsigned REG_FAULT_VPU_MASK0		= 0xFFFFFFFF;
 		static constexpr unsigned REGS_NUMBER			= regi::REGS_NUMBER;
 	} // namespace regm
 
@@ -144,7 +148,7 @@ namespace vxe {
 			static constexpr unsigned ERR_DATA_SHIFT	= 0x00000003;
 		} // namespace REG_INTR_RAW
 
-		// Faulted VPUs mask
+		// Faulted VPUs mask (bit N is set for faulted VPU N)
 		namespace REG_FAULT_VPU_MASK0 {
 			static constexpr unsigned FAULTED_VPU0_MASK	= 0x00000001;
 			static constexpr unsigned FAULTED_VPU0_SHIFT	= 0x00000000;
@@ -209,6 +213,24 @@ namespace vxe {
 		 *  | 1 | 0 | 0 | 1 | 0 |  - ACTF
 		 */
 
+		// Get VPU number from destination field
+		inline unsigned dst_vpu(unsigned dst)
+		{
+			return (dst >> 3) & 0x1Fu;
+		}
+
+		// Get VPU local thread id from destination field
+		inline unsigned dst_thread(unsigned dst)
+		{
+			return dst & 0x7u;
+		}
+
+		// Make destination field from VPU number and VPU local thread id
+		inline unsigned make_dst(unsigned vpu, unsigned thread)
+		{
+			return ((vpu & 0x1Fu) << 3) | (thread & 0x7u);
+		}
+
 		// Generic instruction (it's not a real instruction)
 		union generic {
 			struct {
@@ -438,8 +460,7 @@ namespace vxe {
 			prod(unsigned _dst_vpu)
 				: _z0(0), op(OP)
 			{
-				dst = ((_dst_vpu & 1) << 3) | 0x1;
-				/* (_dst_vpu & 1) - only two VPUs supported */
+				dst = ((_dst_vpu & 0x1F) << 3) | 0x1;
 			}
 
 			operator uint64_t() const { return u64; }
@@ -460,8 +481,7 @@ namespace vxe {
 			store(unsigned _dst_vpu)
 				: _z0(0), op(OP)
 			{
-				dst = ((_dst_vpu & 1) << 3) | 0x1;
-				/* (_dst_vpu & 1) - only two VPUs supported */
+				dst = ((_dst_vpu & 0x1F) << 3) | 0x1;
 			}
 
 			operator uint64_t() const { return u64; }
@@ -508,8 +528,7 @@ namespace vxe {
 			relu(unsigned _dst_vpu)
 				: _z0(0), op(OP)
 			{
-				dst = ((_dst_vpu & 1) << 3) | 0x1;
-				/* (_dst_vpu & 1) - only two VPUs supported */
+				dst = ((_dst_vpu & 0x1F) << 3) | 0x1;
 			}
 
 			operator uint64_t() const { return u64; }
@@ -534,8 +553,7 @@ namespace vxe {
 			lrelu(int e) : ed(0x7F & e), _z1(0), af(AF), _z0(0), dst(0), op(OP) {}
 			lrelu(int e, unsigned _dst_vpu) : ed(0x7F & e), _z1(0), af(AF), _z0(0), op(OP)
 			{
-				dst = ((_dst_vpu & 1) << 3) | 0x1;
-				/* (_dst_vpu & 1) - only two VPUs supported */
+				dst = ((_dst_vpu & 0x1F) << 3) | 0x1;
 			}
 
 			operator uint64_t() const { return u64; }
@@ -27,15 +27,25 @@
  * VxEngine Control Unit
  */
 
+#include <algorithm>
+#include <functional>
 #include <iostream>
+#include <string>
+#include <vector>
 #include <systemc.h>
 #include "register_set.hxx"
 #include "vxe_common.hxx"
 #include "vxe_internal.hxx"
+#include "vxe_clock_sync.hxx"
+#include "vxe_profiler.hxx"
+#include "checkpoint.hxx"
+#include "vxe_tracer.hxx"
 
 
 // VxEngine Control Unit
-SC_MODULE(vxe_ctrl_unit) {
+VXE_MODULE(vxe_ctrl_unit) {
+	static constexpr unsigned CMD_BATCH_MAX = 16;	// Maximum commands in a batch
+
 	sc_in<bool> clk;
 	sc_in<bool> nrst;
 
@@ -50,37 +60,39 @@ SC_MODULE(vxe_ctrl_unit) {
 	// Interrupt request signal
 	sc_out<bool> o_intr;
 
-	// VPUs status and command buses signals
-	sc_in<bool> i_vpu0_busy;
-	sc_in<bool> i_vpu1_busy;
-	sc_in<bool> i_vpu0_err;
-	sc_in<bool> i_vpu1_err;
-	sc_out<bool> o_cmd_select_vpu0;
-	sc_in<bool> i_cmd_ack_vpu0;
-	sc_out<uint8_t> o_cmd_op_vpu0;
-	sc_out<uint8_t> o_cmd_thread_vpu0;
-	sc_out<uint64_t> o_cmd_wdata_vpu0;
-	sc_out<bool> o_cmd_select_vpu1;
-	sc_in<bool> i_cmd_ack_vpu1;
-	sc_out<uint8_t> o_cmd_op_vpu1;
-	sc_out<uint8_t> o_cmd_thread_vpu1;
-	sc_out<uint64_t> o_cmd_wdata_vpu1;
+	// VPUs status and command buses signals (one per VPU)
+	sc_vector<sc_in<bool>> i_vpu_busy;
+	sc_vector<sc_in<bool>> i_vpu_err;
+	sc_vector<sc_out<bool>> o_cmd_select;
+	sc_vector<sc_in<bool>> i_cmd_ack;
+	sc_vector<sc_out<uint8_t>> o_cmd_op;
+	sc_vector<sc_out<uint8_t>> o_cmd_thread;
+	sc_vector<sc_out<uint64_t>> o_cmd_wdata;
 
 	SC_HAS_PROCESS(vxe_ctrl_unit);
 
-	vxe_ctrl_unit(::sc_core::sc_module_name name, unsigned client_id, register_set_if<uint32_t>& regs)
-		: ::sc_core::sc_module(name), clk("clk"), nrst("nrst")
+	/**
+	 * Constructor
+	 * @param name module name
+	 * @param client_id memory hub client id
+	 * @param regs VxE register file
+	 * @param vpus number of VPUs
+	 */
+	vxe_ctrl_unit(::sc_core::sc_module_name name, unsigned client_id, register_set_if<uint32_t>& regs,
+			unsigned vpus = 2)
+		: vxe_prof_module(name), clk("clk"), nrst("nrst")
 		, mem_fifo_in("mem_fifo_in"), mem_fifo_out("mem_fifo_out")
 		, i_start("i_start"), o_busy("o_busy")
 		, o_intr("o_intr")
-		, i_vpu0_busy("i_vpu0_busy"), i_vpu1_busy("i_vpu1_busy")
-		, i_vpu0_err("i_vpu0_err"), i_vpu1_err("i_vpu1_err")
-		, o_cmd_select_vpu0("o_cmd_select_vpu0"), i_cmd_ack_vpu0("i_cmd_ack_vpu0")
-		, o_cmd_op_vpu0("o_cmd_op_vpu0"), o_cmd_thread_vpu0("o_cmd_thread_vpu0")
-		, o_cmd_wdata_vpu0("o_cmd_wdata_vpu0"), o_cmd_select_vpu1("o_cmd_select_vpu1")
-		, i_cmd_ack_vpu1("i_cmd_ack_vpu1"), o_cmd_op_vpu1("o_cmd_op_vpu1")
-		, o_cmd_thread_vpu1("o_cmd_thread_vpu1"), o_cmd_wdata_vpu1("o_cmd_wdata_vpu1")
-		, m_client_id(client_id), m_regs(regs)
+		, i_vpu_busy("i_vpu_busy", vpus), i_vpu_err("i_vpu_err", vpus)
+		, o_cmd_select("o_cmd_select", vpus), i_cmd_ack("i_cmd_ack", vpus)
+		, o_cmd_op("o_cmd_op", vpus), o_cmd_thread("o_cmd_thread", vpus)
+		, o_cmd_wdata("o_cmd_wdata", vpus)
+		, m_client_id(client_id), m_regs(regs), m_vpus(vpus)
+		, out_rqs_fifo("out_rqs_fifo"), vpu_instr_fifo("vpu_instr_fifo", vpus)
+		, m_posted_ints(0)
+		, m_cmd_chan(vpus, nullptr), m_cmd_batch(vpus), m_cmd_pending(vpus, 0)
+		, m_cmd_batches(0), m_cmd_count(0), m_vpu_faulted(vpus, false)
 	{
 		SC_THREAD(instr_fetch_thread);
 			sensitive << clk.pos();
@@ -88,11 +100,13 @@ SC_MODULE(vxe_ctrl_unit) {
 		SC_THREAD(instr_exec_thread);
 			sensitive << clk.pos();
 
-		SC_THREAD(vpu0_exec_thread);
-			sensitive << clk.pos();
-
-		SC_THREAD(vpu1_exec_thread);
-			sensitive << clk.pos();
+		// VPU instructions execution threads
+		for(unsigned v = 0; v < m_vpus; ++v) {
+			sc_spawn_options opts;
+			opts.set_sensitivity(&clk.pos());
+			sc_spawn(sc_bind(&vxe_ctrl_unit::vpu_exec_thread, this, v),
+				("vpu" + std::to_string(v) + "_exec_thread").c_str(), &opts);
+		}
 
 		SC_THREAD(intr_thread);
 			sensitive << clk.pos();
@@ -104,6 +118,125 @@ SC_MODULE(vxe_ctrl_unit) {
 			sensitive << s_ifetch_busy;
 	}
 
+	/**
+	 * Notify that active interrupts were acknowledged through REG_INTR_ACT
+	 * (wakes up interrupt logic if it sleeps)
+	 */
+	void notify_intr_ack()
+	{
+		m_intr_ack_event.notify();
+	}
+
+	/**
+	 * Save internal registers (unit must be idle)
+	 * @param wr checkpoint writer
+	 */
+	void save_state(ckpt::writer& wr) const
+	{
+		wr.put_tag("CU  ");
+		wr.put(m_pgm_counter);
+	}
+
+	/**
+	 * Restore internal registers (unit must be idle)
+	 * @param rd checkpoint reader
+	 * @return true on success
+	 */
+	bool load_state(ckpt::reader& rd)
+	{
+		return rd.expect_tag("CU  ") && rd.get(m_pgm_counter);
+	}
+
+	/**
+	 * Program counter (unit must be idle)
+	 */
+	uint64_t pgm_counter() const { return m_pgm_counter; }
+
+	/**
+	 * Set program counter (unit must be idle)
+	 * @param pc program counter
+	 */
+	void set_pgm_counter(uint64_t pc) { m_pgm_counter = pc; }
+
+	/**
+	 * Raise interrupts on behalf of the functional model (unit must be idle)
+	 * @param ints raw interrupts (REG_INTR_ACT bits)
+	 */
+	void post_intr(uint32_t ints)
+	{
+		m_posted_ints |= ints;
+		m_intr_ack_event.notify();
+	}
+
+	/**
+	 * Reset internal registers (unit must be idle)
+	 */
+	void reset_state()
+	{
+		m_pgm_counter = 0;
+	}
+
+	/**
+	 * Set hook called when PROD instruction is forwarded to VPU threads
+	 * @param hook function receiving VPU number and VPU local thread id
+	 */
+	void set_prod_hook(std::function<void(unsigned, unsigned)> hook)
+	{
+		m_prod_hook = std::move(hook);
+	}
+
+	/**
+	 * Set transaction-level command channel to VPU. Queued VPU
+	 * instructions are sent as batches instead of command bus handshakes.
+	 * @param vpu_no VPU number
+	 * @param chan VPU command channel (nullptr to use command bus signals)
+	 */
+	void set_cmd_channel(unsigned vpu_no, vxe::vpu_cmd_if *chan)
+	{
+		if(vpu_no < m_vpus)
+			m_cmd_chan[vpu_no] = chan;
+		else
+			std::cerr << name() << ": invalid vpu_no for set_cmd_channel!" << std::endl;
+	}
+
+	/**
+	 * Number of VPUs
+	 */
+	unsigned vpus() const { return m_vpus; }
+
+	/**
+	 * Number of command batches sent through transaction-level channels
+	 */
+	uint64_t cmd_batches() const { return m_cmd_batches; }
+
+	/**
+	 * Number of commands sent through transaction-level channels
+	 */
+	uint64_t cmd_count() const { return m_cmd_count; }
+
+	/**
+	 * Register trace probes
+	 * @param tr tracer
+	 */
+	void trace_probes(vxe_tracer& tr) const
+	{
+		const std::string n = name();
+
+		tr.add_signal(o_busy);
+		tr.add_signal(o_intr);
+		tr.add_signal(s_ifetch_busy, n + ".s_ifetch_busy");
+		tr.add_signal(s_ifetch_stop, n + ".s_ifetch_stop");
+		tr.add_signal(s_iexec_busy, n + ".s_iexec_busy");
+		tr.add_signal(s_sync_intr, n + ".s_sync_intr");
+		tr.add_signal(s_err_fetch_intr, n + ".s_err_fetch_intr");
+		tr.add_signal(s_err_instr_intr, n + ".s_err_instr_intr");
+		tr.add_signal(s_vpu_err, n + ".s_vpu_err");
+		tr.add_fifo(out_rqs_fifo);
+		for(const auto& f : vpu_instr_fifo)
+			tr.add_fifo(f);
+		tr.add(n + ".pgm_counter", 64, [this]() -> uint64_t { return m_pgm_counter; });
+	}
+
 private:
 
 	/**
@@ -112,13 +245,18 @@ private:
 	 */
 	[[noreturn]] void instr_fetch_thread()
 	{
+		bool idle = false;
+		vxe_clock_sync clk_sync(clk);
+		clk_sync.init();
+
 		while(true) {
 			s_ifetch_busy.write(false);
 
 			// Wait for start trigger
-			wait();
+			clk_sync.wait_cycle(idle, i_start.value_changed_event());
 
-			if(!i_start.read())
+			idle = !i_start.read();
+			if(idle)
 				continue;
 
 			// Check for logic error
@@ -134,6 +272,10 @@ private:
 			uint64_t pgm_hi = m_regs.get_reg(vxe::regi::REG_PGM_ADDR_HI);
 			m_pgm_counter = (pgm_hi << 32u) | pgm_lo;
 
+			// Clear faulted VPUs mask
+			m_regs.set_reg(vxe::regi::REG_FAULT_VPU_MASK0, 0);
+			std::fill(m_vpu_faulted.begin(), m_vpu_faulted.end(), false);
+
 			while(!s_ifetch_stop.read()) {
 				// Prepare request
 				vxe::vxe_mem_rq rq;
@@ -181,103 +323,93 @@ private:
 	 */
 	bool send_vpu_instr(unsigned vpu_no, uint8_t cmd, uint8_t thread, uint64_t wdata)
 	{
-		if(vpu_no == 0) {
-			// Send to VPU0
-			o_cmd_select_vpu0.write(true);
-			o_cmd_op_vpu0.write(cmd);
-			o_cmd_thread_vpu0.write(thread);
-			o_cmd_wdata_vpu0.write(wdata);
-			wait();	// Wait for next positive edge
-
-			// De-assert select signals
-			o_cmd_select_vpu0.write(false);
-
-			// Wait for acknowledgement from VPU
-			bool ack = false;
-			bool err = false;
-			while(!ack) {
-				ack = i_cmd_ack_vpu0.read();
-				err = i_vpu0_err.read();
-				wait();
-			}
-
-			return err;
-		} else if(vpu_no == 1) {
-			// Send to VPU1
-			o_cmd_select_vpu1.write(true);
-			o_cmd_op_vpu1.write(cmd);
-			o_cmd_thread_vpu1.write(thread);
-			o_cmd_wdata_vpu1.write(wdata);
-			wait();	// Wait for next positive edge
-
-			// De-assert select signals
-			o_cmd_select_vpu1.write(false);
-
-			// Wait for acknowledgement from VPU
-			bool ack = false;
-			bool err = false;
-			while(!ack) {
-				ack = i_cmd_ack_vpu1.read();
-				err = i_vpu1_err.read();
-				wait();
-			}
-
-			return err;
-		} else {
+		if(vpu_no >= m_vpus) {
 			std::cerr << name() << ": invalid vpu_no for send_vpu_instr!"
 				<< std::endl;
 			return true;
 		}
-	}
 
-	/**
-	 * Wait while VPUs are busy
-	 */
-	void wait_for_vpus()
-	{
-		while((i_vpu0_busy.read() || vpu0_instr_fifo.num_available() != 0)
-			|| (i_vpu1_busy.read() || vpu1_instr_fifo.num_available() != 0))
+		o_cmd_select[vpu_no].write(true);
+		o_cmd_op[vpu_no].write(cmd);
+		o_cmd_thread[vpu_no].write(thread);
+		o_cmd_wdata[vpu_no].write(wdata);
+		wait();	// Wait for next positive edge
+
+		// De-assert select signals
+		o_cmd_select[vpu_no].write(false);
+
+		// Wait for acknowledgement from VPU
+		bool ack = false;
+		bool err = false;
+		while(!ack) {
+			ack = i_cmd_ack[vpu_no].read();
+			err = i_vpu_err[vpu_no].read();
 			wait();
+		}
+
+		return err;
 	}
 
 	/**
-	 * Get VPU number from dst field of the instruction
-	 * @param dst destination
-	 * @return VPU number 0 or 1
+	 * Send queued instructions to VPU as a batch through transaction-level channel
+	 * @param vpu_no VPU number
+	 * @param fifo VPU instructions FIFO
+	 * @param vpug first instruction (already read from FIFO)
+	 * @return true if VPU reported an error (commands after the failed one are not executed)
 	 */
-	unsigned vpu_number(unsigned dst)
+	bool send_vpu_batch(unsigned vpu_no, vxe_fifo<vxe::instr::generic_vpu>& fifo,
+		vxe::instr::generic_vpu vpug)
 	{
-		return (dst & 0x8u ? 1 : 0);
+		std::vector<vxe::vpu_cmd>& batch = m_cmd_batch[vpu_no];
+
+		batch.clear();
+		do {
+			batch.push_back({ uint8_t(vpug.op), uint8_t(vxe::instr::dst_thread(vpug.dst)), vpug.pl });
+		} while(batch.size() < CMD_BATCH_MAX && fifo.nb_read(vpug));
+
+		m_cmd_pending[vpu_no] = batch.size();
+		const bool err = m_cmd_chan[vpu_no]->exec_cmds(batch.data(), batch.size());
+		m_cmd_pending[vpu_no] = 0;
+
+		++m_cmd_batches;
+		m_cmd_count += batch.size();
+
+		return err;
 	}
 
 	/**
-	 * Check if destination is VPU0
-	 * @param dst destination
-	 * @return true if destination is VPU0
+	 * Check if VPUs are busy or have pending instructions
+	 * @return true if any of VPUs is busy
 	 */
-	bool is_vpu0_dst(unsigned dst)
+	bool vpus_busy() const
 	{
-		return vpu_number(dst) == 0;
+		for(unsigned v = 0; v < m_vpus; ++v) {
+			if(i_vpu_busy[v].read() || vpu_instr_fifo[v].num_available() != 0 || m_cmd_pending[v])
+				return true;
+		}
+		return false;
 	}
 
 	/**
-	 * Check if destination is VPU1
-	 * @param dst destination
-	 * @return true if destination VPU1
+	 * Check if any of VPUs reports an error
+	 * @return true if error is reported
 	 */
-	bool is_vpu1_dst(unsigned dst)
+	bool vpus_err() const
 	{
-		return vpu_number(dst) == 1;
+		for(unsigned v = 0; v < m_vpus; ++v) {
+			if(i_vpu_err[v].read())
+				return true;
+		}
+		return false;
 	}
 
 	/**
-	 * Get VPU local thread id from dst field of the instruction
-	 * @param dst destination
-	 * @return VPU local thread id
+	 * Wait while VPUs are busy
 	 */
-	unsigned vpu_local_tid(unsigned dst)
+	void wait_for_vpus()
 	{
-		return dst & 0x7u;
+		while(vpus_busy())
+			wait();
 	}
 
 	/**
@@ -327,8 +459,8 @@ private:
 	 */
 	void fwd_vpu_instr(const vxe::instr::generic_vpu& vpug)
 	{
-		bool vpu0 = false;
-		bool vpu1 = false;
+		const unsigned vpu_no = vxe::instr::dst_vpu(vpug.dst);
+		bool broadcast = false;
 
 		// Route instruction
 		switch(vpug.op) {
@@ -339,30 +471,34 @@ private:
 			case vxe::instr::setrt::OP:
 			case vxe::instr::setrd::OP:
 			case vxe::instr::seten::OP:
-				vpu0 = is_vpu0_dst(vpug.dst);
-				vpu1 = is_vpu1_dst(vpug.dst);
 				break;
 			// Can broadcast subclass of instructions
 			case vxe::instr::prod::OP:
 			case vxe::instr::store::OP:
 			case vxe::instr::generic_af::OP:
-				if(!is_vpu_broadcast(vpug.dst)) {
-					vpu0 = is_vpu0_dst(vpug.dst);
-					vpu1 = is_vpu1_dst(vpug.dst);
-				} else {
-					vpu0 = vpu1 = true;
-				}
+				broadcast = is_vpu_broadcast(vpug.dst);
 				break;
 			default:
 				invalid_instruction();
-				break;
+				return;
+		}
+
+		// Destination VPU must exist
+		if(!broadcast && vpu_no >= m_vpus) {
+			invalid_instruction();
+			return;
 		}
 
-		if(vpu0)
-			vpu0_instr_fifo.write(vpug);
+		const unsigned first = broadcast ? 0 : vpu_no;
+		const unsigned last = broadcast ? m_vpus : vpu_no + 1;
 
-		if(vpu1)
-			vpu1_instr_fifo.write(vpug);
+		if(m_prod_hook && vpug.op == vxe::instr::prod::OP) {
+			for(unsigned v = first; v < last; ++v)
+				m_prod_hook(v, vxe::instr::dst_thread(vpug.dst));
+		}
+
+		for(unsigned v = first; v < last; ++v)
+			vpu_instr_fifo[v].write(vpug);
 	}
 
 	/**
@@ -454,28 +590,30 @@ private:
 	}
 
 	/**
-	 * VPU0 instructions execution thread
+	 * VPU instructions execution thread
 	 * Receives instruction stream from an internal FIFO
+	 * @param vpu_no VPU number
 	 */
-	[[noreturn]] void vpu0_exec_thread()
+	[[noreturn]] void vpu_exec_thread(unsigned vpu_no)
 	{
-		while(true) {
-			vxe::instr::generic_vpu vpug = vpu0_instr_fifo.read();
-			if(!s_vpu_err.read())
-				send_vpu_instr(0, vpug.op, vpu_local_tid(vpug.dst), vpug.pl);
-		}
-	}
+		vxe_fifo<vxe::instr::generic_vpu>& fifo = vpu_instr_fifo[vpu_no];
 
-	/**
-	 * VPU1 instructions execution thread
-	 * Receives instruction stream from an internal FIFO
-	 */
-	[[noreturn]] void vpu1_exec_thread()
-	{
 		while(true) {
-			vxe::instr::generic_vpu vpug = vpu1_instr_fifo.read();
-			if(!s_vpu_err.read())
-				send_vpu_instr(1, vpug.op, vpu_local_tid(vpug.dst), vpug.pl);
+			vxe::instr::generic_vpu vpug = fifo.read();
+			// Error is seen on s_vpu_err one cycle later, faulted VPU is not
+			// sent any further instructions of the program
+			if(s_vpu_err.read() || m_vpu_faulted[vpu_no])
+				continue;
+			bool err;
+			if(m_cmd_chan[vpu_no])
+				err = send_vpu_batch(vpu_no, fifo, vpug);
+			else
+				err = send_vpu_instr(vpu_no, vpug.op, vxe::instr::dst_thread(vpug.dst), vpug.pl);
+			if(err) {
+				m_vpu_faulted[vpu_no] = true;
+				while(fifo.nb_read(vpug))
+					;	// Drop queued instructions
+			}
 		}
 	}
 
@@ -484,17 +622,30 @@ private:
 	 */
 	[[noreturn]] void intr_thread()
 	{
+		bool idle = false;
+		vxe_clock_sync clk_sync(clk);
+		clk_sync.init();
+		sc_event_or_list wakeup;	// Events to wake up from idle state
+		wakeup |= s_sync_intr.value_changed_event();
+		wakeup |= s_err_fetch_intr.value_changed_event();
+		wakeup |= s_err_instr_intr.value_changed_event();
+		for(const auto& err : i_vpu_err)
+			wakeup |= err.value_changed_event();
+		wakeup |= m_intr_ack_event;
+
 		o_intr.write(false);	// Initialize to low
 
 		while(true) {
-			wait();	// wait for clock positive edge
+			// Wait for clock positive edge. Sleep if no interrupt conditions
+			// were seen and registers were not changed since last update.
+			clk_sync.wait_cycle(idle, wakeup);
 
 			uint32_t new_ints = 0;		// Newly triggered raw interrupts
 			uint32_t new_ints_masked;	// New active interrupts
 			// Read interrupt condition signals
 			bool sync = s_sync_intr.read();
 			bool err_fetch = s_err_fetch_intr.read();
-			bool err_instr = s_err_instr_intr.read() || i_vpu0_err.read() || i_vpu1_err.read();
+			bool err_instr = s_err_instr_intr.read() || vpus_err();
 
 			// Form raw interrupts register value
 			new_ints = vxe::setbits(new_ints, (sync ? 1u : 0u),
@@ -504,6 +655,10 @@ private:
 			new_ints = vxe::setbits(new_ints, (err_instr ? 1u : 0u),
 				vxe::bits::REG_INTR_ACT::ERR_INSTR_MASK, vxe::bits::REG_INTR_ACT::ERR_INSTR_SHIFT);
 
+			// Add interrupts posted by functional model
+			new_ints |= m_posted_ints;
+			m_posted_ints = 0;
+
 			// Apply interrupt mask
 			new_ints_masked = new_ints & ~m_regs.get_reg(vxe::regi::REG_INTR_MSK);
 
@@ -517,6 +672,8 @@ private:
 
 			// Update interrupt signal
 			o_intr.write(new_ints_masked != 0);
+
+			idle = !(sync || err_fetch || err_instr);
 		}
 	}
 
@@ -525,16 +682,29 @@ private:
 	 */
 	[[noreturn]] void vpu_error_thread()
 	{
+		vxe_clock_sync clk_sync(clk);
+		clk_sync.init();
+		sc_event_or_list wakeup;	// Events to wake up from idle state
+		for(const auto& err : i_vpu_err)
+			wakeup |= err.value_changed_event();
+
 		while(true) {
 			s_vpu_err.write(false);
 
-			if(i_vpu0_err.read() || i_vpu1_err.read()) {
+			if(vpus_err()) {
 				s_vpu_err.write(true);
+				// Record faulted VPUs
+				uint32_t mask = m_regs.get_reg(vxe::regi::REG_FAULT_VPU_MASK0);
+				for(unsigned v = 0; v < m_vpus; ++v) {
+					if(i_vpu_err[v].read())
+						mask |= 1u << v;
+				}
+				m_regs.set_reg(vxe::regi::REG_FAULT_VPU_MASK0, mask);
 				do {
 					wait();
 				} while(o_busy.read());
 			} else
-				wait();
+				clk_sync.wait_cycle(true, wakeup);	// Sleep until error is reported
 		}
 	}
 
@@ -543,11 +713,10 @@ private:
 	 */
 	void busy_logic_method()
 	{
+		vxe_profiler::scope prof;
 		bool busy;
-		bool vpus_busy = (i_vpu0_busy.read() || vpu0_instr_fifo.num_available() != 0)
-			|| (i_vpu1_busy.read() || vpu1_instr_fifo.num_available() != 0);
 
-		if(s_ifetch_busy.read() || vpus_busy)
+		if(s_ifetch_busy.read() || vpus_busy())
 			busy = true;
 		else
 			busy = false;
@@ -566,6 +735,8 @@ private:
 	const unsigned m_client_id;
 	// VxE register file
 	register_set_if<uint32_t>& m_regs;
+	// Number of VPUs
+	const unsigned m_vpus;
 	// Internal control signals
 	sc_signal<bool> s_ifetch_busy;
 	sc_signal<bool> s_ifetch_stop;
@@ -575,9 +746,22 @@ private:
 	sc_signal<bool> s_err_instr_intr;
 	sc_signal<bool> s_vpu_err;
 	// Internal control FIFOs
-	sc_fifo<bool> out_rqs_fifo;
-	sc_fifo<vxe::instr::generic_vpu> vpu0_instr_fifo;
-	sc_fifo<vxe::instr::generic_vpu> vpu1_instr_fifo;
+	vxe_fifo<bool> out_rqs_fifo;
+	sc_vector<vxe_fifo<vxe::instr::generic_vpu>> vpu_instr_fifo;
+	// Interrupts acknowledge event
+	sc_event m_intr_ack_event;
+	// Interrupts posted by functional model
+	uint32_t m_posted_ints;
 	// Internal registers
 	uint64_t m_pgm_counter;
+	// PROD instruction hook
+	std::function<void(unsigned, unsigned)> m_prod_hook;
+	// Transaction-level command channels
+	std::vector<vxe::vpu_cmd_if*> m_cmd_chan;		// VPU command channels (nullptr if not used)
+	std::vector<std::vector<vxe::vpu_cmd>> m_cmd_batch;	// Batches in flight
+	std::vector<unsigned> m_cmd_pending;			// Number of commands in flight
+	uint64_t m_cmd_batches;				// Sent batches
+	uint64_t m_cmd_count;				// Sent commands
+	// VPUs which reported an error in current program
+	std::vector<bool> m_vpu_faulted;
 };
@@ -29,14 +29,16 @@
 
 #include <cstdint>
 #include <iostream>
-#include <list>
 #include <systemc.h>
+#include "vxe_clock_sync.hxx"
+#include "vxe_ring.hxx"
+#include "vxe_profiler.hxx"
 #pragma once
 
 
-// FIFO 64x32
+// FIFO 64x32 (DEPTH is storage capacity, actual depth can be set on construction)
 template<unsigned DEPTH>
-SC_MODULE(vxe_fifo64x32) {
+VXE_MODULE(vxe_fifo64x32) {
 	sc_in<bool> clk;
 	sc_in<bool> nrst;
 
@@ -49,12 +51,27 @@ SC_MODULE(vxe_fifo64x32) {
 	sc_out<bool> o_empty;
 	sc_out<uint32_t> o_data;
 
-	SC_CTOR(vxe_fifo64x32)
-		: clk("clk"), nrst("nrst"), i_data("i_data"), i_write("i_write"), i_valid("i_valid")
+	SC_HAS_PROCESS(vxe_fifo64x32);
+
+	/**
+	 * Constructor
+	 * @param name module name
+	 * @param depth FIFO depth (1 to DEPTH)
+	 */
+	vxe_fifo64x32(::sc_core::sc_module_name name, unsigned depth = DEPTH)
+		: vxe_prof_module(name)
+		, clk("clk"), nrst("nrst"), i_data("i_data"), i_write("i_write"), i_valid("i_valid")
 		, o_full("o_full"), i_read("i_read"), o_empty("o_empty"), o_data("o_data")
+		, m_depth(depth)
 	{
 		static_assert(DEPTH > 0, "DEPTH cannot be 0!");
 
+		if(m_depth == 0 || m_depth > DEPTH) {
+			std::cerr << this->name() << ": invalid depth " << m_depth << ", using "
+				<< DEPTH << "!" << std::endl;
+			m_depth = DEPTH;
+		}
+
 		SC_THREAD(fifo_thread);
 			sensitive << clk.pos();
 	}
@@ -62,14 +79,22 @@ SC_MODULE(vxe_fifo64x32) {
 private:
 	[[noreturn]] void fifo_thread()
 	{
+		vxe_clock_sync sync(clk);
+		sync.init();
+		sc_event_or_list wakeup;	// Events to wake up from idle state
+		wakeup |= i_write.value_changed_event();
+		wakeup |= i_read.value_changed_event();
+		wakeup |= nrst.value_changed_event();
+
 		while(true) {
 			do {
 				if(!nrst.read()) {
-					m_fifo.resize(0);
-					o_full.write(m_fifo.size() == DEPTH);
+					m_fifo.clear();
+					o_full.write(full());
 					o_empty.write(m_fifo.empty());
 				}
-				wait();
+				// Sleep while there are no writes and reads
+				sync.wait_cycle(nrst.read() && !i_write.read() && !i_read.read(), wakeup);
 			} while(!nrst.read());
 
 			bool ignore_wr = false;
@@ -77,7 +102,7 @@ private:
 
 			// Error checking - write operation
 			if(i_write.read()) {
-				if(m_fifo.size() == DEPTH) {
+				if(full()) {
 					std::cerr << name() << ": write to full FIFO!" << std::endl;
 					ignore_wr = true;
 				}
@@ -105,12 +130,12 @@ private:
 				v = i_valid.read();
 				d.v[0] = ((v & 0x1u) != 0);
 				d.v[1] = ((v & 0x2u) != 0);
-				m_fifo.push_front(d);
+				m_fifo.push(d);
 			}
 
 			// Handle read
 			if(!ignore_rd) {
-				data_pair& d = m_fifo.back();
+				data_pair& d = m_fifo.front();
 				if(d.v[0]) {
 					d.v[0] = false;
 				} else if(d.v[1]) {
@@ -118,13 +143,13 @@ private:
 				}
 
 				if(!d.v[0] && !d.v[1]) {
-					m_fifo.pop_back();
+					m_fifo.pop();
 				}
 			}
 
 			// Update output
 			if(!m_fifo.empty() && (!ignore_rd || !ignore_wr)) {
-				data_pair& d = m_fifo.back();
+				data_pair& d = m_fifo.front();
 				if(d.v[0]) {
 					o_data.write(d.u32[0]);
 				} else if(d.v[1]) {
@@ -133,11 +158,17 @@ private:
 			}
 
 			// Update state signals
-			o_full.write(m_fifo.size() == DEPTH);
+			o_full.write(full());
 			o_empty.write(m_fifo.empty());
 		}
 	}
 
+	// Returns true if FIFO reached its depth
+	bool full() const
+	{
+		return m_fifo.size() >= m_depth;
+	}
+
 private:
 	struct data_pair {
 		bool v[2];			// Valid bits for 32-bit words
@@ -148,5 +179,6 @@ private:
 		data_pair() { v[0] = v[1] = false; }
 	};
 
-	std::list<data_pair> m_fifo;
+	vxe_ring<data_pair, DEPTH> m_fifo;
+	unsigned m_depth;	// FIFO depth
 };
@@ -0,0 +1,570 @@
+/*
+ * Copyright (c) 2022 The VxEngine Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * VxEngine functional model
+ * Executes VxEngine programs instruction by instruction without clocked
+ * processes. Results are bit-exact with the detailed model: FMAC and ReLU
+ * use the same algorithmic models as hardware units.
+ * In parallel mode program is split into segments at SYNC instructions.
+ * Instructions of VPU N (N > 0) are executed on worker host thread N while
+ * VPU0 executes on the calling thread. Stores are buffered and committed at
+ * the end of segment. If VPUs access the same memory words within a segment
+ * the segment is re-executed sequentially, so results stay bit-exact.
+ */
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "vxe_common.hxx"
+#include "vxe_internal.hxx"
+#include "flp/hwfmac.hxx"
+#include "relu/hwrelu.hxx"
+#pragma once
+
+
+// VxEngine functional model
+template<unsigned NT>
+class vxe_func_model {
+public:
+	using vpu_state = vxe::vpu_arch_state<NT>;
+
+	// Memory mapper. Returns host pointer to a memory range or nullptr if range is not accessible.
+	using mem_map_fn = std::function<uint8_t*(uint64_t addr, uint64_t len)>;
+
+	// Program execution result
+	struct result {
+		uint32_t intr;		// Raised interrupts (REG_INTR_ACT bits)
+		uint64_t pgm_counter;	// Address of instruction following the last one
+		uint64_t instrs;	// Executed instructions
+		uint64_t data_errors;	// Inaccessible data vectors
+	};
+
+	// Parallel mode statistics
+	struct par_stats {
+		uint64_t segments;	// Executed program segments
+		uint64_t parallel;	// Segments executed by VPUs in parallel
+		uint64_t hazards;	// Segments re-executed sequentially due to memory hazards
+	};
+
+	// Maximum number of instructions in a segment
+	static constexpr unsigned SEGMENT_MAX_INSTRS = 4096;
+	// Minimum number of data instructions per VPU to run it on a separate host thread
+	static constexpr unsigned SEGMENT_MIN_DATA_OPS = 4;
+	// Maximum number of FMAC lanes
+	static constexpr unsigned MAX_LANES = 4;
+	// 1.0f (merge of partial accumulators)
+	static constexpr uint32_t FP32_ONE = 0x3F800000;
+
+	/**
+	 * Constructor
+	 * @param mem memory mapper
+	 * @param vpus number of VPUs
+	 * @param threads number of threads per VPU (1 to NT)
+	 * @param lanes number of FMAC lanes per VPU (1 to MAX_LANES)
+	 */
+	explicit vxe_func_model(mem_map_fn mem, unsigned vpus = 2, unsigned threads = NT,
+			unsigned lanes = 1)
+		: m_mem(std::move(mem)), m_vpus(std::max(vpus, 1u))
+		, m_threads(std::min(std::max(threads, 1u), NT))
+		, m_fmac_lanes(std::min(std::max(lanes, 1u), MAX_LANES))
+		, m_parallel(false), m_stats(), m_lanes(m_vpus), m_worker_stop(false)
+	{}
+
+	~vxe_func_model()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_worker_stop = true;
+		}
+		m_cv.notify_all();
+		for(auto& w : m_workers)
+			w->thread.join();
+	}
+
+	vxe_func_model(const vxe_func_model&) = delete;
+	vxe_func_model& operator=(const vxe_func_model&) = delete;
+
+	/**
+	 * Enable or disable parallel execution of VPUs. In parallel mode
+	 * memory mapper is called from several host threads at the same time.
+	 * @param enable true to enable
+	 */
+	void set_parallel(bool enable)
+	{
+		m_parallel = enable;
+	}
+
+	/**
+	 * Parallel execution enabled
+	 * @return true if enabled
+	 */
+	bool parallel() const
+	{
+		return m_parallel;
+	}
+
+	/**
+	 * Parallel mode statistics
+	 * @return statistics accumulated since construction
+	 */
+	const par_stats& stats() const
+	{
+		return m_stats;
+	}
+
+	/**
+	 * Number of VPUs
+	 */
+	unsigned vpus() const
+	{
+		return m_vpus;
+	}
+
+	/**
+	 * Run program until SYNC with stop bit or an error
+	 * @param pgm_addr program address
+	 * @param vpus states of VPUs (array of vpus() elements, updated)
+	 * @return execution result
+	 */
+	result run(uint64_t pgm_addr, vpu_state *vpus)
+	{
+		result r = { 0, pgm_addr, 0, 0 };
+
+		if(!m_parallel) {
+			while(step(vpus, r, nullptr))
+				;
+			return r;
+		}
+
+		bool running = true;
+		while(running) {
+			const result r0 = r;
+			unsigned n = 0;
+
+			// Decode segment up to the next SYNC
+			for(auto& ln : m_lanes)
+				ln.clear();
+			do {
+				running = step(vpus, r, m_lanes.data());
+				++n;
+			} while(running && n < SEGMENT_MAX_INSTRS && !m_seg_sync);
+
+			++m_stats.segments;
+			unsigned busy = 0;
+			for(const auto& ln : m_lanes)
+				busy += (ln.ops.size() >= SEGMENT_MIN_DATA_OPS ? 1 : 0);
+			if(busy < 2) {
+				running = replay(vpus, r0, n, r);
+				continue;
+			}
+
+			const std::vector<vpu_state> saved(vpus, vpus + m_vpus);
+
+			for(unsigned v = 1; v < m_vpus; ++v)
+				run_worker(v - 1, [this, vpus, v]{ execute(vpus[v], m_lanes[v]); });
+			execute(vpus[0], m_lanes[0]);
+			wait_workers();
+
+			if(hazard(r0.pgm_counter, r.pgm_counter)) {
+				std::copy(saved.begin(), saved.end(), vpus);
+				running = replay(vpus, r0, n, r);
+				++m_stats.hazards;
+				continue;
+			}
+
+			for(unsigned v = 0; v < m_vpus; ++v) {
+				for(const auto& w : m_lanes[v].writes)
+					memcpy(w.ptr, &w.data, sizeof(uint32_t));
+				r.data_errors += m_lanes[v].data_errors;
+			}
+			++m_stats.parallel;
+		}
+
+		return r;
+	}
+
+private:
+	// Buffered store
+	struct store_rec {
+		uint64_t addr;	// Guest address
+		uint8_t *ptr;	// Host pointer
+		uint32_t data;	// Stored value
+	};
+
+	// Per-VPU segment: decoded data instructions and memory accesses
+	struct lane {
+		std::vector<vxe::instr::generic_vpu> ops;		// Decoded VPU instructions
+		std::vector<store_rec> writes;				// Buffered stores
+		std::vector<std::pair<uint64_t, uint64_t>> reads;	// Read ranges [begin, end)
+		uint64_t data_errors;					// Inaccessible data vectors
+
+		void clear()
+		{
+			ops.clear();
+			writes.clear();
+			reads.clear();
+			data_errors = 0;
+		}
+	};
+
+	// Worker host thread
+	struct worker {
+		std::thread thread;		// Host thread
+		std::function<void()> job;	// Current job
+		bool done;			// Job completed
+	};
+
+	/**
+	 * Fetch and execute (or decode into lanes) one instruction
+	 * @param vpus VPU states
+	 * @param r execution result (updated)
+	 * @param lanes if not nullptr VPU instructions are appended to lanes
+	 * @return false if execution is completed
+	 */
+	bool step(vpu_state *vpus, result& r, lane *lanes)
+	{
+		m_seg_sync = false;
+
+		const uint8_t *p = m_mem(r.pgm_counter, sizeof(vxe::instr::generic));
+		if(!p) {
+			r.intr |= vxe::bits::REG_INTR_ACT::ERR_FETCH_MASK;
+			return false;
+		}
+
+		uint64_t raw;
+		memcpy(&raw, p, sizeof(raw));
+		vxe::instr::generic g(raw);
+		vxe::instr::generic_vpu vpug(g);
+
+		r.pgm_counter += sizeof(vxe::instr::generic);
+		++r.instrs;
+
+		switch(g.op) {
+			// CU instructions
+			case vxe::instr::nop::OP:
+				break;
+			case vxe::instr::sync::OP: {
+				vxe::instr::sync sync(g);
+				if(sync.intr)
+					r.intr |= vxe::bits::REG_INTR_ACT::COMPLETED_MASK;
+				if(sync.stop)
+					return false;
+				m_seg_sync = true;
+				break;
+			}
+			// Never broadcast VPU instructions
+			case vxe::instr::setacc::OP:
+			case vxe::instr::setvl::OP:
+			case vxe::instr::setrs::OP:
+			case vxe::instr::setrt::OP:
+			case vxe::instr::setrd::OP:
+			case vxe::instr::seten::OP: {
+				const unsigned v = vxe::instr::dst_vpu(vpug.dst);
+				const unsigned th = vxe::instr::dst_thread(vpug.dst);
+				// Destination thread must exist
+				if(v >= m_vpus || th >= m_threads) {
+					r.intr |= vxe::bits::REG_INTR_ACT::ERR_INSTR_MASK;
+					return false;
+				}
+				if(lanes)
+					lanes[v].ops.push_back(vpug);
+				else
+					set_reg(vpus[v], vpug.op, th, vpug.pl);
+				break;
+			}
+			// Can broadcast VPU instructions
+			case vxe::instr::prod::OP:
+			case vxe::instr::store::OP:
+			case vxe::instr::generic_af::OP: {
+				const bool broadcast = (vpug.dst & 0x1) == 0;
+				const unsigned v0 = broadcast ? 0 : vxe::instr::dst_vpu(vpug.dst);
+				const unsigned v1 = broadcast ? m_vpus : v0 + 1;
+				// Destination VPU must exist
+				if(v0 >= m_vpus) {
+					r.intr |= vxe::bits::REG_INTR_ACT::ERR_INSTR_MASK;
+					return false;
+				}
+				for(unsigned v = v0; v < v1; ++v) {
+					if(lanes)
+						lanes[v].ops.push_back(vpug);
+					else
+						data_op(vpus[v], vpug, r.data_errors, nullptr);
+				}
+				break;
+			}
+			default:
+				r.intr |= vxe::bits::REG_INTR_ACT::ERR_INSTR_MASK;
+				return false;
+		}
+
+		return true;
+	}
+
+	// Re-execute segment of n instructions sequentially starting from saved result,
+	// returns false if execution is completed
+	bool replay(vpu_state *vpus, const result& r0, unsigned n, result& r)
+	{
+		r = r0;
+		for(unsigned i = 0; i < n; ++i) {
+			if(!step(vpus, r, nullptr))
+				return false;
+		}
+		return true;
+	}
+
+	// Execute decoded instructions of a VPU with buffered stores
+	void execute(vpu_state& st, lane& ln)
+	{
+		for(const auto& vpug : ln.ops) {
+			switch(vpug.op) {
+				case vxe::instr::prod::OP:
+				case vxe::instr::store::OP:
+				case vxe::instr::generic_af::OP:
+					data_op(st, vpug, ln.data_errors, &ln);
+					break;
+				default:
+					set_reg(st, vpug.op, vxe::instr::dst_thread(vpug.dst), vpug.pl);
+					break;
+			}
+		}
+	}
+
+	// Check if a word at address overlaps any range
+	static bool overlaps(uint64_t addr, const std::vector<std::pair<uint64_t, uint64_t>>& ranges)
+	{
+		for(const auto& rg : ranges) {
+			if(addr < rg.second && addr + sizeof(uint32_t) > rg.first)
+				return true;
+		}
+		return false;
+	}
+
+	// Check memory accesses of the segment for dependencies between VPUs
+	bool hazard(uint64_t pgm_begin, uint64_t pgm_end)
+	{
+		const std::vector<std::pair<uint64_t, uint64_t>> fetch = { { pgm_begin, pgm_end } };
+		std::vector<std::pair<uint64_t, unsigned>> wr;	// Stored words and VPUs
+
+		for(unsigned v = 0; v < m_vpus; ++v) {
+			for(const auto& w : m_lanes[v].writes) {
+				// Any read of a stored word within segment depends on store order
+				if(overlaps(w.addr, fetch))
+					return true;
+				for(const auto& ln : m_lanes) {
+					if(overlaps(w.addr, ln.reads))
+						return true;
+				}
+				wr.emplace_back(w.addr, v);
+			}
+		}
+
+		// Stores of different VPUs to the same word
+		std::sort(wr.begin(), wr.end());
+		for(size_t i = 1; i < wr.size(); ++i) {
+			if(wr[i].first == wr[i - 1].first && wr[i].second != wr[i - 1].second)
+				return true;
+		}
+
+		return false;
+	}
+
+	// Start job on a worker thread
+	void run_worker(unsigned n, std::function<void()> job)
+	{
+		while(m_workers.size() <= n) {
+			m_workers.emplace_back(new worker{ std::thread(), nullptr, true });
+			worker *w = m_workers.back().get();
+			w->thread = std::thread(&vxe_func_model::worker_thread, this, w);
+		}
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_workers[n]->job = std::move(job);
+		m_workers[n]->done = false;
+		m_cv.notify_all();
+	}
+
+	// Wait for completion of all worker jobs
+	void wait_workers()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_cv.wait(lock, [this]{
+			for(const auto& w : m_workers) {
+				if(!w->done)
+					return false;
+			}
+			return true;
+		});
+	}
+
+	// Worker thread
+	void worker_thread(worker *w)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		while(true) {
+			m_cv.wait(lock, [this, w]{ return m_worker_stop || !w->done; });
+			if(m_worker_stop)
+				return;
+			lock.unlock();
+			w->job();
+			lock.lock();
+			w->done = true;
+			m_cv.notify_all();
+		}
+	}
+
+	// Execute register setup instruction
+	static void set_reg(vpu_state& st, unsigned op, unsigned th, uint64_t wdata)
+	{
+		switch(op) {
+			case vxe::instr::setacc::OP:
+				st.acc[th] = wdata;
+				break;
+			case vxe::instr::setvl::OP:
+				st.rsl[th] = wdata;
+				st.rtl[th] = wdata;
+				break;
+			case vxe::instr::setrs::OP:
+				st.rsa[th] = wdata;
+				break;
+			case vxe::instr::setrt::OP:
+				st.rta[th] = wdata;
+				break;
+			case vxe::instr::setrd::OP:
+				st.rda[th] = wdata;
+				break;
+			case vxe::instr::seten::OP:
+				st.thr_en[th] = (wdata & 1u) != 0;
+				break;
+		}
+	}
+
+	// Execute data processing instruction on enabled threads
+	void data_op(vpu_state& st, const vxe::instr::generic_vpu& vpug, uint64_t& errors, lane *ln)
+	{
+		for(unsigned th = 0; th < m_threads; ++th) {
+			if(!st.thr_en[th])
+				continue;
+
+			switch(vpug.op) {
+				case vxe::instr::prod::OP:
+					prod(st, th, errors, ln);
+					break;
+				case vxe::instr::store::OP:
+					store(st, th, errors, ln);
+					break;
+				case vxe::instr::generic_af::OP:
+					activation(st, th, vpug.pl);
+					break;
+			}
+		}
+	}
+
+	// Vector product: accumulate products of Rs and Rt elements. Element n is
+	// accumulated by FMAC lane n % lanes, partial accumulators of lanes 1 and
+	// up are added to thread accumulator in lane order (same as VPU does).
+	void prod(vpu_state& st, unsigned th, uint64_t& errors, lane *ln)
+	{
+		const uint32_t len = std::min(st.rsl[th], st.rtl[th]);
+		const uint8_t *rs = m_mem(st.rsa[th] << 2, uint64_t(st.rsl[th]) << 2);
+		const uint8_t *rt = m_mem(st.rta[th] << 2, uint64_t(st.rtl[th]) << 2);
+
+		if(len && (!rs || !rt)) {
+			++errors;
+		} else {
+			if(ln && len) {
+				ln->reads.emplace_back(st.rsa[th] << 2, (st.rsa[th] + len) << 2);
+				ln->reads.emplace_back(st.rta[th] << 2, (st.rta[th] + len) << 2);
+			}
+			uint32_t acc[MAX_LANES] = { st.acc[th] };
+			for(uint32_t i = 0; i < len; ++i) {
+				uint32_t& a = acc[i % m_fmac_lanes];
+				uint32_t b, c;
+				memcpy(&b, rs + i * sizeof(uint32_t), sizeof(uint32_t));
+				memcpy(&c, rt + i * sizeof(uint32_t), sizeof(uint32_t));
+				hwfmac::mac<uint32_t, uint64_t, 8, 23, 23>(a, b, c, a);
+			}
+			for(uint32_t l = 1; l < m_fmac_lanes && l < len; ++l)
+				hwfmac::mac<uint32_t, uint64_t, 8, 23, 23>(acc[0], acc[l], FP32_ONE, acc[0]);
+			st.acc[th] = acc[0];
+		}
+
+		// Vectors are consumed the same way as by load logic
+		st.rsa[th] += st.rsl[th];
+		st.rsl[th] = 0;
+		st.rta[th] += st.rtl[th];
+		st.rtl[th] = 0;
+	}
+
+	// Store accumulator
+	void store(const vpu_state& st, unsigned th, uint64_t& errors, lane *ln)
+	{
+		uint8_t *p = m_mem(st.rda[th] << 2, sizeof(uint32_t));
+		if(!p)
+			++errors;
+		else if(ln)
+			ln->writes.push_back({ st.rda[th] << 2, p, st.acc[th] });
+		else
+			memcpy(p, &st.acc[th], sizeof(uint32_t));
+	}
+
+	// Activation function
+	static void activation(vpu_state& st, unsigned th, uint64_t pl)
+	{
+		vxe::instr::generic_af af(pl);
+
+		// Invalid activation types are ignored (as in VPU)
+		if(af.af != vxe::instr::relu::AF && af.af != vxe::instr::lrelu::AF)
+			return;
+
+		uint32_t res = 0;
+		hwrelu::relu<uint32_t, 8, 23>(st.acc[th], res, af.af == vxe::instr::lrelu::AF,
+			uint32_t(af.pl & 0x7F));
+		st.acc[th] = res;
+	}
+
+private:
+	mem_map_fn m_mem;		// Memory mapper
+	const unsigned m_vpus;		// Number of VPUs
+	const unsigned m_threads;	// Number of threads per VPU
+	const unsigned m_fmac_lanes;	// Number of FMAC lanes per VPU
+	bool m_parallel;		// Parallel execution enabled
+	par_stats m_stats;		// Parallel mode statistics
+	std::vector<lane> m_lanes;	// Per-VPU segments
+	bool m_seg_sync;		// Last step executed SYNC without stop
+
+	// Worker threads (worker N executes VPU N+1)
+	std::vector<std::unique_ptr<worker>> m_workers;
+	std::mutex m_mutex;
+	std::condition_variable m_cv;
+	bool m_worker_stop;
+};
@@ -31,7 +31,9 @@
 #include <iosfwd>
 #include <iomanip>
 #include <initializer_list>
+#include <limits>
 #include <type_traits>
+#include <vector>
 #pragma once
 
 
@@ -42,11 +44,46 @@ namespace vxe {
 		static constexpr unsigned CU	= 0;	// Control Unit
 		static constexpr unsigned VPU0	= 1;	// Vector Processing Unit 0
 		static constexpr unsigned VPU1	= 2;	// Vector Processing Unit 1
+
+		// Client id of VPU n
+		inline constexpr unsigned vpu(unsigned n)
+		{
+			return VPU0 + n;
+		}
 	} // namespace mhc
 
 
-	// Memory request
+	// Memory hub routing of client requests to master ports
+	struct hub_route {
+		enum class policy {
+			ARG,		// By client and request type (CU_MAS_SEL, VPU load argument)
+			INTERLEAVE,	// By address, consecutive granules go to consecutive ports
+			TABLE		// By client, master port per client is set in a table
+		};
+
+		policy pol = policy::ARG;	// Routing policy
+		unsigned granule = 64;		// Interleaving granule (bytes, power of two)
+		std::vector<unsigned> table;	// Master port of client n (CU is client 0)
+	};
+
+
+	// VPU architectural state (registers visible to programs)
+	template<unsigned NT>
+	struct vpu_arch_state {
+		uint32_t acc[NT];	// Accumulators
+		uint64_t rsa[NT];	// Rs addresses
+		uint32_t rsl[NT];	// Rs lengths
+		uint64_t rta[NT];	// Rt addresses
+		uint32_t rtl[NT];	// Rt lengths
+		uint64_t rda[NT];	// Rd addresses
+		bool thr_en[NT];	// Thread enables
+	};
+
+
+	// Memory request (read requests can be bursts, responses carry one beat each)
 	struct vxe_mem_rq {
+		static constexpr unsigned MAX_BURST = 16;	// Maximum burst length (beats)
+
 		enum class rqtype {
 			REQ_RD,	// Read request
 			REQ_WR	// Write request
@@ -69,6 +106,8 @@ namespace vxe {
 			uint64_t data_u64[1];
 		};
 		bool ben[8];			// Byte enables
+		uint8_t len;			// Burst length (beats, 1 for writes)
+		uint8_t beat;			// Beat number of response
 
 		// Constructor
 		vxe_mem_rq() {
@@ -78,6 +117,26 @@ namespace vxe {
 			res = rstype::RES_NA;
 			data_u64[0] = 0;
 			for(bool& b : ben) b = false;
+			len = 1;
+			beat = 0;
+		}
+
+		/**
+		 * Check if this is a request or the last beat of response
+		 * @return true if no more beats follow
+		 */
+		bool last_beat() const
+		{
+			return res == rstype::RES_NA || beat + 1u >= len;
+		}
+
+		/**
+		 * Size of burst data
+		 * @return size in bytes
+		 */
+		unsigned burst_bytes() const
+		{
+			return len * sizeof(data_u8);
 		}
 
 		/**
@@ -196,6 +255,8 @@ namespace vxe {
 			<< " ben="
 			<< std::setw(2) << std::setfill('0') << std::hex
 			<< ben;
+		if(rq.len > 1)
+			os << " beat=" << std::dec << unsigned(rq.beat) << "/" << unsigned(rq.len);
 
 		// Restore previous stream state
 		os.copyfmt(state);
@@ -203,6 +264,29 @@ namespace vxe {
 		return os;
 	}
 
+
+	// VPU command (transaction-level CU to VPU command channel)
+	struct vpu_cmd {
+		uint8_t op;	// Operation
+		uint8_t thread;	// VPU local thread id
+		uint64_t wdata;	// Payload
+	};
+
+	// VPU command channel interface
+	class vpu_cmd_if {
+	public:
+		virtual ~vpu_cmd_if() = default;
+
+		/**
+		 * Execute batch of commands (blocks calling thread until all commands are executed)
+		 * @param cmds commands
+		 * @param count number of commands
+		 * @return true if VPU reported an error
+		 */
+		virtual bool exec_cmds(const vpu_cmd *cmds, unsigned count) = 0;
+	};
+
+
 	// Word enable
 	template<size_t NWORDS>
 	struct word_enable {
@@ -27,6 +27,7 @@
  * VxEngine master port
  */
 
+#include <functional>
 #include <systemc.h>
 #include <tlm.h>
 #include "vxe_port_util.hxx"
@@ -50,12 +51,23 @@ SC_MODULE(vxe_master_port), public virtual tlm::tlm_bw_transport_if<> {
 		return m_handler->handle(trans, phase, t);
 	}
 
+	/**
+	 * Set DMI invalidation handler
+	 * @param h handler called with invalidated address range
+	 */
+	void set_invalidate_handler(std::function<void(sc_dt::uint64, sc_dt::uint64)> h)
+	{
+		m_invalidate_handler = std::move(h);
+	}
+
 	void invalidate_direct_mem_ptr(sc_dt::uint64 start_range, sc_dt::uint64 end_range) override
 	{
-		// Not used
+		if(m_invalidate_handler)
+			m_invalidate_handler(start_range, end_range);
 	}
 
 
 public:
 	std::shared_ptr<vxe_port_callback_base> m_handler;
+	std::function<void(sc_dt::uint64, sc_dt::uint64)> m_invalidate_handler;
 };
@@ -24,19 +24,28 @@
  */
 
 /*
- * VxEngine Memory Hub block routes memory requests from functional units
- * to external master ports.
+ * VxEngine Memory Hub block is a crossbar that routes memory requests from
+ * functional units (clients) to external master ports and responses back.
+ * Each output is served by a round-robin arbiter. A read burst is routed as
+ * one request and beats of its response pass an output without arbitration.
  */
 
+#include <algorithm>
 #include <iostream>
+#include <string>
+#include <vector>
 #include <systemc.h>
 #include "register_set.hxx"
 #include "vxe_common.hxx"
 #include "vxe_internal.hxx"
+#include "vxe_clock_sync.hxx"
+#include "vxe_profiler.hxx"
+#include "vxe_tracer.hxx"
+#pragma once
 
 
 // VxEngine Memory Hub
-SC_MODULE(vxe_mem_hub) {
+VXE_MODULE(vxe_mem_hub) {
 	sc_in<bool> clk;
 	sc_in<bool> nrst;
 
@@ -44,287 +53,313 @@ SC_MODULE(vxe_mem_hub) {
 	sc_fifo_in<vxe::vxe_mem_rq> cu_fifo_in;
 	sc_fifo_out<vxe::vxe_mem_rq> cu_fifo_out;
 
-	// Vector Processing Unit 0 memory interface
-	sc_fifo_in<vxe::vxe_mem_rq> vpu0_fifo_in;
-	sc_fifo_out<vxe::vxe_mem_rq> vpu0_fifo_out;
+	// Vector Processing Units memory interfaces
+	sc_vector<sc_fifo_in<vxe::vxe_mem_rq>> vpu_fifo_in;
+	sc_vector<sc_fifo_out<vxe::vxe_mem_rq>> vpu_fifo_out;
 
-	// Vector Processing Unit 1 memory interface
-	sc_fifo_in<vxe::vxe_mem_rq> vpu1_fifo_in;
-	sc_fifo_out<vxe::vxe_mem_rq> vpu1_fifo_out;
-
-	// External master interface 0
-	sc_fifo_in<vxe::vxe_mem_rq> master0_fifo_in;
-	sc_fifo_out<vxe::vxe_mem_rq> master0_fifo_out;
-
-	// External master interface 1
-	sc_fifo_in<vxe::vxe_mem_rq> master1_fifo_in;
-	sc_fifo_out<vxe::vxe_mem_rq> master1_fifo_out;
+	// External master interfaces
+	sc_vector<sc_fifo_in<vxe::vxe_mem_rq>> master_fifo_in;
+	sc_vector<sc_fifo_out<vxe::vxe_mem_rq>> master_fifo_out;
 
 	SC_HAS_PROCESS(vxe_mem_hub);
 
-	vxe_mem_hub(::sc_core::sc_module_name name, register_set_if<uint32_t>& regs)
-		: ::sc_core::sc_module(name), clk("clk"), nrst("nrst")
+	/**
+	 * Constructor
+	 * @param name module name
+	 * @param regs VxE register file
+	 * @param event_driven =true to sleep on internal FIFOs while idle
+	 *        instead of polling them on every clock cycle
+	 * @param fifo_depth depth of internal FIFOs
+	 * @param vpus number of VPU clients
+	 * @param masters number of external master ports
+	 * @param route routing policy
+	 */
+	vxe_mem_hub(::sc_core::sc_module_name name, register_set_if<uint32_t>& regs,
+			bool event_driven = true, unsigned fifo_depth = 16, unsigned vpus = 2,
+			unsigned masters = 2, const vxe::hub_route& route = vxe::hub_route())
+		: vxe_prof_module(name), clk("clk"), nrst("nrst")
 		, cu_fifo_in("cu_fifo_in"), cu_fifo_out("cu_fifo_out")
-		, vpu0_fifo_in("vpu0_fifo_in"), vpu0_fifo_out("vpu0_fifo_out")
-		, vpu1_fifo_in("vpu1_fifo_in"), vpu1_fifo_out("vpu1_fifo_out")
-		, master0_fifo_in("master0_fifo_in"), master0_fifo_out("master0_fifo_out")
-		, master1_fifo_in("master1_fifo_in"), master1_fifo_out("master1_fifo_out")
-		, m_regs(regs)
+		, vpu_fifo_in("vpu_fifo_in", vpus), vpu_fifo_out("vpu_fifo_out", vpus)
+		, master_fifo_in("master_fifo_in", masters), master_fifo_out("master_fifo_out", masters)
+		, m_regs(regs), m_event_driven(event_driven), m_clients(vpus + 1), m_masters(masters)
+		, m_route(route), m_shift(granule_shift(route.granule))
+		, m_ordered(route.pol == vxe::hub_route::policy::INTERLEAVE)
+		, fifo_to_m("fifo_to_m", m_clients * masters, fifo_creator(fifo_depth))
+		, fifo_m_to("fifo_m_to", m_clients * masters,
+			fifo_creator(m_ordered ? order_depth(fifo_depth, masters) : fifo_depth))
+		, order_fifo("order_fifo", m_ordered ? m_clients : 0,
+			order_creator(order_depth(fifo_depth, masters)))
 	{
-		SC_THREAD(cu_fifo_in_thread);
-			sensitive << clk.pos();
-
-		SC_THREAD(cu_fifo_out_thread);
-			sensitive << clk.pos();
-
-		SC_THREAD(vpu0_fifo_in_thread);
-			sensitive << clk.pos();
+		if(m_route.pol == vxe::hub_route::policy::INTERLEAVE
+				&& (route.granule == 0 || (route.granule & (route.granule - 1))))
+			std::cerr << this->name() << ": interleaving granule is not a power of two!"
+				<< std::endl;
+		for(unsigned m : m_route.table)
+			if(m >= m_masters)
+				std::cerr << this->name() << ": routing table master port " << m
+					<< " is out of range!" << std::endl;
+
+		// Client threads (client 0 is CU, client n+1 is VPU n)
+		for(unsigned c = 0; c < m_clients; ++c) {
+			sc_spawn_options opts;
+			opts.set_sensitivity(&clk.pos());
+			const std::string cl = "client" + std::to_string(c);
+			sc_spawn(sc_bind(&vxe_mem_hub::client_fifo_in_thread, this, c),
+				(cl + "_fifo_in_thread").c_str(), &opts);
+			sc_spawn(sc_bind(&vxe_mem_hub::client_fifo_out_thread, this, c),
+				(cl + "_fifo_out_thread").c_str(), &opts);
+		}
 
-		SC_THREAD(vpu0_fifo_out_thread);
-			sensitive << clk.pos();
+		// Master port threads
+		for(unsigned m = 0; m < m_masters; ++m) {
+			sc_spawn_options opts;
+			opts.set_sensitivity(&clk.pos());
+			const std::string ms = "master" + std::to_string(m);
+			sc_spawn(sc_bind(&vxe_mem_hub::master_fifo_in_thread, this, m),
+				(ms + "_fifo_in_thread").c_str(), &opts);
+			sc_spawn(sc_bind(&vxe_mem_hub::master_fifo_out_thread, this, m),
+				(ms + "_fifo_out_thread").c_str(), &opts);
+		}
+	}
 
-		SC_THREAD(vpu1_fifo_in_thread);
-			sensitive << clk.pos();
+	/**
+	 * Number of external master ports
+	 */
+	unsigned masters() const { return m_masters; }
 
-		SC_THREAD(vpu1_fifo_out_thread);
-			sensitive << clk.pos();
+	/**
+	 * Check that no requests are queued inside the hub
+	 * @return true if all internal FIFOs are empty
+	 */
+	bool idle() const
+	{
+		for(unsigned i = 0; i < fifo_to_m.size(); ++i)
+			if(fifo_to_m[i].num_available() || fifo_m_to[i].num_available())
+				return false;
+		for(const auto& f : order_fifo)
+			if(f.num_available())
+				return false;
+		return true;
+	}
 
-		SC_THREAD(master0_fifo_in_thread);
-			sensitive << clk.pos();
+	/**
+	 * Register trace probes (internal FIFO levels)
+	 * @param tr tracer
+	 */
+	void trace_probes(vxe_tracer& tr) const
+	{
+		for(const auto& f : fifo_to_m)
+			tr.add_fifo(f);
+		for(const auto& f : fifo_m_to)
+			tr.add_fifo(f);
+	}
 
-		SC_THREAD(master0_fifo_out_thread);
-			sensitive << clk.pos();
+private:
+	/**
+	 * Creator of internal FIFOs with given depth
+	 */
+	struct fifo_creator {
+		unsigned depth;
+		explicit fifo_creator(unsigned d) : depth(d) {}
+		vxe_fifo<vxe::vxe_mem_rq> *operator()(const char *name, size_t) const
+		{
+			return new vxe_fifo<vxe::vxe_mem_rq>(name, depth);
+		}
+	};
+
+	/**
+	 * Creator of response order FIFOs with given depth
+	 */
+	struct order_creator {
+		unsigned depth;
+		explicit order_creator(unsigned d) : depth(d) {}
+		sc_fifo<unsigned> *operator()(const char *name, size_t) const
+		{
+			return new sc_fifo<unsigned>(name, depth);
+		}
+	};
 
-		SC_THREAD(master1_fifo_in_thread);
-			sensitive << clk.pos();
+	// Returns log2 of interleaving granule
+	static unsigned granule_shift(unsigned granule)
+	{
+		unsigned shift = 0;
+		while((2u << shift) <= granule)
+			++shift;
+		return shift;
+	}
 
-		SC_THREAD(master1_fifo_out_thread);
-			sensitive << clk.pos();
+	// Returns depth of response order FIFOs (holds at least one whole burst)
+	static unsigned order_depth(unsigned fifo_depth, unsigned masters)
+	{
+		return std::max(fifo_depth * masters, vxe::vxe_mem_rq::MAX_BURST);
 	}
 
-private:
-	enum class dest_port { M0, M1 };	// Master 0 or Master 1
+	// Upstream FIFO from client c to master m
+	vxe_fifo<vxe::vxe_mem_rq>& to_master(unsigned c, unsigned m) { return fifo_to_m[m * m_clients + c]; }
 
-	// Returns destination master port for a given request
-	dest_port pick_port(const vxe::vxe_mem_rq& rq)
+	// Downstream FIFO from master m to client c
+	vxe_fifo<vxe::vxe_mem_rq>& from_master(unsigned m, unsigned c) { return fifo_m_to[m * m_clients + c]; }
+
+	// Returns destination master port for a given request of client c
+	unsigned pick_port(unsigned c, const vxe::vxe_mem_rq& rq)
 	{
+		switch(m_route.pol) {
+			case vxe::hub_route::policy::INTERLEAVE:
+				return (rq.addr >> m_shift) % m_masters;
+			case vxe::hub_route::policy::TABLE:
+				if(c < m_route.table.size() && m_route.table[c] < m_masters)
+					return m_route.table[c];
+				break;	// Clients missing in the table are routed by argument
+			default:
+				break;
+		}
+
 		// Master for CU requests is selected through REG_CTRL register
-		if(rq.get_client_id() == vxe::mhc::CU)
+		if(c == vxe::mhc::CU)
 			return m_regs.get_reg(vxe::regi::REG_CTRL) & vxe::bits::REG_CTRL::CU_MAS_SEL_MASK
-				? dest_port::M1 : dest_port::M0;
+				? std::min(1u, m_masters - 1) : 0;
 
-		// VPU loads depend on argument type, stores depend on VPU number
+		// VPU loads are spread over ports by VPU and argument type (rs to even
+		// and rt to odd ports), stores of VPU n go to port n.
+		const unsigned v = c - vxe::mhc::VPU0;
 		if(rq.req == vxe::vxe_mem_rq::rqtype::REQ_RD)
-			return rq.get_thread_arg() == 0 ? dest_port::M0 : dest_port::M1;
+			return (2 * v + (rq.get_thread_arg() == 0 ? 0 : 1)) % m_masters;
 		else
-			return rq.get_client_id() == vxe::mhc::VPU0 ? dest_port::M0 : dest_port::M1;
-	}
-
-private:
-	[[noreturn]] void cu_fifo_in_thread()
-	{
-		while(true) {
-			vxe::vxe_mem_rq rq = cu_fifo_in.read();
-			switch(pick_port(rq)) {
-				case dest_port::M0:
-					fifo_cu_to_m0.write(rq);
-					break;
-				case dest_port::M1:
-					fifo_cu_to_m1.write(rq);
-					break;
-				default:
-					std::cerr << name()
-						<< ": cu_fifo_in_thread: wrong destination port!"
-						<< std::endl;
-					break;
-			}
-		}
+			return v % m_masters;
 	}
 
-	[[noreturn]] void cu_fifo_out_thread()
+	/**
+	 * Round-robin output loop. Reads one request per clock cycle from
+	 * source FIFOs in turn. A slot is held until the last beat of a burst
+	 * response is read. In event-driven mode the loop sleeps while all
+	 * sources are empty and skips round-robin slots for clock cycles passed.
+	 * @param out output FIFO
+	 * @param src source FIFOs in round-robin order
+	 */
+	[[noreturn]] void fifo_out_loop(sc_fifo_out<vxe::vxe_mem_rq>& out,
+		const std::vector<sc_fifo<vxe::vxe_mem_rq>*>& src)
 	{
+		vxe_clock_sync sync(clk);
+		const bool event_driven = m_event_driven && sync.init();
+		const size_t n = src.size();
+		sc_event_or_list written;
+		for(auto *f : src)
+			written |= f->data_written_event();
+
+		size_t slot = 0;
+		bool locked = false;	// Slot is held by a burst
 		while(true) {
 			vxe::vxe_mem_rq rq;
 
-			wait();
-			if(fifo_m0_to_cu.nb_read(rq))
-				cu_fifo_out.write(rq);
+			if(event_driven && !locked && all_empty(src))
+				slot = (slot + sync.sleep(written)) % n;
+			else
+				wait();
 
-			wait();
-			if(fifo_m1_to_cu.nb_read(rq))
-				cu_fifo_out.write(rq);
-		}
-	}
-
-	[[noreturn]] void vpu0_fifo_in_thread()
-	{
-		while(true) {
-			vxe::vxe_mem_rq rq = vpu0_fifo_in.read();
-			switch(pick_port(rq)) {
-				case dest_port::M0:
-					fifo_vpu0_to_m0.write(rq);
-					break;
-				case dest_port::M1:
-					fifo_vpu0_to_m1.write(rq);
-					break;
-				default:
-					std::cerr << name()
-						<< ": vpu0_fifo_in_thread: wrong destination port!"
-						<< std::endl;
-					break;
+			if(src[slot]->nb_read(rq)) {
+				out.write(rq);
+				locked = !rq.last_beat();
 			}
+
+			if(!locked)
+				slot = (slot + 1) % n;
 		}
 	}
 
-	[[noreturn]] void vpu0_fifo_out_thread()
+	/**
+	 * In-order output loop. Delivers responses in the order requests were
+	 * routed, one beat per clock cycle. Used when requests of one argument
+	 * stream may be routed to different master ports.
+	 * @param out output FIFO
+	 * @param c client
+	 */
+	[[noreturn]] void ordered_out_loop(sc_fifo_out<vxe::vxe_mem_rq>& out, unsigned c)
 	{
 		while(true) {
-			vxe::vxe_mem_rq rq;
-
+			unsigned m = order_fifo[c].read();
+			out.write(from_master(m, c).read());
 			wait();
-			if(fifo_m0_to_vpu0.nb_read(rq))
-				vpu0_fifo_out.write(rq);
-
-			wait();
-			if(fifo_m1_to_vpu0.nb_read(rq))
-				vpu0_fifo_out.write(rq);
 		}
 	}
 
-	[[noreturn]] void vpu1_fifo_in_thread()
+	// Returns true if all FIFOs are empty
+	static bool all_empty(const std::vector<sc_fifo<vxe::vxe_mem_rq>*>& src)
 	{
-		while(true) {
-			vxe::vxe_mem_rq rq = vpu1_fifo_in.read();
-			switch(pick_port(rq)) {
-				case dest_port::M0:
-					fifo_vpu1_to_m0.write(rq);
-					break;
-				case dest_port::M1:
-					fifo_vpu1_to_m1.write(rq);
-					break;
-				default:
-					std::cerr << name()
-						<< ": vpu1_fifo_in_thread: wrong destination port!"
-						<< std::endl;
-					break;
-			}
-		}
+		for(auto *f : src)
+			if(f->num_available())
+				return false;
+		return true;
 	}
 
-	[[noreturn]] void vpu1_fifo_out_thread()
+private:
+	[[noreturn]] void client_fifo_in_thread(unsigned c)
 	{
-		while(true) {
-			vxe::vxe_mem_rq rq;
-
-			wait();
-			if(fifo_m0_to_vpu1.nb_read(rq))
-				vpu1_fifo_out.write(rq);
+		sc_fifo_in<vxe::vxe_mem_rq>& in = (c == vxe::mhc::CU ? cu_fifo_in : vpu_fifo_in[c - 1]);
 
-			wait();
-			if(fifo_m1_to_vpu1.nb_read(rq))
-				vpu1_fifo_out.write(rq);
-		}
-	}
-
-	[[noreturn]] void master0_fifo_in_thread()
-	{
 		while(true) {
-			vxe::vxe_mem_rq rq = master0_fifo_in.read();
-			switch(rq.get_client_id()) {
-				case vxe::mhc::CU:
-					fifo_m0_to_cu.write(rq);
-					break;
-				case vxe::mhc::VPU0:
-					fifo_m0_to_vpu0.write(rq);
-					break;
-				case vxe::mhc::VPU1:
-					fifo_m0_to_vpu1.write(rq);
-					break;
-				default:
-					std::cerr << name()
-						<< ": master0_fifo_in_thread: wrong client id!"
-						<< std::endl;
-					break;
-			}
+			vxe::vxe_mem_rq rq = in.read();
+			unsigned m = pick_port(c, rq);
+			// Order entries (one per beat) bound responses in flight,
+			// so they never block on downstream FIFOs in ordered mode
+			if(m_ordered)
+				for(unsigned b = 0; b < rq.len; ++b)
+					order_fifo[c].write(m);
+			to_master(c, m).write(rq);
 		}
 	}
 
-	[[noreturn]] void master0_fifo_out_thread()
+	[[noreturn]] void client_fifo_out_thread(unsigned c)
 	{
-		while(true) {
-			vxe::vxe_mem_rq rq;
+		sc_fifo_out<vxe::vxe_mem_rq>& out = (c == vxe::mhc::CU ? cu_fifo_out : vpu_fifo_out[c - 1]);
 
-			wait();
-			if(fifo_cu_to_m0.nb_read(rq))
-				master0_fifo_out.write(rq);
-
-			wait();
-			if(fifo_vpu0_to_m0.nb_read(rq))
-				master0_fifo_out.write(rq);
+		if(m_ordered)
+			ordered_out_loop(out, c);
 
-			wait();
-			if(fifo_vpu1_to_m0.nb_read(rq))
-				master0_fifo_out.write(rq);
-		}
+		std::vector<sc_fifo<vxe::vxe_mem_rq>*> src;
+		for(unsigned m = 0; m < m_masters; ++m)
+			src.push_back(&from_master(m, c));
+		fifo_out_loop(out, src);
 	}
 
-	[[noreturn]] void master1_fifo_in_thread()
+	// Route responses from a master port to client FIFOs
+	[[noreturn]] void master_fifo_in_thread(unsigned m)
 	{
 		while(true) {
-			vxe::vxe_mem_rq rq = master1_fifo_in.read();
-			switch(rq.get_client_id()) {
-				case vxe::mhc::CU:
-					fifo_m1_to_cu.write(rq);
-					break;
-				case vxe::mhc::VPU0:
-					fifo_m1_to_vpu0.write(rq);
-					break;
-				case vxe::mhc::VPU1:
-					fifo_m1_to_vpu1.write(rq);
-					break;
-				default:
-					std::cerr << name()
-						<< ": master1_fifo_in_thread: wrong client id!"
-						<< std::endl;
-					break;
-			}
+			vxe::vxe_mem_rq rq = master_fifo_in[m].read();
+			unsigned cid = rq.get_client_id();
+			if(cid < m_clients)
+				from_master(m, cid).write(rq);
+			else
+				std::cerr << name() << ": " << master_fifo_in[m].name() << ": wrong client id!"
+					<< std::endl;
 		}
 	}
 
-	[[noreturn]] void master1_fifo_out_thread()
+	[[noreturn]] void master_fifo_out_thread(unsigned m)
 	{
-		while(true) {
-			vxe::vxe_mem_rq rq;
-
-			wait();
-			if(fifo_cu_to_m1.nb_read(rq))
-				master1_fifo_out.write(rq);
-
-			wait();
-			if(fifo_vpu0_to_m1.nb_read(rq))
-				master1_fifo_out.write(rq);
-
-			wait();
-			if(fifo_vpu1_to_m1.nb_read(rq))
-				master1_fifo_out.write(rq);
-		}
+		std::vector<sc_fifo<vxe::vxe_mem_rq>*> src;
+		for(unsigned c = 0; c < m_clients; ++c)
+			src.push_back(&to_master(c, m));
+		fifo_out_loop(master_fifo_out[m], src);
 	}
 
 private:
 	// VxE register file
 	register_set_if<uint32_t>& m_regs;
-	// Upstream traffic FIFOs
-	sc_fifo<vxe::vxe_mem_rq> fifo_cu_to_m0;
-	sc_fifo<vxe::vxe_mem_rq> fifo_cu_to_m1;
-	sc_fifo<vxe::vxe_mem_rq> fifo_vpu0_to_m0;
-	sc_fifo<vxe::vxe_mem_rq> fifo_vpu0_to_m1;
-	sc_fifo<vxe::vxe_mem_rq> fifo_vpu1_to_m0;
-	sc_fifo<vxe::vxe_mem_rq> fifo_vpu1_to_m1;
-	// Downstream traffic FIFOs
-	sc_fifo<vxe::vxe_mem_rq> fifo_m0_to_cu;
-	sc_fifo<vxe::vxe_mem_rq> fifo_m0_to_vpu0;
-	sc_fifo<vxe::vxe_mem_rq> fifo_m0_to_vpu1;
-	sc_fifo<vxe::vxe_mem_rq> fifo_m1_to_cu;
-	sc_fifo<vxe::vxe_mem_rq> fifo_m1_to_vpu0;
-	sc_fifo<vxe::vxe_mem_rq> fifo_m1_to_vpu1;
+	// Sleep on internal FIFOs while idle
+	const bool m_event_driven;
+	// Number of clients (CU and VPUs)
+	const unsigned m_clients;
+	// Number of master ports
+	const unsigned m_masters;
+	// Routing policy
+	const vxe::hub_route m_route;
+	const unsigned m_shift;		// Interleaving granule shift
+	const bool m_ordered;		// Deliver responses in request order
+	// Upstream traffic FIFOs (per master, per client)
+	sc_vector<vxe_fifo<vxe::vxe_mem_rq>> fifo_to_m;
+	// Downstream traffic FIFOs (per master, per client)
+	sc_vector<vxe_fifo<vxe::vxe_mem_rq>> fifo_m_to;
+	// Master ports of requests in flight (per client, ordered mode only)
+	sc_vector<sc_fifo<unsigned>> order_fifo;
 };
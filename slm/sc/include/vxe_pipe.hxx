@@ -27,46 +27,82 @@
  * Simple N-stage pipe
  */
 
-#include <list>
+#include <iostream>
 #include <systemc.h>
+#include "vxe_clock_sync.hxx"
+#include "vxe_ring.hxx"
+#include "vxe_profiler.hxx"
 #pragma once
 
 
-// Pipe template
+// Pipe template (NSTAGES is maximum number of stages)
 template<typename T, unsigned NSTAGES>
-SC_MODULE(vxe_pipe) {
+VXE_MODULE(vxe_pipe) {
 	sc_in<bool> clk;
 	sc_in<bool> nrst;
 
 	sc_in<T> in;
 	sc_out<T> out;
 
-	SC_CTOR(vxe_pipe)
-		: clk("clk"), nrst("nrst"), in("in"), out("out")
+	SC_HAS_PROCESS(vxe_pipe);
+
+	/**
+	 * Constructor
+	 * @param name module name
+	 * @param nstages number of stages (1 to NSTAGES)
+	 */
+	vxe_pipe(::sc_core::sc_module_name name, unsigned nstages = NSTAGES)
+		: vxe_prof_module(name), clk("clk"), nrst("nrst"), in("in"), out("out")
+		, m_nstages(nstages)
 	{
 		static_assert(NSTAGES > 0, "NSTAGES cannot be 0!");
 
 		SC_THREAD(pipe_thread);
 			sensitive << clk.pos();
 
-		m_pipe.resize(NSTAGES);
+		if(m_nstages == 0 || m_nstages > NSTAGES) {
+			std::cerr << this->name() << ": invalid number of stages " << m_nstages
+				<< ", using " << NSTAGES << "!" << std::endl;
+			m_nstages = NSTAGES;
+		}
+
+		for(unsigned i = 0; i < m_nstages; ++i)
+			m_pipe.push(T());
 	}
 
 private:
 	[[noreturn]] void pipe_thread()
 	{
+		vxe_clock_sync sync(clk);
+		sync.init();
+		sc_event_or_list wakeup;	// Events to wake up from idle state
+		wakeup |= in.value_changed_event();
+		wakeup |= nrst.value_changed_event();
+
 		while(true) {
 			do {
-				wait();
+				// Sleep while all stages hold the input value
+				sync.wait_cycle(nrst.read() && steady(), wakeup);
 			} while(!nrst.read());
 
 			// Advance pipe
-			m_pipe.pop_back();
-			m_pipe.push_front(in.read());
-			out.write(m_pipe.back());
+			m_pipe.pop();
+			m_pipe.push(in.read());
+			out.write(m_pipe.front());
 		}
 	}
 
+	// Returns true if advancing the pipe does not change its state
+	bool steady() const
+	{
+		const T v = in.read();
+		for(unsigned i = 0; i < m_nstages; ++i)
+			if(!(m_pipe[i] == v))
+				return false;
+		return true;
+	}
+
 private:
-	std::list<T> m_pipe;
+	vxe_ring<T, NSTAGES> m_pipe;
+	unsigned m_nstages;	// Number of stages
 };
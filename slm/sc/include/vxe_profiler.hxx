@@ -0,0 +1,382 @@
+/*
+ * Copyright (c) 2022 The VxEngine Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Simulator self-profiler
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <systemc.h>
+#pragma once
+
+
+/**
+ * Simulator self-profiler.
+ * Collects activation counts and host time of processes of modules derived
+ * from vxe_prof_module and traffic of vxe_fifo channels. Process is active
+ * from its resume until the next profiled wait, so time spent in waits
+ * which bypass the profiler (e.g. inside TLM utilities) is accounted to
+ * the calling process. Delta cycles are attributed to processes by counting
+ * distinct delta cycles in which a process was activated.
+ * Profiling is disabled by default.
+ *
+ * The profiler is not thread-safe and runs on the simulation kernel thread
+ * only. Host threads (e.g. application thread) must be marked with
+ * host_thread guard, calls from marked threads are ignored and counted.
+ */
+class vxe_profiler {
+public:
+	// Process statistics
+	struct process_stats {
+		uint64_t activations;	// Number of activations
+		uint64_t deltas;	// Number of delta cycles with activations
+		uint64_t last_delta;	// Last active delta cycle + 1 (0 if never active)
+		double host_time;	// Host time (seconds)
+		bool running;		// Process is active
+		std::chrono::steady_clock::time_point start;	// Activation start
+	};
+
+	// FIFO statistics
+	struct fifo_stats {
+		uint64_t writes;	// Number of writes
+		uint64_t reads;		// Number of reads
+		uint64_t write_blocks;	// Number of writes blocked on full FIFO
+		uint64_t read_blocks;	// Number of reads blocked on empty FIFO
+	};
+
+	/**
+	 * Enable or disable profiling globally
+	 * (must be called before simulation start)
+	 * @param enable =true to collect statistics
+	 */
+	static void set_enabled(bool enable)
+	{
+		enabled() = enable;
+	}
+
+	/**
+	 * Check if profiling is enabled globally
+	 * @return reference to global flag
+	 */
+	static bool& enabled()
+	{
+		static bool s_enabled = false;
+		return s_enabled;
+	}
+
+	/**
+	 * Marks current host thread as not a simulation kernel thread
+	 * for the lifetime of the guard
+	 */
+	class host_thread {
+	public:
+		host_thread() { on_host_thread() = true; }
+		~host_thread() { on_host_thread() = false; }
+		host_thread(const host_thread&) = delete;
+		host_thread& operator=(const host_thread&) = delete;
+	};
+
+	/**
+	 * Mark current process as resumed
+	 */
+	static void resume()
+	{
+		if(!enabled() || ignored())
+			return;
+
+		process_stats& ps = current();
+		activate(ps);
+		ps.running = true;
+		ps.start = std::chrono::steady_clock::now();
+	}
+
+	/**
+	 * Mark current process as suspended
+	 */
+	static void suspend()
+	{
+		if(!enabled() || ignored())
+			return;
+
+		process_stats& ps = current();
+		if(ps.running) {
+			std::chrono::duration<double> d = std::chrono::steady_clock::now() - ps.start;
+			ps.host_time += d.count();
+			ps.running = false;
+		} else
+			activate(ps);	// Initial activation of a thread
+	}
+
+	/**
+	 * Profiled wait. Accepts the same arguments as sc_core::wait().
+	 */
+	template<typename... Args>
+	static void wait(Args&&... args)
+	{
+		suspend();
+		::sc_core::wait(std::forward<Args>(args)...);
+		resume();
+	}
+
+	/**
+	 * Register FIFO channel
+	 * @param fifo FIFO object
+	 * @param stats FIFO statistics
+	 */
+	static void add_fifo(const sc_object *fifo, const fifo_stats *stats)
+	{
+		fifos().emplace_back(fifo, stats);
+	}
+
+	/**
+	 * Unregister FIFO channel
+	 * @param fifo FIFO object
+	 */
+	static void remove_fifo(const sc_object *fifo)
+	{
+		auto& f = fifos();
+		f.erase(std::remove_if(f.begin(), f.end(),
+			[fifo](const fifo_entry& e) { return e.first == fifo; }), f.end());
+	}
+
+	/**
+	 * Write collected statistics in JSON format
+	 * @param os output stream
+	 * @param wall_time simulation wall time (seconds)
+	 */
+	static void dump(std::ostream& os, double wall_time)
+	{
+		std::vector<std::pair<const sc_object*, const process_stats*>> procs;
+		for(const auto& p : processes())
+			procs.emplace_back(p.first, &p.second);
+		std::sort(procs.begin(), procs.end(), [](const auto& a, const auto& b) {
+			return a.second->host_time > b.second->host_time;
+		});
+
+		os << "{" << std::endl;
+		os << "\t\"simulated_time_ps\": " << uint64_t(sc_time_stamp().to_seconds() * 1e12 + 0.5) << "," << std::endl;
+		os << "\t\"delta_cycles\": " << sc_delta_count() << "," << std::endl;
+		os << "\t\"wall_time_s\": " << wall_time << "," << std::endl;
+		os << "\t\"host_thread_calls\": " << host_thread_calls() << "," << std::endl;
+
+		os << "\t\"processes\": [";
+		for(size_t i = 0; i < procs.size(); ++i) {
+			os << (i ? "," : "") << std::endl << "\t\t{ \"name\": \"" << procs[i].first->name() << "\""
+				<< ", \"activations\": " << procs[i].second->activations
+				<< ", \"delta_cycles\": " << procs[i].second->deltas
+				<< ", \"host_time_s\": " << procs[i].second->host_time << " }";
+		}
+		os << std::endl << "\t]," << std::endl;
+
+		os << "\t\"fifos\": [";
+		for(size_t i = 0; i < fifos().size(); ++i) {
+			const fifo_entry& f = fifos()[i];
+			os << (i ? "," : "") << std::endl << "\t\t{ \"name\": \"" << f.first->name() << "\""
+				<< ", \"writes\": " << f.second->writes
+				<< ", \"reads\": " << f.second->reads
+				<< ", \"write_blocks\": " << f.second->write_blocks
+				<< ", \"read_blocks\": " << f.second->read_blocks << " }";
+		}
+		os << std::endl << "\t]" << std::endl;
+		os << "}" << std::endl;
+	}
+
+	/**
+	 * Scoped activation of a method process
+	 */
+	class scope {
+	public:
+		scope() { resume(); }
+		~scope() { suspend(); }
+		scope(const scope&) = delete;
+		scope& operator=(const scope&) = delete;
+	};
+
+private:
+	using fifo_entry = std::pair<const sc_object*, const fifo_stats*>;
+
+	static process_stats& current()
+	{
+		return processes()[sc_get_current_process_handle().get_process_object()];
+	}
+
+	// Count process activation and delta cycle it belongs to
+	static void activate(process_stats& ps)
+	{
+		++ps.activations;
+		const uint64_t delta = sc_delta_count() + 1;
+		if(ps.last_delta != delta) {
+			++ps.deltas;
+			ps.last_delta = delta;
+		}
+	}
+
+	// Returns true (and counts the call) on a marked host thread
+	static bool ignored()
+	{
+		if(!on_host_thread())
+			return false;
+		++host_thread_calls();
+		return true;
+	}
+
+	static bool& on_host_thread()
+	{
+		thread_local bool s_host_thread = false;
+		return s_host_thread;
+	}
+
+	static std::atomic<uint64_t>& host_thread_calls()
+	{
+		static std::atomic<uint64_t> s_calls(0);
+		return s_calls;
+	}
+
+	static std::unordered_map<const sc_object*, process_stats>& processes()
+	{
+		static std::unordered_map<const sc_object*, process_stats> s_processes;
+		return s_processes;
+	}
+
+	static std::vector<fifo_entry>& fifos()
+	{
+		static std::vector<fifo_entry> s_fifos;
+		return s_fifos;
+	}
+};
+
+
+/**
+ * Module base with profiled wait(). Hides sc_module::wait() overloads.
+ */
+struct vxe_prof_module : public ::sc_core::sc_module {
+protected:
+	vxe_prof_module() : ::sc_core::sc_module() {}
+
+	explicit vxe_prof_module(::sc_core::sc_module_name name)
+		: ::sc_core::sc_module(name) {}
+
+	template<typename... Args>
+	void wait(Args&&... args)
+	{
+		vxe_profiler::wait(std::forward<Args>(args)...);
+	}
+};
+
+// Declare profiled module (same as SC_MODULE)
+#define VXE_MODULE(user_module_name)	\
+	struct user_module_name : public vxe_prof_module
+
+
+/**
+ * FIFO channel with traffic counters
+ */
+template<typename T>
+class vxe_fifo : public sc_fifo<T> {
+public:
+	explicit vxe_fifo(int size = 16)
+		: sc_fifo<T>(size), m_stats()
+	{
+		vxe_profiler::add_fifo(this, &m_stats);
+	}
+
+	explicit vxe_fifo(const char *name, int size = 16)
+		: sc_fifo<T>(name, size), m_stats()
+	{
+		vxe_profiler::add_fifo(this, &m_stats);
+	}
+
+	~vxe_fifo()
+	{
+		vxe_profiler::remove_fifo(this);
+	}
+
+	void read(T& v) override
+	{
+		if(this->num_available() == 0) {
+			++m_stats.read_blocks;
+			vxe_profiler::suspend();
+			sc_fifo<T>::read(v);
+			vxe_profiler::resume();
+		} else
+			sc_fifo<T>::read(v);
+		++m_stats.reads;
+	}
+
+	T read() override
+	{
+		T v;
+		read(v);
+		return v;
+	}
+
+	bool nb_read(T& v) override
+	{
+		if(!sc_fifo<T>::nb_read(v))
+			return false;
+		++m_stats.reads;
+		return true;
+	}
+
+	void write(const T& v) override
+	{
+		if(this->num_free() == 0) {
+			++m_stats.write_blocks;
+			vxe_profiler::suspend();
+			sc_fifo<T>::write(v);
+			vxe_profiler::resume();
+		} else
+			sc_fifo<T>::write(v);
+		++m_stats.writes;
+	}
+
+	bool nb_write(const T& v) override
+	{
+		if(!sc_fifo<T>::nb_write(v))
+			return false;
+		++m_stats.writes;
+		return true;
+	}
+
+	operator T() { return read(); }
+
+	vxe_fifo& operator=(const T& v) { write(v); return *this; }
+
+	/**
+	 * Get traffic statistics
+	 * @return statistics
+	 */
+	const vxe_profiler::fifo_stats& stats() const { return m_stats; }
+
+private:
+	vxe_profiler::fifo_stats m_stats;
+};
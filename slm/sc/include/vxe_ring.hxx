@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2022 The VxEngine Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Fixed capacity ring buffer
+ */
+
+#include <cstddef>
+#pragma once
+
+
+/**
+ * Ring buffer of compile-time capacity. Elements are stored in place, no
+ * heap allocations are made on push and pop. Indexing starts from the
+ * oldest element.
+ */
+template<typename T, unsigned N>
+class vxe_ring {
+	static_assert(N > 0, "N cannot be 0!");
+
+	T m_buf[N];		// Storage
+	unsigned m_head;	// Index of the oldest element
+	unsigned m_count;	// Number of elements
+
+	static unsigned wrap(unsigned i) { return i < N ? i : i - N; }
+
+public:
+	vxe_ring() : m_buf(), m_head(0), m_count(0) {}
+
+	/**
+	 * Capacity
+	 * @return maximum number of elements
+	 */
+	static constexpr unsigned capacity() { return N; }
+
+	/**
+	 * Number of elements
+	 * @return size
+	 */
+	unsigned size() const { return m_count; }
+
+	/**
+	 * Check if ring is empty
+	 * @return true if empty
+	 */
+	bool empty() const { return m_count == 0; }
+
+	/**
+	 * Check if ring is full
+	 * @return true if full
+	 */
+	bool full() const { return m_count == N; }
+
+	/**
+	 * Remove all elements
+	 */
+	void clear() { m_head = 0; m_count = 0; }
+
+	/**
+	 * Fill ring with N copies of a value
+	 * @param v value
+	 */
+	void fill(const T& v)
+	{
+		for(unsigned i = 0; i < N; ++i)
+			m_buf[i] = v;
+		m_head = 0;
+		m_count = N;
+	}
+
+	/**
+	 * Append element (ring must not be full)
+	 * @param v value
+	 */
+	void push(const T& v)
+	{
+		m_buf[wrap(m_head + m_count)] = v;
+		++m_count;
+	}
+
+	/**
+	 * Remove oldest element (ring must not be empty)
+	 */
+	void pop()
+	{
+		m_head = wrap(m_head + 1);
+		--m_count;
+	}
+
+	/**
+	 * Access oldest element
+	 * @return reference to element
+	 */
+	T& front() { return m_buf[m_head]; }
+	const T& front() const { return m_buf[m_head]; }
+
+	/**
+	 * Access newest element
+	 * @return reference to element
+	 */
+	T& back() { return m_buf[wrap(m_head + m_count - 1)]; }
+	const T& back() const { return m_buf[wrap(m_head + m_count - 1)]; }
+
+	/**
+	 * Access element by position starting from the oldest one
+	 * @param i position
+	 * @return reference to element
+	 */
+	T& operator[](unsigned i) { return m_buf[wrap(m_head + i)]; }
+	const T& operator[](unsigned i) const { return m_buf[wrap(m_head + i)]; }
+};
@@ -0,0 +1,584 @@
+/*
+ * Copyright (c) 2022 The VxEngine Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Adapters between SystemC model memory request FIFOs and pin-level
+ * channels of Verilated RTL blocks:
+ *  - vxe_rtl_client_port drives memory hub request/response channels
+ *    (rqa/rqd/rss/rsd) from sc_fifo<vxe_mem_rq> traffic of a client unit;
+ *  - vxe_rtl_master_port turns AXI4 master traffic of RTL into
+ *    sc_fifo<vxe_mem_rq> requests for VxE top memory masters.
+ */
+
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <systemc.h>
+#include "vxe_internal.hxx"
+#pragma once
+
+
+namespace vxe {
+namespace rtl {
+
+	// AXI4 responses
+	namespace axi4_resp {
+		static constexpr unsigned OKAY		= 0;
+		static constexpr unsigned EXOKAY	= 1;
+		static constexpr unsigned SLVERR	= 2;
+		static constexpr unsigned DECERR	= 3;
+	} // namespace axi4_resp
+
+	static constexpr unsigned TXNID_NUM = 64;	// Number of RTL transaction Ids
+
+	/**
+	 * Make RTL transaction Id
+	 * @param rq memory request
+	 * @return 6-bit transaction Id {client[1:0], thread[2:0], arg}
+	 */
+	inline unsigned txnid(const vxe_mem_rq& rq)
+	{
+		return ((rq.get_client_id() & 3u) << 4) | ((rq.get_thread_id() & 7u) << 1)
+			| (rq.get_thread_arg() & 1u);
+	}
+
+	/**
+	 * Pack request address channel word
+	 * @param rq memory request
+	 * @return 44-bit word {txnid[5:0], rnw, addr[38:3]}
+	 */
+	inline uint64_t pack_rqa(const vxe_mem_rq& rq)
+	{
+		uint64_t t = txnid(rq);
+		uint64_t r = (rq.req == vxe_mem_rq::rqtype::REQ_RD ? 1 : 0);
+		uint64_t a = (rq.addr >> 3) & 0xFFFFFFFFFull;
+		return (t << 38) | (r << 37) | a;
+	}
+
+	/**
+	 * Byte enables as a mask
+	 * @param rq memory request
+	 * @return 8-bit mask
+	 */
+	inline unsigned ben_mask(const vxe_mem_rq& rq)
+	{
+		unsigned m = 0;
+		for(unsigned i = 0; i < 8; ++i)
+			m |= (rq.ben[i] ? 1u : 0u) << i;
+		return m;
+	}
+
+	/**
+	 * Pack request data channel word
+	 * @param rq memory request
+	 * @return 72-bit word {ben[7:0], data[63:0]}
+	 */
+	inline sc_bv<72> pack_rqd(const vxe_mem_rq& rq)
+	{
+		sc_bv<72> r = ben_mask(rq);
+		r <<= 64;
+		r |= rq.data_u64[0];
+		return r;
+	}
+
+	/**
+	 * Convert RTL error status to response type
+	 * @param err 2-bit error status (AXI4 response)
+	 * @return response type
+	 */
+	inline vxe_mem_rq::rstype err_to_res(unsigned err)
+	{
+		switch(err) {
+			case axi4_resp::OKAY:
+			case axi4_resp::EXOKAY:
+				return vxe_mem_rq::rstype::RES_OK;
+			case axi4_resp::DECERR:
+				return vxe_mem_rq::rstype::RES_AE;
+			default:
+				return vxe_mem_rq::rstype::RES_DE;
+		}
+	}
+
+	/**
+	 * Convert response type to AXI4 response
+	 * @param res response type
+	 * @return AXI4 response
+	 */
+	inline unsigned res_to_axi4(vxe_mem_rq::rstype res)
+	{
+		switch(res) {
+			case vxe_mem_rq::rstype::RES_OK:
+				return axi4_resp::OKAY;
+			case vxe_mem_rq::rstype::RES_AE:
+				return axi4_resp::DECERR;
+			default:
+				return axi4_resp::SLVERR;
+		}
+	}
+
+	// Memory hub client channel signals
+	struct client_signals {
+		// Request channel
+		sc_signal<bool>		rqa_rdy;
+		sc_signal<uint64_t>	rqa;
+		sc_signal<bool>		rqa_wr;
+		sc_signal<bool>		rqd_rdy;
+		sc_signal<sc_bv<72>>	rqd;
+		sc_signal<bool>		rqd_wr;
+		// Response channel
+		sc_signal<bool>		rss_vld;
+		sc_signal<uint32_t>	rss;
+		sc_signal<bool>		rss_rd;
+		sc_signal<bool>		rsd_vld;
+		sc_signal<uint64_t>	rsd;
+		sc_signal<bool>		rsd_rd;
+	};
+
+	// AXI4 master signals
+	struct axi4_signals {
+		sc_signal<uint32_t>	AWID;
+		sc_signal<uint64_t>	AWADDR;
+		sc_signal<uint32_t>	AWLEN;
+		sc_signal<uint32_t>	AWSIZE;
+		sc_signal<uint32_t>	AWBURST;
+		sc_signal<bool>		AWLOCK;
+		sc_signal<uint32_t>	AWCACHE;
+		sc_signal<uint32_t>	AWPROT;
+		sc_signal<bool>		AWVALID;
+		sc_signal<bool>		AWREADY;
+		sc_signal<uint64_t>	WDATA;
+		sc_signal<uint32_t>	WSTRB;
+		sc_signal<bool>		WLAST;
+		sc_signal<bool>		WVALID;
+		sc_signal<bool>		WREADY;
+		sc_signal<uint32_t>	BID;
+		sc_signal<uint32_t>	BRESP;
+		sc_signal<bool>		BVALID;
+		sc_signal<bool>		BREADY;
+		sc_signal<uint32_t>	ARID;
+		sc_signal<uint64_t>	ARADDR;
+		sc_signal<uint32_t>	ARLEN;
+		sc_signal<uint32_t>	ARSIZE;
+		sc_signal<uint32_t>	ARBURST;
+		sc_signal<bool>		ARLOCK;
+		sc_signal<uint32_t>	ARCACHE;
+		sc_signal<uint32_t>	ARPROT;
+		sc_signal<bool>		ARVALID;
+		sc_signal<bool>		ARREADY;
+		sc_signal<uint32_t>	RID;
+		sc_signal<uint64_t>	RDATA;
+		sc_signal<uint32_t>	RRESP;
+		sc_signal<bool>		RLAST;
+		sc_signal<bool>		RVALID;
+		sc_signal<bool>		RREADY;
+	};
+
+} // namespace rtl
+} // namespace vxe
+
+
+/**
+ * Client port adapter
+ * Issues requests of a client unit on RTL memory hub request channel and
+ * collects responses from RTL response channel. RTL responses carry only
+ * transaction Id, so issued requests are kept to restore response fields.
+ */
+SC_MODULE(vxe_rtl_client_port) {
+	sc_in<bool> clk;
+	sc_in<bool> nrst;
+
+	// Client side
+	sc_fifo_in<vxe::vxe_mem_rq> rq_fifo_in;		// Requests from client
+	sc_fifo_out<vxe::vxe_mem_rq> rs_fifo_out;	// Responses to client
+
+	// RTL request channel
+	sc_in<bool> i_rqa_rdy;
+	sc_out<uint64_t> o_rqa;
+	sc_out<bool> o_rqa_wr;
+	sc_out<sc_bv<72>> o_rqd;
+	sc_out<bool> o_rqd_wr;
+	// RTL response channel
+	sc_in<bool> i_rss_vld;
+	sc_in<uint32_t> i_rss;
+	sc_out<bool> o_rss_rd;
+	sc_in<bool> i_rsd_vld;
+	sc_in<uint64_t> i_rsd;
+	sc_out<bool> o_rsd_rd;
+
+	SC_HAS_PROCESS(vxe_rtl_client_port);
+
+	/**
+	 * Constructor
+	 * @param name module name
+	 */
+	explicit vxe_rtl_client_port(::sc_core::sc_module_name name)
+		: sc_module(name), clk("clk"), nrst("nrst")
+		, rq_fifo_in("rq_fifo_in"), rs_fifo_out("rs_fifo_out")
+		, i_rqa_rdy("i_rqa_rdy"), o_rqa("o_rqa"), o_rqa_wr("o_rqa_wr")
+		, o_rqd("o_rqd"), o_rqd_wr("o_rqd_wr")
+		, i_rss_vld("i_rss_vld"), i_rss("i_rss"), o_rss_rd("o_rss_rd")
+		, i_rsd_vld("i_rsd_vld"), i_rsd("i_rsd"), o_rsd_rd("o_rsd_rd")
+		, m_pending(0)
+	{
+		SC_THREAD(upstream_thread);
+			sensitive << clk.pos();
+
+		SC_THREAD(downstream_thread);
+			sensitive << clk.pos();
+	}
+
+	/**
+	 * Bind RTL channel signals
+	 * @param s channel signals
+	 */
+	void bind(vxe::rtl::client_signals& s)
+	{
+		i_rqa_rdy(s.rqa_rdy);
+		o_rqa(s.rqa);
+		o_rqa_wr(s.rqa_wr);
+		o_rqd(s.rqd);
+		o_rqd_wr(s.rqd_wr);
+		i_rss_vld(s.rss_vld);
+		i_rss(s.rss);
+		o_rss_rd(s.rss_rd);
+		i_rsd_vld(s.rsd_vld);
+		i_rsd(s.rsd);
+		o_rsd_rd(s.rsd_rd);
+	}
+
+	/**
+	 * Number of requests waiting for response
+	 */
+	unsigned pending() const { return m_pending; }
+
+private:
+	static constexpr unsigned RS_QUEUE_DEPTH = 2;	// Depth of response channel queues
+
+	[[noreturn]] void upstream_thread()
+	{
+		o_rqa_wr.write(false);
+		o_rqd_wr.write(false);
+
+		// Wait for reset release
+		while(!nrst) wait();
+
+		while(true) {
+			if(rq_fifo_in.num_available()) {
+				vxe::vxe_mem_rq rq = rq_fifo_in.read();
+				bool wr = (rq.req == vxe::vxe_mem_rq::rqtype::REQ_WR);
+				m_issued[vxe::rtl::txnid(rq)].push_back(rq);
+				++m_pending;
+
+				o_rqa_wr.write(true);
+				o_rqa.write(vxe::rtl::pack_rqa(rq));
+				o_rqd_wr.write(wr);
+				if(wr)
+					o_rqd.write(vxe::rtl::pack_rqd(rq));
+				// Wait for destination is ready to accept on the next cycle
+				// (data word is accepted together with request address)
+				do { wait(); } while(!i_rqa_rdy.read());
+				continue;
+			} else {
+				o_rqa_wr.write(false);
+				o_rqd_wr.write(false);
+			}
+
+			wait();
+		}
+	}
+
+	[[noreturn]] void downstream_thread()
+	{
+		std::deque<uint32_t> rss_q;	// Received response status
+		std::deque<uint64_t> rsd_q;	// Received response data
+
+		o_rss_rd.write(false);
+		o_rsd_rd.write(false);
+
+		// Wait for reset release
+		while(!nrst) wait();
+
+		while(true) {
+			bool rds = (rss_q.size() < RS_QUEUE_DEPTH && i_rss_vld.read());
+			bool rdd = (rsd_q.size() < RS_QUEUE_DEPTH && i_rsd_vld.read());
+
+			o_rss_rd.write(rds);
+			o_rsd_rd.write(rdd);
+
+			wait();
+
+			if(rds && i_rss_vld.read())
+				rss_q.push_back(i_rss.read());
+			if(rdd && i_rsd_vld.read())
+				rsd_q.push_back(i_rsd.read());
+
+			// Complete responses: status {txnid[5:0], rnw, err[1:0]}, reads also have data
+			while(!rss_q.empty() && rs_fifo_out.num_free()) {
+				uint32_t rss = rss_q.front();
+				unsigned tid = (rss >> 3) & 0x3Fu;
+				bool rnw = (rss & (1u << 2)) != 0;
+
+				if(rnw && rsd_q.empty())
+					break;
+
+				rss_q.pop_front();
+				if(m_issued[tid].empty()) {
+					std::cerr << name() << ": response to unknown transaction "
+						<< tid << "!" << std::endl;
+					if(rnw)
+						rsd_q.pop_front();
+					continue;
+				}
+
+				vxe::vxe_mem_rq rq = m_issued[tid].front();
+				m_issued[tid].pop_front();
+				--m_pending;
+
+				rq.res = vxe::rtl::err_to_res(rss & 3u);
+				if(rnw) {
+					rq.data_u64[0] = rsd_q.front();
+					rsd_q.pop_front();
+				}
+
+				rs_fifo_out.write(rq);
+			}
+		}
+	}
+
+	std::deque<vxe::vxe_mem_rq> m_issued[vxe::rtl::TXNID_NUM];	// Issued requests per transaction Id
+	unsigned m_pending;	// Requests waiting for response
+};
+
+
+/**
+ * AXI4 master port adapter
+ * Acts as AXI4 slave for RTL master port. AXI4 transactions are converted
+ * to memory requests and their responses are returned on AXI4 response
+ * channels. Read bursts of up to MAX_BURST beats are passed as burst
+ * requests, writes are single beat. AXI4 Id is carried in transaction Id field.
+ * Note: RTL memory hub and AXI4 master BIU issue single beat transactions
+ * only (ARLEN = AWLEN = 0).
+ */
+SC_MODULE(vxe_rtl_master_port) {
+	sc_in<bool> clk;
+	sc_in<bool> nrst;
+
+	// Memory master side
+	sc_fifo_out<vxe::vxe_mem_rq> rq_fifo_out;	// Requests to memory master
+	sc_fifo_in<vxe::vxe_mem_rq> rs_fifo_in;		// Responses from memory master
+
+	// AXI4 slave interface
+	sc_in<uint32_t>		AWID;
+	sc_in<uint64_t>		AWADDR;
+	sc_in<uint32_t>		AWLEN;
+	sc_in<bool>		AWVALID;
+	sc_out<bool>		AWREADY;
+	sc_in<uint64_t>		WDATA;
+	sc_in<uint32_t>		WSTRB;
+	sc_in<bool>		WVALID;
+	sc_out<bool>		WREADY;
+	sc_out<uint32_t>	BID;
+	sc_out<uint32_t>	BRESP;
+	sc_out<bool>		BVALID;
+	sc_in<bool>		BREADY;
+	sc_in<uint32_t>		ARID;
+	sc_in<uint64_t>		ARADDR;
+	sc_in<uint32_t>		ARLEN;
+	sc_in<bool>		ARVALID;
+	sc_out<bool>		ARREADY;
+	sc_out<uint32_t>	RID;
+	sc_out<uint64_t>	RDATA;
+	sc_out<uint32_t>	RRESP;
+	sc_out<bool>		RLAST;
+	sc_out<bool>		RVALID;
+	sc_in<bool>		RREADY;
+
+	SC_HAS_PROCESS(vxe_rtl_master_port);
+
+	/**
+	 * Constructor
+	 * @param name module name
+	 */
+	explicit vxe_rtl_master_port(::sc_core::sc_module_name name)
+		: sc_module(name), clk("clk"), nrst("nrst")
+		, rq_fifo_out("rq_fifo_out"), rs_fifo_in("rs_fifo_in")
+		, AWID("AWID"), AWADDR("AWADDR"), AWLEN("AWLEN"), AWVALID("AWVALID"), AWREADY("AWREADY")
+		, WDATA("WDATA"), WSTRB("WSTRB"), WVALID("WVALID"), WREADY("WREADY")
+		, BID("BID"), BRESP("BRESP"), BVALID("BVALID"), BREADY("BREADY")
+		, ARID("ARID"), ARADDR("ARADDR"), ARLEN("ARLEN"), ARVALID("ARVALID"), ARREADY("ARREADY")
+		, RID("RID"), RDATA("RDATA"), RRESP("RRESP"), RLAST("RLAST"), RVALID("RVALID")
+		, RREADY("RREADY")
+		, m_pending(0)
+	{
+		SC_THREAD(request_thread);
+			sensitive << clk.pos();
+
+		SC_THREAD(response_thread);
+			sensitive << clk.pos();
+	}
+
+	/**
+	 * Bind AXI4 signals (unused AXI4 attributes are not connected)
+	 * @param s AXI4 signals
+	 */
+	void bind(vxe::rtl::axi4_signals& s)
+	{
+		AWID(s.AWID);
+		AWADDR(s.AWADDR);
+		AWLEN(s.AWLEN);
+		AWVALID(s.AWVALID);
+		AWREADY(s.AWREADY);
+		WDATA(s.WDATA);
+		WSTRB(s.WSTRB);
+		WVALID(s.WVALID);
+		WREADY(s.WREADY);
+		BID(s.BID);
+		BRESP(s.BRESP);
+		BVALID(s.BVALID);
+		BREADY(s.BREADY);
+		ARID(s.ARID);
+		ARADDR(s.ARADDR);
+		ARLEN(s.ARLEN);
+		ARVALID(s.ARVALID);
+		ARREADY(s.ARREADY);
+		RID(s.RID);
+		RDATA(s.RDATA);
+		RRESP(s.RRESP);
+		RLAST(s.RLAST);
+		RVALID(s.RVALID);
+		RREADY(s.RREADY);
+	}
+
+	/**
+	 * Number of requests waiting for response
+	 */
+	unsigned pending() const { return m_pending; }
+
+private:
+	// Address and data channels
+	[[noreturn]] void request_thread()
+	{
+		bool aw_held = false;	// Write address is received
+		bool w_held = false;	// Write data is received
+		vxe::vxe_mem_rq wr;	// Write request being assembled
+
+		ARREADY.write(false);
+		AWREADY.write(false);
+		WREADY.write(false);
+
+		// Wait for reset release
+		while(!nrst) wait();
+
+		while(true) {
+			// Accept read only if there is a room for a write completed in the same cycle
+			bool ar_ready = rq_fifo_out.num_free() >= 2;
+			bool aw_ready = !aw_held;
+			bool w_ready = !w_held;
+
+			ARREADY.write(ar_ready);
+			AWREADY.write(aw_ready);
+			WREADY.write(w_ready);
+
+			wait();
+
+			if(ar_ready && ARVALID.read()) {
+				vxe::vxe_mem_rq rd;
+				if(ARLEN.read() >= vxe::vxe_mem_rq::MAX_BURST)
+					std::cerr << name() << ": read burst is too long!" << std::endl;
+				else
+					rd.len = ARLEN.read() + 1;
+				rd.tid = ARID.read();
+				rd.addr = ARADDR.read();
+				rd.req = vxe::vxe_mem_rq::rqtype::REQ_RD;
+				rd.set_ben_mask(0xFF);
+				rq_fifo_out.write(rd);
+				++m_pending;
+			}
+
+			if(aw_ready && AWVALID.read()) {
+				if(AWLEN.read() != 0)
+					std::cerr << name() << ": write bursts are not supported!" << std::endl;
+				wr.tid = AWID.read();
+				wr.addr = AWADDR.read();
+				wr.req = vxe::vxe_mem_rq::rqtype::REQ_WR;
+				aw_held = true;
+			}
+
+			if(w_ready && WVALID.read()) {
+				wr.data_u64[0] = WDATA.read();
+				wr.set_ben_mask(WSTRB.read());
+				w_held = true;
+			}
+
+			if(aw_held && w_held && rq_fifo_out.num_free()) {
+				rq_fifo_out.write(wr);
+				++m_pending;
+				wr = vxe::vxe_mem_rq();
+				aw_held = w_held = false;
+			}
+		}
+	}
+
+	// Response channels
+	[[noreturn]] void response_thread()
+	{
+		RVALID.write(false);
+		BVALID.write(false);
+
+		// Wait for reset release
+		while(!nrst) wait();
+
+		while(true) {
+			if(!rs_fifo_in.num_available()) {
+				RVALID.write(false);
+				BVALID.write(false);
+				wait();
+				continue;
+			}
+
+			vxe::vxe_mem_rq rq = rs_fifo_in.read();
+			if(rq.last_beat())
+				--m_pending;
+
+			if(rq.req == vxe::vxe_mem_rq::rqtype::REQ_RD) {
+				BVALID.write(false);
+				RVALID.write(true);
+				RID.write(rq.tid);
+				RDATA.write(rq.data_u64[0]);
+				RRESP.write(vxe::rtl::res_to_axi4(rq.res));
+				RLAST.write(rq.last_beat());
+				do { wait(); } while(!RREADY.read());
+			} else {
+				RVALID.write(false);
+				BVALID.write(true);
+				BID.write(rq.tid);
+				BRESP.write(vxe::rtl::res_to_axi4(rq.res));
+				do { wait(); } while(!BREADY.read());
+			}
+		}
+	}
+
+	unsigned m_pending;	// Requests waiting for response
+};
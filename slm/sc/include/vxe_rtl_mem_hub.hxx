@@ -0,0 +1,289 @@
+/*
+ * Copyright (c) 2022 The VxEngine Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * VxEngine Memory Hub built around Verilated RTL model
+ */
+
+#include <iostream>
+#include <string>
+#include <systemc.h>
+#include "register_set.hxx"
+#include "vxe_common.hxx"
+#include "vxe_internal.hxx"
+#include "vxe_profiler.hxx"
+#include "vxe_tracer.hxx"
+#include "vxe_rtl_adapter.hxx"
+#include "obj_dir/Vvl_axi4_mem_hub.h"
+#pragma once
+
+
+// Bind AXI4 master port of RTL memory hub to signals
+#define VXE_RTL_BIND_AXI4(mp, s)		\
+	do {					\
+		rtl.mp##_AXI4_AWID(s.AWID);	\
+		rtl.mp##_AXI4_AWADDR(s.AWADDR);	\
+		rtl.mp##_AXI4_AWLEN(s.AWLEN);	\
+		rtl.mp##_AXI4_AWSIZE(s.AWSIZE);	\
+		rtl.mp##_AXI4_AWBURST(s.AWBURST);	\
+		rtl.mp##_AXI4_AWLOCK(s.AWLOCK);	\
+		rtl.mp##_AXI4_AWCACHE(s.AWCACHE);	\
+		rtl.mp##_AXI4_AWPROT(s.AWPROT);	\
+		rtl.mp##_AXI4_AWVALID(s.AWVALID);	\
+		rtl.mp##_AXI4_AWREADY(s.AWREADY);	\
+		rtl.mp##_AXI4_WDATA(s.WDATA);	\
+		rtl.mp##_AXI4_WSTRB(s.WSTRB);	\
+		rtl.mp##_AXI4_WLAST(s.WLAST);	\
+		rtl.mp##_AXI4_WVALID(s.WVALID);	\
+		rtl.mp##_AXI4_WREADY(s.WREADY);	\
+		rtl.mp##_AXI4_BID(s.BID);	\
+		rtl.mp##_AXI4_BRESP(s.BRESP);	\
+		rtl.mp##_AXI4_BVALID(s.BVALID);	\
+		rtl.mp##_AXI4_BREADY(s.BREADY);	\
+		rtl.mp##_AXI4_ARID(s.ARID);	\
+		rtl.mp##_AXI4_ARADDR(s.ARADDR);	\
+		rtl.mp##_AXI4_ARLEN(s.ARLEN);	\
+		rtl.mp##_AXI4_ARSIZE(s.ARSIZE);	\
+		rtl.mp##_AXI4_ARBURST(s.ARBURST);	\
+		rtl.mp##_AXI4_ARLOCK(s.ARLOCK);	\
+		rtl.mp##_AXI4_ARCACHE(s.ARCACHE);	\
+		rtl.mp##_AXI4_ARPROT(s.ARPROT);	\
+		rtl.mp##_AXI4_ARVALID(s.ARVALID);	\
+		rtl.mp##_AXI4_ARREADY(s.ARREADY);	\
+		rtl.mp##_AXI4_RID(s.RID);	\
+		rtl.mp##_AXI4_RDATA(s.RDATA);	\
+		rtl.mp##_AXI4_RRESP(s.RRESP);	\
+		rtl.mp##_AXI4_RLAST(s.RLAST);	\
+		rtl.mp##_AXI4_RVALID(s.RVALID);	\
+		rtl.mp##_AXI4_RREADY(s.RREADY);	\
+	} while(0)
+
+// Bind client port of RTL memory hub to signals
+#define VXE_RTL_BIND_CLIENT(cl, s)		\
+	do {					\
+		rtl.o_##cl##_rqa_rdy(s.rqa_rdy);	\
+		rtl.i_##cl##_rqa(s.rqa);	\
+		rtl.i_##cl##_rqa_wr(s.rqa_wr);	\
+		rtl.o_##cl##_rss_vld(s.rss_vld);	\
+		rtl.o_##cl##_rss(s.rss);	\
+		rtl.i_##cl##_rss_rd(s.rss_rd);	\
+		rtl.o_##cl##_rsd_vld(s.rsd_vld);	\
+		rtl.o_##cl##_rsd(s.rsd);	\
+		rtl.i_##cl##_rsd_rd(s.rsd_rd);	\
+	} while(0)
+
+
+// VxEngine Memory Hub (Verilated RTL)
+VXE_MODULE(vxe_rtl_mem_hub) {
+	sc_in<bool> clk;
+	sc_in<bool> nrst;
+
+	// Control Unit memory interface
+	sc_fifo_in<vxe::vxe_mem_rq> cu_fifo_in;
+	sc_fifo_out<vxe::vxe_mem_rq> cu_fifo_out;
+
+	// Vector Processing Units memory interfaces (RTL has two VPU clients)
+	sc_vector<sc_fifo_in<vxe::vxe_mem_rq>> vpu_fifo_in;
+	sc_vector<sc_fifo_out<vxe::vxe_mem_rq>> vpu_fifo_out;
+
+	// External master interfaces (RTL has two master ports)
+	sc_vector<sc_fifo_in<vxe::vxe_mem_rq>> master_fifo_in;
+	sc_vector<sc_fifo_out<vxe::vxe_mem_rq>> master_fifo_out;
+
+	SC_HAS_PROCESS(vxe_rtl_mem_hub);
+
+	/**
+	 * Constructor
+	 * @param name module name
+	 * @param regs VxE register file
+	 * @param event_driven unused, RTL model is evaluated on every clock cycle
+	 * @param fifo_depth unused, RTL model has fixed FIFO sizes
+	 * @param vpus number of VPU clients (RTL model supports only two)
+	 * @param masters number of master ports (RTL model supports only two)
+	 * @param route routing policy (RTL model routes by argument only)
+	 */
+	vxe_rtl_mem_hub(::sc_core::sc_module_name name, register_set_if<uint32_t>& regs,
+			bool event_driven = true, unsigned fifo_depth = 16, unsigned vpus = 2,
+			unsigned masters = 2, const vxe::hub_route& route = vxe::hub_route())
+		: vxe_prof_module(name), clk("clk"), nrst("nrst")
+		, cu_fifo_in("cu_fifo_in"), cu_fifo_out("cu_fifo_out")
+		, vpu_fifo_in("vpu_fifo_in", 2), vpu_fifo_out("vpu_fifo_out", 2)
+		, master_fifo_in("master_fifo_in", 2), master_fifo_out("master_fifo_out", 2)
+		, m_regs(regs), rtl("rtl"), cu_port("cu_port"), vpu0_port("vpu0_port")
+		, vpu1_port("vpu1_port"), master0_port("master0_port"), master1_port("master1_port")
+		, cu_m_sel("cu_m_sel")
+	{
+		(void)event_driven;
+		(void)fifo_depth;
+
+		if(vpus != 2)
+			std::cerr << this->name() << ": RTL memory hub supports only two VPUs!"
+				<< std::endl;
+		if(masters != 2)
+			std::cerr << this->name() << ": RTL memory hub supports only two master ports!"
+				<< std::endl;
+		if(route.pol != vxe::hub_route::policy::ARG)
+			std::cerr << this->name() << ": RTL memory hub supports only routing by argument!"
+				<< std::endl;
+
+		SC_METHOD(cu_m_sel_method);
+			sensitive << clk.pos();
+
+		// RTL memory hub
+		rtl.clk(clk);
+		rtl.nrst(nrst);
+		rtl.i_cu_m_sel(cu_m_sel);
+		VXE_RTL_BIND_AXI4(M0, m0_s);
+		VXE_RTL_BIND_AXI4(M1, m1_s);
+		VXE_RTL_BIND_CLIENT(cu, cu_s);
+		VXE_RTL_BIND_CLIENT(vpu0, vpu0_s);
+		VXE_RTL_BIND_CLIENT(vpu1, vpu1_s);
+		rtl.o_vpu0_rqd_rdy(vpu0_s.rqd_rdy);
+		rtl.i_vpu0_rqd(vpu0_s.rqd);
+		rtl.i_vpu0_rqd_wr(vpu0_s.rqd_wr);
+		rtl.o_vpu1_rqd_rdy(vpu1_s.rqd_rdy);
+		rtl.i_vpu1_rqd(vpu1_s.rqd);
+		rtl.i_vpu1_rqd_wr(vpu1_s.rqd_wr);
+
+		// Client adapters (CU data channel is left unconnected)
+		cu_port.clk(clk);
+		cu_port.nrst(nrst);
+		cu_port.rq_fifo_in(cu_fifo_in);
+		cu_port.rs_fifo_out(cu_fifo_out);
+		cu_port.bind(cu_s);
+
+		vpu0_port.clk(clk);
+		vpu0_port.nrst(nrst);
+		vpu0_port.rq_fifo_in(vpu_fifo_in[0]);
+		vpu0_port.rs_fifo_out(vpu_fifo_out[0]);
+		vpu0_port.bind(vpu0_s);
+
+		vpu1_port.clk(clk);
+		vpu1_port.nrst(nrst);
+		vpu1_port.rq_fifo_in(vpu_fifo_in[1]);
+		vpu1_port.rs_fifo_out(vpu_fifo_out[1]);
+		vpu1_port.bind(vpu1_s);
+
+		// Master adapters
+		master0_port.clk(clk);
+		master0_port.nrst(nrst);
+		master0_port.rq_fifo_out(master_fifo_out[0]);
+		master0_port.rs_fifo_in(master_fifo_in[0]);
+		master0_port.bind(m0_s);
+
+		master1_port.clk(clk);
+		master1_port.nrst(nrst);
+		master1_port.rq_fifo_out(master_fifo_out[1]);
+		master1_port.rs_fifo_in(master_fifo_in[1]);
+		master1_port.bind(m1_s);
+	}
+
+	/**
+	 * Number of external master ports
+	 */
+	unsigned masters() const { return 2; }
+
+	/**
+	 * Check that no requests are in flight inside the hub
+	 * @return true if all client requests are completed
+	 */
+	bool idle() const
+	{
+		return !cu_port.pending() && !vpu0_port.pending() && !vpu1_port.pending();
+	}
+
+	/**
+	 * Register waveform probes
+	 * @param tr waveform tracer
+	 */
+	void trace_probes(vxe_tracer& tr) const
+	{
+		const std::string nm = name();
+		const std::pair<const char*, const vxe::rtl::client_signals*> clients[] = {
+			{ "cu", &cu_s }, { "vpu0", &vpu0_s }, { "vpu1", &vpu1_s }
+		};
+		const std::pair<const char*, const vxe::rtl::axi4_signals*> masters[] = {
+			{ "m0", &m0_s }, { "m1", &m1_s }
+		};
+
+		tr.add_signal(cu_m_sel, nm + ".cu_m_sel");
+		for(const auto& c : clients) {
+			const std::string p = nm + "." + c.first + ".";
+			tr.add_signal(c.second->rqa_rdy, p + "rqa_rdy");
+			tr.add_signal(c.second->rqa, p + "rqa");
+			tr.add_signal(c.second->rqa_wr, p + "rqa_wr");
+			tr.add_signal(c.second->rqd_wr, p + "rqd_wr");
+			tr.add_signal(c.second->rss_vld, p + "rss_vld");
+			tr.add_signal(c.second->rss, p + "rss");
+			tr.add_signal(c.second->rss_rd, p + "rss_rd");
+			tr.add_signal(c.second->rsd_vld, p + "rsd_vld");
+			tr.add_signal(c.second->rsd, p + "rsd");
+			tr.add_signal(c.second->rsd_rd, p + "rsd_rd");
+		}
+		for(const auto& m : masters) {
+			const std::string p = nm + "." + m.first + ".";
+			tr.add_signal(m.second->AWVALID, p + "AWVALID");
+			tr.add_signal(m.second->AWREADY, p + "AWREADY");
+			tr.add_signal(m.second->AWADDR, p + "AWADDR");
+			tr.add_signal(m.second->WVALID, p + "WVALID");
+			tr.add_signal(m.second->WREADY, p + "WREADY");
+			tr.add_signal(m.second->BVALID, p + "BVALID");
+			tr.add_signal(m.second->BREADY, p + "BREADY");
+			tr.add_signal(m.second->ARVALID, p + "ARVALID");
+			tr.add_signal(m.second->ARREADY, p + "ARREADY");
+			tr.add_signal(m.second->ARADDR, p + "ARADDR");
+			tr.add_signal(m.second->RVALID, p + "RVALID");
+			tr.add_signal(m.second->RREADY, p + "RREADY");
+		}
+	}
+
+private:
+	// Master for CU requests is selected through REG_CTRL register
+	void cu_m_sel_method()
+	{
+		cu_m_sel.write((m_regs.get_reg(vxe::regi::REG_CTRL)
+			& vxe::bits::REG_CTRL::CU_MAS_SEL_MASK) != 0);
+	}
+
+	register_set_if<uint32_t>& m_regs;
+
+	Vvl_axi4_mem_hub rtl;	// Verilated memory hub
+
+	vxe_rtl_client_port cu_port;
+	vxe_rtl_client_port vpu0_port;
+	vxe_rtl_client_port vpu1_port;
+	vxe_rtl_master_port master0_port;
+	vxe_rtl_master_port master1_port;
+
+	sc_signal<bool> cu_m_sel;
+	vxe::rtl::client_signals cu_s;
+	vxe::rtl::client_signals vpu0_s;
+	vxe::rtl::client_signals vpu1_s;
+	vxe::rtl::axi4_signals m0_s;
+	vxe::rtl::axi4_signals m1_s;
+};
+
+#undef VXE_RTL_BIND_CLIENT
+#undef VXE_RTL_BIND_AXI4
@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2022 The VxEngine Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Sampled simulation control
+ * SMARTS-style systematic sampling of VxEngine program runs: each sampling
+ * period fast-forwards N runs on the functional model, then runs W warm-up
+ * and M measured runs on the detailed model. Total cycles are extrapolated
+ * from measured runs.
+ */
+
+#include <cmath>
+#include <cstdint>
+#pragma once
+
+
+// Sampled simulation control
+class vxe_sampler {
+public:
+	// Program run mode
+	enum class mode {
+		DETAILED,	// Detailed model, cycles are measured
+		WARMUP,		// Detailed model, cycles are not measured
+		FUNCTIONAL	// Functional model
+	};
+
+	vxe_sampler()
+		: m_ffwd(0), m_warmup(0), m_detail(0)
+		, m_runs(0), m_func_runs(0), m_warmup_runs(0)
+		, m_samples(0), m_mean(0), m_m2(0)
+	{}
+
+	/**
+	 * Set sampling parameters
+	 * @param ffwd number of functional runs per period
+	 * @param warmup number of warm-up runs per period
+	 * @param detail number of measured runs per period (0 disables sampling)
+	 */
+	void configure(unsigned ffwd, unsigned warmup, unsigned detail)
+	{
+		m_ffwd = ffwd;
+		m_warmup = warmup;
+		m_detail = detail;
+	}
+
+	/**
+	 * Sampling is enabled
+	 */
+	bool enabled() const { return m_detail != 0; }
+
+	/**
+	 * Get mode for the next program run
+	 */
+	mode next()
+	{
+		uint64_t pos = m_runs++ % (m_ffwd + m_warmup + m_detail);
+
+		if(pos < m_ffwd) {
+			++m_func_runs;
+			return mode::FUNCTIONAL;
+		} else if(pos < m_ffwd + m_warmup) {
+			++m_warmup_runs;
+			return mode::WARMUP;
+		}
+
+		return mode::DETAILED;
+	}
+
+	/**
+	 * Add measured run
+	 * @param cycles run duration in clock cycles
+	 */
+	void add_sample(double cycles)
+	{
+		// Welford's online algorithm
+		++m_samples;
+		double d = cycles - m_mean;
+		m_mean += d / m_samples;
+		m_m2 += d * (cycles - m_mean);
+	}
+
+	/**
+	 * Total number of program runs
+	 */
+	uint64_t runs() const { return m_runs; }
+
+	/**
+	 * Number of functional runs
+	 */
+	uint64_t functional_runs() const { return m_func_runs; }
+
+	/**
+	 * Number of warm-up runs
+	 */
+	uint64_t warmup_runs() const { return m_warmup_runs; }
+
+	/**
+	 * Number of measured runs
+	 */
+	uint64_t measured_runs() const { return m_samples; }
+
+	/**
+	 * Mean cycles per run
+	 */
+	double mean() const { return m_mean; }
+
+	/**
+	 * Half-width of 95% confidence interval of mean cycles per run
+	 */
+	double ci95() const
+	{
+		if(m_samples < 2)
+			return 0;
+		return Z95 * std::sqrt(m_m2 / (m_samples - 1) / m_samples);
+	}
+
+	/**
+	 * Estimated total cycles of all runs
+	 */
+	double total() const { return m_mean * m_runs; }
+
+	/**
+	 * Half-width of 95% confidence interval of total cycles
+	 */
+	double total_ci95() const { return ci95() * m_runs; }
+
+private:
+	static constexpr double Z95 = 1.96;	// 95% confidence coefficient
+
+	// Sampling parameters
+	unsigned m_ffwd;
+	unsigned m_warmup;
+	unsigned m_detail;
+	// Runs statistics
+	uint64_t m_runs;
+	uint64_t m_func_runs;
+	uint64_t m_warmup_runs;
+	// Measured runs statistics
+	uint64_t m_samples;
+	double m_mean;
+	double m_m2;
+};
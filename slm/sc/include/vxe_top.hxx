@@ -27,9 +27,16 @@
  * VxEngine top
  */
 
+#include <algorithm>
+#include <cstring>
+#include <functional>
 #include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
 #include <systemc.h>
 #include <tlm.h>
+#include <tlm_utils/tlm_quantumkeeper.h>
 #include "register_set.hxx"
 #include "vxe_common.hxx"
 #include "vxe_internal.hxx"
@@ -37,14 +44,24 @@
 #include "tlm_payload.hxx"
 #include "vxe_slave_port.hxx"
 #include "vxe_master_port.hxx"
-#include "vxe_mem_hub.hxx"
+#ifdef VXE_RTL_MEM_HUB
+# include "vxe_rtl_mem_hub.hxx"
+#else
+# include "vxe_mem_hub.hxx"
+#endif
 #include "vxe_ctrl_unit.hxx"
 #include "vxe_vector_unit.hxx"
+#include "vxe_func_model.hxx"
+#include "vxe_sampler.hxx"
+#include "vxe_profiler.hxx"
+#include "checkpoint.hxx"
+#include "sim_config.hxx"
+#include "vxe_tracer.hxx"
 #pragma once
 
 
 // VxEngine top module
-SC_MODULE(vxe_top) {
+VXE_MODULE(vxe_top) {
 	// Data sizes
 	static constexpr unsigned IO_WIDTH	= 32;
 	static constexpr unsigned MEM_WIDTH	= 64;
@@ -55,51 +72,81 @@ SC_MODULE(vxe_top) {
 	sc_out<bool> o_intr;
 
 	tlm::tlm_target_socket<IO_WIDTH> io_target;
-	tlm::tlm_initiator_socket<MEM_WIDTH> mem_initiator0;
-	tlm::tlm_initiator_socket<MEM_WIDTH> mem_initiator1;
+	sc_vector<tlm::tlm_initiator_socket<MEM_WIDTH>> mem_initiator;
 
 	// Instances of internal blocks
+#ifdef VXE_RTL_MEM_HUB
+	vxe_rtl_mem_hub mem_hub;	// Memory Hub (Verilated RTL)
+#else
 	vxe_mem_hub mem_hub;	// Memory Hub
+#endif
 	vxe_ctrl_unit cu;	// Control Unit
-	vxe_vector_unit vpu0;	// Vector Processing Unit 0
-	vxe_vector_unit vpu1;	// Vector Processing Unit 1
-
-	SC_CTOR(vxe_top)
-		: clk("clk"), nrst("nrst")
-		, o_intr("o_intr")
-		, mem_hub("mem_hub", m_regs)
-		, cu("cu", vxe::mhc::CU, m_regs)
-		, vpu0("vpu0", vxe::mhc::VPU0), vpu1("vpu1", vxe::mhc::VPU1)
-		, m_io_slave("m_io_slave"), m_mem_master0("m_mem_master0"), m_mem_master1("m_mem_master1")
-	{
-		SC_THREAD(mem_master0_thread);
-			sensitive << clk.pos();
+	sc_vector<vxe_vector_unit> vpu;	// Vector Processing Units
 
-		SC_THREAD(mem_master1_thread);
-			sensitive << clk.pos();
+	SC_HAS_PROCESS(vxe_top);
+
+	/**
+	 * Constructor
+	 * @param nm module name
+	 * @param cfg model configuration (FIFO depths, FMAC pipeline depth, number of VPUs,
+	 *        threads, FMAC lanes and memory ports, memory hub routing, burst length)
+	 */
+	explicit vxe_top(::sc_core::sc_module_name nm, const sim_config& cfg = sim_config())
+		: vxe_prof_module(nm), clk("clk"), nrst("nrst")
+		, o_intr("o_intr"), mem_initiator("mem_initiator", mem_ports(cfg))
+		, mem_hub("mem_hub", m_regs, true, cfg.fifo_depth, vpu_count(cfg), mem_ports(cfg),
+			hub_route(cfg))
+		, cu("cu", vxe::mhc::CU, m_regs, vpu_count(cfg))
+		, vpu("vpu", vpu_count(cfg), vpu_creator(cfg))
+		, m_io_slave("m_io_slave"), m_mem_master("m_mem_master", mem_ports(cfg))
+		, m_lt_mode(false), m_mem_qk(mem_ports(cfg)), m_dmi_mode(false)
+		, cu_fifo_us("cu_fifo_us", cfg.fifo_depth)
+		, vpu_fifo_us("vpu_fifo_us", vpu_count(cfg), fifo_creator(cfg.fifo_depth))
+		, master_fifo_us("master_fifo_us", mem_ports(cfg), fifo_creator(cfg.fifo_depth))
+		, cu_fifo_ds("cu_fifo_ds", cfg.fifo_depth)
+		, vpu_fifo_ds("vpu_fifo_ds", vpu_count(cfg), fifo_creator(cfg.fifo_depth))
+		, master_fifo_ds("master_fifo_ds", mem_ports(cfg), fifo_creator(cfg.fifo_depth))
+		, vxe_start_fifo("vxe_start_fifo")
+		, s_vpu_busy("s_vpu_busy", vpu_count(cfg)), s_vpu_err("s_vpu_err", vpu_count(cfg))
+		, s_cmd_select("s_cmd_select", vpu_count(cfg)), s_cmd_ack("s_cmd_ack", vpu_count(cfg))
+		, s_cmd_op("s_cmd_op", vpu_count(cfg)), s_cmd_thread("s_cmd_thread", vpu_count(cfg))
+		, s_cmd_wdata("s_cmd_wdata", vpu_count(cfg))
+		, m_run_mode(vxe_sampler::mode::DETAILED), m_run_pending(false), m_run_busy(false)
+		, m_func_model([this](uint64_t addr, uint64_t len) -> uint8_t*
+			{
+				return func_mem_map(addr, len);
+			}, vpu_count(cfg), cfg.vpu_threads, vxe_vector_unit::lane_count(cfg.fmac_lanes))
+	{
+		// Memory master port threads
+		for(unsigned p = 0; p < mem_initiator.size(); ++p) {
+			m_dmi.emplace_back(new master_dmi());
+			sc_spawn_options opts;
+			opts.set_sensitivity(&clk.pos());
+			const std::string mp = "mem_master" + std::to_string(p);
+			sc_spawn(sc_bind(&vxe_top::mem_master_thread, this, p),
+				(mp + "_thread").c_str(), &opts);
+			sc_spawn(sc_bind(&vxe_top::dmi_resp_thread, this, p),
+				(mp + "_dmi_resp_thread").c_str(), &opts);
+		}
 
 		SC_THREAD(vxe_start_ctrl_thread);
 			sensitive << clk.pos();
 
+		SC_METHOD(sample_run_method);
+			sensitive << s_cu_busy_in;
+			dont_initialize();
+
+		SC_METHOD(busy_time_method);
+			sensitive << s_cu_busy_in;
+			dont_initialize();
+
 		// Init TLM sockets
 		io_target(m_io_slave);
-		mem_initiator0(m_mem_master0);
-		mem_initiator1(m_mem_master1);
+		for(unsigned p = 0; p < mem_initiator.size(); ++p)
+			mem_initiator[p](m_mem_master[p]);
 
 		// Set registers
-		m_regs.set_reg(vxe::regi::REG_ID, vxe::VXENGINE_ID);
-		m_regs.set_reg(vxe::regi::REG_CTRL, 0);
-		m_regs.set_reg(vxe::regi::REG_STATUS, 0);
-		m_regs.set_reg(vxe::regi::REG_INTR_ACT, 0);
-		m_regs.set_reg(vxe::regi::REG_INTR_MSK, 0);
-		m_regs.set_reg(vxe::regi::REG_INTR_RAW, 0);
-		m_regs.set_reg(vxe::regi::REG_PGM_ADDR_LO, 0);
-		m_regs.set_reg(vxe::regi::REG_PGM_ADDR_HI, 0);
-		m_regs.set_reg(vxe::regi::REG_FAULT_INSTR_ADDR_LO, 0);
-		m_regs.set_reg(vxe::regi::REG_FAULT_INSTR_ADDR_HI, 0);
-		m_regs.set_reg(vxe::regi::REG_FAULT_INSTR_LO, 0);
-		m_regs.set_reg(vxe::regi::REG_FAULT_INSTR_HI, 0);
-		m_regs.set_reg(vxe::regi::REG_FAULT_VPU_MASK0, 0);
+		reset_regs();
 
 		// Set slave port handler
 		m_io_slave.set_handler(
@@ -111,42 +158,42 @@ SC_MODULE(vxe_top) {
 		);
 
 		// Set master ports handlers
-		m_mem_master0.set_handler(
-			[&](tlm::tlm_generic_payload& trans, tlm::tlm_phase& phase, sc_time& t) -> tlm::tlm_sync_enum
-			{
-				if(phase != tlm::tlm_phase_enum::BEGIN_RESP)
-					std::cerr << name() << ": wrong response phase on master 0!" << std::endl;
-
-				handle_downstream(&trans, master0_fifo_ds);
-
-				return tlm::TLM_COMPLETED;
-			}
-		);
-		m_mem_master1.set_handler(
-			[&](tlm::tlm_generic_payload& trans, tlm::tlm_phase& phase, sc_time& t) -> tlm::tlm_sync_enum
-			{
-				if(phase != tlm::tlm_phase_enum::BEGIN_RESP)
-					std::cerr << name() << ": wrong response phase on master 1!" << std::endl;
+		for(unsigned p = 0; p < m_mem_master.size(); ++p) {
+			m_mem_master[p].set_handler(
+				[this, p](tlm::tlm_generic_payload& trans, tlm::tlm_phase& phase, sc_time& t)
+					-> tlm::tlm_sync_enum
+				{
+					if(phase != tlm::tlm_phase_enum::BEGIN_RESP)
+						std::cerr << name() << ": wrong response phase on master "
+							<< p << "!" << std::endl;
 
-				handle_downstream(&trans, master1_fifo_ds);
+					handle_downstream(&trans, master_fifo_ds[p]);
+					retire_request(*m_dmi[p]);
 
-				return tlm::TLM_COMPLETED;
-			}
-		);
+					return tlm::TLM_COMPLETED;
+				}
+			);
+			m_mem_master[p].set_invalidate_handler(
+				[this, p](sc_dt::uint64 start, sc_dt::uint64 end)
+				{
+					dmi_invalidate(*m_dmi[p], start, end);
+				}
+			);
+		}
 
 		// Setup memory hub connections
 		mem_hub.clk(clk);
 		mem_hub.nrst(nrst);
 		mem_hub.cu_fifo_in(cu_fifo_us);
 		mem_hub.cu_fifo_out(cu_fifo_ds);
-		mem_hub.vpu0_fifo_in(vpu0_fifo_us);
-		mem_hub.vpu0_fifo_out(vpu0_fifo_ds);
-		mem_hub.vpu1_fifo_in(vpu1_fifo_us);
-		mem_hub.vpu1_fifo_out(vpu1_fifo_ds);
-		mem_hub.master0_fifo_in(master0_fifo_ds);
-		mem_hub.master0_fifo_out(master0_fifo_us);
-		mem_hub.master1_fifo_in(master1_fifo_ds);
-		mem_hub.master1_fifo_out(master1_fifo_us);
+		for(unsigned v = 0; v < vpu.size(); ++v) {
+			mem_hub.vpu_fifo_in[v](vpu_fifo_us[v]);
+			mem_hub.vpu_fifo_out[v](vpu_fifo_ds[v]);
+		}
+		for(unsigned p = 0; p < mem_initiator.size(); ++p) {
+			mem_hub.master_fifo_in[p](master_fifo_ds[p]);
+			mem_hub.master_fifo_out[p](master_fifo_us[p]);
+		}
 		// Setup control unit connections
 		cu.clk(clk);
 		cu.nrst(nrst);
@@ -155,47 +202,461 @@ SC_MODULE(vxe_top) {
 		cu.mem_fifo_out(cu_fifo_us);
 		cu.i_start(s_cu_start_out);
 		cu.o_busy(s_cu_busy_in);
-		cu.i_vpu0_busy(s_vpu0_busy);
-		cu.i_vpu1_busy(s_vpu1_busy);
-		cu.i_vpu0_err(s_vpu0_err);
-		cu.i_vpu1_err(s_vpu1_err);
-		// Setup vector processing units connections
-		vpu0.clk(clk);
-		vpu0.nrst(nrst);
-		vpu0.mem_fifo_in(vpu0_fifo_ds);
-		vpu0.mem_fifo_out(vpu0_fifo_us);
-		vpu0.o_busy(s_vpu0_busy);
-		vpu1.clk(clk);
-		vpu1.nrst(nrst);
-		vpu1.mem_fifo_in(vpu1_fifo_ds);
-		vpu1.mem_fifo_out(vpu1_fifo_us);
-		vpu1.o_busy(s_vpu1_busy);
-		// Setup VPUs command buses connections
-		cu.o_cmd_select_vpu0(s_cmd_select_vpu0);
-		cu.i_cmd_ack_vpu0(s_cmd_ack_vpu0);
-		cu.o_cmd_op_vpu0(s_cmd_op_vpu0);
-		cu.o_cmd_thread_vpu0(s_cmd_thread_vpu0);
-		cu.o_cmd_wdata_vpu0(s_cmd_wdata_vpu0);
-		cu.o_cmd_select_vpu1(s_cmd_select_vpu1);
-		cu.i_cmd_ack_vpu1(s_cmd_ack_vpu1);
-		cu.o_cmd_op_vpu1(s_cmd_op_vpu1);
-		cu.o_cmd_thread_vpu1(s_cmd_thread_vpu1);
-		cu.o_cmd_wdata_vpu1(s_cmd_wdata_vpu1);
-		vpu0.i_cmd_select(s_cmd_select_vpu0);
-		vpu0.o_cmd_ack(s_cmd_ack_vpu0);
-		vpu0.o_err(s_vpu0_err);
-		vpu0.i_cmd_op(s_cmd_op_vpu0);
-		vpu0.i_cmd_thread(s_cmd_thread_vpu0);
-		vpu0.i_cmd_wdata(s_cmd_wdata_vpu0);
-		vpu1.i_cmd_select(s_cmd_select_vpu1);
-		vpu1.o_cmd_ack(s_cmd_ack_vpu1);
-		vpu1.o_err(s_vpu1_err);
-		vpu1.i_cmd_op(s_cmd_op_vpu1);
-		vpu1.i_cmd_thread(s_cmd_thread_vpu1);
-		vpu1.i_cmd_wdata(s_cmd_wdata_vpu1);
+		// Setup vector processing units and command buses connections
+		for(unsigned v = 0; v < vpu.size(); ++v) {
+			cu.i_vpu_busy[v](s_vpu_busy[v]);
+			cu.i_vpu_err[v](s_vpu_err[v]);
+			cu.o_cmd_select[v](s_cmd_select[v]);
+			cu.i_cmd_ack[v](s_cmd_ack[v]);
+			cu.o_cmd_op[v](s_cmd_op[v]);
+			cu.o_cmd_thread[v](s_cmd_thread[v]);
+			cu.o_cmd_wdata[v](s_cmd_wdata[v]);
+			vpu[v].clk(clk);
+			vpu[v].nrst(nrst);
+			vpu[v].mem_fifo_in(vpu_fifo_ds[v]);
+			vpu[v].mem_fifo_out(vpu_fifo_us[v]);
+			vpu[v].o_busy(s_vpu_busy[v]);
+			vpu[v].o_err(s_vpu_err[v]);
+			vpu[v].i_cmd_select(s_cmd_select[v]);
+			vpu[v].o_cmd_ack(s_cmd_ack[v]);
+			vpu[v].i_cmd_op(s_cmd_op[v]);
+			vpu[v].i_cmd_thread(s_cmd_thread[v]);
+			vpu[v].i_cmd_wdata(s_cmd_wdata[v]);
+		}
+	}
+
+	/**
+	 * Set loosely-timed mode
+	 * In this mode memory masters use b_transport() with temporal decoupling.
+	 * @param enable =true to enable loosely-timed mode
+	 * @param clk_period clock period
+	 */
+	void set_lt_mode(bool enable, const sc_time& clk_period)
+	{
+		m_lt_mode = enable;
+		m_clk_period = clk_period;
+	}
+
+	/**
+	 * Select CU to VPU command interface
+	 * Transaction-level channel delivers queued VPU instructions as batches
+	 * without per-command handshakes on command bus signals.
+	 * @param tlm =true to use transaction-level channel
+	 */
+	void set_cmd_channel(bool tlm)
+	{
+		for(unsigned v = 0; v < vpu.size(); ++v)
+			cu.set_cmd_channel(v, tlm ? &vpu[v] : nullptr);
+	}
+
+	/**
+	 * Set DMI mode
+	 * In this mode memory masters access memory directly through DMI
+	 * pointers when target grants them and fall back to transport otherwise.
+	 * @param enable =true to enable DMI mode
+	 * @param latency additional access latency
+	 */
+	void set_dmi_mode(bool enable, const sc_time& latency)
+	{
+		m_dmi_mode = enable;
+		m_dmi_latency = latency;
+	}
+
+	/**
+	 * Set sampled simulation mode
+	 * Programs are fast-forwarded on functional model and periodically run
+	 * on detailed model to measure cycles. Requires DMI access to memory.
+	 * @param ffwd number of functional runs per sampling period
+	 * @param warmup number of detailed warm-up runs per sampling period
+	 * @param detail number of detailed measured runs per sampling period (0 disables sampling)
+	 */
+	void set_sampling(unsigned ffwd, unsigned warmup, unsigned detail)
+	{
+		m_sampler.configure(ffwd, warmup, detail);
+	}
+
+	/**
+	 * Sampled simulation statistics
+	 */
+	const vxe_sampler& sampler() const { return m_sampler; }
+
+	/**
+	 * Execute VPUs on separate host threads during functional runs
+	 * @param enable true to enable
+	 */
+	void set_parallel(bool enable)
+	{
+		m_func_model.set_parallel(enable);
+	}
+
+	/**
+	 * Functional model parallel mode statistics
+	 */
+	const vxe_func_model<vxe_vector_unit::NT>::par_stats& parallel_stats() const
+	{
+		return m_func_model.stats();
+	}
+
+	/**
+	 * Total time VxEngine control unit was busy executing programs
+	 */
+	sc_time busy_time() const
+	{
+		return s_cu_busy_in.read() ? m_busy_time + (sc_time_stamp() - m_busy_start) : m_busy_time;
+	}
+
+	/**
+	 * Check that VxEngine is quiescent: units are not busy and there are
+	 * no requests in flight
+	 * @return true if idle
+	 */
+	bool idle() const
+	{
+		if(s_cu_busy_in.read())
+			return false;
+		for(unsigned v = 0; v < vpu.size(); ++v)
+			if(s_vpu_busy[v].read() || vpu_fifo_us[v].num_available() || vpu_fifo_ds[v].num_available())
+				return false;
+		if(!mem_hub.idle() || cu_fifo_us.num_available() || cu_fifo_ds.num_available())
+			return false;
+		for(unsigned p = 0; p < mem_initiator.size(); ++p)
+			if(m_dmi[p]->pending || master_fifo_us[p].num_available()
+					|| master_fifo_ds[p].num_available())
+				return false;
+
+		return vxe_start_fifo.num_available() == 0;
+	}
+
+	/**
+	 * Set hook called on MMIO register writes (before the write takes effect)
+	 * @param hook function receiving register offset and written value
+	 */
+	void set_mmio_write_hook(std::function<void(unsigned, uint32_t)> hook)
+	{
+		m_mmio_write_hook = std::move(hook);
+	}
+
+	/**
+	 * Register trace probes of VxEngine registers, internal signals and units
+	 * @param tr tracer
+	 */
+	void trace_probes(vxe_tracer& tr) const
+	{
+		static const char* const reg_names[vxe::regi::REGS_NUMBER] = {
+			"REG_ID", "REG_CTRL", "REG_STATUS", "REG_INTR_ACT", "REG_INTR_MSK",
+			"REG_INTR_RAW", "REG_PGM_ADDR_LO", "REG_PGM_ADDR_HI", "REG_START",
+			"REG_FAULT_INSTR_ADDR_LO", "REG_FAULT_INSTR_ADDR_HI", "REG_FAULT_INSTR_LO",
+			"REG_FAULT_INSTR_HI", "REG_FAULT_VPU_MASK0"
+		};
+		const std::string n = name();
+
+		for(unsigned i = 0; i < m_regs.size(); ++i)
+			tr.add(n + ".regs." + reg_names[i], IO_WIDTH,
+				[this, i]() -> uint64_t { return m_regs.get_reg(i); });
+
+		tr.add_signal(o_intr);
+		tr.add_signal(s_cu_start_out, n + ".s_cu_start_out");
+		tr.add_signal(s_cu_busy_in, n + ".s_cu_busy_in");
+		for(unsigned v = 0; v < vpu.size(); ++v) {
+			tr.add_signal(s_vpu_busy[v], s_vpu_busy[v].name());
+			tr.add_signal(s_vpu_err[v], s_vpu_err[v].name());
+			tr.add_signal(s_cmd_select[v], s_cmd_select[v].name());
+			tr.add_signal(s_cmd_ack[v], s_cmd_ack[v].name());
+			tr.add_signal(s_cmd_op[v], s_cmd_op[v].name());
+			tr.add_signal(s_cmd_thread[v], s_cmd_thread[v].name());
+			tr.add_signal(s_cmd_wdata[v], s_cmd_wdata[v].name());
+		}
+
+		mem_hub.trace_probes(tr);
+		cu.trace_probes(tr);
+		for(const auto& v : vpu)
+			v.trace_probes(tr);
+	}
+
+	/**
+	 * Save register file and units state (VxEngine must be idle)
+	 * @param wr checkpoint writer
+	 */
+	void save_state(ckpt::writer& wr) const
+	{
+		wr.put_tag("VXE ");
+		wr.put(uint32_t(m_regs.size()));
+		for(unsigned i = 0; i < m_regs.size(); ++i)
+			wr.put(m_regs.get_reg(i));
+		cu.save_state(wr);
+		wr.put(uint32_t(vpu.size()));
+		for(const auto& v : vpu)
+			v.save_state(wr);
+	}
+
+	/**
+	 * Restore register file and units state (VxEngine must be idle)
+	 * @param rd checkpoint reader
+	 * @return true on success
+	 */
+	bool load_state(ckpt::reader& rd)
+	{
+		uint32_t nregs = 0;
+		if(!rd.expect_tag("VXE ") || !rd.get(nregs) || nregs != m_regs.size())
+			return false;
+		for(unsigned i = 0; i < nregs; ++i) {
+			uint32_t v;
+			if(!rd.get(v))
+				return false;
+			m_regs.set_reg(i, v);
+		}
+		uint32_t nvpus = 0;
+		if(!cu.load_state(rd) || !rd.get(nvpus) || nvpus != vpu.size())
+			return false;
+		for(auto& v : vpu)
+			if(!v.load_state(rd))
+				return false;
+
+		// Re-evaluate interrupt output for restored interrupt registers
+		cu.notify_intr_ack();
+
+		return true;
+	}
+
+	/**
+	 * Reset register file and units state to power-on values (VxEngine must be idle)
+	 */
+	void reset_state()
+	{
+		reset_regs();
+		cu.reset_state();
+		for(auto& v : vpu)
+			v.reset_state();
+
+		// Re-evaluate interrupt output for cleared interrupt registers
+		cu.notify_intr_ack();
+	}
+
+	/**
+	 * Number of VPUs for configuration
+	 * @param cfg model configuration
+	 */
+	static unsigned vpu_count(const sim_config& cfg)
+	{
+#ifdef VXE_RTL_MEM_HUB
+		(void)cfg;
+		return 2;	// RTL memory hub has two VPU clients
+#else
+		return std::min(std::max(cfg.vpu_count, 1u), vxe::MAX_VPUS);
+#endif
+	}
+
+	/**
+	 * Number of memory master ports for configuration
+	 * @param cfg model configuration
+	 */
+	static unsigned mem_ports(const sim_config& cfg)
+	{
+#ifdef VXE_RTL_MEM_HUB
+		(void)cfg;
+		return 2;	// RTL memory hub has two master ports
+#else
+		return std::max(cfg.mem_ports, 1u);
+#endif
+	}
+
+	/**
+	 * Maximum length of VPU load bursts for configuration
+	 * (limited by VPU FIFO depth)
+	 * @param cfg model configuration
+	 */
+	static unsigned burst_len(const sim_config& cfg)
+	{
+#ifdef VXE_RTL_MEM_HUB
+		(void)cfg;
+		return 1;	// RTL memory hub client channels are single beat
+#else
+		return vxe_vector_unit::burst_count(cfg.burst_len, cfg.vpu_fifo_depth);
+#endif
+	}
+
+	/**
+	 * Boundary VPU load bursts do not cross for configuration
+	 * (a burst is routed by its start address, so it stays within
+	 * an interleaving granule)
+	 * @param cfg model configuration
+	 */
+	static unsigned burst_boundary(const sim_config& cfg)
+	{
+		return cfg.hub_route == "interleave"
+			? vxe_vector_unit::burst_boundary(cfg.hub_granule)
+			: vxe_vector_unit::BURST_BOUNDARY;
 	}
 
 private:
+	// Returns memory hub routing policy for configuration
+	static vxe::hub_route hub_route(const sim_config& cfg)
+	{
+		vxe::hub_route r;
+		if(cfg.hub_route == "interleave")
+			r.pol = vxe::hub_route::policy::INTERLEAVE;
+		else if(cfg.hub_route == "table")
+			r.pol = vxe::hub_route::policy::TABLE;
+		r.granule = cfg.hub_granule;
+		r.table = cfg.hub_table;
+		return r;
+	}
+
+	/**
+	 * Creator of VPUs
+	 */
+	struct vpu_creator {
+		const sim_config& cfg;
+		explicit vpu_creator(const sim_config& c) : cfg(c) {}
+		vxe_vector_unit *operator()(const char *name, size_t i) const
+		{
+			return new vxe_vector_unit(name, vxe::mhc::vpu(i), cfg.vpu_fifo_depth,
+				cfg.fmac_stages, cfg.vpu_threads, cfg.fmac_lanes, burst_len(cfg),
+				burst_boundary(cfg));
+		}
+	};
+
+	/**
+	 * Creator of memory hub interface FIFOs
+	 */
+	struct fifo_creator {
+		unsigned depth;
+		explicit fifo_creator(unsigned d) : depth(d) {}
+		vxe_fifo<vxe::vxe_mem_rq> *operator()(const char *name, size_t) const
+		{
+			return new vxe_fifo<vxe::vxe_mem_rq>(name, depth);
+		}
+	};
+
+	// Set registers to reset values
+	void reset_regs()
+	{
+		m_regs.set_reg(vxe::regi::REG_ID, vxe::VXENGINE_ID);
+		m_regs.set_reg(vxe::regi::REG_CTRL, 0);
+		m_regs.set_reg(vxe::regi::REG_STATUS, 0);
+		m_regs.set_reg(vxe::regi::REG_INTR_ACT, 0);
+		m_regs.set_reg(vxe::regi::REG_INTR_MSK, 0);
+		m_regs.set_reg(vxe::regi::REG_INTR_RAW, 0);
+		m_regs.set_reg(vxe::regi::REG_PGM_ADDR_LO, 0);
+		m_regs.set_reg(vxe::regi::REG_PGM_ADDR_HI, 0);
+		m_regs.set_reg(vxe::regi::REG_FAULT_INSTR_ADDR_LO, 0);
+		m_regs.set_reg(vxe::regi::REG_FAULT_INSTR_ADDR_HI, 0);
+		m_regs.set_reg(vxe::regi::REG_FAULT_INSTR_LO, 0);
+		m_regs.set_reg(vxe::regi::REG_FAULT_INSTR_HI, 0);
+		m_regs.set_reg(vxe::regi::REG_FAULT_VPU_MASK0, 0);
+	}
+
+	// DMI response
+	struct dmi_response {
+		vxe::vxe_mem_rq rq;	// Completed request
+		sc_time ready;		// Time when response is ready
+
+		friend std::ostream& operator<<(std::ostream& os, const dmi_response& r)
+		{
+			return os << r.rq << " @ " << r.ready;
+		}
+	};
+
+	// Master port DMI state
+	struct master_dmi {
+		tlm::tlm_dmi dmi;			// DMI region
+		bool requested;				// DMI pointer was requested
+		bool valid;				// DMI region is valid
+		bool use_dmi;				// Outstanding requests use DMI path
+		unsigned pending;			// Number of outstanding requests (DMI beats)
+		sc_event idle_event;			// No outstanding requests remain
+		sc_fifo<dmi_response> resp_fifo;	// DMI responses pipe
+
+		master_dmi() : requested(false), valid(false), use_dmi(false), pending(0) {}
+	};
+
+	// Request DMI pointer from target if not done yet
+	void dmi_request(tlm::tlm_initiator_socket<MEM_WIDTH>& port, master_dmi& md, uint64_t addr)
+	{
+		if(!md.requested) {
+			tlm::tlm_generic_payload gp;
+			gp.set_command(tlm::tlm_command::TLM_READ_COMMAND);
+			gp.set_address(addr);
+			md.valid = port->get_direct_mem_ptr(gp, md.dmi);
+			md.requested = true;
+		}
+	}
+
+	// Invalidate DMI region if it overlaps given range
+	void dmi_invalidate(master_dmi& md, sc_dt::uint64 start, sc_dt::uint64 end)
+	{
+		if(start <= md.dmi.get_end_address() && end >= md.dmi.get_start_address()) {
+			md.valid = false;
+			md.requested = false;
+		}
+	}
+
+	/**
+	 * Check if request can be handled through DMI
+	 * (requests DMI pointer from target if not done yet)
+	 * @param port master port
+	 * @param md master port DMI state
+	 * @param rq memory request
+	 * @return true if DMI region covers request
+	 */
+	bool dmi_covers(tlm::tlm_initiator_socket<MEM_WIDTH>& port, master_dmi& md,
+		const vxe::vxe_mem_rq& rq)
+	{
+		dmi_request(port, md, rq.addr);
+
+		if(!md.valid || rq.addr < md.dmi.get_start_address()
+				|| rq.addr + rq.burst_bytes() - 1 > md.dmi.get_end_address())
+			return false;
+
+		return rq.req == vxe::vxe_mem_rq::rqtype::REQ_RD ? md.dmi.is_read_allowed()
+			: md.dmi.is_write_allowed();
+	}
+
+	/**
+	 * Access memory through DMI pointer (one beat)
+	 * @param md master port DMI state
+	 * @param rq memory request (updated to response)
+	 * @return access latency
+	 */
+	sc_time dmi_access(master_dmi& md, vxe::vxe_mem_rq& rq)
+	{
+		unsigned char *p = md.dmi.get_dmi_ptr() + (rq.addr - md.dmi.get_start_address());
+
+		if(rq.req == vxe::vxe_mem_rq::rqtype::REQ_RD) {
+			memcpy(rq.data_u8, p, sizeof(rq.data_u8));
+		} else {
+			for(size_t i = 0; i < sizeof(rq.data_u8); ++i)
+				if(rq.ben[i])
+					p[i] = rq.data_u8[i];
+		}
+		rq.res = vxe::vxe_mem_rq::rstype::RES_OK;
+
+		return m_dmi_latency + (rq.req == vxe::vxe_mem_rq::rqtype::REQ_RD ?
+			md.dmi.get_read_latency() : md.dmi.get_write_latency());
+	}
+
+	/**
+	 * Wait for outstanding requests if access path changes
+	 * (keeps responses in order when switching between DMI and transport)
+	 * @param md master port DMI state
+	 * @param use_dmi =true if next request uses DMI
+	 */
+	void switch_path(master_dmi& md, bool use_dmi)
+	{
+		if(md.use_dmi != use_dmi) {
+			while(md.pending)
+				wait(md.idle_event);
+			md.use_dmi = use_dmi;
+		}
+	}
+
+	// Retire outstanding request
+	void retire_request(master_dmi& md)
+	{
+		if(md.pending && --md.pending == 0)
+			md.idle_event.notify();
+	}
+
 	void handle_mmio(tlm::tlm_generic_payload& trans, sc_time& t)
 	{
 		uint32_t v = 0;
@@ -215,8 +676,11 @@ private:
 			return;
 		}
 
-		if(trans.is_write())
+		if(trans.is_write()) {
 			v = *reinterpret_cast<const uint32_t*>(trans.get_data_ptr());
+			if(m_mmio_write_hook)
+				m_mmio_write_hook(trans.get_address(), v);
+		}
 
 		// Process request
 		switch(regi) {
@@ -240,6 +704,7 @@ private:
 					uint32_t r = m_regs.get_reg(vxe::regi::REG_INTR_ACT);
 					v = ~v & r;	// Apply ack mask
 					m_regs.set_reg(vxe::regi::REG_INTR_ACT, v & vxe::regm::REG_INTR_ACT);
+					cu.notify_intr_ack();
 				} else
 					v = m_regs.get_reg(vxe::regi::REG_INTR_ACT);
 				break;
@@ -300,10 +765,22 @@ private:
 
 		trans.set_response_status(tlm::TLM_OK_RESPONSE);
 
-		wait();	// Wait for next cycle
+		if(m_lt_mode)
+			t += m_clk_period;	// Annotate access time
+		else
+			wait();	// Wait for next cycle
+	}
+
+	// Response beat b of a burst request
+	static vxe::vxe_mem_rq burst_beat(const vxe::vxe_mem_rq& rq, unsigned b)
+	{
+		vxe::vxe_mem_rq r = rq;
+		r.addr = rq.addr + b * sizeof(rq.data_u8);
+		r.beat = b;
+		return r;
 	}
 
-	// Handler of downstream memory traffic
+	// Handler of downstream memory traffic (bursts are split into beats)
 	void handle_downstream(tlm::tlm_generic_payload *gp, sc_fifo<vxe::vxe_mem_rq>& fifo_ds)
 	{
 		// Create payload for downstream
@@ -314,7 +791,7 @@ private:
 		rq.addr = gp->get_address();
 		rq.req = (gp->get_command() == tlm::tlm_command::TLM_READ_COMMAND ?
 			vxe::vxe_mem_rq::rqtype::REQ_RD : vxe::vxe_mem_rq::rqtype::REQ_WR);
-		memcpy(rq.data_u8, gp->get_data_ptr(), sizeof(rq.data_u8));
+		rq.len = gp->get_data_length() / sizeof(rq.data_u8);
 		for(size_t i=0; i < sizeof(rq.ben); ++i) {
 			unsigned char *be = gp->get_byte_enable_ptr();
 			rq.ben[i] = (be[i] == TLM_BYTE_ENABLED);
@@ -326,35 +803,33 @@ private:
 			rq.res = (status == tlm::tlm_response_status::TLM_ADDRESS_ERROR_RESPONSE ?
 				vxe::vxe_mem_rq::rstype::RES_AE : vxe::vxe_mem_rq::rstype::RES_DE);
 			std::cerr << name() << ": Error response => " << rq << std::endl;
-			fifo_ds.write(rq);
-		} else {
+		} else
 			rq.res = vxe::vxe_mem_rq::rstype::RES_OK;
-			fifo_ds.write(rq);
+
+		// Stream response beats
+		for(unsigned b = 0; b < rq.len; ++b) {
+			vxe::vxe_mem_rq r = burst_beat(rq, b);
+			memcpy(r.data_u8, gp->get_data_ptr() + b * sizeof(r.data_u8), sizeof(r.data_u8));
+			fifo_ds.write(r);
 		}
 
 		// Release TLM payload
 		gp->release();
 	}
 
-	// Handler of upstream memory traffic
-	void handle_upstream(tlm::tlm_initiator_socket<MEM_WIDTH>& port, sc_fifo<vxe::vxe_mem_rq>& fifo_us,
-		sc_fifo<vxe::vxe_mem_rq>& fifo_ds)
+	// Create TLM payload for upstream request (byte enables repeat for each beat)
+	tlm::tlm_generic_payload *create_payload(const vxe::vxe_mem_rq& rq)
 	{
-		// Fetch new request
-		vxe::vxe_mem_rq rq;
-		rq = fifo_us.read();
-
 		// Create payload
-		tlm::tlm_generic_payload *gp = tlm_pl::alloc_gp(sizeof(rq.data_u8), sizeof(rq.ben));
-		vxe::vxe_tlm_gp_ext *ext = new vxe::vxe_tlm_gp_ext();
-		gp->set_extension(ext);
+		tlm::tlm_generic_payload *gp = tlm_pl::alloc_gp(rq.burst_bytes(), sizeof(rq.ben));
+		vxe::vxe_tlm_gp_ext *ext = tlm_pl::get_ext<vxe::vxe_tlm_gp_ext>(gp);
 
 		// Setup payload fields
 		ext->set_tid(rq.tid);
 		gp->set_command(rq.req == vxe::vxe_mem_rq::rqtype::REQ_RD ?
 			tlm::tlm_command::TLM_READ_COMMAND : tlm::tlm_command::TLM_WRITE_COMMAND);
 		gp->set_address(rq.addr);
-		gp->set_data_length(sizeof(rq.data_u8));
+		gp->set_data_length(rq.burst_bytes());
 		memcpy(gp->get_data_ptr(), rq.data_u8, sizeof(rq.data_u8));
 		gp->set_byte_enable_length(sizeof(rq.ben));
 		for(size_t i=0; i < sizeof(rq.ben); ++i) {
@@ -362,6 +837,34 @@ private:
 			be[i] = (rq.ben[i] ? TLM_BYTE_ENABLED : TLM_BYTE_DISABLED);
 		}
 
+		return gp;
+	}
+
+	// Handler of upstream memory traffic
+	void handle_upstream(tlm::tlm_initiator_socket<MEM_WIDTH>& port, master_dmi& md,
+		sc_fifo<vxe::vxe_mem_rq>& fifo_us, sc_fifo<vxe::vxe_mem_rq>& fifo_ds)
+	{
+		// Fetch new request
+		vxe::vxe_mem_rq rq;
+		rq = fifo_us.read();
+
+		// Direct memory access. Response beats are delivered by DMI response thread.
+		bool use_dmi = m_dmi_mode && dmi_covers(port, md, rq);
+		switch_path(md, use_dmi);
+		if(use_dmi) {
+			md.pending += rq.len;
+			for(unsigned b = 0; b < rq.len; ++b) {
+				vxe::vxe_mem_rq r = burst_beat(rq, b);
+				sc_time latency = dmi_access(md, r);
+				md.resp_fifo.write({ r, sc_time_stamp() + latency });
+			}
+			return;
+		}
+		++md.pending;
+
+		// Create payload
+		tlm::tlm_generic_payload *gp = create_payload(rq);
+
 		// Initiate transaction
 		tlm::tlm_phase phase(tlm::tlm_phase_enum::BEGIN_REQ);
 		sc_time t;
@@ -370,25 +873,82 @@ private:
 		wait(t);
 
 		// Check return status
-		if(ret == tlm::tlm_sync_enum::TLM_COMPLETED)
+		if(ret == tlm::tlm_sync_enum::TLM_COMPLETED) {
 			handle_downstream(gp, fifo_ds);
+			retire_request(md);
+		}
 	}
 
-	[[noreturn]] void mem_master0_thread()
+	// Handler of DMI responses (same timing as memory port responses pipe)
+	void handle_dmi_response(master_dmi& md, sc_fifo<vxe::vxe_mem_rq>& fifo_ds)
 	{
-		while(true) {
-			handle_upstream(mem_initiator0, master0_fifo_us, master0_fifo_ds);
+		wait();
+		dmi_response r = md.resp_fifo.read();
+		if(r.ready > sc_time_stamp())
+			wait(r.ready - sc_time_stamp());
+		fifo_ds.write(r.rq);
+		retire_request(md);
+	}
+
+	// Handler of upstream memory traffic (loosely-timed)
+	void handle_upstream_lt(tlm::tlm_initiator_socket<MEM_WIDTH>& port, master_dmi& md,
+		tlm_utils::tlm_quantumkeeper& qk, sc_fifo<vxe::vxe_mem_rq>& fifo_us,
+		sc_fifo<vxe::vxe_mem_rq>& fifo_ds)
+	{
+		// Synchronize before waiting for new requests
+		if(fifo_us.num_available() == 0 && qk.get_local_time() != SC_ZERO_TIME)
+			qk.sync();
+
+		// Fetch new request
+		vxe::vxe_mem_rq rq;
+		rq = fifo_us.read();
+
+		// Direct memory access (burst beats follow the first one on each clock cycle)
+		if(m_dmi_mode && dmi_covers(port, md, rq)) {
+			for(unsigned b = 0; b < rq.len; ++b) {
+				vxe::vxe_mem_rq r = burst_beat(rq, b);
+				sc_time latency = dmi_access(md, r);
+				qk.inc(b == 0 ? latency : m_clk_period);
+				fifo_ds.write(r);
+			}
+			if(qk.need_sync())
+				qk.sync();
+			return;
 		}
 
+		// Create payload
+		tlm::tlm_generic_payload *gp = create_payload(rq);
+
+		// Do transaction with local time annotation
+		sc_time t = qk.get_local_time();
+		port->b_transport(*gp, t);
+		qk.set(t);
+
+		handle_downstream(gp, fifo_ds);
+
+		if(qk.need_sync())
+			qk.sync();
 	}
 
-	[[noreturn]] void mem_master1_thread()
+	[[noreturn]] void mem_master_thread(unsigned p)
 	{
+		m_mem_qk[p].reset();
+
 		while(true) {
-			handle_upstream(mem_initiator1, master1_fifo_us, master1_fifo_ds);
+			if(m_lt_mode)
+				handle_upstream_lt(mem_initiator[p], *m_dmi[p], m_mem_qk[p],
+					master_fifo_us[p], master_fifo_ds[p]);
+			else
+				handle_upstream(mem_initiator[p], *m_dmi[p], master_fifo_us[p], master_fifo_ds[p]);
 		}
 	}
 
+	[[noreturn]] void dmi_resp_thread(unsigned p)
+	{
+		while(true)
+			handle_dmi_response(*m_dmi[p], master_fifo_ds[p]);
+	}
+
 	[[noreturn]] void vxe_start_ctrl_thread()
 	{
 		s_cu_start_out.write(false);
@@ -397,6 +957,16 @@ private:
 			bool s = vxe_start_fifo.read();
 			// Ignore all start requests if CU is already busy
 			if(s && !s_cu_busy_in.read()) {
+				m_run_mode = (m_sampler.enabled() ? m_sampler.next() : vxe_sampler::mode::DETAILED);
+
+				// Fast-forward on functional model
+				if(m_run_mode == vxe_sampler::mode::FUNCTIONAL && run_functional()) {
+					wait();
+					continue;
+				}
+
+				m_run_pending = m_sampler.enabled();
+				m_run_start = sc_time_stamp();
 				s_cu_start_out.write(true);
 				wait();
 				s_cu_start_out.write(false);
@@ -405,42 +975,127 @@ private:
 		}
 	}
 
+	// Map memory range for functional model (returns nullptr if not accessible through DMI)
+	uint8_t *func_mem_map(uint64_t addr, uint64_t len)
+	{
+		dmi_request(mem_initiator[0], *m_dmi[0], addr);
+
+		const tlm::tlm_dmi& dmi = m_dmi[0]->dmi;
+		if(!m_dmi[0]->valid || !dmi.is_read_write_allowed() || addr < dmi.get_start_address()
+				|| len > dmi.get_end_address() - addr + 1)
+			return nullptr;
+
+		return dmi.get_dmi_ptr() + (addr - dmi.get_start_address());
+	}
+
+	// Run program on functional model. Architectural state is moved from
+	// detailed units and back. Returns false if functional model is not usable.
+	bool run_functional()
+	{
+		uint64_t pgm_lo = m_regs.get_reg(vxe::regi::REG_PGM_ADDR_LO);
+		uint64_t pgm_hi = m_regs.get_reg(vxe::regi::REG_PGM_ADDR_HI);
+		uint64_t pgm = (pgm_hi << 32u) | pgm_lo;
+
+		if(!func_mem_map(pgm, sizeof(vxe::instr::generic))) {
+			std::cerr << name() << ": program is not accessible through DMI, sampling is disabled!"
+				<< std::endl;
+			m_sampler.configure(0, 0, 0);
+			return false;
+		}
+
+		std::vector<vxe_vector_unit::arch_state> st(vpu.size());
+		for(unsigned v = 0; v < vpu.size(); ++v)
+			vpu[v].get_arch_state(st[v]);
+
+		// DMI pointer is requested above, so mapper is safe to call from VPU worker threads
+		auto r = m_func_model.run(pgm, st.data());
+
+		for(unsigned v = 0; v < vpu.size(); ++v)
+			vpu[v].set_arch_state(st[v]);
+		cu.set_pgm_counter(r.pgm_counter);
+
+		if(r.data_errors)
+			std::cerr << name() << ": " << r.data_errors
+				<< " data vectors are not accessible through DMI!" << std::endl;
+
+		if(r.intr)
+			cu.post_intr(r.intr);
+
+		return true;
+	}
+
+	// Accumulate VxEngine busy time
+	void busy_time_method()
+	{
+		if(s_cu_busy_in.read())
+			m_busy_start = sc_time_stamp();
+		else
+			m_busy_time += sc_time_stamp() - m_busy_start;
+	}
+
+	// Track detailed program runs for sampled simulation
+	void sample_run_method()
+	{
+		vxe_profiler::scope prof;
+
+		if(s_cu_busy_in.read()) {
+			m_run_busy = m_run_pending;
+			return;
+		}
+
+		if(!m_run_busy)
+			return;
+
+		m_run_busy = m_run_pending = false;
+
+		if(m_run_mode == vxe_sampler::mode::DETAILED)
+			m_sampler.add_sample((sc_time_stamp() - m_run_start) / m_clk_period);
+	}
+
 private:
 	// Register set
 	register_set<uint32_t, vxe::regi::REGS_NUMBER> m_regs;
+	// MMIO register write hook
+	std::function<void(unsigned, uint32_t)> m_mmio_write_hook;
 	// Port transaction handlers
 	vxe_slave_port<IO_WIDTH> m_io_slave;
-	vxe_master_port<MEM_WIDTH> m_mem_master0;
-	vxe_master_port<MEM_WIDTH> m_mem_master1;
+	sc_vector<vxe_master_port<MEM_WIDTH>> m_mem_master;
+	// Loosely-timed mode
+	bool m_lt_mode;
+	sc_time m_clk_period;
+	std::vector<tlm_utils::tlm_quantumkeeper> m_mem_qk;
+	// Direct memory interface mode
+	bool m_dmi_mode;
+	sc_time m_dmi_latency;
+	std::vector<std::unique_ptr<master_dmi>> m_dmi;
 	// Memory hub interface - upstream FIFOs
-	sc_fifo<vxe::vxe_mem_rq> cu_fifo_us;
-	sc_fifo<vxe::vxe_mem_rq> vpu0_fifo_us;
-	sc_fifo<vxe::vxe_mem_rq> vpu1_fifo_us;
-	sc_fifo<vxe::vxe_mem_rq> master0_fifo_us;
-	sc_fifo<vxe::vxe_mem_rq> master1_fifo_us;
+	vxe_fifo<vxe::vxe_mem_rq> cu_fifo_us;
+	sc_vector<vxe_fifo<vxe::vxe_mem_rq>> vpu_fifo_us;
+	sc_vector<vxe_fifo<vxe::vxe_mem_rq>> master_fifo_us;
 	// Memory hub interface - downstream FIFOs
-	sc_fifo<vxe::vxe_mem_rq> cu_fifo_ds;
-	sc_fifo<vxe::vxe_mem_rq> vpu0_fifo_ds;
-	sc_fifo<vxe::vxe_mem_rq> vpu1_fifo_ds;
-	sc_fifo<vxe::vxe_mem_rq> master0_fifo_ds;
-	sc_fifo<vxe::vxe_mem_rq> master1_fifo_ds;
+	vxe_fifo<vxe::vxe_mem_rq> cu_fifo_ds;
+	sc_vector<vxe_fifo<vxe::vxe_mem_rq>> vpu_fifo_ds;
+	sc_vector<vxe_fifo<vxe::vxe_mem_rq>> master_fifo_ds;
 	// Internal control
-	sc_fifo<bool> vxe_start_fifo;
+	vxe_fifo<bool> vxe_start_fifo;
 	sc_signal<bool> s_cu_start_out;
 	sc_signal<bool> s_cu_busy_in;
-	sc_signal<bool> s_vpu0_busy;
-	sc_signal<bool> s_vpu1_busy;
-	sc_signal<bool> s_vpu0_err;
-	sc_signal<bool> s_vpu1_err;
+	sc_vector<sc_signal<bool>> s_vpu_busy;
+	sc_vector<sc_signal<bool>> s_vpu_err;
 	// VPUs command busses
-	sc_signal<bool> s_cmd_select_vpu0;
-	sc_signal<bool> s_cmd_ack_vpu0;
-	sc_signal<uint8_t> s_cmd_op_vpu0;
-	sc_signal<uint8_t> s_cmd_thread_vpu0;
-	sc_signal<uint64_t> s_cmd_wdata_vpu0;
-	sc_signal<bool> s_cmd_select_vpu1;
-	sc_signal<bool> s_cmd_ack_vpu1;
-	sc_signal<uint8_t> s_cmd_op_vpu1;
-	sc_signal<uint8_t> s_cmd_thread_vpu1;
-	sc_signal<uint64_t> s_cmd_wdata_vpu1;
+	sc_vector<sc_signal<bool>> s_cmd_select;
+	sc_vector<sc_signal<bool>> s_cmd_ack;
+	sc_vector<sc_signal<uint8_t>> s_cmd_op;
+	sc_vector<sc_signal<uint8_t>> s_cmd_thread;
+	sc_vector<sc_signal<uint64_t>> s_cmd_wdata;
+	// Sampled simulation
+	vxe_sampler m_sampler;
+	vxe_sampler::mode m_run_mode;	// Mode of current program run
+	bool m_run_pending;		// Detailed run is started
+	bool m_run_busy;		// Detailed run is in progress
+	sc_time m_run_start;		// Detailed run start time
+	vxe_func_model<vxe_vector_unit::NT> m_func_model;	// Functional model
+	// Utilization statistics
+	sc_time m_busy_time;		// Total busy time
+	sc_time m_busy_start;		// Start of current busy period
 };
@@ -0,0 +1,425 @@
+/*
+ * Copyright (c) 2022 The VxEngine Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Windowed waveform tracer
+ * Samples registered probes (signals, ports, registers and FIFO levels) on
+ * the positive clock edge and writes value changes into gzip-compressed VCD.
+ * Capture is limited to a time window and can be started by a trigger for a
+ * given number of cycles. Outside of capture the sampling process sleeps and
+ * costs nothing.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <zlib.h>
+#include <systemc.h>
+#pragma once
+
+
+// Windowed waveform tracer
+SC_MODULE(vxe_tracer) {
+	sc_in<bool> clk;
+
+	SC_HAS_PROCESS(vxe_tracer);
+
+	/**
+	 * Constructor
+	 * @param name module name
+	 */
+	explicit vxe_tracer(::sc_core::sc_module_name name)
+		: sc_module(name), clk("clk")
+		, m_file(nullptr), m_start(SC_ZERO_TIME), m_end(sc_max_time())
+		, m_trigger_mode(false), m_trigger_cycles(0)
+		, m_state(state::INIT), m_left(0), m_force(false)
+		, m_triggers(0), m_cycles(0)
+	{
+		SC_METHOD(sample_method);
+			sensitive << clk.pos();
+	}
+
+	~vxe_tracer()
+	{
+		close();
+	}
+
+	/**
+	 * Open trace file
+	 * @param file file name (.vcd.gz)
+	 * @return true on success
+	 */
+	bool open(const std::string& file)
+	{
+		m_file = gzopen(file.c_str(), "wb1");
+		if(!m_file) {
+			std::cerr << name() << ": failed to open trace file: " << file << "!" << std::endl;
+			return false;
+		}
+		gzbuffer(m_file, GZ_BUFFER_SIZE);
+		return true;
+	}
+
+	/**
+	 * Close trace file
+	 */
+	void close()
+	{
+		if(!m_file)
+			return;
+		if(m_state == state::CAPTURE)
+			stop(sc_time_stamp());
+		gzclose(m_file);
+		m_file = nullptr;
+	}
+
+	/**
+	 * Set capture window (capture is not possible outside of it)
+	 * @param start window start time
+	 * @param end window end time
+	 */
+	void set_window(const sc_time& start, const sc_time& end)
+	{
+		m_start = start;
+		m_end = end;
+	}
+
+	/**
+	 * Enable trigger mode: capture starts on trigger() only
+	 * @param cycles number of cycles to capture after trigger
+	 */
+	void set_trigger(unsigned cycles)
+	{
+		m_trigger_mode = true;
+		m_trigger_cycles = cycles;
+	}
+
+	/**
+	 * Trigger capture (restarts cycles count if capture is in progress)
+	 */
+	void trigger()
+	{
+		const sc_time now = sc_time_stamp();
+
+		if(!m_trigger_mode || now < m_start || now >= m_end)
+			return;
+
+		++m_triggers;
+		m_left = m_trigger_cycles;
+		if(m_state == state::WAIT_TRIGGER)
+			m_trigger_event.notify(SC_ZERO_TIME);
+	}
+
+	/**
+	 * Add probe
+	 * @param name hierarchical name (scopes are separated by '.')
+	 * @param width value width in bits (1 to 64)
+	 * @param get function returning current value
+	 */
+	void add(const std::string& name, unsigned width, std::function<uint64_t()> get)
+	{
+		m_probes.emplace_back(name, std::min(std::max(width, 1u), 64u), std::move(get));
+	}
+
+	/**
+	 * Add signal or port probe
+	 * @param sig signal or port
+	 * @param name hierarchical name (signal name is used if empty)
+	 */
+	template<typename S>
+	void add_signal(const S& sig, const std::string& name = std::string())
+	{
+		using T = typename std::decay<decltype(sig.read())>::type;
+		add(name.empty() ? std::string(sig.name()) : name,
+			std::is_same<T, bool>::value ? 1 : 8 * sizeof(T),
+			[&sig]() -> uint64_t { return static_cast<uint64_t>(sig.read()); });
+	}
+
+	/**
+	 * Add FIFO fill level probe
+	 * @param fifo FIFO
+	 */
+	template<typename T>
+	void add_fifo(const sc_fifo<T>& fifo)
+	{
+		add(std::string(fifo.name()) + ".level", 8,
+			[&fifo]() -> uint64_t { return fifo.num_available(); });
+	}
+
+	/**
+	 * Number of accepted triggers
+	 */
+	uint64_t triggers() const { return m_triggers; }
+
+	/**
+	 * Number of captured clock cycles
+	 */
+	uint64_t cycles() const { return m_cycles; }
+
+private:
+	static constexpr unsigned GZ_BUFFER_SIZE = 1024*1024;
+
+	// Capture state
+	enum class state {
+		INIT,		// Not started
+		WAIT_TRIGGER,	// Waiting for a trigger
+		CAPTURE,	// Capture in progress
+		DONE		// Capture window ended
+	};
+
+	// Probe
+	struct probe {
+		std::string name;		// Hierarchical name
+		unsigned width;			// Width in bits
+		std::function<uint64_t()> get;	// Value getter
+		std::string id;			// VCD identifier
+		uint64_t last;			// Last dumped value
+		probe(const std::string& n, unsigned w, std::function<uint64_t()>&& g)
+			: name(n), width(w), get(std::move(g)), last(0) {}
+	};
+
+	void start_of_simulation() override
+	{
+		if(m_file)
+			write_header();
+	}
+
+	/**
+	 * Sampling process
+	 * Sleeps on dynamic sensitivity outside of capture.
+	 */
+	void sample_method()
+	{
+		const sc_time now = sc_time_stamp();
+
+		if(!m_file || m_probes.empty() || m_state == state::DONE) {
+			next_trigger(m_never_event);
+			return;
+		}
+
+		switch(m_state) {
+			case state::INIT:
+				if(m_trigger_mode) {
+					m_state = state::WAIT_TRIGGER;
+					next_trigger(m_trigger_event);
+					return;
+				}
+				m_state = state::CAPTURE;
+				m_force = true;
+				if(now < m_start) {
+					next_trigger(m_start - now);
+					return;
+				}
+				break;
+			case state::WAIT_TRIGGER:
+				m_state = state::CAPTURE;
+				m_force = true;
+				break;
+			default:
+				break;
+		}
+
+		// Window end or trigger cycles elapsed
+		if(now >= m_end || (m_trigger_mode && m_left == 0)) {
+			stop(now);
+			if(now >= m_end) {
+				m_state = state::DONE;
+				next_trigger(m_never_event);
+			} else {
+				m_state = state::WAIT_TRIGGER;
+				next_trigger(m_trigger_event);
+			}
+			return;
+		}
+
+		dump(now);
+		++m_cycles;
+		if(m_trigger_mode)
+			--m_left;
+	}
+
+	/**
+	 * Dump changed values
+	 * @param now current time
+	 */
+	void dump(const sc_time& now)
+	{
+		m_buf.clear();
+		for(auto& p : m_probes) {
+			uint64_t v = p.get();
+			if(!m_force && v == p.last)
+				continue;
+			p.last = v;
+			put_value(p, v);
+		}
+		m_force = false;
+
+		if(!m_buf.empty())
+			write_time(now);
+	}
+
+	/**
+	 * Mark all values unknown at the end of capture
+	 * @param now current time
+	 */
+	void stop(const sc_time& now)
+	{
+		m_buf.clear();
+		for(const auto& p : m_probes) {
+			if(p.width == 1)
+				m_buf += 'x';
+			else
+				m_buf += "bx ";
+			m_buf += p.id;
+			m_buf += '\n';
+		}
+		write_time(now);
+	}
+
+	/**
+	 * Write timestamp followed by buffered value changes
+	 * @param now current time
+	 */
+	void write_time(const sc_time& now)
+	{
+		std::string ts = "#" + std::to_string(now.value()) + "\n";
+		gzwrite(m_file, ts.data(), ts.size());
+		gzwrite(m_file, m_buf.data(), m_buf.size());
+	}
+
+	/**
+	 * Append value change to the buffer
+	 * @param p probe
+	 * @param v value
+	 */
+	void put_value(const probe& p, uint64_t v)
+	{
+		if(p.width == 1) {
+			m_buf += (v & 1u ? '1' : '0');
+		} else {
+			m_buf += 'b';
+			int msb = 63;
+			while(msb > 0 && !((v >> msb) & 1u))
+				--msb;
+			for(int i = msb; i >= 0; --i)
+				m_buf += ((v >> i) & 1u ? '1' : '0');
+			m_buf += ' ';
+		}
+		m_buf += p.id;
+		m_buf += '\n';
+	}
+
+	/**
+	 * Write VCD header with scopes built from hierarchical probe names
+	 */
+	void write_header()
+	{
+		std::stable_sort(m_probes.begin(), m_probes.end(),
+			[](const probe& a, const probe& b)
+			{
+				return split(scope_of(a.name)) < split(scope_of(b.name));
+			});
+
+		std::string hdr;
+		hdr += "$version VxEngine system model $end\n";
+		hdr += "$timescale " + sc_get_time_resolution().to_string() + " $end\n";
+
+		std::vector<std::string> cur;	// Current scope path
+		unsigned n = 0;
+		for(auto& p : m_probes) {
+			std::vector<std::string> path = split(p.name);
+			std::string leaf = path.back();
+			path.pop_back();
+
+			// Leave and enter scopes
+			size_t common = 0;
+			while(common < cur.size() && common < path.size() && cur[common] == path[common])
+				++common;
+			for(size_t i = cur.size(); i > common; --i)
+				hdr += "$upscope $end\n";
+			for(size_t i = common; i < path.size(); ++i)
+				hdr += "$scope module " + path[i] + " $end\n";
+			cur = path;
+
+			p.id = make_id(n++);
+			hdr += "$var wire " + std::to_string(p.width) + " " + p.id + " " + leaf + " $end\n";
+		}
+		for(size_t i = cur.size(); i > 0; --i)
+			hdr += "$upscope $end\n";
+		hdr += "$enddefinitions $end\n";
+
+		gzwrite(m_file, hdr.data(), hdr.size());
+	}
+
+	// Scope part of hierarchical name
+	static std::string scope_of(const std::string& name)
+	{
+		size_t dot = name.rfind('.');
+		return dot == std::string::npos ? std::string() : name.substr(0, dot);
+	}
+
+	// Split hierarchical name
+	static std::vector<std::string> split(const std::string& name)
+	{
+		std::vector<std::string> parts;
+		size_t pos = 0, dot;
+		while((dot = name.find('.', pos)) != std::string::npos) {
+			parts.push_back(name.substr(pos, dot - pos));
+			pos = dot + 1;
+		}
+		parts.push_back(name.substr(pos));
+		return parts;
+	}
+
+	// Make short VCD identifier from printable characters
+	static std::string make_id(unsigned n)
+	{
+		std::string id;
+		do {
+			id += char('!' + n % 94);
+			n /= 94;
+		} while(n);
+		return id;
+	}
+
+	gzFile m_file;			// Trace file
+	std::vector<probe> m_probes;	// Registered probes
+	std::string m_buf;		// Value changes buffer
+	sc_time m_start;		// Window start
+	sc_time m_end;			// Window end
+	bool m_trigger_mode;		// Capture is started by triggers
+	unsigned m_trigger_cycles;	// Cycles to capture after trigger
+	state m_state;			// Capture state
+	unsigned m_left;		// Cycles left to capture
+	bool m_force;			// Dump all values on next sample
+	uint64_t m_triggers;		// Accepted triggers
+	uint64_t m_cycles;		// Captured cycles
+	sc_event m_trigger_event;	// Capture is triggered
+	sc_event m_never_event;		// Never notified
+};
@@ -25,21 +25,54 @@
 
 /*
  * VxEngine Vector Processing Unit
+ *
+ * Vector products are computed by 1, 2 or 4 FMAC lanes. Element n of a vector
+ * is accumulated by lane n % lanes: lane 0 into thread accumulator, other
+ * lanes into partial accumulators starting from +0.0. Each step rounds as
+ * hwfmac::mac(acc, rs, rt). When all products are done, partial accumulators
+ * of lanes that received elements are added to thread accumulator in lane
+ * order as hwfmac::mac(acc, pacc, 1.0), which rounds as a single addition.
+ * With one lane results are bit-exact with sequential hwfmac::mac reference,
+ * with several lanes they differ only by summation order.
+ *
+ * Sequential Rs/Rt words are loaded by read bursts; beats of a burst response
+ * are streamed to thread FIFOs as they arrive. Bursts do not cross 4KB or
+ * smaller burst boundary (e.g. interleaving granule of memory hub).
  */
 
+#include <algorithm>
 #include <iostream>
+#include <string>
 #include <systemc.h>
 #include "vxe_common.hxx"
 #include "vxe_internal.hxx"
 #include "vxe_fifo64x32.hxx"
 #include "vxe_pipe.hxx"
-#include "obj_dir/Vflp32_mac_5stg.h"
-#include "obj_dir/Vflp32_relu.h"
+#include "vxe_clock_sync.hxx"
+#include "vxe_profiler.hxx"
+#include "checkpoint.hxx"
+#include "vxe_tracer.hxx"
+#ifdef VXE_NATIVE_FPU
+# include "flp32_mac_5stg.hxx"
+# include "flp32_relu.hxx"
+#else
+# include "obj_dir/Vflp32_mac_5stg.h"
+# include "obj_dir/Vflp32_relu.h"
+#endif
 
 
 // VxEngine Vector Processing Unit
-SC_MODULE(vxe_vector_unit) {
+VXE_MODULE(vxe_vector_unit), public vxe::vpu_cmd_if {
 	static constexpr unsigned NT = 8;	// Number of threads per VPU
+	static constexpr unsigned FIFO_DEPTH = 16;	// Default depth of 64-to-32 FIFOs
+	static constexpr unsigned MAX_FIFO_DEPTH = 64;	// Maximum depth of 64-to-32 FIFOs
+	static constexpr unsigned FMAC_STAGES = 5;	// Default FMAC pipeline depth (as in RTL)
+	static constexpr unsigned MAX_FMAC_STAGES = 16;	// Maximum FMAC pipeline depth
+	static constexpr unsigned MAX_FMAC_LANES = 4;	// Maximum number of FMAC lanes
+	static constexpr unsigned BURST_BOUNDARY = 4096;	// Bursts never cross this boundary
+	static constexpr uint32_t FP32_ONE = 0x3F800000;	// 1.0f (merge of partial accumulators)
+
+	using arch_state = vxe::vpu_arch_state<NT>;	// Architectural state
 
 	sc_in<bool> clk;
 	sc_in<bool> nrst;
@@ -59,30 +92,89 @@ SC_MODULE(vxe_vector_unit) {
 	sc_in<uint8_t> i_cmd_thread;
 	sc_in<uint64_t> i_cmd_wdata;
 
-	// FMAC32 unit
-	Vflp32_mac_5stg fmac32;
-	vxe_pipe<uint8_t, 5> thr_id_pipe;
+	// FMAC32 units (one per lane)
+#ifdef VXE_NATIVE_FPU
+	using fmac32_unit = flp32_mac_5stg;
+#else
+	using fmac32_unit = Vflp32_mac_5stg;
+#endif
+	sc_vector<fmac32_unit> fmac32;
+	vxe_pipe<uint8_t, MAX_FMAC_STAGES> thr_id_pipe;
 
 	// FRELU32 unit
+#ifdef VXE_NATIVE_FPU
+	flp32_relu frelu32;
+#else
 	Vflp32_relu frelu32;
+#endif
 
-	// 64-to-32 FIFOs
-	sc_vector<vxe_fifo64x32<16>> f64x32_rs_fifo;
-	sc_vector<vxe_fifo64x32<16>> f64x32_rt_fifo;
+	// 64-to-32 FIFOs (one per thread and lane, FIFO of lane l of thread t is t * lanes + l)
+	sc_vector<vxe_fifo64x32<MAX_FIFO_DEPTH>> f64x32_rs_fifo;
+	sc_vector<vxe_fifo64x32<MAX_FIFO_DEPTH>> f64x32_rt_fifo;
 
 	SC_HAS_PROCESS(vxe_vector_unit);
 
-	vxe_vector_unit(::sc_core::sc_module_name name, unsigned client_id)
-		: ::sc_core::sc_module(name), clk("clk"), nrst("nrst")
+	/**
+	 * Constructor
+	 * @param name module name
+	 * @param client_id memory hub client id
+	 * @param fifo_depth depth of 64-to-32 FIFOs
+	 * @param fmac_stages FMAC pipeline depth (only default depth is supported by Verilated FMAC)
+	 * @param threads number of threads (1 to NT)
+	 * @param lanes number of FMAC lanes (1, 2 or 4)
+	 * @param burst maximum length of load bursts (beats, limited by half of FIFO depth)
+	 * @param boundary bursts do not cross this boundary (bytes, power of two up to 4KB)
+	 */
+	vxe_vector_unit(::sc_core::sc_module_name name, unsigned client_id,
+			unsigned fifo_depth = FIFO_DEPTH, unsigned fmac_stages = FMAC_STAGES,
+			unsigned threads = NT, unsigned lanes = 1, unsigned burst = 1,
+			unsigned boundary = BURST_BOUNDARY)
+		: vxe_prof_module(name), clk("clk"), nrst("nrst")
 		, mem_fifo_in("mem_fifo_in"), mem_fifo_out("mem_fifo_out")
 		, o_busy("o_busy"), o_err("o_err")
 		, i_cmd_select("i_cmd_select"), o_cmd_ack("o_cmd_ack")
 		, i_cmd_op("i_cmd_op"), i_cmd_thread("i_cmd_thread"), i_cmd_wdata("i_cmd_wdata")
-		, fmac32("fmac32"), thr_id_pipe("thr_id_pipe")
+#ifdef VXE_NATIVE_FPU
+		, fmac32("fmac32", lane_count(lanes), fmac_creator(fmac_stages))
+		, thr_id_pipe("thr_id_pipe", fmac_stages)
+#else
+		, fmac32("fmac32", lane_count(lanes)), thr_id_pipe("thr_id_pipe", FMAC_STAGES)
+#endif
 		, frelu32("frelu32")
-		, f64x32_rs_fifo("f64x32_rs_fifo", NT), f64x32_rt_fifo("f64x32_rt_fifo", NT)
-		, m_client_id(client_id)
+		, f64x32_rs_fifo("f64x32_rs_fifo", thread_count(threads) * lane_count(lanes),
+			fifo_creator(fifo_depth))
+		, f64x32_rt_fifo("f64x32_rt_fifo", thread_count(threads) * lane_count(lanes),
+			fifo_creator(fifo_depth))
+		, m_client_id(client_id), m_threads(thread_count(threads)), m_lanes(lane_count(lanes))
+		, m_burst(burst_count(burst, fifo_depth)), m_boundary(burst_boundary(boundary))
+		, m_merge_pending(false), s_fmac32_i_valid("s_fmac32_i_valid", m_lanes), s_fmac32_o_sign("s_fmac32_o_sign", m_lanes)
+		, s_fmac32_o_zero("s_fmac32_o_zero", m_lanes), s_fmac32_o_nan("s_fmac32_o_nan", m_lanes)
+		, s_fmac32_o_inf("s_fmac32_o_inf", m_lanes), s_fmac32_o_valid("s_fmac32_o_valid", m_lanes)
+		, s_fmac32_i_a("s_fmac32_i_a", m_lanes), s_fmac32_i_b("s_fmac32_i_b", m_lanes)
+		, s_fmac32_i_c("s_fmac32_i_c", m_lanes), s_fmac32_o_p("s_fmac32_o_p", m_lanes)
+		, relu_wb_fifo("relu_wb_fifo"), out_rqrs_fifo("out_rqrs_fifo")
+		, out_rqrt_fifo("out_rqrt_fifo"), out_rqst_fifo("out_rqst_fifo")
+		, fmac_slots_fifo("fmac_slots_fifo", MAX_FMAC_STAGES)
+		, m_cmd_batch(nullptr), m_cmd_count(0), m_cmd_err(false)
 	{
+#ifndef VXE_NATIVE_FPU
+		if(fmac_stages != FMAC_STAGES)
+			std::cerr << this->name() << ": FMAC pipeline depth " << fmac_stages
+				<< " requires native FPU, using " << FMAC_STAGES << "!" << std::endl;
+#endif
+		if(threads != m_threads)
+			std::cerr << this->name() << ": unsupported number of threads " << threads
+				<< ", using " << m_threads << "!" << std::endl;
+		if(lanes != m_lanes)
+			std::cerr << this->name() << ": unsupported number of FMAC lanes " << lanes
+				<< ", using " << m_lanes << "!" << std::endl;
+		if(burst != m_burst)
+			std::cerr << this->name() << ": unsupported burst length " << burst
+				<< ", using " << m_burst << "!" << std::endl;
+		if(boundary != m_boundary)
+			std::cerr << this->name() << ": unsupported burst boundary " << boundary
+				<< ", using " << m_boundary << "!" << std::endl;
+
 		SC_THREAD(cmd_exec_thread);
 			sensitive << clk.pos();
 
@@ -111,18 +203,20 @@ SC_MODULE(vxe_vector_unit) {
 				<< s_load_store_active;
 
 		// Connect FMAC32 signals
-		fmac32.clk(clk);
-		fmac32.nrst(nrst);
-		fmac32.i_valid(s_fmac32_i_valid);
-		fmac32.o_sign(s_fmac32_o_sign);
-		fmac32.o_zero(s_fmac32_o_zero);
-		fmac32.o_nan(s_fmac32_o_nan);
-		fmac32.o_inf(s_fmac32_o_inf);
-		fmac32.o_valid(s_fmac32_o_valid);
-		fmac32.i_a(s_fmac32_i_a);
-		fmac32.i_b(s_fmac32_i_b);
-		fmac32.i_c(s_fmac32_i_c);
-		fmac32.o_p(s_fmac32_o_p);
+		for(unsigned l = 0; l < m_lanes; ++l) {
+			fmac32[l].clk(clk);
+			fmac32[l].nrst(nrst);
+			fmac32[l].i_valid(s_fmac32_i_valid[l]);
+			fmac32[l].o_sign(s_fmac32_o_sign[l]);
+			fmac32[l].o_zero(s_fmac32_o_zero[l]);
+			fmac32[l].o_nan(s_fmac32_o_nan[l]);
+			fmac32[l].o_inf(s_fmac32_o_inf[l]);
+			fmac32[l].o_valid(s_fmac32_o_valid[l]);
+			fmac32[l].i_a(s_fmac32_i_a[l]);
+			fmac32[l].i_b(s_fmac32_i_b[l]);
+			fmac32[l].i_c(s_fmac32_i_c[l]);
+			fmac32[l].o_p(s_fmac32_o_p[l]);
+		}
 		// Connect thread Id pipe signals
 		thr_id_pipe.clk(clk);
 		thr_id_pipe.nrst(nrst);
@@ -134,7 +228,7 @@ SC_MODULE(vxe_vector_unit) {
 		frelu32.i_v(s_frelu32_i_value);
 		frelu32.o_r(s_frelu32_o_result);
 		// Connect 64-to-32 FIFOs signals
-		for(unsigned i = 0; i < NT; ++i) {
+		for(unsigned i = 0; i < f64x32_rs_fifo.size(); ++i) {
 			// Rs
 			f64x32_rs_fifo[i].clk(clk);
 			f64x32_rs_fifo[i].nrst(nrst);
@@ -158,7 +252,249 @@ SC_MODULE(vxe_vector_unit) {
 		}
 	}
 
+	/**
+	 * Save architectural registers (unit must be idle)
+	 * @param wr checkpoint writer
+	 */
+	void save_state(ckpt::writer& wr) const
+	{
+		wr.put_tag("VPU ");
+		wr.put(uint32_t(NT));
+		wr.put(reg_acc);
+		wr.put(reg_rsa);
+		wr.put(reg_rsl);
+		wr.put(reg_rta);
+		wr.put(reg_rtl);
+		wr.put(reg_rda);
+		wr.put(reg_thr_en);
+	}
+
+	/**
+	 * Restore architectural registers (unit must be idle)
+	 * @param rd checkpoint reader
+	 * @return true on success
+	 */
+	bool load_state(ckpt::reader& rd)
+	{
+		uint32_t nt = 0;
+		if(!rd.expect_tag("VPU ") || !rd.get(nt) || nt != NT)
+			return false;
+		return rd.get(reg_acc) && rd.get(reg_rsa) && rd.get(reg_rsl) && rd.get(reg_rta)
+			&& rd.get(reg_rtl) && rd.get(reg_rda) && rd.get(reg_thr_en);
+	}
+
+	/**
+	 * Register trace probes (control signals, datapath and per-thread registers)
+	 * @param tr tracer
+	 */
+	void trace_probes(vxe_tracer& tr) const
+	{
+		const std::string n = name();
+
+		tr.add_signal(o_busy);
+		tr.add_signal(o_err);
+		tr.add_signal(i_cmd_select);
+		tr.add_signal(o_cmd_ack);
+		tr.add_signal(i_cmd_op);
+		tr.add_signal(i_cmd_thread);
+		tr.add_signal(i_cmd_wdata);
+		for(unsigned l = 0; l < m_lanes; ++l) {
+			tr.add_signal(s_fmac32_i_valid[l], s_fmac32_i_valid[l].name());
+			tr.add_signal(s_fmac32_i_a[l], s_fmac32_i_a[l].name());
+			tr.add_signal(s_fmac32_i_b[l], s_fmac32_i_b[l].name());
+			tr.add_signal(s_fmac32_i_c[l], s_fmac32_i_c[l].name());
+			tr.add_signal(s_fmac32_o_valid[l], s_fmac32_o_valid[l].name());
+			tr.add_signal(s_fmac32_o_p[l], s_fmac32_o_p[l].name());
+		}
+		tr.add_signal(thr_id_pipe_in, n + ".thr_id_pipe_in");
+		tr.add_signal(thr_id_pipe_out, n + ".thr_id_pipe_out");
+		tr.add_signal(s_frelu32_i_value, n + ".s_frelu32_i_value");
+		tr.add_signal(s_frelu32_o_result, n + ".s_frelu32_o_result");
+		tr.add_signal(s_load_store_busy, n + ".s_load_store_busy");
+		tr.add_signal(s_load_store_active, n + ".s_load_store_active");
+		tr.add_signal(s_exec_pipe_busy, n + ".s_exec_pipe_busy");
+		tr.add_signal(s_actf_pipe_busy, n + ".s_actf_pipe_busy");
+		tr.add_signal(s_dpcmd_valid, n + ".s_dpcmd_valid");
+		tr.add_signal(s_dpcmd_op, n + ".s_dpcmd_op");
+		tr.add_signal(s_dpcmd_pl, n + ".s_dpcmd_pl");
+		tr.add_fifo(relu_wb_fifo);
+		tr.add_fifo(out_rqrs_fifo);
+		tr.add_fifo(out_rqrt_fifo);
+		tr.add_fifo(out_rqst_fifo);
+		tr.add_fifo(fmac_slots_fifo);
+
+		for(unsigned t = 0; t < m_threads; ++t) {
+			const std::string th = n + ".thread" + std::to_string(t) + ".";
+			tr.add(th + "acc", 32, [this, t]() -> uint64_t { return reg_acc[t]; });
+			tr.add(th + "rsa", 64, [this, t]() -> uint64_t { return reg_rsa[t]; });
+			tr.add(th + "rsl", 32, [this, t]() -> uint64_t { return reg_rsl[t]; });
+			tr.add(th + "rta", 64, [this, t]() -> uint64_t { return reg_rta[t]; });
+			tr.add(th + "rtl", 32, [this, t]() -> uint64_t { return reg_rtl[t]; });
+			tr.add(th + "rda", 64, [this, t]() -> uint64_t { return reg_rda[t]; });
+			tr.add(th + "en", 1, [this, t]() -> uint64_t { return reg_thr_en[t]; });
+			for(unsigned l = 0; l < m_lanes; ++l) {
+				const unsigned i = t * m_lanes + l;
+				const std::string ln = (m_lanes > 1 ? th + "lane" + std::to_string(l) + "." : th);
+				tr.add_signal(f64x32_rs_fifo_empty[i], ln + "rs_fifo_empty");
+				tr.add_signal(f64x32_rs_fifo_full[i], ln + "rs_fifo_full");
+				tr.add_signal(f64x32_rt_fifo_empty[i], ln + "rt_fifo_empty");
+				tr.add_signal(f64x32_rt_fifo_full[i], ln + "rt_fifo_full");
+			}
+		}
+	}
+
+	/**
+	 * Get architectural registers (unit must be idle)
+	 * @param st state
+	 */
+	void get_arch_state(arch_state& st) const
+	{
+		for(unsigned i = 0; i < NT; ++i) {
+			st.acc[i] = reg_acc[i];
+			st.rsa[i] = reg_rsa[i];
+			st.rsl[i] = reg_rsl[i];
+			st.rta[i] = reg_rta[i];
+			st.rtl[i] = reg_rtl[i];
+			st.rda[i] = reg_rda[i];
+			st.thr_en[i] = reg_thr_en[i];
+		}
+	}
+
+	/**
+	 * Set architectural registers (unit must be idle)
+	 * @param st state
+	 */
+	void set_arch_state(const arch_state& st)
+	{
+		for(unsigned i = 0; i < NT; ++i) {
+			reg_acc[i] = st.acc[i];
+			reg_rsa[i] = st.rsa[i];
+			reg_rsl[i] = st.rsl[i];
+			reg_rta[i] = st.rta[i];
+			reg_rtl[i] = st.rtl[i];
+			reg_rda[i] = st.rda[i];
+			reg_thr_en[i] = st.thr_en[i] && i < m_threads;	// Only existing threads
+		}
+	}
+
+	/**
+	 * Number of threads
+	 */
+	unsigned threads() const { return m_threads; }
+
+	/**
+	 * Number of FMAC lanes
+	 */
+	unsigned lanes() const { return m_lanes; }
+
+	/**
+	 * Maximum length of load bursts
+	 */
+	unsigned burst() const { return m_burst; }
+
+	/**
+	 * Supported number of FMAC lanes
+	 * @param lanes requested number of lanes
+	 * @return 1, 2 or 4
+	 */
+	static unsigned lane_count(unsigned lanes)
+	{
+		return lanes >= MAX_FMAC_LANES ? MAX_FMAC_LANES : (lanes >= 2 ? 2 : 1);
+	}
+
+	/**
+	 * Supported length of load bursts. A burst fills at most half of
+	 * thread FIFOs, so Rs and Rt streams of a thread cannot block each other.
+	 * @param burst requested burst length
+	 * @param fifo_depth depth of 64-to-32 FIFOs
+	 * @return 1 to MAX_BURST
+	 */
+	static unsigned burst_count(unsigned burst, unsigned fifo_depth)
+	{
+		if(fifo_depth == 0 || fifo_depth > MAX_FIFO_DEPTH)
+			fifo_depth = MAX_FIFO_DEPTH;
+		return std::max(1u, std::min({ burst, vxe::vxe_mem_rq::MAX_BURST, fifo_depth / 2 }));
+	}
+
+	/**
+	 * Supported burst boundary. Power of two from one beat to 4KB
+	 * (rounded down).
+	 * @param boundary requested boundary (bytes)
+	 * @return boundary (bytes)
+	 */
+	static unsigned burst_boundary(unsigned boundary)
+	{
+		unsigned b = sizeof(uint64_t);
+		while(b < BURST_BOUNDARY && 2 * b <= boundary)
+			b *= 2;
+		return b;
+	}
+
+	/**
+	 * Reset architectural registers (unit must be idle)
+	 */
+	void reset_state()
+	{
+		for(unsigned i = 0; i < NT; ++i) {
+			reg_acc[i] = 0;
+			reg_rsa[i] = 0;
+			reg_rsl[i] = 0;
+			reg_rta[i] = 0;
+			reg_rtl[i] = 0;
+			reg_rda[i] = 0;
+			reg_thr_en[i] = false;
+		}
+	}
+
+	/**
+	 * Execute batch of commands received through transaction-level command channel
+	 * (called from CU thread, commands are executed by command execution thread)
+	 * @param cmds commands
+	 * @param count number of commands
+	 * @return true if an invalid command was received
+	 */
+	bool exec_cmds(const vxe::vpu_cmd *cmds, unsigned count) override
+	{
+		m_cmd_batch = cmds;
+		m_cmd_count = count;
+		m_cmd_event.notify(SC_ZERO_TIME);
+		wait(m_cmd_done_event);
+		return m_cmd_err;
+	}
+
 private:
+	// Returns number of threads clamped to supported range
+	static unsigned thread_count(unsigned threads)
+	{
+		return std::min(std::max(threads, 1u), NT);
+	}
+
+#ifdef VXE_NATIVE_FPU
+	/**
+	 * Creator of FMAC32 units with given pipeline depth
+	 */
+	struct fmac_creator {
+		unsigned stages;
+		explicit fmac_creator(unsigned s) : stages(s) {}
+		fmac32_unit *operator()(const char *name, size_t) const
+		{
+			return new fmac32_unit(name, stages);
+		}
+	};
+#endif
+
+	/**
+	 * Creator of 64-to-32 FIFOs with given depth
+	 */
+	struct fifo_creator {
+		unsigned depth;
+		explicit fifo_creator(unsigned d) : depth(d) {}
+		vxe_fifo64x32<MAX_FIFO_DEPTH> *operator()(const char *name, size_t) const
+		{
+			return new vxe_fifo64x32<MAX_FIFO_DEPTH>(name, depth);
+		}
+	};
+
 	/**
 	 * ReLU unit writeback result data
 	 */
@@ -174,15 +510,121 @@ private:
 	};
 
 private:
+	// Reset FMAC lanes state before vector product
+	void start_lanes()
+	{
+		for(unsigned th = 0; th < NT; ++th) {
+			m_rs_words[th] = 0;
+			m_rt_words[th] = 0;
+			m_merge_mask[th] = 0;
+			for(unsigned l = 0; l < MAX_FMAC_LANES; ++l)
+				reg_pacc[l][th] = 0;
+		}
+	}
+
+	// Returns true if any thread has partial accumulators to merge
+	bool merge_needed() const
+	{
+		for(unsigned th = 0; th < m_threads; ++th)
+			if(m_merge_mask[th])
+				return true;
+		return false;
+	}
+
+	/**
+	 * Execute single command
+	 * @param cmd_op operation
+	 * @param cmd_thread VPU local thread id
+	 * @param cmd_wdata payload
+	 * @return true if command is invalid
+	 */
+	bool exec_cmd(uint8_t cmd_op, uint8_t cmd_thread, uint64_t cmd_wdata)
+	{
+		// Wait while unit is busy
+		while(o_busy.read())
+			wait();
+
+		// Thread must exist
+		if(cmd_thread >= m_threads)
+			return true;
+
+		switch(cmd_op) {
+			case vxe::instr::setacc::OP:
+				reg_acc[cmd_thread] = cmd_wdata;
+				break;
+			case vxe::instr::setvl::OP:
+				reg_rsl[cmd_thread] = cmd_wdata;
+				reg_rtl[cmd_thread] = cmd_wdata;
+				break;
+			case vxe::instr::setrs::OP:
+				reg_rsa[cmd_thread] = cmd_wdata;
+				break;
+			case vxe::instr::setrt::OP:
+				reg_rta[cmd_thread] = cmd_wdata;
+				break;
+			case vxe::instr::setrd::OP:
+				reg_rda[cmd_thread] = cmd_wdata;
+				break;
+			case vxe::instr::seten::OP:
+				reg_thr_en[cmd_thread] = (cmd_wdata & 1u) != 0;
+				break;
+			case vxe::instr::prod::OP:
+				start_lanes();
+				s_dpcmd_op.write(vxe::instr::prod::OP);
+				s_dpcmd_valid.write(true);
+				wait();
+				s_dpcmd_valid.write(false);
+				wait();
+				while(s_load_store_busy.read() || s_exec_pipe_busy.read())
+					wait();
+				// Merge partial accumulators of FMAC lanes
+				if(merge_needed()) {
+					m_merge_pending = true;
+					m_merge_event.notify(SC_ZERO_TIME);
+					wait();
+					while(m_merge_pending || s_exec_pipe_busy.read())
+						wait();
+				}
+				break;
+			case vxe::instr::store::OP:
+				s_dpcmd_op.write(vxe::instr::store::OP);
+				s_dpcmd_valid.write(true);
+				wait();
+				s_dpcmd_valid.write(false);
+				wait();
+				while(s_load_store_busy.read())
+					wait();
+				break;
+			case vxe::instr::generic_af::OP:
+				s_dpcmd_op.write(vxe::instr::generic_af::OP);
+				s_dpcmd_pl.write(cmd_wdata);
+				s_dpcmd_valid.write(true);
+				wait();
+				s_dpcmd_valid.write(false);
+				wait();
+				while(s_actf_pipe_busy.read())
+					wait();
+				break;
+			default:
+				return true;
+		}
+
+		return false;
+	}
+
 	/**
 	 * Commands execution thread
-	 * Receives commands from CU
+	 * Receives commands from CU through command bus signals or
+	 * as batches through transaction-level command channel
 	 */
 	[[noreturn]] void cmd_exec_thread()
 	{
-		uint8_t cmd_op;
-		uint8_t cmd_thread;
-		uint64_t cmd_wdata;
+		bool idle = false;
+		vxe_clock_sync sync(clk);
+		sync.init();
+		sc_event_or_list wakeup;	// Events to wake up from idle state
+		wakeup |= i_cmd_select.value_changed_event();
+		wakeup |= m_cmd_event;
 
 		// Reset state
 		o_cmd_ack.write(false);
@@ -190,76 +632,32 @@ private:
 		s_dpcmd_valid.write(false);
 
 		while(true) {
-			wait(); // Wait for positive edge
+			// Wait for positive edge (sleep until command select or batch if idle)
+			sync.wait_cycle(idle, wakeup);
 
 			o_cmd_ack.write(false);
 			o_err.write(false);
 			s_dpcmd_valid.write(false);
 
-			if(!i_cmd_select.read())
+			// Batch from transaction-level channel (no handshake per command)
+			if(m_cmd_batch) {
+				bool err = false;
+				for(unsigned i = 0; i < m_cmd_count && !err; ++i)
+					err = exec_cmd(m_cmd_batch[i].op, m_cmd_batch[i].thread, m_cmd_batch[i].wdata);
+				o_err.write(err);
+				m_cmd_err = err;
+				m_cmd_batch = nullptr;
+				m_cmd_done_event.notify(SC_ZERO_TIME);
+				idle = false;
 				continue;
+			}
 
-			// Get operands
-			cmd_op = i_cmd_op.read();
-			cmd_thread = i_cmd_thread.read();
-			cmd_wdata = i_cmd_wdata.read();
-
-			// Wait while unit is busy
-			while(o_busy.read())
-				wait();
+			idle = !i_cmd_select.read();
+			if(idle)
+				continue;
 
-			switch(cmd_op) {
-				case vxe::instr::setacc::OP:
-					reg_acc[cmd_thread] = cmd_wdata;
-					break;
-				case vxe::instr::setvl::OP:
-					reg_rsl[cmd_thread] = cmd_wdata;
-					reg_rtl[cmd_thread] = cmd_wdata;
-					break;
-				case vxe::instr::setrs::OP:
-					reg_rsa[cmd_thread] = cmd_wdata;
-					break;
-				case vxe::instr::setrt::OP:
-					reg_rta[cmd_thread] = cmd_wdata;
-					break;
-				case vxe::instr::setrd::OP:
-					reg_rda[cmd_thread] = cmd_wdata;
-					break;
-				case vxe::instr::seten::OP:
-					reg_thr_en[cmd_thread] = (cmd_wdata & 1u) != 0;
-					break;
-				case vxe::instr::prod::OP:
-					s_dpcmd_op.write(vxe::instr::prod::OP);
-					s_dpcmd_valid.write(true);
-					wait();
-					s_dpcmd_valid.write(false);
-					wait();
-					while(s_load_store_busy.read() || s_exec_pipe_busy.read())
-						wait();
-					break;
-				case vxe::instr::store::OP:
-					s_dpcmd_op.write(vxe::instr::store::OP);
-					s_dpcmd_valid.write(true);
-					wait();
-					s_dpcmd_valid.write(false);
-					wait();
-					while(s_load_store_busy.read())
-						wait();
-					break;
-				case vxe::instr::generic_af::OP:
-					s_dpcmd_op.write(vxe::instr::generic_af::OP);
-					s_dpcmd_pl.write(cmd_wdata);
-					s_dpcmd_valid.write(true);
-					wait();
-					s_dpcmd_valid.write(false);
-					wait();
-					while(s_actf_pipe_busy.read())
-						wait();
-					break;
-				default:
-					o_err.write(true);
-					break;
-			}
+			if(exec_cmd(i_cmd_op.read(), i_cmd_thread.read(), i_cmd_wdata.read()))
+				o_err.write(true);
 
 			o_cmd_ack.write(true);
 		}
@@ -294,15 +692,49 @@ private:
 		rq.addr <<= 2;
 	}
 
+	/**
+	 * Set load burst address and length. Burst continues while vector
+	 * words remain, up to maximum burst length or burst boundary.
+	 * @param rq request structure
+	 * @param addr load address
+	 * @param len current vector length
+	 * @param we word enables of burst beats
+	 * @return burst length
+	 */
+	unsigned set_load_burst(vxe::vxe_mem_rq& rq, uint64_t& addr, uint32_t& len,
+		vxe::word_enable<2> *we)
+	{
+		unsigned beats = 0;
+
+		do {
+			vxe::vxe_mem_rq b;
+			set_load_addr(b, addr, len);
+			if(beats == 0) {
+				rq.addr = b.addr;
+				for(unsigned i = 0; i < sizeof(rq.ben); ++i)
+					rq.ben[i] = b.ben[i];
+			}
+			we[beats++] = vxe::word_enable<2>({ !!b.ben[0], !!b.ben[4] });
+		} while(len != 0 && beats < m_burst && ((addr << 2) & (m_boundary - 1)) != 0);
+
+		// Whole beats are read by bursts
+		if(beats > 1)
+			rq.set_ben_mask(0xFF);
+		rq.len = beats;
+
+		return beats;
+	}
+
 	/**
 	 * Data loads handler
 	 */
 	void data_load()
 	{
 		unsigned done_mask = 0;	// Mask of completed threads
+		vxe::word_enable<2> we[vxe::vxe_mem_rq::MAX_BURST];	// Word enables of burst beats
 
-		while(done_mask != (1 << NT) - 1) {
-			for (unsigned th = 0; th < NT; ++th) {
+		while(done_mask != (1u << m_threads) - 1) {
+			for (unsigned th = 0; th < m_threads; ++th) {
 				// Skip not enabled threads
 				if(!reg_thr_en[th]) {
 					done_mask |= 1 << th;
@@ -317,9 +749,10 @@ private:
 					rq.req = vxe::vxe_mem_rq::rqtype::REQ_RD;
 					rq.set_thread_id(th);
 					rq.set_thread_arg(0);
-					set_load_addr(rq, reg_rsa[th], reg_rsl[th]);
-					// Push to outstanding requests FIFO
-					out_rqrs_fifo.write(vxe::word_enable<2>({ !!rq.ben[0], !!rq.ben[4] }));
+					unsigned beats = set_load_burst(rq, reg_rsa[th], reg_rsl[th], we);
+					// Push to outstanding requests FIFO (one item per beat)
+					for(unsigned b = 0; b < beats; ++b)
+						out_rqrs_fifo.write(we[b]);
 					// Send request
 					mem_fifo_out.write(rq);
 				}
@@ -333,9 +766,10 @@ private:
 					rq.req = vxe::vxe_mem_rq::rqtype::REQ_RD;
 					rq.set_thread_id(th);
 					rq.set_thread_arg(1);
-					set_load_addr(rq, reg_rta[th], reg_rtl[th]);
-					// Push to outstanding requests FIFO
-					out_rqrt_fifo.write(vxe::word_enable<2>({ !!rq.ben[0], !!rq.ben[4] }));
+					unsigned beats = set_load_burst(rq, reg_rta[th], reg_rtl[th], we);
+					// Push to outstanding requests FIFO (one item per beat)
+					for(unsigned b = 0; b < beats; ++b)
+						out_rqrt_fifo.write(we[b]);
 					// Send request
 					mem_fifo_out.write(rq);
 				}
@@ -354,15 +788,18 @@ private:
 	 */
 	void data_store()
 	{
-		for (unsigned th = 0; th < NT; th += 2) {
+		for (unsigned th = 0; th < m_threads; th += 2) {
+			// Last thread has no pair if number of threads is odd
+			const bool en_next = th + 1 < m_threads && reg_thr_en[th + 1];
+
 			// Skip not enabled pairs of threads
-			if(!reg_thr_en[th] && !reg_thr_en[th + 1]) {
+			if(!reg_thr_en[th] && !en_next) {
 				wait();
 				continue;
 			}
 
 			// Check if we can merge store for neighbour threads
-			if(reg_thr_en[th] && reg_thr_en[th + 1] && ((reg_rda[th] & ~1) == (reg_rda[th + 1] & ~1))) {
+			if(reg_thr_en[th] && en_next && ((reg_rda[th] & ~1) == (reg_rda[th + 1] & ~1))) {
 				vxe::vxe_mem_rq rq;
 				rq.set_client_id(m_client_id);
 				rq.req = vxe::vxe_mem_rq::rqtype::REQ_WR;
@@ -399,7 +836,7 @@ private:
 				wait();
 			}
 
-			if(reg_thr_en[th + 1]) {
+			if(en_next) {
 				vxe::vxe_mem_rq rq;
 				rq.set_client_id(m_client_id);
 				rq.req = vxe::vxe_mem_rq::rqtype::REQ_WR;
@@ -424,13 +861,19 @@ private:
 	 */
 	[[noreturn]] void mem_req_thread()
 	{
+		bool idle = false;
+		vxe_clock_sync sync(clk);
+		sync.init();
+
 		while(true) {
 			s_load_store_active.write(false);
-			wait(); // Wait for positive edge
+			// Wait for positive edge (sleep until data processing command if idle)
+			sync.wait_cycle(idle, s_dpcmd_valid.value_changed_event());
 
 			// Check for valid start condition
 			bool dpcmd_valid = s_dpcmd_valid.read();
 			uint8_t dpcmd_op = s_dpcmd_op.read();
+			idle = !dpcmd_valid;
 			if(!dpcmd_valid || (dpcmd_op != vxe::instr::prod::OP && dpcmd_op != vxe::instr::store::OP))
 				continue;
 
@@ -454,7 +897,7 @@ private:
 	[[noreturn]] void mem_resp_thread()
 	{
 		// Reset state
-		for(unsigned i = 0; i < NT; ++i) {
+		for(unsigned i = 0; i < f64x32_rs_fifo.size(); ++i) {
 			f64x32_rs_fifo_write[i].write(false);
 			f64x32_rt_fifo_write[i].write(false);
 		}
@@ -485,107 +928,234 @@ private:
 				continue;
 
 			// Store data to 64x32b FIFOs
-			if(arg == 0) {
-				while(f64x32_rs_fifo_full[thread].read())
-					wait();
-				f64x32_rs_fifo_wdata[thread].write(rq.data_u64[0]);
-				f64x32_rs_fifo_wvalid[thread].write(we.bits<unsigned>());
-				f64x32_rs_fifo_write[thread].write(true);
-				wait();
-				f64x32_rs_fifo_write[thread].write(false);
-			} else {
-				while(f64x32_rt_fifo_full[thread].read())
-					wait();
-				f64x32_rt_fifo_wdata[thread].write(rq.data_u64[0]);
-				f64x32_rt_fifo_wvalid[thread].write(we.bits<unsigned>());
-				f64x32_rt_fifo_write[thread].write(true);
-				wait();
-				f64x32_rt_fifo_write[thread].write(false);
-			}
+			if(arg == 0)
+				push_words(f64x32_rs_fifo_wdata, f64x32_rs_fifo_wvalid, f64x32_rs_fifo_write,
+					f64x32_rs_fifo_full, m_rs_words[thread], thread, rq.data_u64[0],
+					we.bits<unsigned>());
+			else
+				push_words(f64x32_rt_fifo_wdata, f64x32_rt_fifo_wvalid, f64x32_rt_fifo_write,
+					f64x32_rt_fifo_full, m_rt_words[thread], thread, rq.data_u64[0],
+					we.bits<unsigned>());
 
 			wait();
 		}
 	}
 
+	/**
+	 * Distribute valid words of loaded data to lane FIFOs of a thread.
+	 * Vector element n goes to lane n % lanes, so with several lanes both
+	 * words of a 64-bit beat are consumed in the same issue slot.
+	 * @param wdata FIFOs write data signals
+	 * @param wvalid FIFOs write valid signals
+	 * @param write FIFOs write signals
+	 * @param full FIFOs full signals
+	 * @param words number of vector elements received by thread so far
+	 * @param thread thread
+	 * @param data loaded data
+	 * @param we word enables
+	 */
+	void push_words(sc_signal<uint64_t> *wdata, sc_signal<sc_uint<2>> *wvalid,
+		sc_signal<bool> *write, const sc_signal<bool> *full, unsigned& words,
+		unsigned thread, uint64_t data, unsigned we)
+	{
+		const unsigned base = thread * m_lanes;
+		unsigned lane_we[MAX_FMAC_LANES] = {};
+
+		for(unsigned w = 0; w < 2; ++w)
+			if(we & (1u << w))
+				lane_we[words++ % m_lanes] |= (1u << w);
+
+		for(unsigned l = 0; l < m_lanes; ++l)
+			while(lane_we[l] && full[base + l].read())
+				wait();
+
+		for(unsigned l = 0; l < m_lanes; ++l) {
+			if(!lane_we[l])
+				continue;
+			wdata[base + l].write(data);
+			wvalid[base + l].write(lane_we[l]);
+			write[base + l].write(true);
+		}
+		wait();
+		for(unsigned l = 0; l < m_lanes; ++l)
+			if(lane_we[l])
+				write[base + l].write(false);
+	}
+
 	/**
 	 * FMAC operation issue thread
+	 * Each issue slot sends element pairs available in lane FIFOs of a thread
+	 * to FMAC lanes. After vector product partial accumulators of lanes are
+	 * merged into thread accumulator through lane 0 FMAC in lane order.
 	 */
 	[[noreturn]] void op_issue_thread()
 	{
+		vxe_clock_sync sync(clk);
+		sync.init();
+		sc_event_or_list wakeup;	// Events to wake up from idle state
+		for(unsigned i = 0; i < f64x32_rs_fifo.size(); ++i) {
+			wakeup |= f64x32_rs_fifo_empty[i].value_changed_event();
+			wakeup |= f64x32_rt_fifo_empty[i].value_changed_event();
+		}
+		wakeup |= nrst.value_changed_event();
+		wakeup |= m_merge_event;
+
 		// Reset state
-		for(unsigned thread = 0; thread < NT; ++thread) {
-			f64x32_rs_fifo_read[thread].write(false);
-			f64x32_rt_fifo_read[thread].write(false);
+		for(unsigned i = 0; i < f64x32_rs_fifo.size(); ++i) {
+			f64x32_rs_fifo_read[i].write(false);
+			f64x32_rt_fifo_read[i].write(false);
 		}
+		for(unsigned thread = 0; thread < NT; ++thread)
+			m_in_flight[thread] = false;
 
 		while(true) {
+			bool idle = true;		// No operation issued in previous slot
+			bool round_done = false;	// Last slot of the round passed while sleeping
+
 			s_exec_pipe_busy.write(false);
-			s_fmac32_i_valid.write(false);
+			for(unsigned l = 0; l < m_lanes; ++l)
+				s_fmac32_i_valid[l].write(false);
 			if(!nrst.read()) {
 				wait();
 				continue;
 			}
 
-			for(unsigned thread = 0; thread < NT; ++thread) {
+			for(unsigned thread = 0; thread < m_threads; ++thread) {
 				// Evaluate execute pipe busy state
+				if(m_merge_pending && !merge_needed())
+					m_merge_pending = false;
 				bool fmac_busy = (fmac_slots_fifo.num_available() != 0);
-				bool issue_busy = false;
-				for(unsigned i = 0; i < NT; ++i) {
-					if(!f64x32_rs_fifo_empty[i].read() || !f64x32_rt_fifo_empty[i].read()) {
+				bool issue_busy = m_merge_pending;
+				for(unsigned i = 0; i < f64x32_rs_fifo.size() && !issue_busy; ++i) {
+					if(!f64x32_rs_fifo_empty[i].read() || !f64x32_rt_fifo_empty[i].read())
 						issue_busy = true;
+				}
+				s_exec_pipe_busy.write(fmac_busy || issue_busy);
+
+				// Sleep while idle. Issue round has a slot per thread and
+				// one more slot in the end. Slots passed while sleeping are
+				// skipped to keep the same issue order.
+				if(idle && !fmac_busy && !issue_busy && sync.valid()) {
+					thread = (thread + sync.sleep(wakeup)) % (m_threads + 1);
+					if(thread == m_threads || !nrst.read()) {
+						round_done = true;
 						break;
 					}
+				} else
+					wait();
+
+				for(unsigned l = 0; l < m_lanes; ++l)
+					s_fmac32_i_valid[l].write(false);
+
+				// Thread result is not written back yet
+				if(m_in_flight[thread]) {
+					idle = true;
+					continue;
 				}
-				s_exec_pipe_busy.write(fmac_busy || issue_busy);
 
-				wait();
+				// Merge next partial accumulator of the thread
+				if(m_merge_pending) {
+					idle = !issue_merge(thread);
+					continue;
+				}
 
-				s_fmac32_i_valid.write(false);
+				// Lanes with operands available
+				unsigned lanes = 0;
+				for(unsigned l = 0; l < m_lanes && reg_thr_en[thread]; ++l) {
+					const unsigned i = thread * m_lanes + l;
+					if(!f64x32_rs_fifo_empty[i].read() && !f64x32_rt_fifo_empty[i].read())
+						lanes |= (1u << l);
+				}
 
 				// Ignore disabled threads and threads with no data available
-				if(!reg_thr_en[thread] || f64x32_rs_fifo_empty[thread].read() ||
-					f64x32_rt_fifo_empty[thread].read()) {
+				if(!lanes) {
+					idle = true;
 					continue;
 				}
 
-				uint32_t rs, rt;
-
 				// Read FMAC operands
-				f64x32_rs_fifo_read[thread].write(true);
-				f64x32_rt_fifo_read[thread].write(true);
+				for(unsigned l = 0; l < m_lanes; ++l) {
+					if(lanes & (1u << l)) {
+						f64x32_rs_fifo_read[thread * m_lanes + l].write(true);
+						f64x32_rt_fifo_read[thread * m_lanes + l].write(true);
+					}
+				}
 				wait();
-				f64x32_rs_fifo_read[thread].write(false);
-				f64x32_rt_fifo_read[thread].write(false);
-
-				rs = f64x32_rs_fifo_rdata[thread].read();
-				rt = f64x32_rt_fifo_rdata[thread].read();
+				for(unsigned l = 0; l < m_lanes; ++l) {
+					if(lanes & (1u << l)) {
+						f64x32_rs_fifo_read[thread * m_lanes + l].write(false);
+						f64x32_rt_fifo_read[thread * m_lanes + l].write(false);
+					}
+				}
 
-				// Send to FMAC pipeline
-				s_fmac32_i_a.write(reg_acc[thread]);
-				s_fmac32_i_b.write(rs);
-				s_fmac32_i_c.write(rt);
-				s_fmac32_i_valid.write(true);
+				// Send to FMAC pipelines. Lane 0 accumulates into thread
+				// accumulator, other lanes into partial accumulators.
+				for(unsigned l = 0; l < m_lanes; ++l) {
+					if(!(lanes & (1u << l)))
+						continue;
+					const unsigned i = thread * m_lanes + l;
+					s_fmac32_i_a[l].write(l == 0 ? reg_acc[thread] : reg_pacc[l][thread]);
+					s_fmac32_i_b[l].write(f64x32_rs_fifo_rdata[i].read());
+					s_fmac32_i_c[l].write(f64x32_rt_fifo_rdata[i].read());
+					s_fmac32_i_valid[l].write(true);
+				}
+				m_merge_mask[thread] |= (lanes & ~1u);
 				thr_id_pipe_in.write(thread);
 				fmac_slots_fifo.write(true);
+				m_in_flight[thread] = true;
+				idle = false;
 			}
 
-			wait(); // Wait for pos edge after last thread processed
+			if(!round_done)
+				wait(); // Wait for pos edge after last thread processed
 		}
 	}
 
+	/**
+	 * Issue merge of next partial accumulator of a thread (acc + pacc * 1.0)
+	 * @param thread thread
+	 * @return true if operation was issued
+	 */
+	bool issue_merge(unsigned thread)
+	{
+		if(!m_merge_mask[thread])
+			return false;
+
+		unsigned l = 1;
+		while(!(m_merge_mask[thread] & (1u << l)))
+			++l;
+		m_merge_mask[thread] &= ~(1u << l);
+
+		s_fmac32_i_a[0].write(reg_acc[thread]);
+		s_fmac32_i_b[0].write(reg_pacc[l][thread]);
+		s_fmac32_i_c[0].write(FP32_ONE);
+		s_fmac32_i_valid[0].write(true);
+		thr_id_pipe_in.write(thread);
+		fmac_slots_fifo.write(true);
+		m_in_flight[thread] = true;
+
+		return true;
+	}
+
 	/**
 	 * Activation function thread
 	 * Executes activations for accumulators of enabled threads
 	 */
 	[[noreturn]] void activationf_thread()
 	{
+		bool idle = false;
+		vxe_clock_sync sync(clk);
+		sync.init();
+
 		while(true) {
 			s_actf_pipe_busy.write(false);
-			wait();
+			// Wait for positive edge (sleep until data processing command if idle)
+			sync.wait_cycle(idle, s_dpcmd_valid.value_changed_event());
 
 			// Check for start condition
 			bool dpcmd_valid = s_dpcmd_valid.read();
 			uint8_t dpcmd_op = s_dpcmd_op.read();
+			idle = !dpcmd_valid;
 			if(!dpcmd_valid || dpcmd_op != vxe::instr::generic_af::OP)
 				continue;
 
@@ -605,7 +1175,7 @@ private:
 			uint32_t exp_diff = (pl.pl & 0x7F);	// Only 7-bits are used
 
 			// Compute activations
-			for(unsigned th = 0; th < NT; ++th) {
+			for(unsigned th = 0; th < m_threads; ++th) {
 				if(!reg_thr_en[th]) {
 					wait();
 					continue;
@@ -634,12 +1204,28 @@ private:
 	 */
 	[[noreturn]] void writeback_thread()
 	{
+		vxe_clock_sync sync(clk);
+		sync.init();
+		sc_event_or_list wakeup;	// Events to wake up from idle state
+		for(unsigned l = 0; l < m_lanes; ++l)
+			wakeup |= s_fmac32_o_valid[l].value_changed_event();
+		wakeup |= relu_wb_fifo.data_written_event();
+
 		while(true) {
-			wait();
+			// Sleep while there are no results to write back
+			sync.wait_cycle(!fmac_valid() && relu_wb_fifo.num_available() == 0, wakeup);
 
-			if(s_fmac32_o_valid.read()) {
+			if(fmac_valid()) {
 				unsigned thread = thr_id_pipe_out.read();
-				reg_acc[thread] = s_fmac32_o_p.read();
+				for(unsigned l = 0; l < m_lanes; ++l) {
+					if(!s_fmac32_o_valid[l].read())
+						continue;
+					if(l == 0)
+						reg_acc[thread] = s_fmac32_o_p[l].read();
+					else
+						reg_pacc[l][thread] = s_fmac32_o_p[l].read();
+				}
+				m_in_flight[thread] = false;
 				fmac_slots_fifo.read();
 			} else if(relu_wb_fifo.num_available() != 0) {
 				relu_writeback wb = relu_wb_fifo.read();
@@ -648,11 +1234,21 @@ private:
 		}
 	}
 
+	// Returns true if any FMAC lane has valid result
+	bool fmac_valid() const
+	{
+		for(unsigned l = 0; l < m_lanes; ++l)
+			if(s_fmac32_o_valid[l].read())
+				return true;
+		return false;
+	}
+
 	/**
 	 * VPU busy logic method
 	 */
 	void busy_logic_method()
 	{
+		vxe_profiler::scope prof;
 		o_busy.write(s_load_store_busy.read() || s_exec_pipe_busy.read() || s_actf_pipe_busy.read());
 	}
 
@@ -661,6 +1257,7 @@ private:
 	 */
 	void load_store_busy_logic_method()
 	{
+		vxe_profiler::scope prof;
 		bool out_ld1 = (out_rqrs_fifo.num_available() != 0);
 		bool out_ld2 = (out_rqrt_fifo.num_available() != 0);
 		bool out_st = (out_rqst_fifo.num_available() != 0);
@@ -669,6 +1266,10 @@ private:
 
 private:
 	const unsigned m_client_id;
+	const unsigned m_threads;	// Number of threads
+	const unsigned m_lanes;		// Number of FMAC lanes
+	const unsigned m_burst;		// Maximum length of load bursts
+	const unsigned m_boundary;	// Burst boundary (bytes)
 	// Internal registers
 	uint32_t reg_acc[NT];	// Accumulators
 	uint64_t reg_rsa[NT];	// Rs addresses
@@ -677,17 +1278,25 @@ private:
 	uint32_t reg_rtl[NT];	// Rt lengths
 	uint64_t reg_rda[NT];	// Rd addresses
 	bool reg_thr_en[NT];	// Thread enables
-	// FMAC32 signals
-	sc_signal<bool> s_fmac32_i_valid;
-	sc_signal<bool> s_fmac32_o_sign;
-	sc_signal<bool> s_fmac32_o_zero;
-	sc_signal<bool> s_fmac32_o_nan;
-	sc_signal<bool> s_fmac32_o_inf;
-	sc_signal<bool> s_fmac32_o_valid;
-	sc_signal<uint32_t> s_fmac32_i_a;
-	sc_signal<uint32_t> s_fmac32_i_b;
-	sc_signal<uint32_t> s_fmac32_i_c;
-	sc_signal<uint32_t> s_fmac32_o_p;
+	// FMAC lanes state
+	uint32_t reg_pacc[MAX_FMAC_LANES][NT];	// Partial accumulators (lane 0 uses reg_acc)
+	unsigned m_rs_words[NT];	// Rs elements received in current vector product
+	unsigned m_rt_words[NT];	// Rt elements received in current vector product
+	unsigned m_merge_mask[NT];	// Lanes with partial accumulators to merge
+	bool m_in_flight[NT];		// Thread has an operation in FMAC pipeline
+	bool m_merge_pending;		// Partial accumulators merge is requested
+	sc_event m_merge_event;		// Partial accumulators merge is requested
+	// FMAC32 signals (per lane)
+	sc_vector<sc_signal<bool>> s_fmac32_i_valid;
+	sc_vector<sc_signal<bool>> s_fmac32_o_sign;
+	sc_vector<sc_signal<bool>> s_fmac32_o_zero;
+	sc_vector<sc_signal<bool>> s_fmac32_o_nan;
+	sc_vector<sc_signal<bool>> s_fmac32_o_inf;
+	sc_vector<sc_signal<bool>> s_fmac32_o_valid;
+	sc_vector<sc_signal<uint32_t>> s_fmac32_i_a;
+	sc_vector<sc_signal<uint32_t>> s_fmac32_i_b;
+	sc_vector<sc_signal<uint32_t>> s_fmac32_i_c;
+	sc_vector<sc_signal<uint32_t>> s_fmac32_o_p;
 	// Thread Id pipe signals
 	sc_signal<uint8_t> thr_id_pipe_in;
 	sc_signal<uint8_t> thr_id_pipe_out;
@@ -697,28 +1306,28 @@ private:
 	sc_signal<uint32_t> s_frelu32_i_value;
 	sc_signal<uint32_t> s_frelu32_o_result;
 	// Internal control FIFOs
-	sc_fifo<relu_writeback> relu_wb_fifo;
-	sc_fifo<vxe::word_enable<2>> out_rqrs_fifo;
-	sc_fifo<vxe::word_enable<2>> out_rqrt_fifo;
-	sc_fifo<bool> out_rqst_fifo;
+	vxe_fifo<relu_writeback> relu_wb_fifo;
+	vxe_fifo<vxe::word_enable<2>> out_rqrs_fifo;
+	vxe_fifo<vxe::word_enable<2>> out_rqrt_fifo;
+	vxe_fifo<bool> out_rqst_fifo;
 	// 64-to-32 Rs FIFOs signals
-	sc_signal<uint64_t> f64x32_rs_fifo_wdata[NT];
-	sc_signal<sc_uint<2>> f64x32_rs_fifo_wvalid[NT];
-	sc_signal<bool> f64x32_rs_fifo_write[NT];
-	sc_signal<bool> f64x32_rs_fifo_read[NT];
-	sc_signal<uint32_t> f64x32_rs_fifo_rdata[NT];
-	sc_signal<bool> f64x32_rs_fifo_empty[NT];
-	sc_signal<bool> f64x32_rs_fifo_full[NT];
+	sc_signal<uint64_t> f64x32_rs_fifo_wdata[NT * MAX_FMAC_LANES];
+	sc_signal<sc_uint<2>> f64x32_rs_fifo_wvalid[NT * MAX_FMAC_LANES];
+	sc_signal<bool> f64x32_rs_fifo_write[NT * MAX_FMAC_LANES];
+	sc_signal<bool> f64x32_rs_fifo_read[NT * MAX_FMAC_LANES];
+	sc_signal<uint32_t> f64x32_rs_fifo_rdata[NT * MAX_FMAC_LANES];
+	sc_signal<bool> f64x32_rs_fifo_empty[NT * MAX_FMAC_LANES];
+	sc_signal<bool> f64x32_rs_fifo_full[NT * MAX_FMAC_LANES];
 	// 64-to-32 Rt FIFOs signals
-	sc_signal<uint64_t> f64x32_rt_fifo_wdata[NT];
-	sc_signal<sc_uint<2>> f64x32_rt_fifo_wvalid[NT];
-	sc_signal<bool> f64x32_rt_fifo_write[NT];
-	sc_signal<bool> f64x32_rt_fifo_read[NT];
-	sc_signal<uint32_t> f64x32_rt_fifo_rdata[NT];
-	sc_signal<bool> f64x32_rt_fifo_empty[NT];
-	sc_signal<bool> f64x32_rt_fifo_full[NT];
+	sc_signal<uint64_t> f64x32_rt_fifo_wdata[NT * MAX_FMAC_LANES];
+	sc_signal<sc_uint<2>> f64x32_rt_fifo_wvalid[NT * MAX_FMAC_LANES];
+	sc_signal<bool> f64x32_rt_fifo_write[NT * MAX_FMAC_LANES];
+	sc_signal<bool> f64x32_rt_fifo_read[NT * MAX_FMAC_LANES];
+	sc_signal<uint32_t> f64x32_rt_fifo_rdata[NT * MAX_FMAC_LANES];
+	sc_signal<bool> f64x32_rt_fifo_empty[NT * MAX_FMAC_LANES];
+	sc_signal<bool> f64x32_rt_fifo_full[NT * MAX_FMAC_LANES];
 	// Occupied FMAC slots FIFO
-	sc_fifo<bool> fmac_slots_fifo;
+	vxe_fifo<bool> fmac_slots_fifo;
 	// Busy signals
 	sc_signal<bool> s_load_store_busy;
 	sc_signal<bool> s_exec_pipe_busy;
@@ -728,4 +1337,10 @@ private:
 	sc_signal<uint64_t> s_dpcmd_pl;	// Data processing command payload
 	sc_signal<bool> s_dpcmd_valid;	// Data processing command valid
 	sc_signal<bool> s_load_store_active;
+	// Transaction-level command channel
+	const vxe::vpu_cmd *m_cmd_batch;	// Pending batch of commands
+	unsigned m_cmd_count;			// Number of commands in pending batch
+	bool m_cmd_err;				// Invalid command in last batch
+	sc_event m_cmd_event;			// Batch is pending
+	sc_event m_cmd_done_event;		// Batch is executed
 };
@@ -0,0 +1,195 @@
+#!/usr/bin/perl
+# The VxEngine Project
+# Sharded batch runner for system model workloads
+
+use threads;
+use Thread::Queue;
+use Config;
+use Getopt::Long;
+use Time::HiRes qw(time);
+use Term::ANSIColor qw(:constants);
+
+$Config{useithreads} or
+	die('Recompile Perl with threads to run this program.');
+
+
+# Arguments
+my $print_help;
+my $verbose;
+my $num_threads = `nproc 2>/dev/null` || 4;
+my $num_shards = 0;
+my $model_opts = "";
+my $out_dir = "shards";
+my $bin_path = "$ENV{'VXENGINE_HOME'}/slm/sc/vxmodel.elf";
+my $so_path = "$ENV{'VXENGINE_HOME'}/slm/sc/libmlp_test.so";
+
+chomp($num_threads);
+
+
+# Parse command line
+GetOptions("help" => \$print_help,
+	"verbose" => \$verbose,
+	"nthreads=i" => \$num_threads,
+	"nshards=i" => \$num_shards,
+	"opts=s" => \$model_opts,
+	"outdir=s" => \$out_dir,
+	"binary=s" => \$bin_path,
+	"so=s" => \$so_path)
+or die("Error in command line arguments\n");
+
+$num_shards = $num_threads if($num_shards == 0);
+
+
+# Intro
+print "\n";
+print "VxE model sharded runner\n";
+print "========================\n";
+
+
+# Print help screen
+if($print_help) {
+	print "-help                - this help screen;\n";
+	print "-verbose             - be verbose;\n";
+	print "-nthreads <num>      - Number of parallel model instances;\n";
+	print "-nshards <num>       - Number of shards to split input set into (default: nthreads);\n";
+	print "-opts <options>      - Additional model options (e.g. \"-lt -dmi\");\n";
+	print "-outdir <path>       - Directory for shard logs;\n";
+	print "-binary <path>       - Path to model binary;\n";
+	print "-so <path>           - Path to app shared object (must accept -shard K/N).\n";
+	print "\n";
+	exit 0;
+}
+
+
+# Print run info
+print "Number of workers : $num_threads\n";
+print "Number of shards  : $num_shards\n";
+print "Model options     : $model_opts\n";
+print "Logs directory    : $out_dir\n";
+print "Model binary path : $bin_path\n";
+print "App shared object : $so_path\n";
+
+if($num_threads == 0 || $num_shards == 0) {
+	print "Number of threads or shards is 0. Exiting\n";
+	exit 0;
+}
+
+mkdir($out_dir) unless(-d $out_dir);
+
+
+# Shards queue
+my $shards = Thread::Queue->new(0 .. $num_shards - 1);
+$shards->end();
+
+
+# Worker thread
+sub worker_thread {
+	my ($num) = @_;
+
+	while(defined(my $shard = $shards->dequeue())) {
+		my $log = "$out_dir/shard_${shard}.log";
+		my $cmd = "$bin_path $model_opts -so $so_path -arg -shard -arg $shard/$num_shards " .
+			"1>$log 2>&1";
+		my $err;
+
+		if($verbose) {
+			print "Worker $num: starting shard $shard\n";
+		}
+
+		$err = system("$cmd");
+		if($err != 0) {
+			print RED, "Worker $num: shard $shard exited with error.\n", RESET;
+		} elsif($verbose) {
+			print GREEN, "Worker $num: shard $shard completed\n", RESET;
+		}
+	}
+}
+
+
+# Start workers
+print "\nStarting worker threads...\n";
+my $start_time = time();
+
+for(my $i=0; $i < $num_threads && $i < $num_shards; ++$i) {
+	threads->new(\&worker_thread, $i);
+}
+
+
+# Loop through all the threads
+foreach my $thr (threads->list()) {
+	$thr->join();
+}
+
+my $elapsed = time() - $start_time;
+
+
+# Merge results
+my $passed = 0;
+my $images = 0;
+my $cycles = 0;
+my $max_cycles = 0;
+my $shards_wall = 0;
+my $failed = 0;
+
+open(my $merged, '>', "$out_dir/merged.log") or die("Cannot create $out_dir/merged.log\n");
+
+for(my $i=0; $i < $num_shards; ++$i) {
+	my $log = "$out_dir/shard_${i}.log";
+	my $rate_seen = 0;
+	my $shard_cycles = 0;
+
+	print $merged "=== Shard $i/$num_shards ===\n";
+
+	my $fh;
+
+	if(!open($fh, '<', $log)) {
+		print RED, "Shard $i: no log file.\n", RESET;
+		++$failed;
+		next;
+	}
+
+	while(my $line = <$fh>) {
+		print $merged $line;
+		if($line =~ /^Pass rate: (\d+) \/ (\d+)/) {
+			$passed += $1;
+			$images += $2;
+			$rate_seen = 1;
+		} elsif($line =~ /^> Simulated cycles: (\d+)/) {
+			$shard_cycles = $1;
+		} elsif($line =~ /^> Wall time: ([\d.]+)s/) {
+			$shards_wall += $1;
+		}
+	}
+	close($fh);
+
+	if(!$rate_seen) {
+		print RED, "Shard $i: FAILED (no pass rate reported). See $log\n", RESET;
+		++$failed;
+	}
+
+	$cycles += $shard_cycles;
+	$max_cycles = $shard_cycles if($shard_cycles > $max_cycles);
+}
+
+close($merged);
+
+
+# Print summary
+print "\nSummary\n";
+print "=======\n";
+print "Pass rate         : $passed / $images\n";
+print "Failed shards     : $failed / $num_shards\n";
+print "Simulated cycles  : $cycles (max per shard: $max_cycles)\n";
+printf("Wall time         : %.3fs\n", $elapsed);
+printf("Shards wall time  : %.3fs\n", $shards_wall);
+printf("Parallel speedup  : %.2f\n", $elapsed > 0 ? $shards_wall / $elapsed : 0);
+print "Merged log        : $out_dir/merged.log\n";
+
+if($failed) {
+	print RED, "FAILED\n", RESET;
+	exit 1;
+}
+
+print GREEN, "PASSED\n", RESET;
+
+#END
@@ -0,0 +1,237 @@
+#!/usr/bin/perl
+# The VxEngine Project
+# Parallel design-space sweep of system model parameters
+
+use threads;
+use Thread::Queue;
+use Config;
+use Getopt::Long;
+use Term::ANSIColor qw(:constants);
+
+$Config{useithreads} or
+	die('Recompile Perl with threads to run this program.');
+
+
+# Arguments
+my $print_help;
+my $verbose;
+my $num_threads = `nproc 2>/dev/null` || 4;
+my @grid_args;
+my @workload_args;
+my $base_cfg;
+my $model_opts = "";
+my $out_dir = "sweep";
+my $csv_file = "sweep.csv";
+my $bin_path = "$ENV{'VXENGINE_HOME'}/slm/sc/vxmodel.elf";
+
+chomp($num_threads);
+
+
+# Parse command line
+GetOptions("help" => \$print_help,
+	"verbose" => \$verbose,
+	"nthreads=i" => \$num_threads,
+	"param=s" => \@grid_args,
+	"workload=s" => \@workload_args,
+	"base=s" => \$base_cfg,
+	"opts=s" => \$model_opts,
+	"outdir=s" => \$out_dir,
+	"csv=s" => \$csv_file,
+	"binary=s" => \$bin_path)
+or die("Error in command line arguments\n");
+
+
+# Intro
+print "\n";
+print "VxE model design-space sweep\n";
+print "============================\n";
+
+
+# Print help screen
+if($print_help) {
+	print "-help                - this help screen;\n";
+	print "-verbose             - be verbose;\n";
+	print "-nthreads <num>      - Number of parallel model instances;\n";
+	print "-param <key=v1,v2..> - Parameter values to sweep (can be repeated);\n";
+	print "-workload <name=so[,arg..]> - Workload to run (can be repeated);\n";
+	print "-base <file>         - Base configuration file;\n";
+	print "-opts <options>      - Additional model options (e.g. \"-lt -dmi\");\n";
+	print "-outdir <path>       - Directory for configs and logs;\n";
+	print "-csv <file>          - Output CSV file;\n";
+	print "-binary <path>       - Path to model binary.\n";
+	print "\n";
+	print "Example:\n";
+	print "  run_sweep.pl -param fifo_depth=4,8,16 -param mem_latency=0,8 \\\n";
+	print "    -workload mlp=libmlp_test.so,-shard,0/10\n";
+	print "\n";
+	exit 0;
+}
+
+
+# Parameter grid
+my @keys;
+my %values;
+foreach my $p (@grid_args) {
+	my ($key, $list) = split(/=/, $p, 2);
+	die("Invalid parameter: $p\n") if(!defined($list) || $list eq "");
+	push(@keys, $key) unless(exists($values{$key}));
+	$values{$key} = [ split(/,/, $list) ];
+}
+
+# Workloads
+my @workloads;
+push(@workload_args, "mlp=$ENV{'VXENGINE_HOME'}/slm/sc/libmlp_test.so") if(!@workload_args);
+foreach my $w (@workload_args) {
+	my ($name, $spec) = split(/=/, $w, 2);
+	die("Invalid workload: $w\n") if(!defined($spec) || $spec eq "");
+	my ($so, @args) = split(/,/, $spec);
+	push(@workloads, { name => $name, so => $so, args => [ @args ] });
+}
+
+# Base configuration
+my $base_text = "";
+if(defined($base_cfg)) {
+	open(my $fh, '<', $base_cfg) or die("Cannot open $base_cfg\n");
+	local $/;
+	$base_text = <$fh>;
+	close($fh);
+}
+
+# Expand grid into points
+my @points = ( {} );
+foreach my $key (@keys) {
+	my @expanded;
+	foreach my $pt (@points) {
+		foreach my $v (@{$values{$key}}) {
+			push(@expanded, { %$pt, $key => $v });
+		}
+	}
+	@points = @expanded;
+}
+
+my $num_runs = scalar(@points) * scalar(@workloads);
+
+
+# Print sweep info
+print "Number of workers : $num_threads\n";
+print "Parameters        : " . join(", ", map { "$_=" . join("/", @{$values{$_}}) } @keys) . "\n";
+print "Workloads         : " . join(", ", map { $_->{name} } @workloads) . "\n";
+print "Number of runs    : $num_runs\n";
+print "Base config       : " . (defined($base_cfg) ? $base_cfg : "N/A") . "\n";
+print "Model options     : $model_opts\n";
+print "Output directory  : $out_dir\n";
+print "Model binary path : $bin_path\n";
+
+if($num_threads == 0 || $num_runs == 0) {
+	print "Number of threads or runs is 0. Exiting\n";
+	exit 0;
+}
+
+mkdir($out_dir) unless(-d $out_dir);
+
+
+# Runs queue
+my $runs = Thread::Queue->new(0 .. $num_runs - 1);
+$runs->end();
+
+
+# Worker thread
+sub worker_thread {
+	my ($num) = @_;
+
+	while(defined(my $run = $runs->dequeue())) {
+		my $pt = $points[int($run / scalar(@workloads))];
+		my $wl = $workloads[$run % scalar(@workloads)];
+		my $cfg = "$out_dir/run_${run}.cfg";
+		my $log = "$out_dir/run_${run}.log";
+		my $args = join(" ", map { "-arg $_" } @{$wl->{args}});
+		my $err;
+
+		# Write configuration
+		open(my $fh, '>', $cfg) or die("Cannot create $cfg\n");
+		print $fh $base_text;
+		print $fh "\n# Sweep point\n";
+		print $fh "$_ = $pt->{$_}\n" foreach(@keys);
+		close($fh);
+
+		if($verbose) {
+			print "Worker $num: starting run $run\n";
+		}
+
+		$err = system("$bin_path -config $cfg $model_opts -so $wl->{so} $args 1>$log 2>&1");
+		if($err != 0) {
+			print RED, "Worker $num: run $run exited with error.\n", RESET;
+		} elsif($verbose) {
+			print GREEN, "Worker $num: run $run completed\n", RESET;
+		}
+	}
+}
+
+
+# Start workers
+print "\nStarting worker threads...\n";
+
+for(my $i=0; $i < $num_threads && $i < $num_runs; ++$i) {
+	threads->new(\&worker_thread, $i);
+}
+
+
+# Loop through all the threads
+foreach my $thr (threads->list()) {
+	$thr->join();
+}
+
+
+# Collect results
+my $failed = 0;
+
+open(my $csv, '>', $csv_file) or die("Cannot create $csv_file\n");
+print $csv join(",", @keys, "workload", "status", "sim_cycles", "vxe_busy_cycles",
+	"utilization", "wall_time_s", "pass_rate") . "\n";
+
+for(my $run = 0; $run < $num_runs; ++$run) {
+	my $pt = $points[int($run / scalar(@workloads))];
+	my $wl = $workloads[$run % scalar(@workloads)];
+	my $log = "$out_dir/run_${run}.log";
+	my ($cycles, $busy, $util, $wall, $rate) = ("", "", "", "", "");
+	my $fh;
+
+	if(open($fh, '<', $log)) {
+		while(my $line = <$fh>) {
+			if($line =~ /^> Simulated cycles: (\d+)/) {
+				$cycles = $1;
+			} elsif($line =~ /^> VxE busy cycles: (\d+)/) {
+				$busy = $1;
+			} elsif($line =~ /^> VxE utilization: ([\d.]+)%/) {
+				$util = $1;
+			} elsif($line =~ /^> Wall time: ([\d.]+)s/) {
+				$wall = $1;
+			} elsif($line =~ /^Pass rate: (\d+) \/ (\d+)/) {
+				$rate = "$1/$2";
+			}
+		}
+		close($fh);
+	}
+
+	my $status = ($cycles ne "" ? "ok" : "failed");
+	if($status ne "ok") {
+		print RED, "Run $run: FAILED. See $log\n", RESET;
+		++$failed;
+	}
+
+	print $csv join(",", (map { $pt->{$_} } @keys), $wl->{name}, $status, $cycles, $busy,
+		$util, $wall, $rate) . "\n";
+}
+
+close($csv);
+
+
+# Print summary
+print "\nSummary\n";
+print "=======\n";
+print "Completed runs    : " . ($num_runs - $failed) . " / $num_runs\n";
+print "Results           : $csv_file\n";
+
+exit($failed ? 1 : 0);
+
+#END
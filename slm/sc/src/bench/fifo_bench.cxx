@@ -0,0 +1,291 @@
+/*
+ * Copyright (c) 2022 The VxEngine Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * 64b-to-32b FIFO benchmark.
+ *
+ * Drives random writes and reads into a single FIFO module and checks the
+ * data read back against a reference queue.
+ */
+
+#include <chrono>
+#include <deque>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <cstring>
+#include <systemc.h>
+#include "vxe_fifo64x32.hxx"
+
+
+namespace {
+
+	// FIFO depth (same as in VPU)
+	constexpr unsigned FIFO_DEPTH = 16;
+
+
+	// Benchmark top-level
+	SC_MODULE(fifo_bench) {
+		sc_in<bool> clk;
+		sc_in<bool> nrst;
+
+		SC_HAS_PROCESS(fifo_bench);
+
+		fifo_bench(::sc_core::sc_module_name name, unsigned long cycles, unsigned load,
+			unsigned seed)
+			: ::sc_core::sc_module(name), clk("clk"), nrst("nrst")
+			, m_cycles(cycles), m_load(load), m_rng(seed)
+			, m_writes(0), m_reads(0), m_errors(0), m_fifo("fifo")
+		{
+			SC_THREAD(stimulus_thread);
+				sensitive << clk.pos();
+
+			m_fifo.clk(clk);
+			m_fifo.nrst(nrst);
+			m_fifo.i_data(s_wdata);
+			m_fifo.i_write(s_write);
+			m_fifo.i_valid(s_wvalid);
+			m_fifo.o_full(s_full);
+			m_fifo.i_read(s_read);
+			m_fifo.o_empty(s_empty);
+			m_fifo.o_data(s_rdata);
+		}
+
+		unsigned long writes() const { return m_writes; }
+		unsigned long reads() const { return m_reads; }
+		unsigned long errors() const { return m_errors; }
+
+	private:
+		// Reference FIFO entry
+		struct entry {
+			uint32_t w[2];	// 32-bit words
+			bool v[2];	// Valid bits
+		};
+
+		/**
+		 * Stimulus thread
+		 * Requests are applied by the FIFO on the next clock edge. Reference
+		 * model is updated at the same time the request is issued, so FIFO
+		 * state is always known without sampling o_full and o_empty.
+		 */
+		[[noreturn]] void stimulus_thread()
+		{
+			bool rd_pending = false;	// Read was issued on previous cycle
+			uint32_t rd_expected = 0;	// Expected word for the pending read
+
+			// Wait for reset release
+			do {
+				wait();
+			} while(!nrst.read());
+
+			for(unsigned long i = 0; i < m_cycles; ++i) {
+				// Check data of the read issued on previous cycle
+				if(rd_pending)
+					check(rd_expected);
+
+				bool wr = (m_rng() % 100) < m_load && m_ref.size() < FIFO_DEPTH;
+				bool rd = (m_rng() % 100) < m_load && !m_ref.empty();
+
+				rd_pending = rd;
+				if(rd) {
+					entry& e = m_ref.front();
+					unsigned k = e.v[0] ? 0 : 1;
+					rd_expected = e.w[k];
+					e.v[k] = false;
+					if(!e.v[0] && !e.v[1])
+						m_ref.pop_front();
+					++m_reads;
+				}
+
+				if(wr) {
+					entry e;
+					unsigned valid = 1 + m_rng() % 3;
+					e.w[0] = m_rng();
+					e.w[1] = m_rng();
+					e.v[0] = ((valid & 0x1u) != 0);
+					e.v[1] = ((valid & 0x2u) != 0);
+					m_ref.push_back(e);
+					s_wdata.write((uint64_t(e.w[1]) << 32) | e.w[0]);
+					s_wvalid.write(valid);
+					++m_writes;
+				}
+
+				s_write.write(wr);
+				s_read.write(rd);
+				wait();
+			}
+
+			s_write.write(false);
+			s_read.write(false);
+			wait();
+
+			if(rd_pending)
+				check(rd_expected);
+
+			sc_stop();
+
+			while(true)
+				wait();
+		}
+
+		/**
+		 * Check FIFO output
+		 * @param expected expected value
+		 */
+		void check(uint32_t expected)
+		{
+			constexpr unsigned MAX_REPORTS = 16;
+			if(s_rdata.read() != expected && m_errors++ < MAX_REPORTS) {
+				std::cerr << sc_time_stamp() << ": data mismatch: "
+					<< std::hex << std::setfill('0')
+					<< "FIFO=" << std::setw(8) << s_rdata.read()
+					<< " expected=" << std::setw(8) << expected
+					<< std::dec << std::setfill(' ') << std::endl;
+			}
+		}
+
+	private:
+		const unsigned long m_cycles;
+		const unsigned m_load;
+		std::mt19937 m_rng;
+		unsigned long m_writes;
+		unsigned long m_reads;
+		unsigned long m_errors;
+		std::deque<entry> m_ref;	// Reference model
+		// FIFO under test
+		vxe_fifo64x32<FIFO_DEPTH> m_fifo;
+		sc_signal<uint64_t> s_wdata;
+		sc_signal<bool> s_write;
+		sc_signal<sc_uint<2>> s_wvalid;
+		sc_signal<bool> s_full;
+		sc_signal<bool> s_read;
+		sc_signal<bool> s_empty;
+		sc_signal<uint32_t> s_rdata;
+	};
+
+} // Private namespace
+
+
+// MAIN
+int sc_main(int argc, char *argv[])
+{
+	unsigned long cycles = 1000000;
+	unsigned load = 50;
+	unsigned seed = 1;
+
+	// Parse command-line arguments
+	for(int i=1; i<argc; ++i) {
+		if(!strcmp(argv[i], "-h")) {
+			std::cout << std::endl << "Command line arguments:" << std::endl
+				<< "\t-h                   - this help screen;" << std::endl
+				<< "\t-cycles <num>        - number of clock cycles to run;" << std::endl
+				<< "\t-load <percent>      - write and read probability per cycle;" << std::endl
+				<< "\t-seed <num>          - random seed." << std::endl
+				<< std::endl;
+			return 0;
+		} else if(!strcmp(argv[i], "-cycles")) {
+			++i;
+			if(i<argc) {
+				try {
+					cycles = std::stoul(argv[i]);
+				}
+				catch(const std::exception& e)
+				{
+					std::cerr << e.what() << std::endl;
+				}
+			} else {
+				std::cerr << "-cycles: missing number." << std::endl;
+			}
+		} else if(!strcmp(argv[i], "-load")) {
+			++i;
+			if(i<argc) {
+				try {
+					load = std::stoul(argv[i]);
+				}
+				catch(const std::exception& e)
+				{
+					std::cerr << e.what() << std::endl;
+				}
+			} else {
+				std::cerr << "-load: missing percent." << std::endl;
+			}
+		} else if(!strcmp(argv[i], "-seed")) {
+			++i;
+			if(i<argc) {
+				try {
+					seed = std::stoul(argv[i]);
+				}
+				catch(const std::exception& e)
+				{
+					std::cerr << e.what() << std::endl;
+				}
+			} else {
+				std::cerr << "-seed: missing number." << std::endl;
+			}
+		} else {
+			std::cerr << "Unknown argument: " << argv[i] << std::endl;
+		}
+	}
+
+	// Print benchmark parameters
+	std::cout << std::endl;
+	std::cout << std::setfill('=') << std::setw(80) << "=" << std::endl;
+	std::cout << "FIFO benchmark parameters:" << std::endl;
+	std::cout << "> Depth: " << FIFO_DEPTH << std::endl;
+	std::cout << "> Cycles: " << cycles << std::endl;
+	std::cout << "> Load: " << load << "%" << std::endl;
+	std::cout << "> Seed: " << seed << std::endl;
+	std::cout << std::setfill('=') << std::setw(80) << "=" << std::endl;
+
+	// Clock and reset
+	sc_clock clk("clk", 10, SC_NS);
+	sc_signal<bool> nrst;
+
+	fifo_bench bench("fifo_bench", cycles, load, seed);
+	bench.clk(clk);
+	bench.nrst(nrst);
+
+	auto start = std::chrono::steady_clock::now();
+
+	sc_start(0, SC_NS);
+	nrst = 0;
+	sc_start(100, SC_NS);
+	nrst = 1;
+	sc_start();
+
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+	// Print results
+	std::cout << "Wall time: " << std::fixed << std::setprecision(3)
+		<< elapsed.count() << " s" << std::endl;
+	std::cout << "Simulation speed: " << std::setprecision(0)
+		<< (elapsed.count() > 0 ? cycles / elapsed.count() : 0) << " cycles/s" << std::endl;
+	std::cout << "Writes: " << bench.writes() << std::endl;
+	std::cout << "Reads: " << bench.reads() << std::endl;
+	std::cout << "Mismatches: " << bench.errors() << std::endl;
+	std::cout << (bench.errors() == 0 ? "PASSED" : "FAILED") << std::endl;
+
+	return bench.errors() == 0 ? 0 : 1;
+}
@@ -0,0 +1,391 @@
+/*
+ * Copyright (c) 2022 The VxEngine Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * FMAC32 and FReLU32 benchmark. Native C++ models vs Verilated RTL.
+ *
+ * Mode "cmp" runs both models side by side on the same random operands and
+ * checks results cycle by cycle. Modes "vl" and "native" run only one model
+ * to measure its simulation speed.
+ */
+
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <random>
+#include <cstring>
+#include <systemc.h>
+#include "flp32_mac_5stg.hxx"
+#include "flp32_relu.hxx"
+#include "obj_dir/Vflp32_mac_5stg.h"
+#include "obj_dir/Vflp32_relu.h"
+
+
+namespace {
+
+	/**
+	 * Random operands generator
+	 * Mixes random normal values with special values and subnormals.
+	 */
+	class operand_gen {
+		std::mt19937 m_rng;
+	public:
+		explicit operand_gen(unsigned seed) : m_rng(seed) {}
+
+		uint32_t next()
+		{
+			const uint32_t sign = m_rng() & 0x80000000;
+			switch(m_rng() % 16) {
+				case 0:	// Zero
+					return sign;
+				case 1:	// Inf
+					return sign | 0x7F800000;
+				case 2:	// NaN
+					return sign | 0x7F800000 | (m_rng() & 0x007FFFFF) | 1;
+				case 3:	// Subnormal
+					return sign | (m_rng() & 0x007FFFFF);
+				case 4:	// Huge or tiny values for overflows and underflows
+					return sign | ((m_rng() & 1 ? 0xF8 + m_rng() % 7 : 1 + m_rng() % 7) << 23)
+						| (m_rng() & 0x007FFFFF);
+				default: // Normal values with close exponents
+					return sign | ((120 + m_rng() % 16) << 23) | (m_rng() & 0x007FFFFF);
+			}
+		}
+
+		bool chance(unsigned percent)
+		{
+			return (m_rng() % 100) < percent;
+		}
+
+		uint32_t bits(unsigned width)
+		{
+			return m_rng() & ((1u << width) - 1);
+		}
+	};
+
+
+	// Benchmark top-level
+	SC_MODULE(fpu_bench) {
+		sc_in<bool> clk;
+		sc_in<bool> nrst;
+
+		SC_HAS_PROCESS(fpu_bench);
+
+		fpu_bench(::sc_core::sc_module_name name, bool use_vl, bool use_native,
+			unsigned long cycles, unsigned seed)
+			: ::sc_core::sc_module(name), clk("clk"), nrst("nrst")
+			, m_use_vl(use_vl), m_use_native(use_native), m_cycles(cycles)
+			, m_gen(seed), m_fmac_ops(0), m_relu_ops(0), m_errors(0), m_flag_diffs(0)
+		{
+			SC_THREAD(stimulus_thread);
+				sensitive << clk.pos();
+
+			if(m_use_vl && m_use_native) {
+				SC_METHOD(check_method);
+					sensitive << clk.neg();
+					dont_initialize();
+			}
+
+			if(m_use_vl) {
+				m_vl_fmac.reset(new Vflp32_mac_5stg("vl_fmac"));
+				m_vl_fmac->clk(clk);
+				m_vl_fmac->nrst(nrst);
+				m_vl_fmac->i_a(s_a);
+				m_vl_fmac->i_b(s_b);
+				m_vl_fmac->i_c(s_c);
+				m_vl_fmac->i_valid(s_valid);
+				m_vl_fmac->o_p(s_vl_p);
+				m_vl_fmac->o_sign(s_vl_sign);
+				m_vl_fmac->o_zero(s_vl_zero);
+				m_vl_fmac->o_nan(s_vl_nan);
+				m_vl_fmac->o_inf(s_vl_inf);
+				m_vl_fmac->o_valid(s_vl_valid);
+
+				m_vl_relu.reset(new Vflp32_relu("vl_relu"));
+				m_vl_relu->i_v(s_v);
+				m_vl_relu->i_l(s_l);
+				m_vl_relu->i_e(s_e);
+				m_vl_relu->o_r(s_vl_r);
+			}
+
+			if(m_use_native) {
+				m_nt_fmac.reset(new flp32_mac_5stg("nt_fmac"));
+				m_nt_fmac->clk(clk);
+				m_nt_fmac->nrst(nrst);
+				m_nt_fmac->i_a(s_a);
+				m_nt_fmac->i_b(s_b);
+				m_nt_fmac->i_c(s_c);
+				m_nt_fmac->i_valid(s_valid);
+				m_nt_fmac->o_p(s_nt_p);
+				m_nt_fmac->o_sign(s_nt_sign);
+				m_nt_fmac->o_zero(s_nt_zero);
+				m_nt_fmac->o_nan(s_nt_nan);
+				m_nt_fmac->o_inf(s_nt_inf);
+				m_nt_fmac->o_valid(s_nt_valid);
+
+				m_nt_relu.reset(new flp32_relu("nt_relu"));
+				m_nt_relu->i_v(s_v);
+				m_nt_relu->i_l(s_l);
+				m_nt_relu->i_e(s_e);
+				m_nt_relu->o_r(s_nt_r);
+			}
+		}
+
+		unsigned long fmac_ops() const { return m_fmac_ops; }
+		unsigned long relu_ops() const { return m_relu_ops; }
+		unsigned long errors() const { return m_errors; }
+		unsigned long flag_diffs() const { return m_flag_diffs; }
+
+	private:
+		/**
+		 * Stimulus thread
+		 * Drives new random operands on every clock cycle.
+		 */
+		[[noreturn]] void stimulus_thread()
+		{
+			// Wait for reset release
+			do {
+				wait();
+			} while(!nrst.read());
+
+			for(unsigned long i = 0; i < m_cycles; ++i) {
+				// FMAC32 operands
+				s_a.write(m_gen.next());
+				s_b.write(m_gen.next());
+				s_c.write(m_gen.next());
+				s_valid.write(m_gen.chance(75));
+				// FReLU32 operands
+				s_v.write(m_gen.next());
+				s_l.write(m_gen.chance(50));
+				s_e.write(m_gen.bits(7));
+				wait();
+			}
+
+			s_valid.write(false);
+			wait(8);	// Drain FMAC pipe
+
+			sc_stop();
+
+			while(true)
+				wait();
+		}
+
+		/**
+		 * Checker method
+		 * Compares outputs of both models on the negative clock edge.
+		 */
+		void check_method()
+		{
+			if(!nrst.read())
+				return;
+
+			// FMAC32
+			if(s_vl_valid.read() != s_nt_valid.read()) {
+				report("FMAC32 valid", s_vl_valid.read(), s_nt_valid.read());
+			} else if(s_vl_valid.read()) {
+				++m_fmac_ops;
+				if(s_vl_p.read() != s_nt_p.read() || s_vl_sign.read() != s_nt_sign.read())
+					report("FMAC32 result", s_vl_p.read(), s_nt_p.read());
+				else if(s_vl_zero.read() != s_nt_zero.read() || s_vl_nan.read() != s_nt_nan.read()
+					|| s_vl_inf.read() != s_nt_inf.read())
+					++m_flag_diffs;
+			}
+
+			// FReLU32
+			++m_relu_ops;
+			if(s_vl_r.read() != s_nt_r.read())
+				report("FReLU32 result", s_vl_r.read(), s_nt_r.read());
+		}
+
+		/**
+		 * Report mismatch
+		 * @param what mismatching output
+		 * @param vl Verilated model value
+		 * @param nt native model value
+		 */
+		void report(const char *what, uint32_t vl, uint32_t nt)
+		{
+			constexpr unsigned MAX_REPORTS = 16;
+			if(m_errors++ < MAX_REPORTS) {
+				std::cerr << sc_time_stamp() << ": " << what << " mismatch: "
+					<< std::hex << std::setfill('0')
+					<< "RTL=" << std::setw(8) << vl
+					<< " native=" << std::setw(8) << nt
+					<< std::dec << std::setfill(' ') << std::endl;
+			}
+		}
+
+	private:
+		const bool m_use_vl;
+		const bool m_use_native;
+		const unsigned long m_cycles;
+		operand_gen m_gen;
+		unsigned long m_fmac_ops;
+		unsigned long m_relu_ops;
+		unsigned long m_errors;
+		unsigned long m_flag_diffs;
+		// Models under test
+		std::unique_ptr<Vflp32_mac_5stg> m_vl_fmac;
+		std::unique_ptr<Vflp32_relu> m_vl_relu;
+		std::unique_ptr<flp32_mac_5stg> m_nt_fmac;
+		std::unique_ptr<flp32_relu> m_nt_relu;
+		// FMAC32 inputs
+		sc_signal<uint32_t> s_a;
+		sc_signal<uint32_t> s_b;
+		sc_signal<uint32_t> s_c;
+		sc_signal<bool> s_valid;
+		// Verilated FMAC32 outputs
+		sc_signal<uint32_t> s_vl_p;
+		sc_signal<bool> s_vl_sign;
+		sc_signal<bool> s_vl_zero;
+		sc_signal<bool> s_vl_nan;
+		sc_signal<bool> s_vl_inf;
+		sc_signal<bool> s_vl_valid;
+		// Native FMAC32 outputs
+		sc_signal<uint32_t> s_nt_p;
+		sc_signal<bool> s_nt_sign;
+		sc_signal<bool> s_nt_zero;
+		sc_signal<bool> s_nt_nan;
+		sc_signal<bool> s_nt_inf;
+		sc_signal<bool> s_nt_valid;
+		// FReLU32 inputs
+		sc_signal<uint32_t> s_v;
+		sc_signal<bool> s_l;
+		sc_signal<uint32_t> s_e;
+		// FReLU32 outputs
+		sc_signal<uint32_t> s_vl_r;
+		sc_signal<uint32_t> s_nt_r;
+	};
+
+} // Private namespace
+
+
+// MAIN
+int sc_main(int argc, char *argv[])
+{
+	unsigned long cycles = 1000000;
+	unsigned seed = 1;
+	const char *mode = "cmp";
+
+	// Parse command-line arguments
+	for(int i=1; i<argc; ++i) {
+		if(!strcmp(argv[i], "-h")) {
+			std::cout << std::endl << "Command line arguments:" << std::endl
+				<< "\t-h                   - this help screen;" << std::endl
+				<< "\t-mode <mode>         - cmp (default), vl or native;" << std::endl
+				<< "\t-cycles <num>        - number of clock cycles to run;" << std::endl
+				<< "\t-seed <num>          - random seed." << std::endl
+				<< std::endl;
+			return 0;
+		} else if(!strcmp(argv[i], "-mode")) {
+			++i;
+			if(i<argc) {
+				mode = argv[i];
+			} else {
+				std::cerr << "-mode: missing mode." << std::endl;
+			}
+		} else if(!strcmp(argv[i], "-cycles")) {
+			++i;
+			if(i<argc) {
+				try {
+					cycles = std::stoul(argv[i]);
+				}
+				catch(const std::exception& e)
+				{
+					std::cerr << e.what() << std::endl;
+				}
+			} else {
+				std::cerr << "-cycles: missing number." << std::endl;
+			}
+		} else if(!strcmp(argv[i], "-seed")) {
+			++i;
+			if(i<argc) {
+				try {
+					seed = std::stoul(argv[i]);
+				}
+				catch(const std::exception& e)
+				{
+					std::cerr << e.what() << std::endl;
+				}
+			} else {
+				std::cerr << "-seed: missing number." << std::endl;
+			}
+		} else {
+			std::cerr << "Unknown argument: " << argv[i] << std::endl;
+		}
+	}
+
+	bool use_vl = !strcmp(mode, "cmp") || !strcmp(mode, "vl");
+	bool use_native = !strcmp(mode, "cmp") || !strcmp(mode, "native");
+	if(!use_vl && !use_native) {
+		std::cerr << "Unknown mode: " << mode << std::endl;
+		return 1;
+	}
+
+	// Print benchmark parameters
+	std::cout << std::endl;
+	std::cout << std::setfill('=') << std::setw(80) << "=" << std::endl;
+	std::cout << "FPU benchmark parameters:" << std::endl;
+	std::cout << "> Mode: " << mode << std::endl;
+	std::cout << "> Cycles: " << cycles << std::endl;
+	std::cout << "> Seed: " << seed << std::endl;
+	std::cout << std::setfill('=') << std::setw(80) << "=" << std::endl;
+
+	// Clock and reset
+	sc_clock clk("clk", 10, SC_NS);
+	sc_signal<bool> nrst;
+
+	fpu_bench bench("fpu_bench", use_vl, use_native, cycles, seed);
+	bench.clk(clk);
+	bench.nrst(nrst);
+
+	auto start = std::chrono::steady_clock::now();
+
+	sc_start(0, SC_NS);
+	nrst = 0;
+	sc_start(100, SC_NS);
+	nrst = 1;
+	sc_start();
+
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+	// Print results
+	std::cout << "Wall time: " << std::fixed << std::setprecision(3)
+		<< elapsed.count() << " s" << std::endl;
+	std::cout << "Simulation speed: " << std::setprecision(0)
+		<< (elapsed.count() > 0 ? cycles / elapsed.count() : 0) << " cycles/s" << std::endl;
+
+	if(use_vl && use_native) {
+		std::cout << "FMAC32 results checked: " << bench.fmac_ops() << std::endl;
+		std::cout << "FReLU32 results checked: " << bench.relu_ops() << std::endl;
+		std::cout << "Flags-only differences: " << bench.flag_diffs() << std::endl;
+		std::cout << "Mismatches: " << bench.errors() << std::endl;
+		std::cout << (bench.errors() == 0 ? "PASSED" : "FAILED") << std::endl;
+		return bench.errors() == 0 ? 0 : 1;
+	}
+
+	return 0;
+}
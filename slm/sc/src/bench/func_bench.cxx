@@ -0,0 +1,542 @@
+/*
+ * Copyright (c) 2022 The VxEngine Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Functional model parallel mode benchmark.
+ *
+ * Builds a program where both VPUs compute vector products on independent
+ * data, runs it on the functional model sequentially and with VPUs on
+ * separate host threads, checks that memory and VPU state are bit-exact
+ * and reports speedup.
+ * With -so an application (e.g. mlp_test or relu_test) is run instead: its
+ * VxEngine programs execute on the functional model, MMIO and interrupts
+ * are emulated, and speedup is reported for time spent in the model.
+ */
+
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <dlfcn.h>
+#include "vxe_common.hxx"
+#include "vxe_internal.hxx"
+#include "vxe_func_model.hxx"
+#include "simple_cpu_if.h"
+
+
+namespace {
+
+	// Threads per VPU (same as in VPU)
+	constexpr unsigned NT = 8;
+	// Number of input vectors per VPU
+	constexpr unsigned POOL_SIZE = 16;
+	// Application memory size
+	constexpr uint64_t APP_MEM_SIZE = 64 << 20;
+
+	using func_model = vxe_func_model<NT>;
+
+
+	// Program and data in host memory
+	class workload {
+	public:
+		/**
+		 * Constructor
+		 * @param segments number of program segments (SYNC separated)
+		 * @param len vector length
+		 * @param vpus number of VPUs
+		 * @param shared VPU N reads results stored by VPU N-1 in the same segment
+		 * @param seed random seed
+		 */
+		workload(unsigned segments, unsigned len, unsigned vpus, bool shared, unsigned seed)
+			: m_vpus(vpus)
+		{
+			const uint64_t vec_size = uint64_t(len) * sizeof(uint32_t);
+			const uint64_t out_size = uint64_t(segments) * vpus * NT * sizeof(uint32_t);
+
+			m_pgm_addr = 0;
+			m_out_addr = m_pgm_addr + (uint64_t(segments) * (vpus * NT * 6 + vpus * 2 + 1) + 1)
+				* sizeof(uint64_t);
+			m_vec_addr = m_out_addr + out_size;
+			m_mem.resize(m_vec_addr + vpus * 2 * POOL_SIZE * vec_size);
+
+			// Input vectors
+			std::mt19937 rng(seed);
+			std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+			for(uint64_t a = m_vec_addr; a < m_mem.size(); a += sizeof(float)) {
+				float f = dist(rng);
+				memcpy(&m_mem[a], &f, sizeof(float));
+			}
+
+			// Program
+			uint64_t pc = m_pgm_addr;
+			auto emit = [this, &pc](uint64_t instr) {
+				memcpy(&m_mem[pc], &instr, sizeof(instr));
+				pc += sizeof(instr);
+			};
+
+			for(unsigned s = 0; s < segments; ++s) {
+				for(unsigned v = 0; v < vpus; ++v) {
+					for(unsigned th = 0; th < NT; ++th) {
+						const unsigned dst = v * NT + th;
+						const unsigned k = (s + th) % POOL_SIZE;
+						uint64_t rs = m_vec_addr + (uint64_t(v) * 2 * POOL_SIZE + k) * vec_size;
+						uint64_t rt = rs + POOL_SIZE * vec_size;
+						uint64_t rd = m_out_addr + (uint64_t(s) * vpus * NT + dst) * sizeof(uint32_t);
+
+						// Make VPU N depend on results of VPU N-1
+						if(shared && v != 0 && th == 0)
+							rs = rd - NT * sizeof(uint32_t);
+
+						emit(vxe::instr::setacc(dst, 0.0f));
+						emit(vxe::instr::setrs(dst, rs));
+						emit(vxe::instr::setrt(dst, rt));
+						emit(vxe::instr::setrd(dst, rd));
+						emit(vxe::instr::setvl(dst, shared && v != 0 && th == 0 ? 1 : len));
+						emit(vxe::instr::seten(dst, true));
+					}
+				}
+				for(unsigned v = 0; v < vpus; ++v)
+					emit(vxe::instr::prod(v));
+				for(unsigned v = 0; v < vpus; ++v)
+					emit(vxe::instr::store(v));
+				emit(vxe::instr::sync(false, false));
+			}
+			emit(vxe::instr::sync(true, true));
+		}
+
+		uint64_t pgm_addr() const { return m_pgm_addr; }
+		const std::vector<uint8_t>& mem() const { return m_mem; }
+
+		/**
+		 * Run program on functional model
+		 * @param parallel enable parallel mode
+		 * @param mem memory image (updated)
+		 * @param vpus VPU states (updated)
+		 * @param stats parallel mode statistics (updated)
+		 * @return execution result
+		 */
+		func_model::result run(bool parallel, std::vector<uint8_t>& mem,
+			std::vector<func_model::vpu_state>& vpus, func_model::par_stats& stats) const
+		{
+			func_model fm(
+				[&mem](uint64_t addr, uint64_t len) -> uint8_t*
+				{
+					return (addr <= mem.size() && len <= mem.size() - addr ? &mem[addr] : nullptr);
+				}, m_vpus
+			);
+			fm.set_parallel(parallel);
+			vpus.assign(m_vpus, func_model::vpu_state());
+			auto r = fm.run(m_pgm_addr, vpus.data());
+			stats = fm.stats();
+			return r;
+		}
+
+	private:
+		unsigned m_vpus;		// Number of VPUs
+		uint64_t m_pgm_addr;		// Program address
+		uint64_t m_out_addr;		// Results address
+		uint64_t m_vec_addr;		// Input vectors address
+		std::vector<uint8_t> m_mem;	// Memory image
+	};
+
+
+	// Application running on functional model (single VxEngine instance)
+	class app_workload {
+	public:
+		/**
+		 * Constructor
+		 * @param so_file application shared object
+		 * @param args application arguments
+		 * @param vpus number of VPUs
+		 * @param threads number of threads per VPU
+		 */
+		app_workload(const std::string& so_file, const std::vector<std::string>& args,
+			unsigned vpus, unsigned threads)
+			: m_args(args), m_vpus(vpus), m_threads(threads), m_entry(nullptr)
+		{
+			m_handle = dlopen(so_file.c_str(), RTLD_NOW);
+			if(!m_handle) {
+				std::cerr << "Failed to load " << so_file << ": " << dlerror() << std::endl;
+				return;
+			}
+			m_entry = reinterpret_cast<simple_cpu_entry_t>(dlsym(m_handle, SIMPLE_CPU_ENTRY_NAME));
+			if(!m_entry)
+				std::cerr << so_file << ": no entry point." << std::endl;
+		}
+
+		~app_workload()
+		{
+			if(m_handle)
+				dlclose(m_handle);
+		}
+
+		app_workload(const app_workload&) = delete;
+		app_workload& operator=(const app_workload&) = delete;
+
+		bool valid() const { return m_entry != nullptr; }
+
+		/**
+		 * Run application, its programs are run on functional model
+		 * @param parallel enable parallel mode
+		 * @param mem memory image (replaced)
+		 * @param vpus VPU states after last program (replaced)
+		 * @param stats parallel mode statistics (replaced)
+		 * @param model_s time spent in functional model
+		 * @return accumulated execution result of all programs
+		 */
+		func_model::result run(bool parallel, std::vector<uint8_t>& mem,
+			std::vector<func_model::vpu_state>& vpus, func_model::par_stats& stats,
+			double& model_s)
+		{
+			m_parallel = parallel;
+			m_mem = &mem;
+			m_vpu_st = &vpus;
+			m_stats = &stats;
+			m_model_s = &model_s;
+			mem.assign(APP_MEM_SIZE, 0);
+			vpus.assign(m_vpus, func_model::vpu_state());
+			stats = {};
+			model_s = 0;
+			m_res = { 0, 0, 0, 0 };
+			m_pgm_addr = 0;
+			m_intr = 0;
+
+			std::vector<const char*> argv;
+			for(const auto& a : m_args)
+				argv.push_back(a.c_str());
+			argv.push_back(nullptr);
+
+			struct simple_cpu_if cpu_if = {};
+			cpu_if.cpuid = this;
+			cpu_if.wait = [](void *) {};
+			cpu_if.wait_cycles = [](void *, unsigned) {};
+			cpu_if.wait_intr = [](void *) {};	// Programs are completed on start
+			cpu_if.mmio_rreg32 = mmio_rreg32;
+			cpu_if.mmio_wreg32 = mmio_wreg32;
+			cpu_if.get_dmi = get_dmi;
+			cpu_if.checkpoint = [](void *, int) { return SIMPLE_CPU_CKPT_NONE; };
+			cpu_if.get_vxe_info = get_vxe_info;
+			cpu_if.argc = static_cast<int>(m_args.size());
+			cpu_if.argv = argv.data();
+
+			m_exit_code = m_entry(&cpu_if);
+
+			return m_res;
+		}
+
+		// Application exit code of the last run
+		int exit_code() const { return m_exit_code; }
+
+	private:
+		static uint32_t mmio_rreg32(void *cpuid, uint64_t addr)
+		{
+			auto *self = static_cast<app_workload*>(cpuid);
+			switch(addr) {
+				case vxe::rego::REG_ID:
+					return vxe::VXENGINE_ID;
+				case vxe::rego::REG_INTR_ACT:
+				case vxe::rego::REG_INTR_RAW:
+					return self->m_intr;
+				default:
+					return 0;
+			}
+		}
+
+		static void mmio_wreg32(void *cpuid, uint64_t addr, uint32_t value)
+		{
+			auto *self = static_cast<app_workload*>(cpuid);
+			switch(addr) {
+				case vxe::rego::REG_PGM_ADDR_LO:
+					self->m_pgm_addr = (self->m_pgm_addr & ~0xFFFFFFFFull) | value;
+					break;
+				case vxe::rego::REG_PGM_ADDR_HI:
+					self->m_pgm_addr = (self->m_pgm_addr & 0xFFFFFFFFull) | (uint64_t(value) << 32u);
+					break;
+				case vxe::rego::REG_INTR_ACT:
+					self->m_intr &= ~value;
+					break;
+				case vxe::rego::REG_START:
+					self->run_program();
+					break;
+			}
+		}
+
+		static int get_dmi(void *cpuid, struct simple_cpu_dmi *dmi)
+		{
+			auto *self = static_cast<app_workload*>(cpuid);
+			dmi->ptr = self->m_mem->data();
+			dmi->start = 0;
+			dmi->end = self->m_mem->size() - 1;
+			return 1;
+		}
+
+		static void get_vxe_info(void *cpuid, struct simple_cpu_vxe_info *info)
+		{
+			auto *self = static_cast<app_workload*>(cpuid);
+			*info = { 1, 0, 0, self->m_vpus, self->m_threads };
+		}
+
+		// Run program from REG_PGM_ADDR on functional model
+		void run_program()
+		{
+			std::vector<uint8_t>& mem = *m_mem;
+			func_model fm(
+				[&mem](uint64_t addr, uint64_t len) -> uint8_t*
+				{
+					return (addr <= mem.size() && len <= mem.size() - addr ? &mem[addr] : nullptr);
+				}, m_vpus, m_threads
+			);
+			fm.set_parallel(m_parallel);
+			m_vpu_st->assign(m_vpus, func_model::vpu_state());
+
+			auto start = std::chrono::steady_clock::now();
+			auto r = fm.run(m_pgm_addr, m_vpu_st->data());
+			std::chrono::duration<double> d = std::chrono::steady_clock::now() - start;
+			*m_model_s += d.count();
+
+			m_intr |= r.intr;
+			m_res.intr |= r.intr;
+			m_res.pgm_counter = r.pgm_counter;
+			m_res.instrs += r.instrs;
+			m_res.data_errors += r.data_errors;
+			m_stats->segments += fm.stats().segments;
+			m_stats->parallel += fm.stats().parallel;
+			m_stats->hazards += fm.stats().hazards;
+		}
+
+		std::vector<std::string> m_args;	// Application arguments
+		unsigned m_vpus;			// Number of VPUs
+		unsigned m_threads;			// Number of threads per VPU
+		void *m_handle;				// Shared object handle
+		simple_cpu_entry_t m_entry;		// Application entry
+		int m_exit_code = 0;			// Application exit code
+		// State of current run
+		bool m_parallel = false;
+		std::vector<uint8_t> *m_mem = nullptr;
+		std::vector<func_model::vpu_state> *m_vpu_st = nullptr;
+		func_model::par_stats *m_stats = nullptr;
+		double *m_model_s = nullptr;
+		func_model::result m_res = {};
+		uint64_t m_pgm_addr = 0;		// Program address register
+		uint32_t m_intr = 0;			// Active interrupts register
+	};
+
+} // Private namespace
+
+
+// MAIN
+int main(int argc, char *argv[])
+{
+	unsigned segments = 256;
+	unsigned len = 4096;
+	unsigned vpus = 2;
+	unsigned threads = NT;
+	unsigned seed = 1;
+	bool shared = false;
+	std::string so_file;			// Application (empty for synthetic program)
+	std::vector<std::string> app_args;	// Application arguments
+
+	// Parse command-line arguments
+	for(int i=1; i<argc; ++i) {
+		if(!strcmp(argv[i], "-h")) {
+			std::cout << std::endl << "Command line arguments:" << std::endl
+				<< "\t-h                   - this help screen;" << std::endl
+				<< "\t-segments <num>      - number of program segments;" << std::endl
+				<< "\t-len <num>           - vector length;" << std::endl
+				<< "\t-vpus <num>          - number of VPUs (1 to 32);" << std::endl
+				<< "\t-threads <num>       - threads per VPU (1 to 8, application only);" << std::endl
+				<< "\t-shared              - VPU N reads results of VPU N-1 (hazards);" << std::endl
+				<< "\t-seed <num>          - random seed;" << std::endl
+				<< "\t-so <file>           - run application instead of synthetic program;" << std::endl
+				<< "\t-arg <arg>           - application argument (can be repeated)." << std::endl
+				<< std::endl;
+			return 0;
+		} else if(!strcmp(argv[i], "-segments")) {
+			++i;
+			if(i<argc) {
+				try {
+					segments = std::stoul(argv[i]);
+				}
+				catch(const std::exception& e)
+				{
+					std::cerr << e.what() << std::endl;
+				}
+			} else {
+				std::cerr << "-segments: missing number." << std::endl;
+			}
+		} else if(!strcmp(argv[i], "-len")) {
+			++i;
+			if(i<argc) {
+				try {
+					len = std::stoul(argv[i]);
+				}
+				catch(const std::exception& e)
+				{
+					std::cerr << e.what() << std::endl;
+				}
+			} else {
+				std::cerr << "-len: missing number." << std::endl;
+			}
+		} else if(!strcmp(argv[i], "-vpus")) {
+			++i;
+			if(i<argc) {
+				try {
+					vpus = std::stoul(argv[i]);
+				}
+				catch(const std::exception& e)
+				{
+					std::cerr << e.what() << std::endl;
+				}
+			} else {
+				std::cerr << "-vpus: missing number." << std::endl;
+			}
+		} else if(!strcmp(argv[i], "-threads")) {
+			++i;
+			if(i<argc) {
+				try {
+					threads = std::stoul(argv[i]);
+				}
+				catch(const std::exception& e)
+				{
+					std::cerr << e.what() << std::endl;
+				}
+			} else {
+				std::cerr << "-threads: missing number." << std::endl;
+			}
+		} else if(!strcmp(argv[i], "-shared")) {
+			shared = true;
+		} else if(!strcmp(argv[i], "-seed")) {
+			++i;
+			if(i<argc) {
+				try {
+					seed = std::stoul(argv[i]);
+				}
+				catch(const std::exception& e)
+				{
+					std::cerr << e.what() << std::endl;
+				}
+			} else {
+				std::cerr << "-seed: missing number." << std::endl;
+			}
+		} else if(!strcmp(argv[i], "-so")) {
+			++i;
+			if(i<argc) {
+				so_file = argv[i];
+			} else {
+				std::cerr << "-so: missing file name." << std::endl;
+			}
+		} else if(!strcmp(argv[i], "-arg")) {
+			++i;
+			if(i<argc) {
+				app_args.emplace_back(argv[i]);
+			} else {
+				std::cerr << "-arg: missing value." << std::endl;
+			}
+		} else {
+			std::cerr << "Unknown argument: " << argv[i] << std::endl;
+		}
+	}
+
+	len = std::max(1u, std::min(len, (1u << 20) - 1));
+	vpus = std::max(1u, std::min(vpus, vxe::MAX_VPUS));
+	threads = std::max(1u, std::min(threads, NT));
+
+	// Print benchmark parameters
+	std::cout << std::endl;
+	std::cout << std::setfill('=') << std::setw(80) << "=" << std::endl;
+	std::cout << "Functional model parallel mode benchmark parameters:" << std::endl;
+	if(so_file.empty()) {
+		std::cout << "> Segments: " << segments << std::endl;
+		std::cout << "> Vector length: " << len << std::endl;
+		std::cout << "> VPUs: " << vpus << std::endl;
+		std::cout << "> Shared data: " << (shared ? "ON" : "OFF") << std::endl;
+		std::cout << "> Seed: " << seed << std::endl;
+	} else {
+		std::cout << "> Application: " << so_file << std::endl;
+		std::cout << "> VPUs: " << vpus << std::endl;
+		std::cout << "> Threads per VPU: " << threads << std::endl;
+	}
+	std::cout << std::setfill('=') << std::setw(80) << "=" << std::endl;
+
+	// Sequential and parallel runs (on copies of the same memory image)
+	std::vector<uint8_t> mem[2];
+	std::vector<func_model::vpu_state> st[2];
+	func_model::par_stats stats[2];
+	func_model::result res[2];
+	double elapsed[2];
+	unsigned long errors = 0;
+
+	if(so_file.empty()) {
+		workload wl(segments, len, vpus, shared, seed);
+		mem[0] = mem[1] = wl.mem();
+
+		for(unsigned m = 0; m < 2; ++m) {
+			auto start = std::chrono::steady_clock::now();
+			res[m] = wl.run(m != 0, mem[m], st[m], stats[m]);
+			std::chrono::duration<double> d = std::chrono::steady_clock::now() - start;
+			elapsed[m] = d.count();
+		}
+	} else {
+		// Only time spent in functional model is measured
+		app_workload app(so_file, app_args, vpus, threads);
+		if(!app.valid())
+			return 1;
+
+		for(unsigned m = 0; m < 2; ++m) {
+			res[m] = app.run(m != 0, mem[m], st[m], stats[m], elapsed[m]);
+			if(app.exit_code() != 0) {
+				std::cerr << (m ? "Parallel" : "Sequential") << " run: application exit code "
+					<< app.exit_code() << std::endl;
+				++errors;
+			}
+		}
+	}
+
+	// Compare results
+	if(mem[0] != mem[1])
+		++errors;
+	if(memcmp(st[0].data(), st[1].data(), vpus * sizeof(func_model::vpu_state)) != 0)
+		++errors;
+	if(res[0].intr != res[1].intr || res[0].pgm_counter != res[1].pgm_counter ||
+			res[0].instrs != res[1].instrs || res[0].data_errors != res[1].data_errors)
+		++errors;
+
+	// Print results
+	std::cout << "Instructions: " << res[0].instrs << std::endl;
+	std::cout << "Sequential wall time: " << std::fixed << std::setprecision(3)
+		<< elapsed[0] << " s" << std::endl;
+	std::cout << "Parallel wall time: " << elapsed[1] << " s" << std::endl;
+	std::cout << "Speedup: " << std::setprecision(2)
+		<< (elapsed[1] > 0 ? elapsed[0] / elapsed[1] : 0) << std::endl;
+	std::cout << "Segments: " << stats[1].segments << " (" << stats[1].parallel << " parallel, "
+		<< stats[1].hazards << " hazard fallbacks)" << std::endl;
+	std::cout << "Mismatches: " << errors << std::endl;
+	std::cout << (errors == 0 ? "PASSED" : "FAILED") << std::endl;
+
+	return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,367 @@
+/*
+ * Copyright (c) 2022 The VxEngine Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Simulation server client benchmark.
+ *
+ * Runs the same application job repeatedly as cold starts of the system
+ * model and as jobs of a persistent simulation server, and compares job
+ * latencies.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+
+
+namespace {
+
+	// Time to wait for server socket to appear
+	constexpr unsigned CONNECT_TIMEOUT_MS = 30000;
+
+
+	// Latency statistics
+	struct latency_stats {
+		std::vector<double> samples;	// Job latencies in ms
+
+		void add(double ms) { samples.push_back(ms); }
+
+		double mean() const
+		{
+			double sum = 0;
+			for(double s : samples)
+				sum += s;
+			return samples.empty() ? 0 : sum / samples.size();
+		}
+
+		double min() const
+		{
+			return samples.empty() ? 0 : *std::min_element(samples.begin(), samples.end());
+		}
+
+		double max() const
+		{
+			return samples.empty() ? 0 : *std::max_element(samples.begin(), samples.end());
+		}
+
+		void print(const char *title) const
+		{
+			std::cout << "> " << title << ": mean " << std::fixed << std::setprecision(3)
+				<< mean() << " ms, min " << min() << " ms, max " << max() << " ms"
+				<< std::endl;
+		}
+	};
+
+
+	// Start model process with output redirected to /dev/null
+	pid_t spawn_model(const std::vector<std::string>& args)
+	{
+		std::vector<char*> argv;
+		for(const auto& a : args)
+			argv.push_back(const_cast<char*>(a.c_str()));
+		argv.push_back(nullptr);
+
+		posix_spawn_file_actions_t fa;
+		posix_spawn_file_actions_init(&fa);
+		posix_spawn_file_actions_addopen(&fa, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+		posix_spawn_file_actions_addopen(&fa, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+
+		pid_t pid = -1;
+		int r = posix_spawn(&pid, argv[0], &fa, nullptr, argv.data(), environ);
+		posix_spawn_file_actions_destroy(&fa);
+
+		if(r) {
+			std::cerr << "Failed to start " << args[0] << ": " << strerror(r) << std::endl;
+			return -1;
+		}
+
+		return pid;
+	}
+
+	// Wait for process completion, returns true if it exited normally with zero status
+	bool wait_model(pid_t pid)
+	{
+		int status = 0;
+		while(waitpid(pid, &status, 0) < 0)
+			if(errno != EINTR)
+				return false;
+		return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+	}
+
+	// Connect to server socket (retries until server is up)
+	int connect_server(const std::string& path)
+	{
+		struct sockaddr_un addr = {};
+
+		if(path.size() >= sizeof(addr.sun_path))
+			return -1;
+
+		addr.sun_family = AF_UNIX;
+		strcpy(addr.sun_path, path.c_str());
+
+		for(unsigned t = 0; t < CONNECT_TIMEOUT_MS; t += 10) {
+			int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+			if(fd < 0)
+				return -1;
+			if(connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) == 0)
+				return fd;
+			close(fd);
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+
+		return -1;
+	}
+
+	// Send request line and receive reply line
+	bool request(int fd, const std::string& req, std::string& rep)
+	{
+		const std::string out = req + "\n";
+		size_t sent = 0;
+
+		while(sent < out.size()) {
+			ssize_t n = send(fd, out.data() + sent, out.size() - sent, MSG_NOSIGNAL);
+			if(n < 0 && errno == EINTR)
+				continue;
+			if(n <= 0)
+				return false;
+			sent += n;
+		}
+
+		rep.clear();
+		while(true) {
+			char c;
+			ssize_t n = read(fd, &c, 1);
+			if(n < 0 && errno == EINTR)
+				continue;
+			if(n <= 0)
+				return false;
+			if(c == '\n')
+				return true;
+			rep += c;
+		}
+	}
+
+	// Milliseconds since time point
+	double elapsed_ms(const std::chrono::steady_clock::time_point& start)
+	{
+		std::chrono::duration<double, std::milli> d = std::chrono::steady_clock::now() - start;
+		return d.count();
+	}
+
+} // Private namespace
+
+
+// MAIN
+int main(int argc, char *argv[])
+{
+	std::string model = "./vxmodel.elf";
+	std::string so_file;
+	std::string socket_path = "/tmp/vxmodel_bench." + std::to_string(getpid()) + ".sock";
+	unsigned jobs = 10;
+	std::vector<std::string> model_opts;	// Extra model options
+	std::vector<std::string> app_args;	// Application arguments
+
+	// Parse command-line arguments
+	for(int i=1; i<argc; ++i) {
+		if(!strcmp(argv[i], "-h")) {
+			std::cout << std::endl << "Command line arguments:" << std::endl
+				<< "\t-h                   - this help screen;" << std::endl
+				<< "\t-model <file>        - system model executable;" << std::endl
+				<< "\t-socket <path>       - server socket path;" << std::endl
+				<< "\t-jobs <num>          - number of jobs to run in each mode;" << std::endl
+				<< "\t-opt <option>        - model option (can be repeated);" << std::endl
+				<< "\t-arg <value>         - app argument (can be repeated);" << std::endl
+				<< "\t-so <so_file>        - app library to run." << std::endl
+				<< std::endl;
+			return 0;
+		} else if(!strcmp(argv[i], "-model")) {
+			++i;
+			if(i<argc) {
+				model = argv[i];
+			} else {
+				std::cerr << "-model: missing file name." << std::endl;
+			}
+		} else if(!strcmp(argv[i], "-socket")) {
+			++i;
+			if(i<argc) {
+				socket_path = argv[i];
+			} else {
+				std::cerr << "-socket: missing path." << std::endl;
+			}
+		} else if(!strcmp(argv[i], "-jobs")) {
+			++i;
+			if(i<argc) {
+				try {
+					jobs = std::stoul(argv[i]);
+				}
+				catch(const std::exception& e)
+				{
+					std::cerr << e.what() << std::endl;
+				}
+			} else {
+				std::cerr << "-jobs: missing number." << std::endl;
+			}
+		} else if(!strcmp(argv[i], "-opt")) {
+			++i;
+			if(i<argc) {
+				model_opts.emplace_back(argv[i]);
+			} else {
+				std::cerr << "-opt: missing option." << std::endl;
+			}
+		} else if(!strcmp(argv[i], "-arg")) {
+			++i;
+			if(i<argc) {
+				app_args.emplace_back(argv[i]);
+			} else {
+				std::cerr << "-arg: missing value." << std::endl;
+			}
+		} else if(!strcmp(argv[i], "-so")) {
+			++i;
+			if(i<argc) {
+				so_file = argv[i];
+			} else {
+				std::cerr << "-so: missing file name." << std::endl;
+			}
+		} else {
+			std::cerr << "Unknown argument: " << argv[i] << std::endl;
+		}
+	}
+
+	if(so_file.empty()) {
+		std::cerr << "No shared object provided. Use -h for help." << std::endl;
+		return 1;
+	}
+
+	// Print benchmark parameters
+	std::cout << std::endl;
+	std::cout << std::setfill('=') << std::setw(80) << "=" << std::endl;
+	std::cout << "Simulation server benchmark parameters:" << std::endl;
+	std::cout << "> Model: " << model << std::endl;
+	std::cout << "> Socket: " << socket_path << std::endl;
+	std::cout << "> Shared object: " << so_file << std::endl;
+	std::cout << "> Jobs: " << jobs << std::endl;
+	std::cout << std::setfill('=') << std::setw(80) << "=" << std::endl;
+
+	unsigned errors = 0;
+	latency_stats cold;
+	latency_stats warm;
+
+	// Cold starts: new model process per job
+	std::vector<std::string> cold_cmd = { model };
+	cold_cmd.insert(cold_cmd.end(), model_opts.begin(), model_opts.end());
+	for(const auto& a : app_args) {
+		cold_cmd.push_back("-arg");
+		cold_cmd.push_back(a);
+	}
+	cold_cmd.push_back("-so");
+	cold_cmd.push_back(so_file);
+
+	for(unsigned i = 0; i < jobs; ++i) {
+		auto start = std::chrono::steady_clock::now();
+		pid_t pid = spawn_model(cold_cmd);
+		if(pid < 0 || !wait_model(pid)) {
+			++errors;
+			continue;
+		}
+		cold.add(elapsed_ms(start));
+	}
+
+	// Server jobs: single model process
+	std::vector<std::string> server_cmd = { model };
+	server_cmd.insert(server_cmd.end(), model_opts.begin(), model_opts.end());
+	server_cmd.push_back("-server");
+	server_cmd.push_back(socket_path);
+
+	std::string job_req = "run " + so_file;
+	for(const auto& a : app_args)
+		job_req += " -arg " + a;
+
+	auto server_start = std::chrono::steady_clock::now();
+	double startup_ms = 0;
+	std::string first_rep;
+	pid_t server_pid = spawn_model(server_cmd);
+	int fd = (server_pid < 0 ? -1 : connect_server(socket_path));
+
+	if(fd < 0) {
+		std::cerr << "Failed to connect to server: " << socket_path << std::endl;
+		++errors;
+	} else {
+		startup_ms = elapsed_ms(server_start);
+
+		for(unsigned i = 0; i < jobs; ++i) {
+			std::string rep;
+			auto start = std::chrono::steady_clock::now();
+			if(!request(fd, job_req, rep)) {
+				std::cerr << "Server connection lost." << std::endl;
+				++errors;
+				break;
+			}
+			warm.add(elapsed_ms(start));
+
+			// Each job must succeed with the same result
+			std::string result = rep.substr(0, rep.find(" cycles="));
+			if(rep.compare(0, 3, "ok ") || (i && result != first_rep)) {
+				std::cerr << "Unexpected reply: " << rep << std::endl;
+				++errors;
+			}
+			if(!i)
+				first_rep = result;
+		}
+
+		std::string rep;
+		if(!request(fd, "quit", rep) || rep != "bye")
+			++errors;
+		close(fd);
+	}
+
+	if(server_pid >= 0 && !wait_model(server_pid))
+		++errors;
+
+	// Print results
+	cold.print("Cold start job latency");
+	std::cout << "> Server startup: " << std::fixed << std::setprecision(3)
+		<< startup_ms << " ms" << std::endl;
+	warm.print("Server job latency");
+	std::cout << "> Speedup: " << std::setprecision(1)
+		<< (warm.mean() > 0 ? cold.mean() / warm.mean() : 0) << "x" << std::endl;
+	std::cout << "Errors: " << errors << std::endl;
+	std::cout << (errors == 0 ? "PASSED" : "FAILED") << std::endl;
+
+	return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,452 @@
+/*
+ * Copyright (c) 2022 The VxEngine Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * System model throughput benchmark.
+ *
+ * Runs a fixed set of applications on the system model, measures simulated
+ * cycles, host wall time, simulation speed and peak memory usage, writes
+ * results to a CSV file and compares them against a stored baseline.
+ * Optionally each workload is also run in a compared mode (extra model
+ * options, e.g. -lt or -dmi) and speedup against the base mode is reported.
+ * Workloads with a VPU topology config check results on non-default VPU and
+ * thread counts.
+ */
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+
+
+namespace {
+
+	// Benchmark workload
+	struct workload {
+		const char *name;		// Workload name
+		const char *so_file;		// App. shared object
+		std::vector<std::string> args;	// App. arguments
+		const char *config;		// Model config file (nullptr for defaults)
+	};
+
+	// Benchmark workloads (applications are deterministic, inputs are fixed)
+	const std::vector<workload> workloads = {
+		{ "simple_test", "libsimple_test.so", {}, nullptr },
+		{ "simple_test_long", "libsimple_test.so", { "-len", "8192" }, nullptr },	// Long PROD vectors
+		{ "unicast_test", "libunicast_test.so", {}, nullptr },
+		{ "relu_test", "librelu_test.so", {}, nullptr },
+		{ "mlp_test", "libmlp_test.so", { "-shard", "0/10" }, nullptr },
+		// Non-default VPU topologies
+		{ "unicast_test_4x4", "libunicast_test.so", {}, "vpu_4x4.cfg" },
+		{ "relu_test_4x4", "librelu_test.so", {}, "vpu_4x4.cfg" },
+		{ "mlp_test_4x4", "libmlp_test.so", { "-shard", "0/100" }, "vpu_4x4.cfg" },
+		{ "unicast_test_1x8", "libunicast_test.so", {}, "vpu_1x8.cfg" },
+		{ "relu_test_1x8", "librelu_test.so", {}, "vpu_1x8.cfg" },
+		{ "mlp_test_1x8", "libmlp_test.so", { "-shard", "0/100" }, "vpu_1x8.cfg" }
+	};
+
+
+	// Benchmark result
+	struct result {
+		uint64_t sim_cycles = 0;	// Simulated cycles
+		double wall_s = 0;		// Host wall time
+		double cycles_per_s = 0;	// Simulation speed
+		long peak_rss_kb = 0;		// Peak resident set size
+	};
+
+
+	// Run model with output redirected to log file and collect its resource usage
+	bool run_model(const std::vector<std::string>& args, const std::string& log,
+		double& wall_s, long& peak_rss_kb)
+	{
+		std::vector<char*> argv;
+		for(const auto& a : args)
+			argv.push_back(const_cast<char*>(a.c_str()));
+		argv.push_back(nullptr);
+
+		posix_spawn_file_actions_t fa;
+		posix_spawn_file_actions_init(&fa);
+		posix_spawn_file_actions_addopen(&fa, STDOUT_FILENO, log.c_str(),
+			O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		posix_spawn_file_actions_adddup2(&fa, STDOUT_FILENO, STDERR_FILENO);
+
+		auto start = std::chrono::steady_clock::now();
+
+		pid_t pid = -1;
+		int r = posix_spawn(&pid, argv[0], &fa, nullptr, argv.data(), environ);
+		posix_spawn_file_actions_destroy(&fa);
+
+		if(r) {
+			std::cerr << "Failed to start " << args[0] << ": " << strerror(r) << std::endl;
+			return false;
+		}
+
+		int status = 0;
+		struct rusage ru = {};
+		while(wait4(pid, &status, 0, &ru) < 0)
+			if(errno != EINTR)
+				return false;
+
+		std::chrono::duration<double> d = std::chrono::steady_clock::now() - start;
+		wall_s = d.count();
+		peak_rss_kb = ru.ru_maxrss;
+
+		return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+	}
+
+	// Parse model log, returns true if app completed with zero exit code
+	bool parse_log(const std::string& log, uint64_t& sim_cycles)
+	{
+		std::ifstream is(log);
+		std::string line;
+		bool app_ok = false;
+
+		while(std::getline(is, line)) {
+			size_t p;
+			if(line.compare(0, 20, "> Simulated cycles: ") == 0)
+				sim_cycles = std::stoull(line.substr(20));
+			else if((p = line.find("app terminated, exit code ")) != std::string::npos)
+				app_ok = (std::atoi(line.c_str() + p + 26) == 0);
+		}
+
+		return app_ok;
+	}
+
+	// Load results from CSV file
+	bool load_results(const std::string& file, std::map<std::string, result>& res)
+	{
+		std::ifstream is(file);
+		if(!is)
+			return false;
+
+		std::string line;
+		std::getline(is, line);	// Skip header
+		while(std::getline(is, line)) {
+			std::istringstream ss(line);
+			std::string name, field;
+			result r;
+			if(!std::getline(ss, name, ','))
+				continue;
+			try {
+				std::getline(ss, field, ','); r.sim_cycles = std::stoull(field);
+				std::getline(ss, field, ','); r.wall_s = std::stod(field);
+				std::getline(ss, field, ','); r.cycles_per_s = std::stod(field);
+				std::getline(ss, field, ','); r.peak_rss_kb = std::stol(field);
+			}
+			catch(const std::exception& e)
+			{
+				std::cerr << file << ": malformed line: " << line << std::endl;
+				continue;
+			}
+			res[name] = r;
+		}
+
+		return true;
+	}
+
+	// Save results to CSV file
+	bool save_results(const std::string& file, const std::vector<std::pair<std::string, result>>& res)
+	{
+		std::ofstream os(file);
+		os << "name,sim_cycles,wall_s,cycles_per_s,peak_rss_kb" << std::endl;
+		for(const auto& r : res)
+			os << r.first << "," << r.second.sim_cycles << "," << std::fixed
+				<< std::setprecision(3) << r.second.wall_s << "," << std::setprecision(0)
+				<< r.second.cycles_per_s << "," << r.second.peak_rss_kb << std::endl;
+		return os.good();
+	}
+
+	// Relative difference in percent
+	double diff_pct(double cur, double base)
+	{
+		return base != 0 ? 100.0 * (cur - base) / base : 0;
+	}
+
+	// Run workload several times, returns true on success (best run is taken)
+	bool run_workload(const std::vector<std::string>& cmd, const std::string& log,
+		unsigned runs, result& best)
+	{
+		for(unsigned i = 0; i < runs; ++i) {
+			result r;
+			if(!run_model(cmd, log, r.wall_s, r.peak_rss_kb) || !parse_log(log, r.sim_cycles))
+				return false;
+			r.cycles_per_s = (r.wall_s > 0 ? r.sim_cycles / r.wall_s : 0);
+			if(i == 0 || r.wall_s < best.wall_s)
+				best = r;
+		}
+		return true;
+	}
+
+	// Print workload result
+	void print_result(const std::string& name, const result& r)
+	{
+		std::cout << "> " << name << ": " << r.sim_cycles << " cycles, "
+			<< std::fixed << std::setprecision(3) << r.wall_s << " s, "
+			<< std::setprecision(0) << r.cycles_per_s << " cycles/s, "
+			<< r.peak_rss_kb << " KB peak RSS" << std::endl;
+	}
+
+} // Private namespace
+
+
+// MAIN
+int main(int argc, char *argv[])
+{
+	std::string model = "./vxmodel.elf";
+	std::string lib_dir = ".";
+	std::string cfg_dir = "scripts";
+	std::string out_file = "sim_bench.csv";
+	std::string baseline_file;
+	unsigned runs = 1;
+	double tolerance = 10;
+	std::vector<std::string> model_opts;	// Extra model options
+	std::vector<std::string> compare_opts;	// Model options of compared mode
+
+	// Parse command-line arguments
+	for(int i=1; i<argc; ++i) {
+		if(!strcmp(argv[i], "-h")) {
+			std::cout << std::endl << "Command line arguments:" << std::endl
+				<< "\t-h                   - this help screen;" << std::endl
+				<< "\t-model <file>        - system model executable;" << std::endl
+				<< "\t-libdir <path>       - directory with app libraries;" << std::endl
+				<< "\t-cfgdir <path>       - directory with VPU topology configs;" << std::endl
+				<< "\t-runs <num>          - runs per workload (best is taken);" << std::endl
+				<< "\t-out <file>          - results file (CSV);" << std::endl
+				<< "\t-baseline <file>     - baseline results file (CSV);" << std::endl
+				<< "\t-tol <percent>       - allowed speed and memory regression;" << std::endl
+				<< "\t-opt <option>        - model option (can be repeated);" << std::endl
+				<< "\t-compare <option>    - model option of compared mode (can be repeated)." << std::endl
+				<< std::endl;
+			return 0;
+		} else if(!strcmp(argv[i], "-model")) {
+			++i;
+			if(i<argc) {
+				model = argv[i];
+			} else {
+				std::cerr << "-model: missing file name." << std::endl;
+			}
+		} else if(!strcmp(argv[i], "-libdir")) {
+			++i;
+			if(i<argc) {
+				lib_dir = argv[i];
+			} else {
+				std::cerr << "-libdir: missing path." << std::endl;
+			}
+		} else if(!strcmp(argv[i], "-cfgdir")) {
+			++i;
+			if(i<argc) {
+				cfg_dir = argv[i];
+			} else {
+				std::cerr << "-cfgdir: missing path." << std::endl;
+			}
+		} else if(!strcmp(argv[i], "-runs")) {
+			++i;
+			if(i<argc) {
+				try {
+					runs = std::stoul(argv[i]);
+				}
+				catch(const std::exception& e)
+				{
+					std::cerr << e.what() << std::endl;
+				}
+				runs = runs ? runs : 1;
+			} else {
+				std::cerr << "-runs: missing number." << std::endl;
+			}
+		} else if(!strcmp(argv[i], "-out")) {
+			++i;
+			if(i<argc) {
+				out_file = argv[i];
+			} else {
+				std::cerr << "-out: missing file name." << std::endl;
+			}
+		} else if(!strcmp(argv[i], "-baseline")) {
+			++i;
+			if(i<argc) {
+				baseline_file = argv[i];
+			} else {
+				std::cerr << "-baseline: missing file name." << std::endl;
+			}
+		} else if(!strcmp(argv[i], "-tol")) {
+			++i;
+			if(i<argc) {
+				try {
+					tolerance = std::stod(argv[i]);
+				}
+				catch(const std::exception& e)
+				{
+					std::cerr << e.what() << std::endl;
+				}
+			} else {
+				std::cerr << "-tol: missing value." << std::endl;
+			}
+		} else if(!strcmp(argv[i], "-opt")) {
+			++i;
+			if(i<argc) {
+				model_opts.emplace_back(argv[i]);
+			} else {
+				std::cerr << "-opt: missing option." << std::endl;
+			}
+		} else if(!strcmp(argv[i], "-compare")) {
+			++i;
+			if(i<argc) {
+				compare_opts.emplace_back(argv[i]);
+			} else {
+				std::cerr << "-compare: missing option." << std::endl;
+			}
+		} else {
+			std::cerr << "Unknown argument: " << argv[i] << std::endl;
+		}
+	}
+
+	// Print benchmark parameters
+	std::cout << std::endl;
+	std::cout << std::setfill('=') << std::setw(80) << "=" << std::endl;
+	std::cout << "System model benchmark parameters:" << std::endl;
+	std::cout << "> Model: " << model << std::endl;
+	std::cout << "> Libraries: " << lib_dir << std::endl;
+	std::cout << "> Configs: " << cfg_dir << std::endl;
+	std::cout << "> Runs per workload: " << runs << std::endl;
+	std::cout << "> Results: " << out_file << std::endl;
+	std::cout << "> Baseline: " << (baseline_file.empty() ? "N/A" : baseline_file) << std::endl;
+	std::cout << "> Tolerance: " << tolerance << "%" << std::endl;
+	std::string cmp_mode;	// Compared mode name (joined options)
+	for(const auto& o : compare_opts)
+		cmp_mode += (cmp_mode.empty() ? "" : " ") + o;
+	std::cout << "> Compared mode: " << (cmp_mode.empty() ? "N/A" : cmp_mode) << std::endl;
+	std::cout << std::setfill('=') << std::setw(80) << "=" << std::endl;
+
+	unsigned errors = 0;
+	std::vector<std::pair<std::string, result>> results;
+
+	// Run workloads
+	for(const auto& w : workloads) {
+		std::vector<std::string> cmd = { model };
+		cmd.insert(cmd.end(), model_opts.begin(), model_opts.end());
+		if(w.config) {
+			cmd.push_back("-config");
+			cmd.push_back(cfg_dir + "/" + w.config);
+		}
+		for(const auto& a : w.args) {
+			cmd.push_back("-arg");
+			cmd.push_back(a);
+		}
+		cmd.push_back("-so");
+		cmd.push_back(lib_dir + "/" + w.so_file);
+
+		const std::string log = std::string(w.name) + ".bench.log";
+		result best;
+
+		if(!run_workload(cmd, log, runs, best)) {
+			std::cerr << w.name << ": run failed, see " << log << std::endl;
+			++errors;
+			continue;
+		}
+
+		print_result(w.name, best);
+		results.emplace_back(w.name, best);
+
+		if(compare_opts.empty())
+			continue;
+
+		// Same workload in compared mode (options go before app arguments)
+		const std::string cmp_name = std::string(w.name) + " " + cmp_mode;
+		const std::string cmp_log = std::string(w.name) + ".cmp.bench.log";
+		cmd.insert(cmd.begin() + 1 + model_opts.size(), compare_opts.begin(), compare_opts.end());
+		result cmp;
+
+		if(!run_workload(cmd, cmp_log, runs, cmp)) {
+			std::cerr << cmp_name << ": run failed, see " << cmp_log << std::endl;
+			++errors;
+			continue;
+		}
+
+		print_result(cmp_name, cmp);
+		std::cout << "> " << cmp_name << " speedup: " << std::setprecision(2)
+			<< (cmp.wall_s > 0 ? best.wall_s / cmp.wall_s : 0) << "x wall time, "
+			<< (best.cycles_per_s > 0 ? cmp.cycles_per_s / best.cycles_per_s : 0)
+			<< "x cycles/s" << std::endl;
+		results.emplace_back(cmp_name, cmp);
+	}
+
+	if(!save_results(out_file, results)) {
+		std::cerr << "Failed to write results: " << out_file << std::endl;
+		++errors;
+	}
+
+	// Compare with baseline
+	std::map<std::string, result> baseline;
+	if(!baseline_file.empty() && !load_results(baseline_file, baseline))
+		std::cout << "Baseline not found, comparison skipped." << std::endl;
+
+	for(const auto& r : results) {
+		auto it = baseline.find(r.first);
+		if(it == baseline.end())
+			continue;
+
+		const result& cur = r.second;
+		const result& base = it->second;
+		double speed = diff_pct(cur.cycles_per_s, base.cycles_per_s);
+		double rss = diff_pct(cur.peak_rss_kb, base.peak_rss_kb);
+
+		std::cout << "> " << r.first << " vs baseline: speed " << std::showpos
+			<< std::setprecision(1) << speed << "%, peak RSS " << rss << "%"
+			<< std::noshowpos << std::endl;
+
+		// Model timing changes must come with a baseline update
+		if(cur.sim_cycles != base.sim_cycles) {
+			std::cerr << r.first << ": simulated cycles changed: " << base.sim_cycles
+				<< " -> " << cur.sim_cycles << std::endl;
+			++errors;
+		}
+		if(speed < -tolerance) {
+			std::cerr << r.first << ": simulation speed regression!" << std::endl;
+			++errors;
+		}
+		if(rss > tolerance) {
+			std::cerr << r.first << ": peak memory regression!" << std::endl;
+			++errors;
+		}
+	}
+
+	std::cout << "Errors: " << errors << std::endl;
+	std::cout << (errors == 0 ? "PASSED" : "FAILED") << std::endl;
+
+	return errors == 0 ? 0 : 1;
+}
@@ -27,22 +27,53 @@
  * Main function. Top-level instantiation.
  */
 
+#include <chrono>
+#include <fstream>
 #include <iostream>
 #include <iomanip>
 #include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
 #include <systemc.h>
+#include <tlm.h>
 #include <sys_top.hxx>
-#include <trace.hxx>
+#include <sim_server.hxx>
+#include <sim_config.hxx>
+#include <tlm_payload.hxx>
+#include <vxe_clock_sync.hxx>
+#include <vxe_profiler.hxx>
+#include <vxe_tracer.hxx>
 
 
 // MAIN
 int sc_main(int argc, char *argv[])
 {
 	constexpr unsigned SZ_MB = 1024*1024;
-	sc_trace_file *sys_trace = 0;	// trace file
 	unsigned ram_size = 4*SZ_MB;
 	const char *so_file = nullptr;
 	bool do_trace = false;
+	std::string trace_file = "trace.vcd.gz";
+	uint64_t trace_window[2] = { 0, 0 };	// Trace window start and end, ns (0 end is unbounded)
+	std::string trace_trigger;	// Trace trigger specification
+	unsigned trace_cycles = 1000;	// Cycles to trace after trigger
+	bool lt_mode = false;
+	unsigned quantum_ns = 1000;
+	bool idle_skip = true;
+	bool dmi_mode = false;
+	bool cmd_tlm = false;	// Transaction-level CU to VPU command channel
+	unsigned dmi_latency_ns = 0;
+	const char *profile_file = nullptr;
+	const char *ckpt_load = nullptr;
+	const char *ckpt_save = nullptr;
+	const char *server_socket = nullptr;
+	bool app_thread = false;
+	const char *config_file = nullptr;
+	sim_config cfg;		// Model configuration
+	unsigned sample[3] = { 0, 0, 0 };	// Sampling: functional, warm-up and measured runs
+	bool parallel = false;	// Run VPUs on separate host threads in functional runs
+	std::vector<std::string> app_args;	// Application arguments
+	std::vector<std::pair<std::string, uint64_t>> mem_images;	// Memory images to load
 
 	// Hint for help
 	if(argc < 2)
@@ -54,12 +85,97 @@ int sc_main(int argc, char *argv[])
 			std::cout << std::endl << "Command line arguments:" << std::endl
 				<< "\t-h                   - this help screen;" << std::endl
 				<< "\t-trace               - dump trace;" << std::endl
+				<< "\t-trace-file <file>   - trace file (default trace.vcd.gz);" << std::endl
+				<< "\t-trace-window <s:e>  - trace only from s to e ns (e can be omitted);" << std::endl
+				<< "\t-trace-trigger <t>   - start trace on trigger: mmio:<offset>[=<value>]" << std::endl
+				<< "\t                       register write or prod:<vpu>.<thread> PROD;" << std::endl
+				<< "\t-trace-cycles <N>    - cycles to trace after trigger;" << std::endl
+				<< "\t-config <file>       - load model configuration;" << std::endl
 				<< "\t-ram <size MB>       - RAM size to use;" << std::endl
+				<< "\t-load <file@addr>    - load binary image to RAM (can be repeated);" << std::endl
+				<< "\t-lt                  - loosely-timed mode;" << std::endl
+				<< "\t-quantum <ns>        - global quantum for loosely-timed mode;" << std::endl
+				<< "\t-noidleskip          - poll idle processes on every clock cycle;" << std::endl
+				<< "\t-dmi                 - VxEngine memory accesses through DMI;" << std::endl
+				<< "\t-dmi-latency <ns>    - additional latency of DMI accesses;" << std::endl
+				<< "\t-cmdbus <mode>       - CU to VPU commands: signal (default) or tlm" << std::endl
+				<< "\t                       (batched transaction-level channel);" << std::endl
+				<< "\t-sample <N,W,M>      - sampled simulation: N functional, W warm-up and" << std::endl
+				<< "\t                       M measured VxE program runs per period;" << std::endl
+				<< "\t-parallel            - run VPUs on host threads in functional runs of" << std::endl
+				<< "\t                       -sample (detailed runs stay single-threaded);" << std::endl
+				<< "\t-profile <file>      - dump simulator profile (JSON);" << std::endl
+				<< "\t-ckpt-load <file>    - checkpoint to restore on app request;" << std::endl
+				<< "\t-ckpt-save <file>    - checkpoint to save on app request;" << std::endl
+				<< "\t-server <socket>     - run as simulation server on UNIX socket;" << std::endl
+				<< "\t-arg <value>         - app argument (can be repeated);" << std::endl
+				<< "\t-appthread           - run app on a separate host thread (CPU request" << std::endl
+				<< "\t                       timing depends on host speed, runs are not" << std::endl
+				<< "\t                       deterministic);" << std::endl
 				<< "\t-so <so_file >       - app library to run." << std::endl
 				<< std::endl;
 			return 0;
 		} else if(!strcmp(argv[i], "-trace")) {
 			do_trace = true;
+		} else if(!strcmp(argv[i], "-trace-file")) {
+			++i;
+			if(i<argc) {
+				trace_file = argv[i];
+				do_trace = true;
+			} else {
+				std::cerr << "-trace-file: missing file name." << std::endl;
+			}
+		} else if(!strcmp(argv[i], "-trace-window")) {
+			++i;
+			if(i<argc) {
+				std::string arg(argv[i]);
+				size_t colon = arg.find(':');
+				try {
+					if(colon == std::string::npos)
+						throw std::invalid_argument("expected start:end");
+					trace_window[0] = std::stoull(arg.substr(0, colon));
+					trace_window[1] = (colon + 1 < arg.size() ? std::stoull(arg.substr(colon + 1)) : 0);
+					do_trace = true;
+				}
+				catch(const std::exception& e)
+				{
+					std::cerr << "-trace-window: " << e.what() << std::endl;
+				}
+			} else {
+				std::cerr << "-trace-window: missing start:end." << std::endl;
+			}
+		} else if(!strcmp(argv[i], "-trace-trigger")) {
+			++i;
+			if(i<argc) {
+				trace_trigger = argv[i];
+				do_trace = true;
+			} else {
+				std::cerr << "-trace-trigger: missing trigger." << std::endl;
+			}
+		} else if(!strcmp(argv[i], "-trace-cycles")) {
+			++i;
+			if(i<argc) {
+				unsigned n = 0;
+				try {
+					n = std::stoul(argv[i]);
+				}
+				catch(const std::exception& e)
+				{
+					std::cerr << e.what() << std::endl;
+				}
+				trace_cycles = n ? n : trace_cycles;
+			} else {
+				std::cerr << "-trace-cycles: missing value." << std::endl;
+			}
+		} else if(!strcmp(argv[i], "-config")) {
+			++i;
+			if(i<argc) {
+				config_file = argv[i];
+				if(!cfg.load(config_file))
+					return 1;
+			} else {
+				std::cerr << "-config: missing file." << std::endl;
+			}
 		} else if(!strcmp(argv[i], "-ram")) {
 			++i;
 			if(i<argc) {
@@ -76,6 +192,130 @@ int sc_main(int argc, char *argv[])
 			} else {
 				std::cerr << "-ram: missing size." << std::endl;
 			}
+		} else if(!strcmp(argv[i], "-load")) {
+			++i;
+			if(i<argc) {
+				std::string arg(argv[i]);
+				size_t at = arg.rfind('@');
+				uint64_t addr = 0;
+				try {
+					if(at == std::string::npos)
+						throw std::invalid_argument("missing load address");
+					addr = std::stoull(arg.substr(at + 1), nullptr, 0);
+					mem_images.emplace_back(arg.substr(0, at), addr);
+				}
+				catch(const std::exception& e)
+				{
+					std::cerr << "-load: " << e.what() << std::endl;
+				}
+			} else {
+				std::cerr << "-load: missing file@addr." << std::endl;
+			}
+		} else if(!strcmp(argv[i], "-lt")) {
+			lt_mode = true;
+		} else if(!strcmp(argv[i], "-quantum")) {
+			++i;
+			if(i<argc) {
+				unsigned q = 0;
+				try {
+					q = std::stoi(argv[i]);
+				}
+				catch(const std::exception& e)
+				{
+					std::cerr << e.what() << std::endl;
+				}
+				quantum_ns = q ? q : quantum_ns;
+			} else {
+				std::cerr << "-quantum: missing value." << std::endl;
+			}
+		} else if(!strcmp(argv[i], "-dmi")) {
+			dmi_mode = true;
+		} else if(!strcmp(argv[i], "-dmi-latency")) {
+			++i;
+			if(i<argc) {
+				try {
+					dmi_latency_ns = std::stoi(argv[i]);
+				}
+				catch(const std::exception& e)
+				{
+					std::cerr << e.what() << std::endl;
+				}
+			} else {
+				std::cerr << "-dmi-latency: missing value." << std::endl;
+			}
+		} else if(!strcmp(argv[i], "-cmdbus")) {
+			++i;
+			if(i<argc) {
+				if(!strcmp(argv[i], "tlm"))
+					cmd_tlm = true;
+				else if(!strcmp(argv[i], "signal"))
+					cmd_tlm = false;
+				else
+					std::cerr << "-cmdbus: unknown mode " << argv[i] << "." << std::endl;
+			} else {
+				std::cerr << "-cmdbus: missing mode." << std::endl;
+			}
+		} else if(!strcmp(argv[i], "-noidleskip")) {
+			idle_skip = false;
+		} else if(!strcmp(argv[i], "-sample")) {
+			++i;
+			if(i<argc) {
+				std::string arg(argv[i]);
+				size_t c1 = arg.find(',');
+				size_t c2 = (c1 == std::string::npos ? c1 : arg.find(',', c1 + 1));
+				try {
+					if(c2 == std::string::npos)
+						throw std::invalid_argument("expected N,W,M");
+					sample[0] = std::stoul(arg.substr(0, c1));
+					sample[1] = std::stoul(arg.substr(c1 + 1, c2 - c1 - 1));
+					sample[2] = std::stoul(arg.substr(c2 + 1));
+				}
+				catch(const std::exception& e)
+				{
+					std::cerr << "-sample: " << e.what() << std::endl;
+				}
+			} else {
+				std::cerr << "-sample: missing N,W,M." << std::endl;
+			}
+		} else if(!strcmp(argv[i], "-parallel")) {
+			parallel = true;
+		} else if(!strcmp(argv[i], "-profile")) {
+			++i;
+			if(i<argc) {
+				profile_file = argv[i];
+			} else {
+				std::cerr << "-profile: missing file name." << std::endl;
+			}
+		} else if(!strcmp(argv[i], "-ckpt-load")) {
+			++i;
+			if(i<argc) {
+				ckpt_load = argv[i];
+			} else {
+				std::cerr << "-ckpt-load: missing file name." << std::endl;
+			}
+		} else if(!strcmp(argv[i], "-ckpt-save")) {
+			++i;
+			if(i<argc) {
+				ckpt_save = argv[i];
+			} else {
+				std::cerr << "-ckpt-save: missing file name." << std::endl;
+			}
+		} else if(!strcmp(argv[i], "-appthread")) {
+			app_thread = true;
+		} else if(!strcmp(argv[i], "-server")) {
+			++i;
+			if(i<argc) {
+				server_socket = argv[i];
+			} else {
+				std::cerr << "-server: missing socket path." << std::endl;
+			}
+		} else if(!strcmp(argv[i], "-arg")) {
+			++i;
+			if(i<argc) {
+				app_args.emplace_back(argv[i]);
+			} else {
+				std::cerr << "-arg: missing value." << std::endl;
+			}
 		} else if(!strcmp(argv[i], "-so")) {
 			++i;
 			if(i<argc) {
@@ -88,21 +328,122 @@ int sc_main(int argc, char *argv[])
 		}
 	}
 
+	// Parse trace trigger
+	bool trig_mmio = false, trig_prod = false;
+	bool trig_has_value = false;
+	unsigned trig_addr = 0, trig_vpu = 0, trig_thread = 0;
+	uint32_t trig_value = 0;
+	if(!trace_trigger.empty()) {
+		try {
+			if(!trace_trigger.compare(0, 5, "mmio:")) {
+				size_t eq = trace_trigger.find('=');
+				trig_addr = std::stoul(trace_trigger.substr(5, eq == std::string::npos ? eq : eq - 5), nullptr, 0);
+				if(eq != std::string::npos) {
+					trig_value = std::stoul(trace_trigger.substr(eq + 1), nullptr, 0);
+					trig_has_value = true;
+				}
+				trig_mmio = true;
+			} else if(!trace_trigger.compare(0, 5, "prod:")) {
+				size_t dot = trace_trigger.find('.');
+				if(dot == std::string::npos)
+					throw std::invalid_argument("expected prod:<vpu>.<thread>");
+				trig_vpu = std::stoul(trace_trigger.substr(5, dot - 5));
+				trig_thread = std::stoul(trace_trigger.substr(dot + 1));
+				trig_prod = true;
+			} else
+				throw std::invalid_argument("unknown trigger");
+		}
+		catch(const std::exception& e)
+		{
+			std::cerr << "-trace-trigger: " << e.what() << std::endl;
+			return 1;
+		}
+	}
+
+	// Shared memory interconnect arbitrates transactions only, DMI would bypass it
+	if(dmi_mode && cfg.vxe_count > 1) {
+		std::cerr << "-dmi: not supported with several VxEngine instances, ignored." << std::endl;
+		dmi_mode = false;
+	}
+
+	// Parallel VPUs are used in functional runs of sampled simulation only
+	if(parallel && !(sample[0] && sample[2])) {
+		std::cerr << "-parallel: requires -sample with functional runs, ignored." << std::endl;
+		parallel = false;
+	}
+
 	// Print simulation summary
 	std::cout << std::endl;
 	std::cout << std::setfill('=') << std::setw(80) << "=" << std::endl;
 	std::cout << "Simulation parameters:" << std::endl;
 	std::cout << "> Tracing: " << (do_trace ? "ON" : "OFF") << std::endl;
+	if(do_trace) {
+		std::cout << "> Trace file: " << trace_file << std::endl;
+		std::cout << "> Trace window: " << trace_window[0] << "ns - ";
+		if(trace_window[1])
+			std::cout << trace_window[1] << "ns" << std::endl;
+		else
+			std::cout << "end" << std::endl;
+		if(!trace_trigger.empty())
+			std::cout << "> Trace trigger: " << trace_trigger << ", " << trace_cycles
+				<< " cycles" << std::endl;
+	}
+	std::cout << "> Config file: " << (config_file ? config_file : "N/A") << std::endl;
+	std::cout << "> Clock period: " << cfg.clk_period_ns << "ns" << std::endl;
+	std::cout << "> Memory latency: " << cfg.mem_latency << " cycles" << std::endl;
+	std::cout << "> FIFO depth: " << cfg.fifo_depth << std::endl;
+	std::cout << "> VPU FIFO depth: " << cfg.vpu_fifo_depth << std::endl;
+	std::cout << "> FMAC stages: " << cfg.fmac_stages << std::endl;
+	std::cout << "> FMAC lanes: " << cfg.fmac_lanes << std::endl;
+	std::cout << "> VPUs: " << vxe_top::vpu_count(cfg) << std::endl;
+	std::cout << "> Threads per VPU: " << cfg.vpu_threads << std::endl;
+	std::cout << "> Memory ports: " << vxe_top::mem_ports(cfg) << std::endl;
+	std::cout << "> Memory hub routing: " << cfg.hub_route << std::endl;
+	std::cout << "> Burst length: " << vxe_top::burst_len(cfg) << std::endl;
+	if(vxe_top::burst_len(cfg) > 1)
+		std::cout << "> Burst boundary: " << vxe_top::burst_boundary(cfg) << " bytes" << std::endl;
+	std::cout << "> VxEngine instances: " << cfg.vxe_count << std::endl;
+	std::cout << "> VxEngine MMIO window: 0x" << std::hex << cfg.vxe_mmio_size << std::dec
+		<< std::endl;
+#ifdef VXE_RTL_MEM_HUB
+	std::cout << "> Memory hub: RTL" << std::endl;
+#else
+	std::cout << "> Memory hub: SystemC" << std::endl;
+#endif
 	std::cout << "> RAM size: " << (ram_size/SZ_MB) << "MB" << std::endl;
+	for(const auto& img : mem_images)
+		std::cout << "> RAM image: " << img.first << " @ 0x" << std::hex << img.second
+			<< std::dec << std::endl;
+	std::cout << "> Timing mode: " << (lt_mode ? "LT" : "AT") << std::endl;
+	if(lt_mode)
+		std::cout << "> Global quantum: " << quantum_ns << "ns" << std::endl;
+	std::cout << "> VxEngine DMI: " << (dmi_mode ? "ON" : "OFF") << std::endl;
+	if(dmi_mode)
+		std::cout << "> DMI latency: " << dmi_latency_ns << "ns" << std::endl;
+	std::cout << "> VPU command bus: " << (cmd_tlm ? "TLM" : "signal") << std::endl;
+	std::cout << "> Idle skip: " << (idle_skip ? "ON" : "OFF") << std::endl;
+	if(sample[2])
+		std::cout << "> Sampling: " << sample[0] << " functional, " << sample[1] << " warm-up, "
+			<< sample[2] << " measured runs" << std::endl;
+	else
+		std::cout << "> Sampling: OFF" << std::endl;
+	std::cout << "> Parallel VPU: " << (parallel ? "ON" : "OFF") << std::endl;
+	std::cout << "> Profile: " << (profile_file ? profile_file : "N/A") << std::endl;
+	std::cout << "> Checkpoint load: " << (ckpt_load ? ckpt_load : "N/A") << std::endl;
+	std::cout << "> Checkpoint save: " << (ckpt_save ? ckpt_save : "N/A") << std::endl;
+	std::cout << "> Server socket: " << (server_socket ? server_socket : "N/A") << std::endl;
+	std::cout << "> App thread: " << (app_thread ? "ON" : "OFF") << std::endl;
 	std::cout << "> Shared object: " << (so_file ? so_file : "N/A") << std::endl;
+	for(const auto& arg : app_args)
+		std::cout << "> App argument: " << arg << std::endl;
 	std::cout << std::setfill('=') << std::setw(80) << "=" << std::endl;
 
 	// System clock and reset
-	sc_clock sys_clk("sys_clk", 10, SC_NS);
+	sc_clock sys_clk("sys_clk", cfg.clk_period_ns, SC_NS);
 	sc_signal<bool> nrst;
 
 	// Top-level
-	sys_top top("sys_top");
+	sys_top top("sys_top", cfg);
 
 	// Bind signals
 	top.clk(sys_clk);
@@ -110,18 +451,80 @@ int sc_main(int argc, char *argv[])
 
 	// Set model parameters
 	top.cpu.so_file = so_file ? so_file : "";
+	top.cpu.app_args = app_args;
 	top.ram.mem.resize(ram_size);
+	for(const auto& img : mem_images) {
+		if(!top.ram.load_image(img.first, img.second))
+			return 1;
+	}
+	top.set_lt_mode(lt_mode, sys_clk.period());
+	top.set_app_thread(app_thread);
+	tlm::tlm_global_quantum::instance().set(sc_time(quantum_ns, SC_NS));
+	vxe_clock_sync::set_enabled(idle_skip);
+	vxe_profiler::set_enabled(profile_file != nullptr);
+	top.set_dmi_mode(dmi_mode, sc_time(dmi_latency_ns, SC_NS));
+	top.set_cmd_channel(cmd_tlm);
+	top.set_sampling(sample[0], sample[1], sample[2]);
+	top.set_parallel(parallel);
+	top.set_checkpoint_files(ckpt_load ? ckpt_load : "", ckpt_save ? ckpt_save : "");
+
+	// Simulation server
+	sim_server server(top, sys_clk.period(), mem_images);
+	if(server_socket) {
+		if(!server.open(server_socket))
+			return 1;
+		top.cpu.set_job_source(
+			[&server](simple_cpu::app_job& job) -> bool
+			{
+				return server.next_job(job);
+			},
+			[&server](const simple_cpu::app_job& job, bool started, int exit_code)
+			{
+				server.job_done(job, started, exit_code);
+			}
+		);
+	}
 
 	// Setup tracing
-	sys_trace = (do_trace ? sc_create_vcd_trace_file("trace") : 0);
-	if(sys_trace) {
-		// Clock and reset
-		sc_trace_x(sys_trace, sys_clk);
-		sc_trace_x(sys_trace, nrst);
+	vxe_tracer tracer("tracer");
+	tracer.clk(sys_clk);
+	if(do_trace) {
+		if(!tracer.open(trace_file))
+			return 1;
+		tracer.set_window(sc_time(double(trace_window[0]), SC_NS),
+			trace_window[1] ? sc_time(double(trace_window[1]), SC_NS) : sc_max_time());
+
+		// Reset (clock is the sampling event and is not traced)
+		tracer.add("nrst", 1, [&nrst]() -> uint64_t { return nrst.read(); });
+		for(auto& v : top.vxe)
+			v.trace_probes(tracer);
 
-		//TODO:
+		// Trigger on event of any VxEngine instance
+		if(trig_mmio || trig_prod)
+			tracer.set_trigger(trace_cycles);
+		for(auto& engine : top.vxe) {
+			if(trig_mmio) {
+				engine.set_mmio_write_hook(
+					[&tracer, trig_addr, trig_has_value, trig_value](unsigned addr, uint32_t v)
+					{
+						if(addr == trig_addr && (!trig_has_value || v == trig_value))
+							tracer.trigger();
+					}
+				);
+			} else if(trig_prod) {
+				engine.cu.set_prod_hook(
+					[&tracer, trig_vpu, trig_thread](unsigned vpu, unsigned thread)
+					{
+						if(vpu == trig_vpu && thread == trig_thread)
+							tracer.trigger();
+					}
+				);
+			}
+		}
 	}
 
+	auto wall_start = std::chrono::steady_clock::now();
+
 	// Start simulation
 	sc_start(0, SC_NS);
 	nrst = 0;
@@ -129,9 +532,87 @@ int sc_main(int argc, char *argv[])
 	nrst = 1;
 	sc_start();
 
+	std::chrono::duration<double> wall_time = std::chrono::steady_clock::now() - wall_start;
+
+	// Print simulation statistics
+	double sim_cycles = sc_time_stamp() / sys_clk.period();
+	std::cout << std::setfill('=') << std::setw(80) << "=" << std::endl;
+	std::cout << "Simulation statistics:" << std::endl;
+	std::cout << "> Simulated time: " << sc_time_stamp() << std::endl;
+	std::cout << "> Simulated cycles: " << std::fixed << std::setprecision(0) << sim_cycles << std::endl;
+	std::cout << "> Wall time: " << std::setprecision(3) << wall_time.count() << "s" << std::endl;
+	std::cout << "> Simulation speed: " << std::setprecision(0)
+		<< (wall_time.count() > 0 ? sim_cycles / wall_time.count() : 0) << " cycles/s" << std::endl;
+	double vxe_cycles = 0;	// Busy cycles of all instances
+	for(unsigned i = 0; i < top.vxe.size(); ++i) {
+		double cycles = top.vxe[i].busy_time() / sys_clk.period();
+		vxe_cycles += cycles;
+		if(top.vxe.size() > 1)
+			std::cout << "> VxE" << i << " busy cycles: " << std::setprecision(0) << cycles
+				<< std::endl;
+	}
+	std::cout << "> VxE busy cycles: " << std::setprecision(0) << vxe_cycles << std::endl;
+	std::cout << "> VxE utilization: " << std::setprecision(1)
+		<< (sim_cycles > 0 ? 100.0 * vxe_cycles / (sim_cycles * top.vxe.size()) : 0) << "%"
+		<< std::endl;
+	if(cmd_tlm) {
+		uint64_t batches = 0, cmds = 0;
+		for(const auto& v : top.vxe) {
+			batches += v.cu.cmd_batches();
+			cmds += v.cu.cmd_count();
+		}
+		std::cout << "> VPU command batches: " << batches << " (" << cmds << " commands)"
+			<< std::endl;
+	}
+	for(unsigned p = 0; p < top.mem_ports(); ++p) {
+		const auto *ic = top.interconnect(p);
+		if(!ic)
+			continue;
+		for(unsigned i = 0; i < ic->masters(); ++i)
+			std::cout << "> RAM port" << p << " VxE" << i << ": " << ic->grants(i)
+				<< " requests, " << ic->stalls(i) << " stall cycles" << std::endl;
+	}
+	const tlm_pl::alloc_stats& pl_stats = tlm_pl::get_stats();
+	std::cout << "> TLM payloads: " << pl_stats.gp_allocs << " allocated, "
+		<< pl_stats.gp_reuses << " reused, " << pl_stats.gp_pooled << " pooled" << std::endl;
+	std::cout << "> TLM buffers/extensions allocated: " << pl_stats.buf_allocs << "/"
+		<< pl_stats.ext_allocs << std::endl;
+	if(server_socket)
+		std::cout << "> Server jobs: " << server.jobs() << std::endl;
+	if(do_trace) {
+		if(!trace_trigger.empty())
+			std::cout << "> Trace triggers: " << tracer.triggers() << std::endl;
+		std::cout << "> Traced cycles: " << tracer.cycles() << std::endl;
+	}
+	for(unsigned i = 0; sample[2] && i < top.vxe.size(); ++i) {
+		const vxe_sampler& smp = top.vxe[i].sampler();
+		const std::string vn = (top.vxe.size() > 1 ? "VxE" + std::to_string(i) : "VxE");
+		std::cout << "> " << vn << " program runs: " << smp.runs() << " ("
+			<< smp.functional_runs() << " functional, " << smp.warmup_runs() << " warm-up, "
+			<< smp.measured_runs() << " measured)" << std::endl;
+		std::cout << "> " << vn << " cycles per run: " << std::setprecision(1) << smp.mean()
+			<< " +/- " << smp.ci95() << " (95% CI)" << std::endl;
+		std::cout << "> Estimated " << vn << " cycles: " << std::setprecision(0) << smp.total()
+			<< " +/- " << smp.total_ci95() << " (95% CI)" << std::endl;
+		if(parallel) {
+			const auto& ps = top.vxe[i].parallel_stats();
+			std::cout << "> " << vn << " functional segments: " << ps.segments << " ("
+				<< ps.parallel << " parallel, " << ps.hazards << " hazard fallbacks)" << std::endl;
+		}
+	}
+	std::cout << std::setfill('=') << std::setw(80) << "=" << std::endl;
+
+	// Write profile
+	if(profile_file) {
+		std::ofstream prof(profile_file);
+		if(prof)
+			vxe_profiler::dump(prof, wall_time.count());
+		else
+			std::cerr << "Failed to open profile file: " << profile_file << std::endl;
+	}
+
 	// Close trace file
-	if(sys_trace)
-		sc_close_vcd_trace_file(sys_trace);
+	tracer.close();
 
 	return 0;
 }
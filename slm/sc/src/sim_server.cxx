@@ -0,0 +1,273 @@
+/*
+ * Copyright (c) 2022 The VxEngine Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Simulation server
+ */
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "sim_server.hxx"
+
+
+sim_server::sim_server(sys_top& top, const sc_time& clk_period, const image_list& images)
+	: m_top(top)
+	, m_clk_period(clk_period)
+	, m_images(images)
+	, m_listen_fd(-1)
+	, m_conn_fd(-1)
+	, m_jobs(0)
+{
+}
+
+sim_server::~sim_server()
+{
+	if(m_conn_fd >= 0)
+		close(m_conn_fd);
+	if(m_listen_fd >= 0) {
+		close(m_listen_fd);
+		unlink(m_path.c_str());
+	}
+}
+
+bool sim_server::open(const std::string& path)
+{
+	struct sockaddr_un addr = {};
+
+	if(path.size() >= sizeof(addr.sun_path)) {
+		std::cerr << "sim_server: socket path is too long: " << path << std::endl;
+		return false;
+	}
+
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, path.c_str());
+
+	m_listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if(m_listen_fd < 0) {
+		std::cerr << "sim_server: socket: " << strerror(errno) << std::endl;
+		return false;
+	}
+
+	unlink(path.c_str());	// Remove stale socket
+	if(bind(m_listen_fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0
+			|| listen(m_listen_fd, 1) < 0) {
+		std::cerr << "sim_server: " << path << ": " << strerror(errno) << std::endl;
+		close(m_listen_fd);
+		m_listen_fd = -1;
+		return false;
+	}
+
+	m_path = path;
+
+	return true;
+}
+
+bool sim_server::next_job(simple_cpu::app_job& job)
+{
+	std::string line;
+
+	while(read_line(line)) {
+		std::istringstream is(line);
+		std::string cmd;
+		std::string err;
+		image_list images;
+
+		if(!(is >> cmd))
+			continue;	// Empty line
+
+		if(cmd == "quit") {
+			reply("bye");
+			return false;
+		} else if(cmd != "run") {
+			reply("error unknown command: " + cmd);
+			continue;
+		}
+
+		if(!parse_job(is, job, images, err) || !setup_job(images, err)) {
+			reply("error " + err);
+			continue;
+		}
+
+		m_job_start = sc_time_stamp();
+		m_wall_start = std::chrono::steady_clock::now();
+
+		return true;
+	}
+
+	return false;
+}
+
+void sim_server::job_done(const simple_cpu::app_job& job, bool started, int exit_code)
+{
+	std::chrono::duration<double, std::micro> wall_time =
+		std::chrono::steady_clock::now() - m_wall_start;
+	const sc_time sim_time = sc_time_stamp() - m_job_start;
+
+	++m_jobs;
+
+	if(!started) {
+		reply("error failed to run: " + job.so_file);
+		return;
+	}
+
+	std::ostringstream os;
+	os << "ok exit=" << exit_code
+		<< " cycles=" << uint64_t(sim_time / m_clk_period)
+		<< " sim_ns=" << uint64_t(sim_time.to_seconds() * 1e9 + 0.5)
+		<< " wall_us=" << uint64_t(wall_time.count());
+	reply(os.str());
+}
+
+bool sim_server::read_line(std::string& line)
+{
+	char buf[4096];
+
+	while(true) {
+		size_t eol = m_rx.find('\n');
+		if(eol != std::string::npos) {
+			line = m_rx.substr(0, eol);
+			m_rx.erase(0, eol + 1);
+			return true;
+		}
+
+		// Wait for a client
+		while(m_conn_fd < 0) {
+			m_conn_fd = accept(m_listen_fd, nullptr, nullptr);
+			if(m_conn_fd < 0 && errno != EINTR) {
+				std::cerr << "sim_server: accept: " << strerror(errno) << std::endl;
+				return false;
+			}
+		}
+
+		ssize_t n = read(m_conn_fd, buf, sizeof(buf));
+		if(n < 0 && errno == EINTR)
+			continue;
+		if(n <= 0) {
+			// Client disconnected
+			close(m_conn_fd);
+			m_conn_fd = -1;
+			m_rx.clear();
+			continue;
+		}
+
+		m_rx.append(buf, n);
+	}
+}
+
+void sim_server::reply(const std::string& msg)
+{
+	if(m_conn_fd < 0)
+		return;
+
+	const std::string out = msg + "\n";
+	size_t sent = 0;
+
+	while(sent < out.size()) {
+		ssize_t n = send(m_conn_fd, out.data() + sent, out.size() - sent, MSG_NOSIGNAL);
+		if(n < 0 && errno == EINTR)
+			continue;
+		if(n <= 0) {
+			// Client is gone, drop connection
+			close(m_conn_fd);
+			m_conn_fd = -1;
+			m_rx.clear();
+			return;
+		}
+		sent += n;
+	}
+}
+
+bool sim_server::parse_job(std::istream& is, simple_cpu::app_job& job, image_list& images,
+	std::string& err)
+{
+	std::string tok;
+
+	job.so_file.clear();
+	job.args.clear();
+
+	if(!(is >> job.so_file)) {
+		err = "missing shared object";
+		return false;
+	}
+
+	while(is >> tok) {
+		std::string val;
+		if(!(is >> val)) {
+			err = tok + ": missing value";
+			return false;
+		}
+
+		if(tok == "-arg") {
+			job.args.push_back(val);
+		} else if(tok == "-load") {
+			size_t at = val.rfind('@');
+			try {
+				if(at == std::string::npos)
+					throw std::invalid_argument("missing load address");
+				images.emplace_back(val.substr(0, at), std::stoull(val.substr(at + 1), nullptr, 0));
+			}
+			catch(const std::exception& e)
+			{
+				err = "-load: " + std::string(e.what());
+				return false;
+			}
+		} else {
+			err = "unknown argument: " + tok;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool sim_server::setup_job(const image_list& images, std::string& err)
+{
+	// Let VxEngine finish work left by previous job
+	for(unsigned i = 0; i < DRAIN_CYCLES && !m_top.vxe_idle(); ++i)
+		wait(m_clk_period);
+
+	if(!m_top.reset_state()) {
+		err = "system reset failed";
+		return false;
+	}
+
+	const image_list *lists[] = { &m_images, &images };
+	for(const image_list *list : lists) {
+		for(const auto& img : *list) {
+			if(!m_top.ram.load_image(img.first, img.second)) {
+				err = "failed to load image: " + img.first;
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
@@ -28,24 +28,57 @@
  */
 
 #include <iostream>
+#include <thread>
 #include <dlfcn.h>
 #include "util.hxx"
 #include "tlm_payload.hxx"
+#include "vxe_profiler.hxx"
 #include "simple_cpu.hxx"
 
 
 // Private namespace
 namespace {
 
+	// Advance CPU local time in loosely-timed mode
+	void cpu_lt_inc(simple_cpu *cpu, const sc_time& t)
+	{
+		cpu->m_qk.inc(t);
+		if(cpu->m_qk.need_sync())
+			cpu->m_qk.sync();
+	}
+
+	// Send MMIO request and wait for its completion
+	void cpu_mmio_transport(simple_cpu *cpu, tlm::tlm_generic_payload *pl)
+	{
+		if(cpu->m_lt_mode) {
+			sc_time t = cpu->m_qk.get_local_time();
+			cpu->io_initiator->b_transport(*pl, t);
+			cpu->m_qk.set(t);
+			cpu_lt_inc(cpu, cpu->m_clk_period);	// Same as wait for posedge below
+		} else {
+			sc_time t;
+			cpu->io_initiator->b_transport(*pl, t);
+			wait(t);
+			wait(); // wait for posedge
+		}
+	}
+
 	void cpu_wait(void *cpuid)
 	{
 		simple_cpu *cpu = reinterpret_cast<simple_cpu*>(cpuid);
-		wait(cpu->clk.posedge_event());
+		if(cpu->m_lt_mode)
+			cpu_lt_inc(cpu, cpu->m_clk_period);
+		else
+			wait(cpu->clk.posedge_event());
 	}
 
 	void cpu_wait_cycles(void *cpuid, unsigned cycles)
 	{
 		simple_cpu *cpu = reinterpret_cast<simple_cpu*>(cpuid);
+		if(cpu->m_lt_mode) {
+			cpu_lt_inc(cpu, cpu->m_clk_period * cycles);
+			return;
+		}
 		while(cycles) {
 			wait(cpu->clk.posedge_event());
 			--cycles;
@@ -55,6 +88,13 @@ namespace {
 	void cpu_wait_intr(void *cpuid)
 	{
 		simple_cpu *cpu = reinterpret_cast<simple_cpu*>(cpuid);
+		if(cpu->m_lt_mode) {
+			// Catch up with simulation time and sleep until interrupt
+			cpu->m_qk.sync();
+			while(!cpu->i_intr.read())
+				wait(cpu->i_intr.posedge_event());
+			return;
+		}
 		while(!cpu->i_intr.read())
 			wait(cpu->clk.posedge_event());
 	}
@@ -63,7 +103,6 @@ namespace {
 	{
 		simple_cpu *cpu = reinterpret_cast<simple_cpu*>(cpuid);
 
-		sc_time t;
 		tlm::tlm_generic_payload *pl = tlm_pl::alloc_gp(sizeof(uint32_t));
 
 		// Set payload for read transaction
@@ -76,19 +115,19 @@ namespace {
 		pl->set_response_status(tlm::TLM_INCOMPLETE_RESPONSE);
 
 		// Send request
-		cpu->io_initiator->b_transport(*pl, t);
-		wait(t);
-		wait(); // wait for posedge
+		cpu_mmio_transport(cpu, pl);
 
 		// Check response
 		if(pl->get_response_status() != tlm::TLM_OK_RESPONSE) {
 			std::cerr << cpu->name() << ": error response received for read!" << std::endl;
+			pl->release();
 			return 0;
 		}
 
 		// Check that returned data length is correct
 		if(pl->get_data_length() != sizeof(uint32_t)) {
 			std::cerr << cpu->name() << ": wrong data length returned!" << std::endl;
+			pl->release();
 			return 0;
 		}
 
@@ -103,7 +142,6 @@ namespace {
 	{
 		simple_cpu *cpu = reinterpret_cast<simple_cpu*>(cpuid);
 
-		sc_time t;
 		tlm::tlm_generic_payload *pl = tlm_pl::alloc_gp(sizeof(uint32_t));
 
 		// Set payload for write transaction
@@ -117,13 +155,11 @@ namespace {
 		pl->set_response_status(tlm::TLM_INCOMPLETE_RESPONSE);
 
 		// Send request
-		cpu->io_initiator->b_transport(*pl, t);
-		wait(t);
-		wait(); // wait for posedge
+		cpu_mmio_transport(cpu, pl);
 
 		// Check response
 		if(pl->get_response_status() != tlm::TLM_OK_RESPONSE)
-			std::cerr << cpu->name() << ": error response received for read!" << std::endl;
+			std::cerr << cpu->name() << ": error response received for write!" << std::endl;
 
 		// Release payload
 		pl->release();
@@ -136,6 +172,70 @@ namespace {
 		return cpu->dmi.ptr != nullptr;
 	}
 
+	void cpu_get_vxe_info(void *cpuid, struct simple_cpu_vxe_info *info)
+	{
+		simple_cpu *cpu = reinterpret_cast<simple_cpu*>(cpuid);
+		*info = cpu->vxe_info;
+	}
+
+	int cpu_checkpoint(void *cpuid, int op)
+	{
+		simple_cpu *cpu = reinterpret_cast<simple_cpu*>(cpuid);
+
+		if(!cpu->checkpoint_handler)
+			return SIMPLE_CPU_CKPT_NONE;
+
+		// Catch up with simulation time
+		if(cpu->m_lt_mode)
+			cpu->m_qk.sync();
+
+		return cpu->checkpoint_handler(op);
+	}
+
+	/*
+	 * Application thread interface: calls are executed in simulation context
+	 */
+
+	void app_wait(void *cpuid)
+	{
+		simple_cpu *cpu = reinterpret_cast<simple_cpu*>(cpuid);
+		cpu->m_app_calls.call([cpu]{ cpu_wait(cpu); });
+	}
+
+	void app_wait_cycles(void *cpuid, unsigned cycles)
+	{
+		simple_cpu *cpu = reinterpret_cast<simple_cpu*>(cpuid);
+		cpu->m_app_calls.call([cpu, cycles]{ cpu_wait_cycles(cpu, cycles); });
+	}
+
+	void app_wait_intr(void *cpuid)
+	{
+		simple_cpu *cpu = reinterpret_cast<simple_cpu*>(cpuid);
+		cpu->m_app_calls.call([cpu]{ cpu_wait_intr(cpu); });
+	}
+
+	uint32_t app_mmio_rreg32(void *cpuid, uint64_t addr)
+	{
+		simple_cpu *cpu = reinterpret_cast<simple_cpu*>(cpuid);
+		uint32_t v = 0;
+		cpu->m_app_calls.call([cpu, addr, &v]{ v = cpu_mmio_rreg32(cpu, addr); });
+		return v;
+	}
+
+	void app_mmio_wreg32(void *cpuid, uint64_t addr, uint32_t value)
+	{
+		simple_cpu *cpu = reinterpret_cast<simple_cpu*>(cpuid);
+		cpu->m_app_calls.call([cpu, addr, value]{ cpu_mmio_wreg32(cpu, addr, value); });
+	}
+
+	int app_checkpoint(void *cpuid, int op)
+	{
+		simple_cpu *cpu = reinterpret_cast<simple_cpu*>(cpuid);
+		int r = SIMPLE_CPU_CKPT_ERROR;
+		cpu->m_app_calls.call([cpu, op, &r]{ r = cpu_checkpoint(cpu, op); });
+		return r;
+	}
+
 } // Private namespace
 
 
@@ -145,6 +245,10 @@ simple_cpu::simple_cpu(::sc_core::sc_module_name name, bool allow_stop)
 	, nrst("nrst")
 	, i_intr("i_intr")
 	, m_allow_stop(allow_stop)
+	, m_lt_mode(false)
+	, vxe_info{1, 0, 0, 2, 8}
+	, m_app_thread(false)
+	, m_app_calls("app_calls")
 {
 	SC_THREAD(cpu_thread);
 		sensitive << clk.pos();
@@ -160,16 +264,27 @@ simple_cpu::simple_cpu(::sc_core::sc_module_name name, bool allow_stop)
 	cpu_if.mmio_rreg32 = cpu_mmio_rreg32;
 	cpu_if.mmio_wreg32 = cpu_mmio_wreg32;
 	cpu_if.get_dmi = cpu_get_dmi;
+	cpu_if.checkpoint = cpu_checkpoint;
+	cpu_if.get_vxe_info = cpu_get_vxe_info;
+	cpu_if.argc = 0;
+	cpu_if.argv = nullptr;
+
+	// Set interface for application thread (DMI and VxEngine info are read directly)
+	app_if = cpu_if;
+	app_if.wait = app_wait;
+	app_if.wait_cycles = app_wait_cycles;
+	app_if.wait_intr = app_wait_intr;
+	app_if.mmio_rreg32 = app_mmio_rreg32;
+	app_if.mmio_wreg32 = app_mmio_wreg32;
+	app_if.checkpoint = app_checkpoint;
 }
 
 void simple_cpu::cpu_thread()
 {
-	void *lh = nullptr;
-	simple_cpu_entry_t entry = nullptr;
-	const ut::scope_guard guard([&lh]{ if(lh) dlclose(lh); });
-
 	wait();
 
+	m_qk.reset();
+
 	// Request DMI
 	tlm::tlm_generic_payload *pl = tlm_pl::alloc_gp();
 	tlm::tlm_dmi dmi_data;
@@ -183,29 +298,104 @@ void simple_cpu::cpu_thread()
 
 	pl->release();	// Free payload object
 
-	// Load application shared object
-	if(!so_file.empty()) {
-		lh = dlopen(so_file.c_str(), RTLD_LAZY);
-		if(lh)
-			entry = reinterpret_cast<simple_cpu_entry_t>(dlsym(lh, SIMPLE_CPU_ENTRY_NAME));
-		else
-			std::cerr << name() << ": failed to load: " << so_file << std::endl;
+	if(job_source) {
+		// Server mode: run jobs until source is drained
+		app_job job;
+		while(job_source(job)) {
+			int r = -1;
+			bool started = run_app(job, r);
+			if(job_done)
+				job_done(job, started, r);
+		}
+	} else if(!so_file.empty()) {
+		app_job job;
+		job.so_file = so_file;
+		job.args = app_args;
+		int r;
+		run_app(job, r);
 	} else {
 		std::cerr << name() << ": no shared object provided!" << std::endl;
 	}
 
-	// Call application
-	if(entry) {
-		int r = entry(&cpu_if);
-		std::cout << name() << ": app terminated, exit code " << r << "." << std::endl;
-	}
-
 	if(m_allow_stop) {
 		// Stop simulation
 		sc_stop();
 	}
 }
 
+bool simple_cpu::run_app(const app_job& job, int& exit_code)
+{
+	void *lh = nullptr;
+	simple_cpu_entry_t entry = nullptr;
+	const ut::scope_guard guard([&lh]{ if(lh) dlclose(lh); });
+
+	// Load application shared object
+	lh = dlopen(job.so_file.c_str(), RTLD_LAZY);
+	if(lh)
+		entry = reinterpret_cast<simple_cpu_entry_t>(dlsym(lh, SIMPLE_CPU_ENTRY_NAME));
+	else
+		std::cerr << name() << ": failed to load: " << job.so_file << std::endl;
+
+	if(!entry)
+		return false;
+
+	// Pass application arguments
+	std::vector<const char*> argv;
+	for(const auto& a : job.args)
+		argv.push_back(a.c_str());
+	argv.push_back(nullptr);
+	cpu_if.argc = static_cast<int>(job.args.size());
+	cpu_if.argv = argv.data();
+
+	// Call application
+	if(m_app_thread) {
+		app_if.argc = cpu_if.argc;
+		app_if.argv = cpu_if.argv;
+		m_app_calls.reopen();
+		std::thread app([this, entry, &exit_code]{
+			vxe_profiler::host_thread prof_guard;	// App thread is not profiled
+			exit_code = entry(&app_if);
+			m_app_calls.close();
+		});
+		serve_app_thread();
+		app.join();
+		app_if.argc = 0;
+		app_if.argv = nullptr;
+	} else {
+		exit_code = entry(&cpu_if);
+	}
+	std::cout << name() << ": app terminated, exit code " << exit_code << "." << std::endl;
+
+	cpu_if.argc = 0;
+	cpu_if.argv = nullptr;
+
+	// Catch up with simulation time
+	if(m_lt_mode)
+		m_qk.sync();
+
+	return true;
+}
+
+void simple_cpu::serve_app_thread()
+{
+	for(;;) {
+		if(m_app_calls.execute())
+			continue;
+		if(m_app_calls.closed())
+			break;
+
+		if(busy_check && busy_check()) {
+			// Keep simulating while application computes
+			if(m_lt_mode)
+				m_qk.sync();
+			wait(m_app_calls.call_event() | clk.posedge_event());
+		} else {
+			// Nothing to simulate, wait for the next call
+			m_app_calls.wait_blocking();
+		}
+	}
+}
+
 tlm::tlm_sync_enum simple_cpu::nb_transport_bw(tlm::tlm_generic_payload& trans, tlm::tlm_phase& phase, sc_time& t)
 {
 	// Non-blocking transfers are not used
@@ -215,3 +405,31 @@ tlm::tlm_sync_enum simple_cpu::nb_transport_bw(tlm::tlm_generic_payload& trans,
 void simple_cpu::invalidate_direct_mem_ptr(sc_dt::uint64 start_range, sc_dt::uint64 end_range)
 {
 }
+
+void simple_cpu::set_lt_mode(bool enable, const sc_time& clk_period)
+{
+	m_lt_mode = enable;
+	m_clk_period = clk_period;
+}
+
+void simple_cpu::set_checkpoint_handler(std::function<int(int)> handler)
+{
+	checkpoint_handler = std::move(handler);
+}
+
+void simple_cpu::set_job_source(std::function<bool(app_job&)> source,
+	std::function<void(const app_job&, bool, int)> done)
+{
+	job_source = std::move(source);
+	job_done = std::move(done);
+}
+
+void simple_cpu::set_app_thread(bool enable)
+{
+	m_app_thread = enable;
+}
+
+void simple_cpu::set_busy_check(std::function<bool()> check)
+{
+	busy_check = std::move(check);
+}
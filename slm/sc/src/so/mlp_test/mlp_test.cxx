@@ -28,6 +28,7 @@
  */
 
 #include <cstdint>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
 #include "vxe_common.hxx"
@@ -43,6 +44,7 @@ typedef sw::simple_allocator::allocation alloc_t;
 
 namespace {
 	simple_cpu_dmi dmi;		// Direct memory interface information
+	simple_cpu_vxe_info vxe_info;	// VxEngine instances information
 	uint8_t *mem;			// Pointer to memory
 	sw::simple_allocator mem_alloc;	// Memory allocator
 }
@@ -107,6 +109,17 @@ void run_inference(const float *input, configuration& cfg);
 bool label_match(const float *res, const float *label);
 
 
+/**
+ * Parse shard argument ("-shard K/N") and compute range of test images
+ * @param argc number of arguments
+ * @param argv arguments
+ * @param first first image index
+ * @param last last image index (not included)
+ * @return false on error
+ */
+bool parse_shard(int argc, const char * const *argv, size_t& first, size_t& last);
+
+
 /**
  * Main entry point
  */
@@ -120,6 +133,11 @@ extern "C" int simple_cpu_entry(struct simple_cpu_if *cpu_if)
 	std::cout << "Output neurons: " << mdl::NO << std::endl;
 	std::cout << "Test set size: " << mdl::NIMG << std::endl;
 
+	size_t img_first, img_last;
+	if(!parse_shard(cpu_if->argc, cpu_if->argv, img_first, img_last))
+		return -1;
+	std::cout << "Test images: " << img_first << " - " << img_last << std::endl;
+
 	std::cout << "Requesting DMI data." << std::endl;
 	cpu_if->get_dmi(cpu_if->cpuid, &dmi);
 	if(dmi.ptr == nullptr) {
@@ -131,6 +149,11 @@ extern "C" int simple_cpu_entry(struct simple_cpu_if *cpu_if)
 	std::cout << "Setting up memory allocator." << std::endl;
 	mem_alloc = sw::simple_allocator(dmi.ptr, dmi.start, dmi.end);
 
+	// Neurons are spread over all threads of all VPUs
+	get_vxe_info(&vxe_info);
+	std::cout << "VPUs: " << vxe_info.vpu_count << " x " << vxe_info.vpu_threads
+		<< " threads" << std::endl;
+
 	constexpr size_t alignment = sizeof(float);
 	constexpr size_t PC_LIMIT = 8192;
 	configuration cfg = {};
@@ -151,7 +174,6 @@ extern "C" int simple_cpu_entry(struct simple_cpu_if *cpu_if)
 		std::cerr << "Error: failed to allocate space for hidden layer weights." << std::endl;
 		return -1;
 	}
-	std::memcpy(cfg.layer_w1.vaddr, mdl::mlp_weights_layer1, sizeof(mdl::mlp_weights_layer1));
 
 	// Allocate intermediate result buffer
 	std::cout << "Allocating intermediate result buffer." << std::endl;
@@ -168,7 +190,6 @@ extern "C" int simple_cpu_entry(struct simple_cpu_if *cpu_if)
 		std::cerr << "Error: failed to allocate space for output layer weights." << std::endl;
 		return -1;
 	}
-	std::memcpy(cfg.layer_w2.vaddr, mdl::mlp_weights_layer2, sizeof(mdl::mlp_weights_layer2));
 
 	// Allocate output buffer
 	std::cout << "Allocating output buffer." << std::endl;
@@ -187,16 +208,36 @@ extern "C" int simple_cpu_entry(struct simple_cpu_if *cpu_if)
 	}
 	instr = reinterpret_cast<uint64_t*>(cfg.program.vaddr);
 
-	std::cout << "Creating VxE program." << std::endl;
-	size_t pc = 0;
-	pc = set_infer_stage(instr, pc, PC_LIMIT, cfg.in_buf, mdl::IMW * mdl::IMH, cfg.layer_w1, mdl::NH, cfg.tmp_buf);
-	pc = set_infer_stage(instr, pc, PC_LIMIT, cfg.tmp_buf, mdl::NH, cfg.layer_w2, mdl::NO, cfg.out_buf);
-	instr[pc++] = vxe::instr::sync(true, true);
-	std::cout << "Program created." << " (" << pc << " instr.)" << std::endl;
+	// Weights and program are restored from checkpoint if the model has one
+	int ckpt = checkpoint(SIMPLE_CPU_CKPT_RESTORE);
+	if(ckpt == SIMPLE_CPU_CKPT_ERROR) {
+		std::cerr << "Error: failed to restore checkpoint." << std::endl;
+		return -1;
+	} else if(ckpt == SIMPLE_CPU_CKPT_DONE) {
+		std::cout << "Weights and program restored from checkpoint." << std::endl;
+	} else {
+		std::cout << "Copying weights." << std::endl;
+		std::memcpy(cfg.layer_w1.vaddr, mdl::mlp_weights_layer1, sizeof(mdl::mlp_weights_layer1));
+		std::memcpy(cfg.layer_w2.vaddr, mdl::mlp_weights_layer2, sizeof(mdl::mlp_weights_layer2));
+
+		std::cout << "Creating VxE program." << std::endl;
+		size_t pc = 0;
+		pc = set_infer_stage(instr, pc, PC_LIMIT, cfg.in_buf, mdl::IMW * mdl::IMH, cfg.layer_w1, mdl::NH, cfg.tmp_buf);
+		instr[pc++] = vxe::instr::sync(false, false);	// Hidden layer results are stored
+		pc = set_infer_stage(instr, pc, PC_LIMIT, cfg.tmp_buf, mdl::NH, cfg.layer_w2, mdl::NO, cfg.out_buf);
+		instr[pc++] = vxe::instr::sync(true, true);
+		std::cout << "Program created." << " (" << pc << " instr.)" << std::endl;
+
+		// Save state for later runs (if requested)
+		if(checkpoint(SIMPLE_CPU_CKPT_SAVE) == SIMPLE_CPU_CKPT_ERROR) {
+			std::cerr << "Error: failed to save checkpoint." << std::endl;
+			return -1;
+		}
+	}
 
 	std::cout << "Executing inference test..." << std::endl;
 	size_t pass_count = 0;
-	for(size_t i = 0; i < mdl::NIMG; ++i) {
+	for(size_t i = img_first; i < img_last; ++i) {
 		float *res = reinterpret_cast<float*>(cfg.out_buf.vaddr);
 		float *label = &mdl::mnist_test_labels[i][0];
 		bool pass;
@@ -207,26 +248,56 @@ extern "C" int simple_cpu_entry(struct simple_cpu_if *cpu_if)
 		std::cout << (pass ? "PASS" : "FAIL") << std::endl;
 		pass_count += (pass ? 1 : 0);
 	}
-	std::cout << "Pass rate: " << pass_count << " / " << mdl::NIMG << std::endl;
+	std::cout << "Pass rate: " << pass_count << " / " << (img_last - img_first) << std::endl;
 
 	wait_cycles(50);
 
 	std::cout << "All done." << std::endl;
 
-	return 0;
+	return pass_count == img_last - img_first ? 0 : -1;
+}
+
+bool parse_shard(int argc, const char * const *argv, size_t& first, size_t& last)
+{
+	unsigned long k = 0, n = 1;
+
+	for(int i = 0; i < argc; ++i) {
+		if(!strcmp(argv[i], "-shard")) {
+			char *end = nullptr;
+			if(++i == argc) {
+				std::cerr << "Error: -shard: missing K/N." << std::endl;
+				return false;
+			}
+			k = strtoul(argv[i], &end, 10);
+			if(*end != '/' || (n = strtoul(end + 1, &end, 10)) == 0 || *end || k >= n) {
+				std::cerr << "Error: -shard: wrong value: " << argv[i] << std::endl;
+				return false;
+			}
+		} else {
+			std::cerr << "Error: unknown argument: " << argv[i] << std::endl;
+			return false;
+		}
+	}
+
+	first = mdl::NIMG * k / n;
+	last = mdl::NIMG * (k + 1) / n;
+
+	return true;
 }
 
 size_t set_infer_stage(uint64_t *prog, size_t pc, size_t pc_lim, alloc_t in, size_t ni, alloc_t w, size_t nn, alloc_t out)
 {
-	constexpr size_t MAX_THREADS = 16;
-	size_t nr, th;
+	const size_t slots = vxe_info.vpu_count * vxe_info.vpu_threads;
+	size_t nr;
 	uint64_t rs, rt, rd;
 
 	rs = in.paddr;
 	rd = out.paddr;
 	nr = 0;
 	while(nr < nn) {
-		for(th = 0; th < MAX_THREADS; ++th) {
+		for(size_t s = 0; s < slots; ++s) {
+			const unsigned th = vxe::instr::make_dst(s / vxe_info.vpu_threads,
+				s % vxe_info.vpu_threads);
 			if(nr < nn) {
 				float bias = reinterpret_cast<float*>(w.vaddr)[nr * (ni + 1)];
 				rt = w.paddr + (nr * (ni + 1)) * sizeof(float) + sizeof(float);
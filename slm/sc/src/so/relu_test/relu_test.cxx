@@ -27,6 +27,7 @@
  * Test of ReLU support
  */
 
+#include <algorithm>
 #include <cstdint>
 #include <iostream>
 #include "vxe_common.hxx"
@@ -46,15 +47,22 @@ static struct simple_cpu_if *g_cpu_if;
 #define PLOT_MAX	(16.0)		// Plot X axis maximum
 #define PLOT_STEP	(0.1)		// Plot step
 #define PLOT_POINTS	((PLOT_MAX - PLOT_MIN) / PLOT_STEP + 1)
-#define MAX_THREADS	(16)		// Max. number of threads supported
+#define MAX_ENGINES	(16)		// Max. number of VxEngine instances used
 
 
 namespace {
 	simple_cpu_dmi dmi;		// Direct memory interface information
+	simple_cpu_vxe_info vxe_info;	// VxEngine instances information
 	uint8_t *mem;			// Pointer to memory
 	sw::simple_allocator mem_alloc;	// Memory allocator
 }
 
+// MMIO address of VxEngine instance register
+uint64_t vxe_reg(unsigned vxe, unsigned reg)
+{
+	return vxe_info.mmio_base + vxe * vxe_info.mmio_size + reg;
+}
+
 // Floating point ReLU reference model
 float relu_ref(float v, bool l, int e)
 {
@@ -88,6 +96,17 @@ extern "C" int simple_cpu_entry(struct simple_cpu_if *cpu_if)
 	std::cout << "Setting up memory allocator." << std::endl;
 	mem_alloc = sw::simple_allocator(dmi.ptr, dmi.start, dmi.end);
 
+	// Points are split between VxEngine instances
+	get_vxe_info(&vxe_info);
+	const unsigned engines = std::min<unsigned>(vxe_info.count, MAX_ENGINES);
+	std::cout << "VxEngine instances: " << vxe_info.count << " (using " << engines << ")"
+		<< std::endl;
+
+	// Points are spread over all threads of all VPUs of an instance
+	const unsigned slots = vxe_info.vpu_count * vxe_info.vpu_threads;
+	std::cout << "VPUs: " << vxe_info.vpu_count << " x " << vxe_info.vpu_threads
+		<< " threads" << std::endl;
+
 	// Check ID register
 	uint32_t vxe_id, vxe_id_tmp;
 	vxe_id = mmio_rreg32(vxe::rego::REG_ID);
@@ -136,99 +155,119 @@ extern "C" int simple_cpu_entry(struct simple_cpu_if *cpu_if)
 		}
 	}
 
-	std::cout << "Setting up VxE program." << std::endl;
-	uint64_t prog_addr;
+	std::cout << "Setting up VxE programs." << std::endl;
+	uint64_t prog_addr[MAX_ENGINES];
 	{
-		constexpr size_t prog_len = PLOT_POINTS * 4;
-		size_t pc, pnt, th;
-		float pv;
-		uint64_t *instr;
-		auto prog = mem_alloc.allocate(prog_len * sizeof(uint64_t), sizeof(uint64_t));
-		if(prog.vaddr == nullptr) {
-			std::cerr << "Error: failed to allocate space for program." << std::endl;
-			return -1;
-		}
-		instr = reinterpret_cast<uint64_t*>(prog.vaddr);
-		prog_addr = prog.paddr;
-
-		pc = pnt = 0;
-		pv = PLOT_MIN;
-		uint64_t rd_addr = vxe_result_base;
-		while(pnt < PLOT_POINTS) {
-			for(th = 0; th < MAX_THREADS; ++th) {
-				if(pnt < PLOT_POINTS) {
-					instr[pc++] = vxe::instr::setacc(th, pv);
-					instr[pc++] = vxe::instr::setrd(th, rd_addr);
-					instr[pc++] = vxe::instr::seten(th, true);
-					rd_addr += sizeof(float);
-				} else {
-					instr[pc++] = vxe::instr::seten(th, false);
+		constexpr size_t points = PLOT_POINTS;
+		const size_t chunk = (points + engines - 1) / engines;
+
+		for(unsigned e = 0; e < engines; ++e) {
+			const size_t first = std::min(points, e * chunk);
+			const size_t last = std::min(points, first + chunk);
+			const size_t rounds = (last - first + slots - 1) / slots;
+			const size_t prog_len = rounds * (slots * 3 + 2) + 1;
+			size_t pc, pnt;
+			float pv;
+			uint64_t *instr;
+			auto prog = mem_alloc.allocate(prog_len * sizeof(uint64_t), sizeof(uint64_t));
+			if(prog.vaddr == nullptr) {
+				std::cerr << "Error: failed to allocate space for program." << std::endl;
+				return -1;
+			}
+			instr = reinterpret_cast<uint64_t*>(prog.vaddr);
+			prog_addr[e] = prog.paddr;
+
+			pc = 0;
+			pnt = first;
+			pv = PLOT_MIN;
+			for(size_t i = 0; i < first; ++i)
+				pv = pv + PLOT_STEP;	// Same steps as for reference values
+			uint64_t rd_addr = vxe_result_base + first * sizeof(float);
+			while(pnt < last) {
+				for(unsigned s = 0; s < slots; ++s) {
+					const unsigned th = vxe::instr::make_dst(s / vxe_info.vpu_threads,
+						s % vxe_info.vpu_threads);
+					if(pnt < last) {
+						instr[pc++] = vxe::instr::setacc(th, pv);
+						instr[pc++] = vxe::instr::setrd(th, rd_addr);
+						instr[pc++] = vxe::instr::seten(th, true);
+						rd_addr += sizeof(float);
+					} else {
+						instr[pc++] = vxe::instr::seten(th, false);
+					}
+					++pnt;
+					pv = pv + PLOT_STEP;
 				}
-				++pnt;
-				pv = pv + PLOT_STEP;
+				instr[pc++] = vxe::instr::lrelu(EXP_REDUCE);
+				instr[pc++] = vxe::instr::store();
 			}
-			instr[pc++] = vxe::instr::lrelu(EXP_REDUCE);
-			instr[pc++] = vxe::instr::store();
-			if(pc >= prog_len)
-				std::cerr << "Warning PC overflow!" << std::endl;
-		}
-		instr[pc++] = vxe::instr::sync(true, true);
+			instr[pc++] = vxe::instr::sync(true, true);
 
-		std::ios state(nullptr);
-		state.copyfmt(std::cout);
-		std::cout << "Program address: 0x" << std::hex << prog_addr
-			<< " (" << std::dec << pc << " instr.)" << std::endl;
-		std::cout.copyfmt(state);
+			std::ios state(nullptr);
+			state.copyfmt(std::cout);
+			std::cout << "VxE" << e << " program address: 0x" << std::hex << prog_addr[e]
+				<< " (" << std::dec << pc << " instr.)" << std::endl;
+			std::cout.copyfmt(state);
+		}
 	}
 
 	// Start processing
 	std::cout << "Preparing VxE for start." << std::endl;
 
-	// Set program address
-	mmio_wreg32(vxe::rego::REG_PGM_ADDR_LO, prog_addr & 0xFFFFFFFF);
-	mmio_wreg32(vxe::rego::REG_PGM_ADDR_HI, prog_addr >> 32u);
+	for(unsigned e = 0; e < engines; ++e) {
+		// Set program address
+		mmio_wreg32(vxe_reg(e, vxe::rego::REG_PGM_ADDR_LO), prog_addr[e] & 0xFFFFFFFF);
+		mmio_wreg32(vxe_reg(e, vxe::rego::REG_PGM_ADDR_HI), prog_addr[e] >> 32u);
+	}
 
 	std::cout << "Start..." << std::endl;
-	mmio_wreg32(vxe::rego::REG_START, 0);
+	for(unsigned e = 0; e < engines; ++e)
+		mmio_wreg32(vxe_reg(e, vxe::rego::REG_START), 0);
 
 	// Status register
-	{
-		uint32_t status_reg = mmio_rreg32(vxe::rego::REG_STATUS);
+	for(unsigned e = 0; e < engines; ++e) {
+		uint32_t status_reg = mmio_rreg32(vxe_reg(e, vxe::rego::REG_STATUS));
 		std::ios state(nullptr);
 		state.copyfmt(std::cout);
-		std::cout << "Status reg = 0x" << std::hex << status_reg << std::endl;
+		std::cout << "VxE" << e << " status reg = 0x" << std::hex << status_reg << std::endl;
 		std::cout.copyfmt(state);
 	}
 
-	// Wait for interrupt
-	wait_intr();
-
-	std::cout << "Interrupt has arrived." << std::endl;
-
-	// Status register and active interrupts register
-	{
-		uint32_t status_reg = mmio_rreg32(vxe::rego::REG_STATUS);
-		uint32_t act_intr = mmio_rreg32(vxe::rego::REG_INTR_ACT);
-		std::ios state(nullptr);
-		state.copyfmt(std::cout);
-		std::cout << "Status reg = 0x" << std::hex << status_reg << std::endl;
-		std::cout << "Active intr. = 0x" << std::hex << act_intr << std::endl;
-		std::cout.copyfmt(state);
-	}
-
-	// Acknowledge interrupt
-	std::cout << "Acknowledging interrupt" << std::endl;
-	mmio_wreg32(vxe::rego::REG_INTR_ACT, mmio_rreg32(vxe::rego::REG_INTR_ACT));
-
-	// Status register and active interrupts register
-	{
-		uint32_t status_reg = mmio_rreg32(vxe::rego::REG_STATUS);
-		uint32_t act_intr = mmio_rreg32(vxe::rego::REG_INTR_ACT);
-		std::ios state(nullptr);
-		state.copyfmt(std::cout);
-		std::cout << "Status reg = 0x" << std::hex << status_reg << std::endl;
-		std::cout << "(ack.) Active intr. = 0x" << std::hex << act_intr << std::endl;
-		std::cout.copyfmt(state);
+	// Wait for interrupts of all instances
+	for(unsigned done = 0, mask = 0; done < engines; ) {
+		wait_intr();
+
+		for(unsigned e = 0; e < engines; ++e) {
+			if(mask & (1u << e))
+				continue;
+
+			// Status register and active interrupts register
+			uint32_t act_intr = mmio_rreg32(vxe_reg(e, vxe::rego::REG_INTR_ACT));
+			if(!act_intr)
+				continue;
+			uint32_t status_reg = mmio_rreg32(vxe_reg(e, vxe::rego::REG_STATUS));
+			std::ios state(nullptr);
+			state.copyfmt(std::cout);
+			std::cout << "VxE" << e << " interrupt has arrived." << std::endl;
+			std::cout << "Status reg = 0x" << std::hex << status_reg << std::endl;
+			std::cout << "Active intr. = 0x" << std::hex << act_intr << std::endl;
+			std::cout.copyfmt(state);
+
+			// Acknowledge interrupt
+			std::cout << "Acknowledging interrupt" << std::endl;
+			mmio_wreg32(vxe_reg(e, vxe::rego::REG_INTR_ACT), act_intr);
+
+			// Status register and active interrupts register
+			status_reg = mmio_rreg32(vxe_reg(e, vxe::rego::REG_STATUS));
+			act_intr = mmio_rreg32(vxe_reg(e, vxe::rego::REG_INTR_ACT));
+			state.copyfmt(std::cout);
+			std::cout << "Status reg = 0x" << std::hex << status_reg << std::endl;
+			std::cout << "(ack.) Active intr. = 0x" << std::hex << act_intr << std::endl;
+			std::cout.copyfmt(state);
+
+			mask |= (1u << e);
+			++done;
+		}
 	}
 
 	// Verify result
@@ -247,5 +286,5 @@ extern "C" int simple_cpu_entry(struct simple_cpu_if *cpu_if)
 
 	std::cout << "All done." << std::endl;
 
-	return 0;
+	return verif_failed ? -1 : 0;
 }
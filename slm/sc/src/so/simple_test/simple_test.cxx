@@ -28,6 +28,8 @@
  */
 
 #include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include "vxe_common.hxx"
 #include "simple_alloc.hxx"
@@ -40,7 +42,8 @@
 static struct simple_cpu_if *g_cpu_if;
 #define SIMPLE_CPU_IF	g_cpu_if
 
-constexpr size_t VEC_LEN	= 129;	// Vectors length to use
+constexpr size_t VEC_LEN	= 129;	// Default vectors length (can be set by -len)
+constexpr size_t MAX_VEC_LEN	= (1u << 20) - 1;	// Maximum vectors length (SETVL)
 constexpr size_t VEC_PAIRS	= 16;	// Number of vector pairs (16 max.)
 
 
@@ -75,6 +78,38 @@ static float vector_prod(float acc, float *rs, float *rt, size_t len)
 	return a.f;
 }
 
+/**
+ * Parse vectors length argument ("-len N")
+ * @param argc number of arguments
+ * @param argv arguments
+ * @param len vectors length
+ * @return false on error
+ */
+static bool parse_len(int argc, const char * const *argv, size_t& len)
+{
+	len = VEC_LEN;
+
+	for(int i = 0; i < argc; ++i) {
+		if(!strcmp(argv[i], "-len")) {
+			char *end = nullptr;
+			if(++i == argc) {
+				std::cerr << "Error: -len: missing value." << std::endl;
+				return false;
+			}
+			len = strtoul(argv[i], &end, 10);
+			if(*end || len == 0 || len > MAX_VEC_LEN) {
+				std::cerr << "Error: -len: wrong value: " << argv[i] << std::endl;
+				return false;
+			}
+		} else {
+			std::cerr << "Error: unknown argument: " << argv[i] << std::endl;
+			return false;
+		}
+	}
+
+	return true;
+}
+
 /**
  * Pair of vector operands
  */
@@ -94,6 +129,11 @@ extern "C" int simple_cpu_entry(struct simple_cpu_if *cpu_if)
 
 	std::cout << "Started on CPU: " << cpu_if->cpuid << std::endl;
 
+	size_t vec_len;
+	if(!parse_len(cpu_if->argc, cpu_if->argv, vec_len))
+		return -1;
+	std::cout << "Vectors length: " << vec_len << std::endl;
+
 	std::cout << "Requesting DMI data." << std::endl;
 	cpu_if->get_dmi(cpu_if->cpuid, &dmi);
 	if(dmi.ptr == nullptr) {
@@ -136,8 +176,8 @@ extern "C" int simple_cpu_entry(struct simple_cpu_if *cpu_if)
 		float vgen_n2 = 1.0;
 		float vgen_n3 = 2.0;
 		for(size_t i = 0; i < VEC_PAIRS; ++i) {
-			auto rs = mem_alloc.allocate(VEC_LEN * sizeof(float), sizeof(float));
-			auto rt = mem_alloc.allocate(VEC_LEN * sizeof(float), sizeof(float));
+			auto rs = mem_alloc.allocate(vec_len * sizeof(float), sizeof(float));
+			auto rt = mem_alloc.allocate(vec_len * sizeof(float), sizeof(float));
 			if (rs.vaddr == nullptr || rt.vaddr == nullptr) {
 				std::cerr << "Error: failed to allocate vector pair: " << i << std::endl;
 				return -1;
@@ -148,10 +188,10 @@ extern "C" int simple_cpu_entry(struct simple_cpu_if *cpu_if)
 			vpairs[i].rt_pa = rt.paddr;
 			// Generate pair
 			std::cout << "Generating pair No." << i << std::endl;
-			sw::gen_vector2(vgen_n0, vgen_n1, vgen_n2, vgen_n3, vpairs[i].rs, VEC_LEN);
+			sw::gen_vector2(vgen_n0, vgen_n1, vgen_n2, vgen_n3, vpairs[i].rs, vec_len);
 			vgen_n2 += 0.2;
 			vgen_n3 += 0.4;
-			sw::gen_vector2(vgen_n0, vgen_n1, vgen_n2, vgen_n3, vpairs[i].rt, VEC_LEN);
+			sw::gen_vector2(vgen_n0, vgen_n1, vgen_n2, vgen_n3, vpairs[i].rt, vec_len);
 		}
 	}
 
@@ -174,7 +214,7 @@ extern "C" int simple_cpu_entry(struct simple_cpu_if *cpu_if)
 
 	std::cout << "Computing reference result." << std::endl;
 	for(size_t i = 0; i < VEC_PAIRS; ++i) {
-		ref_result[i] = vector_prod(0.0, vpairs[i].rs, vpairs[i].rt, VEC_LEN);
+		ref_result[i] = vector_prod(0.0, vpairs[i].rs, vpairs[i].rt, vec_len);
 	}
 
 	std::cout << "Setting up VxE program." << std::endl;
@@ -197,7 +237,7 @@ extern "C" int simple_cpu_entry(struct simple_cpu_if *cpu_if)
 			instr[pc++] = vxe::instr::setrs(i, vpairs[i].rs_pa);
 			instr[pc++] = vxe::instr::setrt(i, vpairs[i].rt_pa);
 			instr[pc++] = vxe::instr::setrd(i, rd_addr);
-			instr[pc++] = vxe::instr::setvl(i, VEC_LEN);
+			instr[pc++] = vxe::instr::setvl(i, vec_len);
 			instr[pc++] = vxe::instr::seten(i, true);
 			rd_addr += sizeof(float);
 		}
@@ -41,13 +41,12 @@ static struct simple_cpu_if *g_cpu_if;
 #define SIMPLE_CPU_IF	g_cpu_if
 
 constexpr size_t VEC_LEN		= 129;	// Vectors length to use
-constexpr size_t VEC_PAIRS		= 16;	// Number of vector pairs (16 max.)
-constexpr size_t THREADS_PER_VPU	= 8;	// Threads per VPU
-constexpr size_t VPUS_NR		= 2;	// Number of VPUs
+constexpr size_t MAX_PAIRS		= vxe::MAX_VPUS * 8;	// Max. number of vector pairs
 
 
 namespace {
 	simple_cpu_dmi dmi;		// Direct memory interface information
+	simple_cpu_vxe_info vxe_info;	// VxEngine instances information
 	uint8_t *mem;			// Pointer to memory
 	sw::simple_allocator mem_alloc;	// Memory allocator
 }
@@ -108,6 +107,17 @@ extern "C" int simple_cpu_entry(struct simple_cpu_if *cpu_if)
 	std::cout << "Setting up memory allocator." << std::endl;
 	mem_alloc = sw::simple_allocator(dmi.ptr, dmi.start, dmi.end);
 
+	// One vector pair per thread of each VPU
+	get_vxe_info(&vxe_info);
+	const size_t vpus = vxe_info.vpu_count;
+	const size_t threads = vxe_info.vpu_threads;
+	const size_t pairs = vpus * threads;
+	std::cout << "VPUs: " << vpus << " x " << threads << " threads" << std::endl;
+	if(pairs == 0 || pairs > MAX_PAIRS) {
+		std::cerr << "Error: unsupported VPUs configuration!" << std::endl;
+		return -1;
+	}
+
 	// Check ID register
 	uint32_t vxe_id, vxe_id_tmp;
 	vxe_id = mmio_rreg32(vxe::rego::REG_ID);
@@ -132,13 +142,13 @@ extern "C" int simple_cpu_entry(struct simple_cpu_if *cpu_if)
 
 	// Allocate vector operands
 	std::cout << "Preparing vector operands." << std::endl;
-	vector_pair vpairs[VEC_PAIRS];
+	vector_pair vpairs[MAX_PAIRS];
 	{
 		float vgen_n0 = 0.0;
 		float vgen_n1 = 0.5;
 		float vgen_n2 = 1.0;
 		float vgen_n3 = 2.0;
-		for(size_t i = 0; i < VEC_PAIRS; ++i) {
+		for(size_t i = 0; i < pairs; ++i) {
 			auto rs = mem_alloc.allocate(VEC_LEN * sizeof(float), sizeof(float));
 			auto rt = mem_alloc.allocate(VEC_LEN * sizeof(float), sizeof(float));
 			if (rs.vaddr == nullptr || rt.vaddr == nullptr) {
@@ -164,8 +174,8 @@ extern "C" int simple_cpu_entry(struct simple_cpu_if *cpu_if)
 	float *vxe_result;
 	uint64_t vxe_result_base;
 	{
-		auto r1 = mem_alloc.allocate(VEC_PAIRS * sizeof(float), sizeof(float));
-		auto r2 = mem_alloc.allocate(VEC_PAIRS * sizeof(float), sizeof(float));
+		auto r1 = mem_alloc.allocate(pairs * sizeof(float), sizeof(float));
+		auto r2 = mem_alloc.allocate(pairs * sizeof(float), sizeof(float));
 		if(r1.vaddr == nullptr || r2.vaddr == nullptr) {
 			std::cerr << "Error: failed to allocate space for results." << std::endl;
 			return -1;
@@ -176,14 +186,14 @@ extern "C" int simple_cpu_entry(struct simple_cpu_if *cpu_if)
 	}
 
 	std::cout << "Computing reference result." << std::endl;
-	for(size_t i = 0; i < VEC_PAIRS; ++i) {
+	for(size_t i = 0; i < pairs; ++i) {
 		ref_result[i] = vector_prod(0.0, vpairs[i].rs, vpairs[i].rt, VEC_LEN);
 	}
 
 	std::cout << "Setting up VxE program." << std::endl;
 	uint64_t prog_addr;
 	{
-		constexpr size_t prog_len = 256;
+		const size_t prog_len = pairs * 6 + vpus * 2 + 1;
 		size_t pc = 0;
 		uint64_t *instr;
 		auto prog = mem_alloc.allocate(prog_len * sizeof(uint64_t), sizeof(uint64_t));
@@ -194,28 +204,23 @@ extern "C" int simple_cpu_entry(struct simple_cpu_if *cpu_if)
 		instr = reinterpret_cast<uint64_t*>(prog.vaddr);
 		prog_addr = prog.paddr;
 
-		uint64_t rd_addr = vxe_result_base;
-		for (size_t i = 0; i < VEC_PAIRS / VPUS_NR; ++i) {
-			// Overlapped VPU0 and VPU1 instructions
-			instr[pc++] = vxe::instr::setacc(i, 0.0f);
-			instr[pc++] = vxe::instr::setacc(i + THREADS_PER_VPU, 0.0f);
-			instr[pc++] = vxe::instr::setrs(i, vpairs[i].rs_pa);
-			instr[pc++] = vxe::instr::setrs(i + THREADS_PER_VPU, vpairs[i + THREADS_PER_VPU].rs_pa);
-			instr[pc++] = vxe::instr::setrt(i, vpairs[i].rt_pa);
-			instr[pc++] = vxe::instr::setrt(i + THREADS_PER_VPU, vpairs[i + THREADS_PER_VPU].rt_pa);
-			instr[pc++] = vxe::instr::setrd(i, rd_addr);
-			instr[pc++] = vxe::instr::setrd(i + THREADS_PER_VPU, rd_addr +
-					THREADS_PER_VPU * sizeof(float));
-			instr[pc++] = vxe::instr::setvl(i, VEC_LEN);
-			instr[pc++] = vxe::instr::setvl(i + THREADS_PER_VPU, VEC_LEN);
-			instr[pc++] = vxe::instr::seten(i, true);
-			instr[pc++] = vxe::instr::seten(i + THREADS_PER_VPU, true);
-			rd_addr += sizeof(float);
+		// Overlapped instructions of all VPUs, pair i = vpu * threads + thread
+		for(size_t th = 0; th < threads; ++th) {
+			for(size_t v = 0; v < vpus; ++v) {
+				const size_t i = v * threads + th;
+				const unsigned dst = vxe::instr::make_dst(v, th);
+				instr[pc++] = vxe::instr::setacc(dst, 0.0f);
+				instr[pc++] = vxe::instr::setrs(dst, vpairs[i].rs_pa);
+				instr[pc++] = vxe::instr::setrt(dst, vpairs[i].rt_pa);
+				instr[pc++] = vxe::instr::setrd(dst, vxe_result_base + i * sizeof(float));
+				instr[pc++] = vxe::instr::setvl(dst, VEC_LEN);
+				instr[pc++] = vxe::instr::seten(dst, true);
+			}
 		}
-		instr[pc++] = vxe::instr::prod(0);	// Start PROD on VPU0
-		instr[pc++] = vxe::instr::prod(1);	// Start PROD on VPU1
-		instr[pc++] = vxe::instr::store(0);	// Store result of VPU0
-		instr[pc++] = vxe::instr::store(1);	// Store result of VPU1
+		for(size_t v = 0; v < vpus; ++v)
+			instr[pc++] = vxe::instr::prod(v);	// Start PROD on each VPU
+		for(size_t v = 0; v < vpus; ++v)
+			instr[pc++] = vxe::instr::store(v);	// Store result of each VPU
 		instr[pc++] = vxe::instr::sync(true, true);
 
 		std::ios state(nullptr);
@@ -278,7 +283,7 @@ extern "C" int simple_cpu_entry(struct simple_cpu_if *cpu_if)
 	// Verify result
 	std::cout << "Verifying result." << std::endl;
 	bool verif_failed = false;
-	for(size_t i = 0; i < VEC_PAIRS; ++i) {
+	for(size_t i = 0; i < pairs; ++i) {
 		if(ref_result[i] != vxe_result[i]) {
 			std::cerr << "Thread" << i << ": " << ref_result[i] << " != "
 				<< vxe_result[i] << " mismatch!" << std::endl;
@@ -291,5 +296,5 @@ extern "C" int simple_cpu_entry(struct simple_cpu_if *cpu_if)
 
 	std::cout << "All done." << std::endl;
 
-	return 0;
+	return verif_failed ? -1 : 0;
 }
@@ -0,0 +1,452 @@
+/*
+ * Copyright (c) 2022 The VxEngine Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Control Unit VPU fault testbench.
+ *
+ * Runs Control Unit with stub VPUs through command bus signals and through
+ * batched transaction-level channel. Programs send an invalid thread id to
+ * VPU0 at different positions of its instruction stream (in batched mode
+ * some of them fall in the middle of a batch). No command after the failed
+ * one may reach VPU0, the fault must be reported in REG_INTR_RAW and
+ * REG_FAULT_VPU_MASK0. A following program without errors must be executed
+ * completely on both VPUs.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <systemc.h>
+#include "register_set.hxx"
+#include "vxe_common.hxx"
+#include "vxe_internal.hxx"
+#include "vxe_ctrl_unit.hxx"
+
+
+namespace {
+
+	// Threads of stub VPUs
+	constexpr unsigned THREADS = 4;
+	// Number of VPUs
+	constexpr unsigned VPUS = 2;
+	// Cycles spent by stub VPU on a batch (instructions queue up meanwhile)
+	constexpr unsigned BATCH_CYCLES = 8;
+	// Instructions to each VPU after the failed one
+	constexpr unsigned TAIL_INSTRS = 32;
+	// Positions of invalid thread id in VPU0 instruction stream
+	constexpr unsigned BAD_FIRST = 1;
+	constexpr unsigned BAD_LAST = 12;
+
+
+	/**
+	 * Stub VPU
+	 * Executes SETACC-like commands by logging them. Command with thread
+	 * id out of range fails and stops the rest of a batch (as in VPU).
+	 * Batches are executed by the command thread (single writer of outputs).
+	 */
+	SC_MODULE(stub_vpu), public vxe::vpu_cmd_if {
+		sc_in<bool> clk;
+		sc_out<bool> o_busy;
+		sc_out<bool> o_err;
+		sc_in<bool> i_cmd_select;
+		sc_out<bool> o_cmd_ack;
+		sc_in<uint8_t> i_cmd_op;
+		sc_in<uint8_t> i_cmd_thread;
+		sc_in<uint64_t> i_cmd_wdata;
+
+		SC_HAS_PROCESS(stub_vpu);
+
+		explicit stub_vpu(::sc_core::sc_module_name name)
+			: ::sc_core::sc_module(name), clk("clk"), o_busy("o_busy"), o_err("o_err")
+			, i_cmd_select("i_cmd_select"), o_cmd_ack("o_cmd_ack"), i_cmd_op("i_cmd_op")
+			, i_cmd_thread("i_cmd_thread"), i_cmd_wdata("i_cmd_wdata")
+			, m_batch(nullptr), m_count(0), m_err(false)
+		{
+			SC_THREAD(cmd_thread);
+				sensitive << clk.pos();
+		}
+
+		bool exec_cmds(const vxe::vpu_cmd *cmds, unsigned count) override
+		{
+			m_batch = cmds;
+			m_count = count;
+			wait(m_done_event);
+			return m_err;
+		}
+
+		// Payloads of executed commands
+		std::vector<uint64_t> log;
+		// Failed command had commands before and after it in the same batch
+		bool mid_batch_fault = false;
+
+	private:
+		// Execute command, returns true on error
+		bool exec_cmd(uint8_t thread, uint64_t wdata)
+		{
+			log.push_back(wdata);
+			return thread >= THREADS;
+		}
+
+		// Command bus handshake and batches execution
+		[[noreturn]] void cmd_thread()
+		{
+			unsigned batch_cycles = 0;
+
+			o_busy.write(false);
+			o_err.write(false);
+			o_cmd_ack.write(false);
+
+			while(true) {
+				wait();
+				o_cmd_ack.write(false);
+				o_err.write(false);
+
+				// Batch takes several cycles (instructions queue up meanwhile)
+				if(m_batch) {
+					if(++batch_cycles < BATCH_CYCLES)
+						continue;
+					batch_cycles = 0;
+
+					bool err = false;
+					unsigned i;
+					for(i = 0; i < m_count && !err; ++i)
+						err = exec_cmd(m_batch[i].thread, m_batch[i].wdata);
+					if(err && i > 1 && i < m_count)
+						mid_batch_fault = true;
+					o_err.write(err);
+					m_err = err;
+					m_batch = nullptr;
+					m_done_event.notify(SC_ZERO_TIME);
+					continue;
+				}
+
+				if(!i_cmd_select.read())
+					continue;
+				if(exec_cmd(i_cmd_thread.read(), i_cmd_wdata.read()))
+					o_err.write(true);
+				o_cmd_ack.write(true);
+			}
+		}
+
+		const vxe::vpu_cmd *m_batch;	// Pending batch
+		unsigned m_count;		// Commands in pending batch
+		bool m_err;			// Batch failed
+		sc_event m_done_event;		// Batch is executed
+	};
+
+
+	/**
+	 * Control Unit test environment
+	 * Control Unit with program memory and stub VPUs
+	 */
+	SC_MODULE(cu_env) {
+		sc_in<bool> clk;
+		sc_in<bool> nrst;
+
+		SC_HAS_PROCESS(cu_env);
+
+		/**
+		 * Constructor
+		 * @param name module name
+		 * @param batched use transaction-level command channels
+		 */
+		cu_env(::sc_core::sc_module_name name, bool batched)
+			: ::sc_core::sc_module(name), clk("clk"), nrst("nrst")
+			, cu("cu", vxe::mhc::CU, m_regs, VPUS)
+			, vpu("vpu", VPUS)
+			, rq_fifo("rq_fifo", 2), rs_fifo("rs_fifo", 2)
+			, s_start("s_start"), s_busy("s_busy"), s_intr("s_intr")
+			, s_vpu_busy("s_vpu_busy", VPUS), s_vpu_err("s_vpu_err", VPUS)
+			, s_cmd_select("s_cmd_select", VPUS), s_cmd_ack("s_cmd_ack", VPUS)
+			, s_cmd_op("s_cmd_op", VPUS), s_cmd_thread("s_cmd_thread", VPUS)
+			, s_cmd_wdata("s_cmd_wdata", VPUS)
+			, m_batched(batched), m_mid_batch_faults(0), m_done(false), m_errors(0)
+		{
+			for(unsigned i = 0; i < m_regs.size(); ++i)
+				m_regs.set_reg(i, 0);
+
+			cu.clk(clk);
+			cu.nrst(nrst);
+			cu.mem_fifo_out(rq_fifo);
+			cu.mem_fifo_in(rs_fifo);
+			cu.i_start(s_start);
+			cu.o_busy(s_busy);
+			cu.o_intr(s_intr);
+
+			for(unsigned v = 0; v < VPUS; ++v) {
+				cu.i_vpu_busy[v](s_vpu_busy[v]);
+				cu.i_vpu_err[v](s_vpu_err[v]);
+				cu.o_cmd_select[v](s_cmd_select[v]);
+				cu.i_cmd_ack[v](s_cmd_ack[v]);
+				cu.o_cmd_op[v](s_cmd_op[v]);
+				cu.o_cmd_thread[v](s_cmd_thread[v]);
+				cu.o_cmd_wdata[v](s_cmd_wdata[v]);
+				vpu[v].clk(clk);
+				vpu[v].o_busy(s_vpu_busy[v]);
+				vpu[v].o_err(s_vpu_err[v]);
+				vpu[v].i_cmd_select(s_cmd_select[v]);
+				vpu[v].o_cmd_ack(s_cmd_ack[v]);
+				vpu[v].i_cmd_op(s_cmd_op[v]);
+				vpu[v].i_cmd_thread(s_cmd_thread[v]);
+				vpu[v].i_cmd_wdata(s_cmd_wdata[v]);
+				if(batched)
+					cu.set_cmd_channel(v, &vpu[v]);
+			}
+
+			SC_THREAD(mem_thread);
+				sensitive << clk.pos();
+			SC_THREAD(test_thread);
+				sensitive << clk.pos();
+		}
+
+		bool done() const { return m_done; }
+		unsigned errors() const { return m_errors; }
+		unsigned mid_batch_faults() const { return m_mid_batch_faults; }
+
+	private:
+		// Make program, bad_at is position of invalid thread id in VPU0 stream
+		// (-1 for no error). Payload is the position in VPU stream.
+		void make_program(int bad_at)
+		{
+			m_pgm.clear();
+			const unsigned n = (bad_at < 0 ? 0 : bad_at + 1) + TAIL_INSTRS;
+			for(unsigned i = 0; i < n; ++i) {
+				for(unsigned v = 0; v < VPUS; ++v) {
+					const unsigned th = (v == 0 && int(i) == bad_at ? THREADS : i % THREADS);
+					m_pgm.push_back(vxe::instr::setacc(vxe::instr::make_dst(v, th), uint32_t(i)));
+				}
+			}
+			m_pgm.push_back(vxe::instr::sync(true, true));
+			m_stream_len = n;
+		}
+
+		// Run program, returns raw interrupts
+		uint32_t run_program()
+		{
+			for(auto& v : vpu) {
+				v.log.clear();
+				v.mid_batch_fault = false;
+			}
+			m_regs.set_reg(vxe::regi::REG_INTR_ACT, 0);
+			m_regs.set_reg(vxe::regi::REG_INTR_RAW, 0);
+			m_regs.set_reg(vxe::regi::REG_PGM_ADDR_LO, 0);
+			m_regs.set_reg(vxe::regi::REG_PGM_ADDR_HI, 0);
+			cu.notify_intr_ack();
+			do {
+				wait();	// Interrupt output is updated on acknowledge
+			} while(s_intr.read());
+
+			s_start.write(true);
+			wait();
+			s_start.write(false);
+			do {
+				wait();
+			} while(!s_intr.read());
+			while(s_busy.read())
+				wait();
+			for(unsigned i = 0; i < 2 * BATCH_CYCLES; ++i)
+				wait();	// Let late commands reach VPUs
+
+			return m_regs.get_reg(vxe::regi::REG_INTR_RAW);
+		}
+
+		// Program memory
+		[[noreturn]] void mem_thread()
+		{
+			while(true) {
+				vxe::vxe_mem_rq rq = rq_fifo.read();
+				const uint64_t idx = rq.addr / sizeof(uint64_t);
+				if(idx < m_pgm.size()) {
+					rq.res = vxe::vxe_mem_rq::rstype::RES_OK;
+					rq.data_u64[0] = m_pgm[idx];
+				} else
+					rq.res = vxe::vxe_mem_rq::rstype::RES_AE;
+				wait();
+				rs_fifo.write(rq);
+			}
+		}
+
+		// Test sequence
+		void test_thread()
+		{
+			// Wait for reset release
+			do {
+				wait();
+			} while(!nrst.read());
+
+			for(unsigned bad_at = BAD_FIRST; bad_at <= BAD_LAST; ++bad_at) {
+				// Invalid thread id in VPU0 stream
+				make_program(bad_at);
+				uint32_t raw = run_program();
+
+				if(!(raw & vxe::bits::REG_INTR_ACT::ERR_INSTR_MASK)) {
+					std::cerr << name() << ": fault at " << bad_at
+						<< ": VPU error is not reported!" << std::endl;
+					++m_errors;
+				}
+				if(m_regs.get_reg(vxe::regi::REG_FAULT_VPU_MASK0) != 0x1) {
+					std::cerr << name() << ": fault at " << bad_at << ": faulted VPUs mask 0x"
+						<< std::hex << m_regs.get_reg(vxe::regi::REG_FAULT_VPU_MASK0)
+						<< std::dec << " (expected 0x1)" << std::endl;
+					++m_errors;
+				}
+				const auto& log0 = vpu[0].log;
+				if(log0.size() != bad_at + 1 || log0.back() != bad_at) {
+					std::cerr << name() << ": fault at " << bad_at << ": VPU0 executed "
+						<< log0.size() << " commands (expected " << bad_at + 1 << ")"
+						<< std::endl;
+					++m_errors;
+				}
+				m_mid_batch_faults += (vpu[0].mid_batch_fault ? 1 : 0);
+
+				// Program without errors runs to completion
+				make_program(-1);
+				raw = run_program();
+
+				if(raw != vxe::bits::REG_INTR_ACT::COMPLETED_MASK) {
+					std::cerr << name() << ": after fault at " << bad_at << ": raw interrupts 0x"
+						<< std::hex << raw << std::dec << " (expected completion only)"
+						<< std::endl;
+					++m_errors;
+				}
+				for(unsigned v = 0; v < VPUS; ++v) {
+					if(vpu[v].log.size() != m_stream_len) {
+						std::cerr << name() << ": after fault at " << bad_at << ": VPU" << v
+							<< " executed " << vpu[v].log.size() << " commands (expected "
+							<< m_stream_len << ")" << std::endl;
+						++m_errors;
+					}
+				}
+			}
+
+			// Batched mode must have exercised a fault inside a batch
+			if(m_batched && m_mid_batch_faults == 0) {
+				std::cerr << name() << ": no fault in the middle of a batch!" << std::endl;
+				++m_errors;
+			}
+
+			m_done = true;
+		}
+
+		register_set<uint32_t, vxe::regi::REGS_NUMBER> m_regs;
+	public:
+		vxe_ctrl_unit cu;
+		sc_vector<stub_vpu> vpu;
+	private:
+		sc_fifo<vxe::vxe_mem_rq> rq_fifo;
+		sc_fifo<vxe::vxe_mem_rq> rs_fifo;
+		sc_signal<bool> s_start;
+		sc_signal<bool> s_busy;
+		sc_signal<bool> s_intr;
+		sc_vector<sc_signal<bool>> s_vpu_busy;
+		sc_vector<sc_signal<bool>> s_vpu_err;
+		sc_vector<sc_signal<bool>> s_cmd_select;
+		sc_vector<sc_signal<bool>> s_cmd_ack;
+		sc_vector<sc_signal<uint8_t>> s_cmd_op;
+		sc_vector<sc_signal<uint8_t>> s_cmd_thread;
+		sc_vector<sc_signal<uint64_t>> s_cmd_wdata;
+		std::vector<uint64_t> m_pgm;	// Program
+		unsigned m_stream_len;		// Instructions to each VPU
+		bool m_batched;			// Transaction-level command channels are used
+		unsigned m_mid_batch_faults;	// Faults in the middle of a batch
+		bool m_done;
+		unsigned m_errors;
+	};
+
+} // Private namespace
+
+
+// MAIN
+int sc_main(int argc, char *argv[])
+{
+	// Parse command-line arguments
+	for(int i=1; i<argc; ++i) {
+		if(!strcmp(argv[i], "-h")) {
+			std::cout << std::endl << "Command line arguments:" << std::endl
+				<< "\t-h                   - this help screen." << std::endl
+				<< std::endl;
+			return 0;
+		} else {
+			std::cerr << "Unknown argument: " << argv[i] << std::endl;
+		}
+	}
+
+	// Print testbench parameters
+	std::cout << std::endl;
+	std::cout << std::setfill('=') << std::setw(80) << "=" << std::endl;
+	std::cout << "Control Unit VPU fault testbench parameters:" << std::endl;
+	std::cout << "> VPUs: " << VPUS << std::endl;
+	std::cout << "> Threads per VPU: " << THREADS << std::endl;
+	std::cout << "> Batch cycles: " << BATCH_CYCLES << std::endl;
+	std::cout << std::setfill('=') << std::setw(80) << "=" << std::endl;
+
+	// Clock and reset
+	sc_clock clk("clk", 10, SC_NS);
+	sc_signal<bool> nrst;
+
+	// Command bus signals and batched channel
+	cu_env signal("signal", false);
+	signal.clk(clk);
+	signal.nrst(nrst);
+
+	cu_env batched("batched", true);
+	batched.clk(clk);
+	batched.nrst(nrst);
+
+	cu_env *envs[] = { &signal, &batched };
+
+	sc_start(0, SC_NS);
+	nrst = 0;
+	sc_start(100, SC_NS);
+	nrst = 1;
+
+	// Run until all environments are done or time limit is reached
+	const sc_time step(1000, SC_NS);
+	const sc_time limit(1, SC_MS);
+	while(!(signal.done() && batched.done()) && sc_time_stamp() < limit)
+		sc_start(step);
+
+	// Check results
+	unsigned errors = 0;
+	for(const auto *env : envs) {
+		if(!env->done()) {
+			std::cerr << env->name() << ": test is not completed!" << std::endl;
+			++errors;
+		} else if(env->errors()) {
+			++errors;
+		} else {
+			std::cout << env->name() << ": no commands after VPU fault ("
+				<< env->mid_batch_faults() << " faults in the middle of a batch)" << std::endl;
+		}
+	}
+
+	std::cout << "Simulated time: " << sc_time_stamp() << std::endl;
+	std::cout << (errors == 0 ? "PASSED" : "FAILED") << std::endl;
+
+	return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,697 @@
+/*
+ * Copyright (c) 2022 The VxEngine Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Memory Hub ordering testbench.
+ *
+ * Runs clock-polled and event-driven Memory Hub instances side by side on
+ * identical random traffic and checks that every hub port sees the same
+ * sequence of requests on the same clock cycles.
+ *
+ * Also checks routing policies on hubs with more than two master ports:
+ * requests must reach ports selected by address (interleave) or by client
+ * (table), interleaved responses must be delivered in request order and
+ * beats of a read burst must not be interleaved with other responses.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <systemc.h>
+#include "vxe_mem_hub.hxx"
+
+
+namespace {
+
+	// Trace record of a request passed through a hub port
+	struct trace_rec {
+		uint64_t cycle;		// Clock cycle number
+		uint32_t tid;		// Transaction Id
+		uint64_t addr;		// Memory address
+		vxe::vxe_mem_rq::rqtype req;	// Request type
+		vxe::vxe_mem_rq::rstype res;	// Response type
+
+		bool operator==(const trace_rec& r) const
+		{
+			return cycle == r.cycle && tid == r.tid && addr == r.addr
+				&& req == r.req && res == r.res;
+		}
+
+		bool operator!=(const trace_rec& r) const
+		{
+			return !(*this == r);
+		}
+	};
+
+	// Stream insertion operator for trace_rec
+	std::ostream& operator<<(std::ostream& os, const trace_rec& r)
+	{
+		os << "cycle=" << std::dec << r.cycle << std::hex << std::setfill('0')
+			<< " tid=" << std::setw(8) << r.tid
+			<< " addr=" << std::setw(16) << r.addr
+			<< (r.req == vxe::vxe_mem_rq::rqtype::REQ_WR ? " WR" : " RD")
+			<< (r.res == vxe::vxe_mem_rq::rstype::RES_NA ? "" : " RESP")
+			<< std::dec << std::setfill(' ');
+		return os;
+	}
+
+	// Hub ports traced by testbench
+	enum trace_port { TP_M0, TP_M1, TP_CU, TP_VPU0, TP_VPU1, TP_NUM };
+	const char *trace_port_name[TP_NUM] = { "master0", "master1", "cu", "vpu0", "vpu1" };
+
+
+	/**
+	 * Memory Hub test environment
+	 * Memory Hub with traffic generators on client ports and responders
+	 * on master ports. Clients send bursts of requests separated by idle
+	 * periods, masters and clients randomly stall to create backpressure.
+	 */
+	SC_MODULE(hub_env) {
+		sc_in<bool> clk;
+		sc_in<bool> nrst;
+
+		SC_HAS_PROCESS(hub_env);
+
+		/**
+		 * Constructor
+		 * @param name module name
+		 * @param event_driven Memory Hub mode
+		 * @param requests number of requests per client
+		 * @param seed random seed
+		 */
+		hub_env(::sc_core::sc_module_name name, bool event_driven, unsigned requests,
+			unsigned seed)
+			: ::sc_core::sc_module(name), clk("clk"), nrst("nrst")
+			, hub("hub", m_regs, event_driven)
+			, cu_fifo_us("cu_fifo_us", 2), cu_fifo_ds("cu_fifo_ds", 2)
+			, vpu0_fifo_us("vpu0_fifo_us", 2), vpu0_fifo_ds("vpu0_fifo_ds", 2)
+			, vpu1_fifo_us("vpu1_fifo_us", 2), vpu1_fifo_ds("vpu1_fifo_ds", 2)
+			, master0_fifo_us("master0_fifo_us", 2), master0_fifo_ds("master0_fifo_ds", 2)
+			, master1_fifo_us("master1_fifo_us", 2), master1_fifo_ds("master1_fifo_ds", 2)
+			, m_requests(requests), m_seed(seed), m_responses(0)
+		{
+			for(unsigned i = 0; i < m_regs.size(); ++i)
+				m_regs.set_reg(i, 0);
+
+			hub.clk(clk);
+			hub.nrst(nrst);
+			hub.cu_fifo_in(cu_fifo_us);
+			hub.cu_fifo_out(cu_fifo_ds);
+			hub.vpu_fifo_in[0](vpu0_fifo_us);
+			hub.vpu_fifo_out[0](vpu0_fifo_ds);
+			hub.vpu_fifo_in[1](vpu1_fifo_us);
+			hub.vpu_fifo_out[1](vpu1_fifo_ds);
+			hub.master_fifo_in[0](master0_fifo_ds);
+			hub.master_fifo_out[0](master0_fifo_us);
+			hub.master_fifo_in[1](master1_fifo_ds);
+			hub.master_fifo_out[1](master1_fifo_us);
+
+			SC_THREAD(cu_client_thread);
+				sensitive << clk.pos();
+			SC_THREAD(vpu0_client_thread);
+				sensitive << clk.pos();
+			SC_THREAD(vpu1_client_thread);
+				sensitive << clk.pos();
+			SC_THREAD(cu_sink_thread);
+				sensitive << clk.pos();
+			SC_THREAD(vpu0_sink_thread);
+				sensitive << clk.pos();
+			SC_THREAD(vpu1_sink_thread);
+				sensitive << clk.pos();
+			SC_THREAD(master0_thread);
+				sensitive << clk.pos();
+			SC_THREAD(master1_thread);
+				sensitive << clk.pos();
+		}
+
+		/**
+		 * Get port trace
+		 * @param port traced port
+		 * @return trace records
+		 */
+		const std::vector<trace_rec>& trace(trace_port port) const
+		{
+			return m_trace[port];
+		}
+
+		/**
+		 * Check if all responses are received by clients
+		 * @return true if done
+		 */
+		bool done() const
+		{
+			return m_responses == 3 * m_requests;
+		}
+
+	private:
+		// Current clock cycle number
+		static uint64_t cycle()
+		{
+			return sc_time_stamp().value() / sc_time(10, SC_NS).value();
+		}
+
+		// Record request into port trace
+		void record(trace_port port, const vxe::vxe_mem_rq& rq)
+		{
+			m_trace[port].push_back({ cycle(), rq.tid, rq.addr, rq.req, rq.res });
+		}
+
+		/**
+		 * Client traffic generator
+		 * @param cid client id
+		 * @param fifo upstream FIFO
+		 */
+		void client(unsigned cid, sc_fifo<vxe::vxe_mem_rq>& fifo)
+		{
+			std::mt19937 rng(m_seed * 16 + cid);
+
+			// Wait for reset release
+			do {
+				wait();
+			} while(!nrst.read());
+
+			unsigned sent = 0;
+			while(sent < m_requests) {
+				// Idle period
+				wait(1 + rng() % (rng() % 4 ? 4 : 64));
+
+				// Burst of requests
+				unsigned burst = 1 + rng() % 8;
+				while(burst-- && sent < m_requests) {
+					vxe::vxe_mem_rq rq;
+					rq.set_client_id(cid);
+					rq.set_thread_id(sent & 0xFF);
+					rq.set_thread_arg(rng() % 2);
+					rq.addr = (uint64_t(cid) << 32) | (sent << 3);
+					rq.req = rng() % 2 ? vxe::vxe_mem_rq::rqtype::REQ_WR
+						: vxe::vxe_mem_rq::rqtype::REQ_RD;
+					rq.data_u64[0] = rng();
+					rq.set_ben_mask(0xFF);
+
+					// CU switches master port from time to time
+					if(cid == vxe::mhc::CU && rng() % 8 == 0)
+						m_regs.set_reg(vxe::regi::REG_CTRL,
+							m_regs.get_reg(vxe::regi::REG_CTRL)
+							^ vxe::bits::REG_CTRL::CU_MAS_SEL_MASK);
+
+					fifo.write(rq);
+					++sent;
+					if(rng() % 4 == 0)
+						wait();
+				}
+			}
+
+			while(true)
+				wait();
+		}
+
+		/**
+		 * Client responses sink
+		 * @param port traced port
+		 * @param cid client id
+		 * @param fifo downstream FIFO
+		 */
+		void sink(trace_port port, unsigned cid, sc_fifo<vxe::vxe_mem_rq>& fifo)
+		{
+			std::mt19937 rng(m_seed * 16 + 4 + cid);
+
+			while(true) {
+				vxe::vxe_mem_rq rq = fifo.read();
+				record(port, rq);
+				if(rq.get_client_id() != cid)
+					std::cerr << name() << ": " << trace_port_name[port]
+						<< ": response for wrong client!" << std::endl;
+				++m_responses;
+				if(rng() % 8 == 0)
+					wait(1 + rng() % 8);
+			}
+		}
+
+		/**
+		 * Master port responder
+		 * @param port traced port
+		 * @param us upstream FIFO
+		 * @param ds downstream FIFO
+		 */
+		void master(trace_port port, sc_fifo<vxe::vxe_mem_rq>& us,
+			sc_fifo<vxe::vxe_mem_rq>& ds)
+		{
+			std::mt19937 rng(m_seed * 16 + 8 + port);
+
+			while(true) {
+				vxe::vxe_mem_rq rq = us.read();
+				record(port, rq);
+				if(rng() % 4 == 0)
+					wait(1 + rng() % 4);
+				rq.res = vxe::vxe_mem_rq::rstype::RES_OK;
+				ds.write(rq);
+			}
+		}
+
+		[[noreturn]] void cu_client_thread() { client(vxe::mhc::CU, cu_fifo_us); }
+		[[noreturn]] void vpu0_client_thread() { client(vxe::mhc::VPU0, vpu0_fifo_us); }
+		[[noreturn]] void vpu1_client_thread() { client(vxe::mhc::VPU1, vpu1_fifo_us); }
+		[[noreturn]] void cu_sink_thread() { sink(TP_CU, vxe::mhc::CU, cu_fifo_ds); }
+		[[noreturn]] void vpu0_sink_thread() { sink(TP_VPU0, vxe::mhc::VPU0, vpu0_fifo_ds); }
+		[[noreturn]] void vpu1_sink_thread() { sink(TP_VPU1, vxe::mhc::VPU1, vpu1_fifo_ds); }
+		[[noreturn]] void master0_thread() { master(TP_M0, master0_fifo_us, master0_fifo_ds); }
+		[[noreturn]] void master1_thread() { master(TP_M1, master1_fifo_us, master1_fifo_ds); }
+
+	private:
+		register_set<uint32_t, vxe::regi::REGS_NUMBER> m_regs;
+		vxe_mem_hub hub;
+		sc_fifo<vxe::vxe_mem_rq> cu_fifo_us;
+		sc_fifo<vxe::vxe_mem_rq> cu_fifo_ds;
+		sc_fifo<vxe::vxe_mem_rq> vpu0_fifo_us;
+		sc_fifo<vxe::vxe_mem_rq> vpu0_fifo_ds;
+		sc_fifo<vxe::vxe_mem_rq> vpu1_fifo_us;
+		sc_fifo<vxe::vxe_mem_rq> vpu1_fifo_ds;
+		sc_fifo<vxe::vxe_mem_rq> master0_fifo_us;
+		sc_fifo<vxe::vxe_mem_rq> master0_fifo_ds;
+		sc_fifo<vxe::vxe_mem_rq> master1_fifo_us;
+		sc_fifo<vxe::vxe_mem_rq> master1_fifo_ds;
+		const unsigned m_requests;
+		const unsigned m_seed;
+		unsigned m_responses;
+		std::vector<trace_rec> m_trace[TP_NUM];
+	};
+
+
+	/**
+	 * Memory Hub routing test environment
+	 * Memory Hub with given number of VPU clients and master ports. Clients
+	 * number their requests, masters check routing of each request and
+	 * respond with random delays, so responses of different ports overtake
+	 * each other. Sinks check response order in interleaved mode and that
+	 * beats of a burst response arrive back to back.
+	 */
+	SC_MODULE(route_env) {
+		sc_in<bool> clk;
+		sc_in<bool> nrst;
+
+		/**
+		 * Constructor
+		 * @param name module name
+		 * @param route routing policy
+		 * @param vpus number of VPU clients
+		 * @param masters number of master ports
+		 * @param burst maximum length of read bursts (power of two)
+		 * @param requests number of requests per client
+		 * @param seed random seed
+		 */
+		route_env(::sc_core::sc_module_name name, const vxe::hub_route& route, unsigned vpus,
+			unsigned masters, unsigned burst, unsigned requests, unsigned seed)
+			: ::sc_core::sc_module(name), clk("clk"), nrst("nrst")
+			, hub("hub", m_regs, true, 4, vpus, masters, route)
+			, client_us("client_us", vpus + 1), client_ds("client_ds", vpus + 1)
+			, master_us("master_us", masters), master_ds("master_ds", masters)
+			, m_route(route), m_clients(vpus + 1), m_masters(masters), m_burst(burst)
+			, m_requests(requests), m_seed(seed), m_responses(0), m_errors(0)
+		{
+			for(unsigned i = 0; i < m_regs.size(); ++i)
+				m_regs.set_reg(i, 0);
+
+			hub.clk(clk);
+			hub.nrst(nrst);
+			hub.cu_fifo_in(client_us[vxe::mhc::CU]);
+			hub.cu_fifo_out(client_ds[vxe::mhc::CU]);
+			for(unsigned v = 0; v < vpus; ++v) {
+				hub.vpu_fifo_in[v](client_us[vxe::mhc::vpu(v)]);
+				hub.vpu_fifo_out[v](client_ds[vxe::mhc::vpu(v)]);
+			}
+			for(unsigned m = 0; m < masters; ++m) {
+				hub.master_fifo_in[m](master_ds[m]);
+				hub.master_fifo_out[m](master_us[m]);
+			}
+
+			for(unsigned c = 0; c < m_clients; ++c) {
+				sc_spawn_options opts;
+				opts.set_sensitivity(&clk.pos());
+				const std::string cl = "client" + std::to_string(c);
+				sc_spawn(sc_bind(&route_env::client, this, c), (cl + "_thread").c_str(), &opts);
+				sc_spawn(sc_bind(&route_env::sink, this, c), (cl + "_sink_thread").c_str(), &opts);
+			}
+			for(unsigned m = 0; m < masters; ++m) {
+				sc_spawn_options opts;
+				opts.set_sensitivity(&clk.pos());
+				const std::string ms = "master" + std::to_string(m);
+				sc_spawn(sc_bind(&route_env::master, this, m), (ms + "_thread").c_str(), &opts);
+			}
+		}
+
+		/**
+		 * Check if all responses are received by clients
+		 * @return true if done
+		 */
+		bool done() const
+		{
+			return m_responses == m_clients * m_requests;
+		}
+
+		/**
+		 * Number of detected errors
+		 */
+		unsigned errors() const { return m_errors; }
+
+	private:
+		// Sequence number of request (kept in data of request and response)
+		static uint64_t seq(const vxe::vxe_mem_rq& rq) { return rq.data_u64[0]; }
+
+		// Returns expected master port of request or m_masters if not known
+		unsigned expected_port(const vxe::vxe_mem_rq& rq) const
+		{
+			const unsigned c = rq.get_client_id();
+			switch(m_route.pol) {
+				case vxe::hub_route::policy::INTERLEAVE:
+					return (rq.addr / m_route.granule) % m_masters;
+				case vxe::hub_route::policy::TABLE:
+					return c < m_route.table.size() ? m_route.table[c] : m_masters;
+				default:
+					return m_masters;
+			}
+		}
+
+		// Client traffic generator
+		[[noreturn]] void client(unsigned c)
+		{
+			std::mt19937 rng(m_seed * 64 + c);
+
+			// Wait for reset release
+			do {
+				wait();
+			} while(!nrst.read());
+
+			for(unsigned sent = 0; sent < m_requests; ++sent) {
+				vxe::vxe_mem_rq rq;
+				rq.set_client_id(c);
+				rq.set_thread_id(sent & 0xFF);
+				rq.set_thread_arg(rng() % 2);
+				rq.addr = (uint64_t(rng() % 4096)) << 3;
+				rq.req = rng() % 2 ? vxe::vxe_mem_rq::rqtype::REQ_WR
+					: vxe::vxe_mem_rq::rqtype::REQ_RD;
+				// Read bursts are aligned to their size (never cross a granule)
+				if(rq.req == vxe::vxe_mem_rq::rqtype::REQ_RD && m_burst > 1) {
+					rq.len = 1u << (rng() % (ilog2(m_burst) + 1));
+					rq.addr &= ~(uint64_t(rq.len) * sizeof(rq.data_u8) - 1);
+				}
+				rq.data_u64[0] = sent;
+				rq.set_ben_mask(0xFF);
+				client_us[c].write(rq);
+				if(rng() % 4 == 0)
+					wait(1 + rng() % 4);
+			}
+
+			while(true)
+				wait();
+		}
+
+		// Client responses sink
+		[[noreturn]] void sink(unsigned c)
+		{
+			const bool ordered = (m_route.pol == vxe::hub_route::policy::INTERLEAVE);
+			uint64_t next = 0;
+			bool in_burst = false;	// Burst response is being received
+			uint64_t burst_seq = 0;	// Request of burst response
+			unsigned next_beat = 0;	// Next beat of burst response
+
+			while(true) {
+				vxe::vxe_mem_rq rq = client_ds[c].read();
+				if(rq.get_client_id() != c) {
+					std::cerr << name() << ": client" << c << ": response for wrong client!"
+						<< std::endl;
+					++m_errors;
+				}
+				if(in_burst && (seq(rq) != burst_seq || rq.beat != next_beat)) {
+					std::cerr << name() << ": client" << c << ": response " << seq(rq)
+						<< " interleaved with burst response " << burst_seq << std::endl;
+					++m_errors;
+				}
+				if(ordered && rq.beat == 0) {
+					if(seq(rq) != next) {
+						std::cerr << name() << ": client" << c << ": response " << seq(rq)
+							<< " delivered out of order, expected " << next << std::endl;
+						++m_errors;
+					}
+					next = seq(rq) + 1;
+				}
+				in_burst = !rq.last_beat();
+				burst_seq = seq(rq);
+				next_beat = rq.beat + 1;
+				if(rq.last_beat())
+					++m_responses;
+			}
+		}
+
+		// Master port responder
+		[[noreturn]] void master(unsigned m)
+		{
+			std::mt19937 rng(m_seed * 64 + 32 + m);
+
+			while(true) {
+				vxe::vxe_mem_rq rq = master_us[m].read();
+				const unsigned exp = expected_port(rq);
+				if(exp != m_masters && exp != m) {
+					std::cerr << name() << ": master" << m << ": request " << rq
+						<< " expected on master" << exp << std::endl;
+					++m_errors;
+				}
+				if(rng() % 2 == 0)
+					wait(1 + rng() % 16);
+				// Burst response beats with random gaps
+				for(unsigned b = 0; b < rq.len; ++b) {
+					vxe::vxe_mem_rq r = rq;
+					r.addr = rq.addr + b * sizeof(r.data_u8);
+					r.beat = b;
+					r.res = vxe::vxe_mem_rq::rstype::RES_OK;
+					master_ds[m].write(r);
+					if(b + 1 < rq.len && rng() % 2 == 0)
+						wait(1 + rng() % 4);
+				}
+			}
+		}
+
+		// Returns log2 of power of two
+		static unsigned ilog2(unsigned v)
+		{
+			unsigned l = 0;
+			while(v >>= 1)
+				++l;
+			return l;
+		}
+
+	private:
+		register_set<uint32_t, vxe::regi::REGS_NUMBER> m_regs;
+		vxe_mem_hub hub;
+		sc_vector<sc_fifo<vxe::vxe_mem_rq>> client_us;
+		sc_vector<sc_fifo<vxe::vxe_mem_rq>> client_ds;
+		sc_vector<sc_fifo<vxe::vxe_mem_rq>> master_us;
+		sc_vector<sc_fifo<vxe::vxe_mem_rq>> master_ds;
+		const vxe::hub_route m_route;
+		const unsigned m_clients;
+		const unsigned m_masters;
+		const unsigned m_burst;
+		const unsigned m_requests;
+		const unsigned m_seed;
+		unsigned m_responses;
+		unsigned m_errors;
+	};
+
+
+	/**
+	 * Compare port traces of two environments
+	 * @param ref reference environment
+	 * @param dut environment under test
+	 * @return number of mismatching ports
+	 */
+	unsigned compare(const hub_env& ref, const hub_env& dut)
+	{
+		unsigned errors = 0;
+
+		for(unsigned p = 0; p < TP_NUM; ++p) {
+			const auto& a = ref.trace(trace_port(p));
+			const auto& b = dut.trace(trace_port(p));
+			size_t n = std::min(a.size(), b.size());
+			size_t i = 0;
+			while(i < n && a[i] == b[i])
+				++i;
+
+			if(i < n) {
+				std::cerr << trace_port_name[p] << ": mismatch at record " << i
+					<< ":" << std::endl
+					<< "\tpolled: " << a[i] << std::endl
+					<< "\tevent:  " << b[i] << std::endl;
+				++errors;
+			} else if(a.size() != b.size()) {
+				std::cerr << trace_port_name[p] << ": number of records differs: "
+					<< a.size() << " vs " << b.size() << std::endl;
+				++errors;
+			} else {
+				std::cout << trace_port_name[p] << ": " << a.size()
+					<< " records match" << std::endl;
+			}
+		}
+
+		return errors;
+	}
+
+} // Private namespace
+
+
+// MAIN
+int sc_main(int argc, char *argv[])
+{
+	unsigned requests = 10000;
+	unsigned seed = 1;
+
+	// Parse command-line arguments
+	for(int i=1; i<argc; ++i) {
+		if(!strcmp(argv[i], "-h")) {
+			std::cout << std::endl << "Command line arguments:" << std::endl
+				<< "\t-h                   - this help screen;" << std::endl
+				<< "\t-requests <num>      - number of requests per client;" << std::endl
+				<< "\t-seed <num>          - random seed." << std::endl
+				<< std::endl;
+			return 0;
+		} else if(!strcmp(argv[i], "-requests")) {
+			++i;
+			if(i<argc) {
+				try {
+					requests = std::stoul(argv[i]);
+				}
+				catch(const std::exception& e)
+				{
+					std::cerr << e.what() << std::endl;
+				}
+			} else {
+				std::cerr << "-requests: missing number." << std::endl;
+			}
+		} else if(!strcmp(argv[i], "-seed")) {
+			++i;
+			if(i<argc) {
+				try {
+					seed = std::stoul(argv[i]);
+				}
+				catch(const std::exception& e)
+				{
+					std::cerr << e.what() << std::endl;
+				}
+			} else {
+				std::cerr << "-seed: missing number." << std::endl;
+			}
+		} else {
+			std::cerr << "Unknown argument: " << argv[i] << std::endl;
+		}
+	}
+
+	// Print testbench parameters
+	std::cout << std::endl;
+	std::cout << std::setfill('=') << std::setw(80) << "=" << std::endl;
+	std::cout << "Memory Hub ordering testbench parameters:" << std::endl;
+	std::cout << "> Requests per client: " << requests << std::endl;
+	std::cout << "> Seed: " << seed << std::endl;
+	std::cout << std::setfill('=') << std::setw(80) << "=" << std::endl;
+
+	// Clock and reset
+	sc_clock clk("clk", 10, SC_NS);
+	sc_signal<bool> nrst;
+
+	hub_env polled("polled", false, requests, seed);
+	polled.clk(clk);
+	polled.nrst(nrst);
+
+	hub_env event("event", true, requests, seed);
+	event.clk(clk);
+	event.nrst(nrst);
+
+	// Interleaved routing over 4 master ports (read bursts up to the granule)
+	vxe::hub_route interleave;
+	interleave.pol = vxe::hub_route::policy::INTERLEAVE;
+	interleave.granule = 64;
+	route_env interleaved("interleaved", interleave, 2, 4, 8, requests, seed);
+	interleaved.clk(clk);
+	interleaved.nrst(nrst);
+
+	// Table routing of 4 clients over 3 master ports
+	vxe::hub_route table;
+	table.pol = vxe::hub_route::policy::TABLE;
+	table.table = { 2, 0, 1, 2 };
+	route_env tabled("tabled", table, 3, 3, 1, requests, seed);
+	tabled.clk(clk);
+	tabled.nrst(nrst);
+
+	// Routing by argument over 3 master ports with read bursts, responses of
+	// different ports contend for client outputs
+	route_env bursts("bursts", vxe::hub_route(), 2, 3, vxe::vxe_mem_rq::MAX_BURST, requests, seed);
+	bursts.clk(clk);
+	bursts.nrst(nrst);
+
+	route_env *routed[] = { &interleaved, &tabled, &bursts };
+
+	sc_start(0, SC_NS);
+	nrst = 0;
+	sc_start(100, SC_NS);
+	nrst = 1;
+
+	// Run until both environments are done or time limit is reached
+	const sc_time step(1000, SC_NS);
+	const sc_time limit = sc_time(10, SC_NS) * (256.0 * requests + 10000);
+	auto all_done = [&]() -> bool
+	{
+		bool done = polled.done() && event.done();
+		for(const auto *env : routed)
+			done = done && env->done();
+		return done;
+	};
+	while(!all_done() && sc_time_stamp() < limit)
+		sc_start(step);
+	sc_start(step);	// Let trailing activity settle
+
+	// Check results
+	unsigned errors = 0;
+	if(!polled.done() || !event.done()) {
+		std::cerr << "Not all responses received!" << std::endl;
+		++errors;
+	}
+	errors += compare(polled, event);
+	for(const auto *env : routed) {
+		if(!env->done()) {
+			std::cerr << env->name() << ": not all responses received!" << std::endl;
+			++errors;
+		} else if(env->errors()) {
+			std::cerr << env->name() << ": " << env->errors() << " routing errors" << std::endl;
+			++errors;
+		} else {
+			std::cout << env->name() << ": routing and ordering match" << std::endl;
+		}
+	}
+
+	std::cout << "Simulated time: " << sc_time_stamp() << std::endl;
+	std::cout << (errors == 0 ? "PASSED" : "FAILED") << std::endl;
+
+	return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,381 @@
+/*
+ * Copyright (c) 2022 The VxEngine Project. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * VPU FMAC lanes testbench.
+ *
+ * Runs vector products on detailed VPU models with 1, 2 and 4 FMAC lanes
+ * (single beat and burst loads) and checks that accumulators are bit-exact
+ * with the functional model configured with the same number of lanes, i.e.
+ * both models use the same summation order. Threads use different vector
+ * lengths and word aligned and unaligned vector addresses.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <systemc.h>
+#include "vxe_common.hxx"
+#include "vxe_internal.hxx"
+#include "vxe_func_model.hxx"
+#include "vxe_vector_unit.hxx"
+
+
+namespace {
+
+	// Threads per VPU
+	constexpr unsigned NT = vxe_vector_unit::NT;
+	// Vector lengths of threads
+	constexpr unsigned VEC_LEN[NT] = { 1, 2, 3, 5, 8, 31, 64, 257 };
+	// Longest vector
+	constexpr unsigned VEC_MAX = 257;
+
+	using func_model = vxe_func_model<NT>;
+
+
+	// Program and data in host memory
+	class workload {
+	public:
+		/**
+		 * Constructor
+		 * @param seed random seed
+		 */
+		explicit workload(unsigned seed)
+		{
+			// Program, then Rs and Rt vectors of each thread (odd threads
+			// start vectors from an unaligned word)
+			const uint64_t vec_size = (VEC_MAX + 1) * sizeof(uint32_t);
+			m_pgm_addr = 0;
+			const uint64_t vec_addr = (NT * 6 + 2) * sizeof(uint64_t);
+			m_mem.resize(vec_addr + 2 * NT * vec_size);
+
+			std::mt19937 rng(seed);
+			std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+			for(uint64_t a = vec_addr; a < m_mem.size(); a += sizeof(float)) {
+				float f = dist(rng);
+				memcpy(&m_mem[a], &f, sizeof(float));
+			}
+
+			uint64_t pc = m_pgm_addr;
+			auto emit = [this, &pc](uint64_t instr) {
+				memcpy(&m_mem[pc], &instr, sizeof(instr));
+				pc += sizeof(instr);
+			};
+
+			for(unsigned th = 0; th < NT; ++th) {
+				const uint64_t skew = (th & 1) * sizeof(uint32_t);
+				const uint64_t rs = vec_addr + 2 * th * vec_size + skew;
+				const uint64_t rt = rs + vec_size;
+				emit(vxe::instr::setacc(th, 0.0f));
+				emit(vxe::instr::setrs(th, rs));
+				emit(vxe::instr::setrt(th, rt));
+				emit(vxe::instr::setrd(th, 0));
+				emit(vxe::instr::setvl(th, VEC_LEN[th]));
+				emit(vxe::instr::seten(th, true));
+			}
+			emit(vxe::instr::prod(0));
+			emit(vxe::instr::sync(true, true));
+		}
+
+		/**
+		 * Map guest memory range
+		 * @param addr address
+		 * @param len length
+		 * @return host pointer or nullptr if range is not mapped
+		 */
+		const uint8_t *map(uint64_t addr, uint64_t len) const
+		{
+			return (addr <= m_mem.size() && len <= m_mem.size() - addr ? &m_mem[addr] : nullptr);
+		}
+
+		/**
+		 * VPU commands of the program (as CU sends them)
+		 * @return commands
+		 */
+		std::vector<vxe::vpu_cmd> commands() const
+		{
+			std::vector<vxe::vpu_cmd> cmds;
+			for(uint64_t pc = m_pgm_addr; ; pc += sizeof(uint64_t)) {
+				uint64_t raw;
+				memcpy(&raw, &m_mem[pc], sizeof(raw));
+				vxe::instr::generic g(raw);
+				if(g.op == vxe::instr::sync::OP)
+					break;
+				vxe::instr::generic_vpu vpug(g);
+				cmds.push_back({ uint8_t(vpug.op), uint8_t(vxe::instr::dst_thread(vpug.dst)), vpug.pl });
+			}
+			return cmds;
+		}
+
+		/**
+		 * Run program on functional model
+		 * @param lanes number of FMAC lanes
+		 * @return VPU state
+		 */
+		func_model::vpu_state reference(unsigned lanes) const
+		{
+			std::vector<uint8_t> mem(m_mem);
+			func_model fm(
+				[&mem](uint64_t addr, uint64_t len) -> uint8_t*
+				{
+					return (addr <= mem.size() && len <= mem.size() - addr ? &mem[addr] : nullptr);
+				}, 1, NT, lanes
+			);
+			func_model::vpu_state st = func_model::vpu_state();
+			fm.run(m_pgm_addr, &st);
+			return st;
+		}
+
+	private:
+		uint64_t m_pgm_addr;		// Program address
+		std::vector<uint8_t> m_mem;	// Memory image
+	};
+
+
+	/**
+	 * VPU test environment
+	 * Detailed VPU with a memory responder. Driver sends program commands
+	 * as a batch and compares accumulators with the functional model.
+	 */
+	SC_MODULE(lane_env) {
+		sc_in<bool> clk;
+		sc_in<bool> nrst;
+
+		SC_HAS_PROCESS(lane_env);
+
+		/**
+		 * Constructor
+		 * @param name module name
+		 * @param wl workload
+		 * @param lanes number of FMAC lanes
+		 * @param burst maximum length of load bursts
+		 */
+		lane_env(::sc_core::sc_module_name name, const workload& wl, unsigned lanes,
+			unsigned burst)
+			: ::sc_core::sc_module(name), clk("clk"), nrst("nrst")
+			, vpu("vpu", vxe::mhc::VPU0, vxe_vector_unit::FIFO_DEPTH,
+				vxe_vector_unit::FMAC_STAGES, NT, lanes, burst)
+			, mem_us("mem_us"), mem_ds("mem_ds")
+			, m_wl(wl), m_ref(wl.reference(lanes)), m_done(false), m_errors(0)
+		{
+			vpu.clk(clk);
+			vpu.nrst(nrst);
+			vpu.mem_fifo_in(mem_ds);
+			vpu.mem_fifo_out(mem_us);
+			vpu.o_busy(s_busy);
+			vpu.o_err(s_err);
+			vpu.i_cmd_select(s_cmd_select);
+			vpu.o_cmd_ack(s_cmd_ack);
+			vpu.i_cmd_op(s_cmd_op);
+			vpu.i_cmd_thread(s_cmd_thread);
+			vpu.i_cmd_wdata(s_cmd_wdata);
+
+			SC_THREAD(driver_thread);
+				sensitive << clk.pos();
+			SC_THREAD(memory_thread);
+				sensitive << clk.pos();
+		}
+
+		/**
+		 * Check if program is completed
+		 * @return true if done
+		 */
+		bool done() const { return m_done; }
+
+		/**
+		 * Number of mismatching accumulators
+		 */
+		unsigned errors() const { return m_errors; }
+
+	private:
+		// Sends program commands and checks results
+		[[noreturn]] void driver_thread()
+		{
+			// Wait for reset release
+			do {
+				wait();
+			} while(!nrst.read());
+
+			const std::vector<vxe::vpu_cmd> cmds = m_wl.commands();
+			if(vpu.exec_cmds(cmds.data(), cmds.size())) {
+				std::cerr << name() << ": VPU reported an error!" << std::endl;
+				++m_errors;
+			}
+
+			vxe_vector_unit::arch_state st;
+			vpu.get_arch_state(st);
+			for(unsigned th = 0; th < NT; ++th) {
+				if(st.acc[th] == m_ref.acc[th])
+					continue;
+				std::cerr << name() << ": thread " << th << ": accumulator " << std::hex
+					<< std::setfill('0') << std::setw(8) << st.acc[th] << ", expected "
+					<< std::setw(8) << m_ref.acc[th] << std::dec << std::setfill(' ')
+					<< std::endl;
+				++m_errors;
+			}
+
+			m_done = true;
+			while(true)
+				wait();
+		}
+
+		// Responds to VPU memory requests, one beat per clock cycle
+		[[noreturn]] void memory_thread()
+		{
+			while(true) {
+				vxe::vxe_mem_rq rq = mem_us.read();
+				for(unsigned b = 0; b < rq.len; ++b) {
+					vxe::vxe_mem_rq r = rq;
+					r.addr = rq.addr + b * sizeof(r.data_u8);
+					r.beat = b;
+					if(r.req == vxe::vxe_mem_rq::rqtype::REQ_RD) {
+						const uint8_t *p = m_wl.map(r.addr, sizeof(r.data_u8));
+						if(p)
+							memcpy(r.data_u8, p, sizeof(r.data_u8));
+						else
+							std::cerr << name() << ": read out of memory!" << std::endl;
+					}
+					r.res = vxe::vxe_mem_rq::rstype::RES_OK;
+					mem_ds.write(r);
+					wait();
+				}
+			}
+		}
+
+	private:
+		vxe_vector_unit vpu;
+		sc_fifo<vxe::vxe_mem_rq> mem_us;
+		sc_fifo<vxe::vxe_mem_rq> mem_ds;
+		sc_signal<bool> s_busy;
+		sc_signal<bool> s_err;
+		sc_signal<bool> s_cmd_select;
+		sc_signal<bool> s_cmd_ack;
+		sc_signal<uint8_t> s_cmd_op;
+		sc_signal<uint8_t> s_cmd_thread;
+		sc_signal<uint64_t> s_cmd_wdata;
+		const workload& m_wl;
+		const func_model::vpu_state m_ref;
+		bool m_done;
+		unsigned m_errors;
+	};
+
+} // Private namespace
+
+
+// MAIN
+int sc_main(int argc, char *argv[])
+{
+	unsigned seed = 1;
+
+	// Parse command-line arguments
+	for(int i=1; i<argc; ++i) {
+		if(!strcmp(argv[i], "-h")) {
+			std::cout << std::endl << "Command line arguments:" << std::endl
+				<< "\t-h                   - this help screen;" << std::endl
+				<< "\t-seed <num>          - random seed." << std::endl
+				<< std::endl;
+			return 0;
+		} else if(!strcmp(argv[i], "-seed")) {
+			++i;
+			if(i<argc) {
+				try {
+					seed = std::stoul(argv[i]);
+				}
+				catch(const std::exception& e)
+				{
+					std::cerr << e.what() << std::endl;
+				}
+			} else {
+				std::cerr << "-seed: missing number." << std::endl;
+			}
+		} else {
+			std::cerr << "Unknown argument: " << argv[i] << std::endl;
+		}
+	}
+
+	// Print testbench parameters
+	std::cout << std::endl;
+	std::cout << std::setfill('=') << std::setw(80) << "=" << std::endl;
+	std::cout << "VPU FMAC lanes testbench parameters:" << std::endl;
+	std::cout << "> Seed: " << seed << std::endl;
+	std::cout << std::setfill('=') << std::setw(80) << "=" << std::endl;
+
+	// Clock and reset
+	sc_clock clk("clk", 10, SC_NS);
+	sc_signal<bool> nrst;
+
+	// Environments for each number of lanes with single beat and burst loads
+	const workload wl(seed);
+	std::vector<std::unique_ptr<lane_env>> envs;
+	for(unsigned lanes : { 1u, 2u, 4u }) {
+		for(unsigned burst : { 1u, 4u }) {
+			const std::string name = "lanes" + std::to_string(lanes) + "_burst"
+				+ std::to_string(burst);
+			envs.emplace_back(new lane_env(name.c_str(), wl, lanes, burst));
+			envs.back()->clk(clk);
+			envs.back()->nrst(nrst);
+		}
+	}
+
+	sc_start(0, SC_NS);
+	nrst = 0;
+	sc_start(100, SC_NS);
+	nrst = 1;
+
+	// Run until all environments are done or time limit is reached
+	auto all_done = [&envs]() -> bool
+	{
+		for(const auto& env : envs)
+			if(!env->done())
+				return false;
+		return true;
+	};
+	const sc_time step(1000, SC_NS);
+	const sc_time limit(1, SC_MS);
+	while(!all_done() && sc_time_stamp() < limit)
+		sc_start(step);
+
+	// Check results
+	unsigned errors = 0;
+	for(const auto& env : envs) {
+		if(!env->done()) {
+			std::cerr << env->name() << ": program is not completed!" << std::endl;
+			++errors;
+		} else if(env->errors()) {
+			++errors;
+		} else {
+			std::cout << env->name() << ": " << NT << " accumulators match" << std::endl;
+		}
+	}
+
+	std::cout << "Simulated time: " << sc_time_stamp() << std::endl;
+	std::cout << (errors == 0 ? "PASSED" : "FAILED") << std::endl;
+
+	return errors == 0 ? 0 : 1;
+}
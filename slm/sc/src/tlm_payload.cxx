@@ -27,25 +27,125 @@
  * TLM payloads management
  */
 
+#include <cstring>
+#include <vector>
 #include "tlm_payload.hxx"
 
 
 // Private namespace
 namespace {
 
+	// Allocation statistics
+	tlm_pl::alloc_stats stats = {};
+
+	/**
+	 * Pooled generic payload. Owns data and byte enable buffers.
+	 */
+	struct pooled_gp : public tlm::tlm_generic_payload {
+		unsigned char *data_buf;	// Data buffer
+		unsigned char *be_buf;		// Byte enable buffer
+		size_t data_size;		// Data buffer size
+		size_t be_length;		// Byte enable buffer length
+
+		pooled_gp(tlm::tlm_mm_interface *mm, size_t dsz, size_t bel)
+			: tlm::tlm_generic_payload(mm)
+			, data_buf(nullptr), be_buf(nullptr)
+			, data_size(dsz), be_length(bel)
+		{
+			try {
+				if(data_size) {
+					data_buf = new unsigned char[data_size];
+					++stats.buf_allocs;
+				}
+				if(be_length) {
+					be_buf = new unsigned char[be_length];
+					++stats.buf_allocs;
+				}
+			}
+			catch(...) {
+				delete[] data_buf;
+				throw;
+			}
+		}
+
+		~pooled_gp()
+		{
+			delete[] data_buf;
+			delete[] be_buf;
+		}
+	};
+
 	/**
 	 * TLM generic payload memory manager
 	 */
 	class tlm_gp_mm: public tlm::tlm_mm_interface {
+		// Free list of payloads of the same size
+		struct bucket {
+			size_t data_size;
+			size_t be_length;
+			std::vector<pooled_gp*> free;
+		};
+		std::vector<bucket> m_buckets;
+
+		bucket& get_bucket(size_t data_size, size_t be_length)
+		{
+			for(auto& b : m_buckets) {
+				if(b.data_size == data_size && b.be_length == be_length)
+					return b;
+			}
+			m_buckets.push_back({data_size, be_length, {}});
+			return m_buckets.back();
+		}
+
 	public:
-		void free(tlm::tlm_generic_payload *pl) override
+		~tlm_gp_mm()
+		{
+			for(auto& b : m_buckets) {
+				for(auto *pl : b.free)
+					delete pl;
+			}
+		}
+
+		pooled_gp *alloc(size_t data_size, size_t be_length)
 		{
-			unsigned char *data_ptr = pl->get_data_ptr();
-			unsigned char *be_ptr = pl->get_byte_enable_ptr();
+			bucket& b = get_bucket(data_size, be_length);
+			pooled_gp *pl;
+
+			if(!b.free.empty()) {
+				pl = b.free.back();
+				b.free.pop_back();
+				--stats.gp_pooled;
+				++stats.gp_reuses;
+			} else {
+				pl = new pooled_gp(this, data_size, be_length);
+				++stats.gp_allocs;
+			}
+
+			if(pl->be_buf)
+				memset(pl->be_buf, 0, pl->be_length);
+
+			pl->set_data_ptr(pl->data_buf);
+			pl->set_byte_enable_ptr(pl->be_buf);
+
+			return pl;
+		}
+
+		void free(tlm::tlm_generic_payload *gp) override
+		{
+			auto *pl = static_cast<pooled_gp*>(gp);
+
+			// Reset payload state but keep extensions attached for reuse
 			pl->reset();
-			delete[] data_ptr;
-			delete[] be_ptr;
-			delete pl;
+			pl->set_address(0);
+			pl->set_command(tlm::TLM_IGNORE_COMMAND);
+			pl->set_data_length(0);
+			pl->set_byte_enable_length(0);
+			pl->set_streaming_width(0);
+			pl->set_dmi_allowed(false);
+			pl->set_response_status(tlm::TLM_INCOMPLETE_RESPONSE);
+
+			get_bucket(pl->data_size, pl->be_length).free.push_back(pl);
+			++stats.gp_pooled;
 		}
 	};
 	// Private MM instance
@@ -56,24 +156,21 @@ namespace {
 
 tlm::tlm_generic_payload* tlm_pl::alloc_gp(size_t data_size, size_t be_length)
 {
-	tlm::tlm_generic_payload *pl = new tlm::tlm_generic_payload(&mm);
-	unsigned char *data_ptr = nullptr;
-	unsigned char *be_ptr = nullptr;
+	tlm::tlm_generic_payload *pl = mm.alloc(data_size, be_length);
 
 	pl->acquire();	// ++ref_count
 
-	try {
-		if(data_size) data_ptr = new unsigned char[data_size];
-		if(be_length) be_ptr = new unsigned char[be_length]();
-	}
-	catch(...) {
-		delete[] data_ptr;
-		pl->release();
-		throw;
-	}
+	return pl;
+}
 
-	pl->set_data_ptr(data_ptr);
-	pl->set_byte_enable_ptr(be_ptr);
 
-	return pl;
+const tlm_pl::alloc_stats& tlm_pl::get_stats()
+{
+	return stats;
+}
+
+
+void tlm_pl::count_ext_alloc()
+{
+	++stats.ext_allocs;
 }
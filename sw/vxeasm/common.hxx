@@ -53,15 +53,10 @@ const std::string INT = "int";
 const std::string NOINT = "noint";
 const std::string STOP = "stop";
 const std::string NOSTOP = "nostop";
-const std::string VPU0 = "vpu0";
-const std::string VPU1 = "vpu1";
-const std::string TH0 = "th0";
-const std::string TH1 = "th1";
-const std::string TH2 = "th2";
-const std::string TH3 = "th3";
-const std::string TH4 = "th4";
-const std::string TH5 = "th5";
-const std::string TH6 = "th6";
-const std::string TH7 = "th7";
+const std::string VPU = "vpu";	// vpu0 - vpu31
+const std::string TH = "th";	// th0 - th7
+// Destination limits (5-bit VPU number and 3-bit thread id)
+const unsigned MAX_VPUS = 32;
+const unsigned MAX_THREADS = 8;
 // Directives
 const std::string QUAD = ".quad";
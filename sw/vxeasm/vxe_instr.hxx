@@ -312,8 +312,7 @@ union prod {
 	prod(unsigned _dst_vpu)
 		: _z0(0), op(OP)
 	{
-		dst = ((_dst_vpu & 1) << 3) | 0x1;
-		/* (_dst_vpu & 1) - only two VPUs supported */
+		dst = ((_dst_vpu & 0x1F) << 3) | 0x1;
 	}
 
 	operator uint64_t() const { return u64; }
@@ -334,8 +333,7 @@ union store {
 	store(unsigned _dst_vpu)
 		: _z0(0), op(OP)
 	{
-		dst = ((_dst_vpu & 1) << 3) | 0x1;
-		/* (_dst_vpu & 1) - only two VPUs supported */
+		dst = ((_dst_vpu & 0x1F) << 3) | 0x1;
 	}
 
 	operator uint64_t() const { return u64; }
@@ -382,8 +380,7 @@ union relu {
 	relu(unsigned _dst_vpu)
 		: _z0(0), op(OP)
 	{
-		dst = ((_dst_vpu & 1) << 3) | 0x1;
-		/* (_dst_vpu & 1) - only two VPUs supported */
+		dst = ((_dst_vpu & 0x1F) << 3) | 0x1;
 	}
 
 	operator uint64_t() const { return u64; }
@@ -408,8 +405,7 @@ union lrelu {
 	lrelu(int e) : ed(0x7F & e), _z1(0), af(AF), _z0(0), dst(0), op(OP) {}
 	lrelu(int e, unsigned _dst_vpu) : ed(0x7F & e), _z1(0), af(AF), _z0(0), op(OP)
 	{
-		dst = ((_dst_vpu & 1) << 3) | 0x1;
-		/* (_dst_vpu & 1) - only two VPUs supported */
+		dst = ((_dst_vpu & 0x1F) << 3) | 0x1;
 	}
 
 	operator uint64_t() const { return u64; }
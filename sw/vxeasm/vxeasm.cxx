@@ -329,17 +329,34 @@ bool parse_line(int line_no, const std::string& line, command& cmd)
 }
 
 
+// Parse "<prefix><number>" operand with number less than max
+bool to_index(const std::string& op, const std::string& prefix, unsigned max, unsigned& idx)
+{
+	if(op.size() <= prefix.size() || op.compare(0, prefix.size(), prefix) != 0)
+		return false;
+
+	const std::string num = op.substr(prefix.size());
+	if(num.size() > 2 || (num.size() > 1 && num[0] == '0'))
+		return false;
+
+	idx = 0;
+	for(char c : num) {
+		if(c < '0' || c > '9')
+			return false;
+		idx = idx * 10 + (c - '0');
+	}
+
+	return idx < max;
+}
+
+
 unsigned to_vpu_no(const token& tok)
 {
 	unsigned vpu = 0;
 
-	if(tok.lc() == VPU0) {
-		vpu = 0;
-	} else if(tok.lc() == VPU1) {
-		vpu = 1;
-	} else {
+	if(!to_index(tok.lc(), VPU, MAX_VPUS, vpu)) {
 		std::string msg = std::string("invalid destination VPU '")
-			+ tok.tok + "'. Must be 'vpu[0-1]'.";
+			+ tok.tok + "'. Must be 'vpu[0-31]'.";
 		throw std::runtime_error(tok.err_msg(msg));
 	}
 
@@ -351,23 +368,7 @@ unsigned to_th_no(const token& tok)
 {
 	unsigned th = 0;
 
-	if(tok.lc() == TH0) {
-		th = 0;
-	} else if(tok.lc() == TH1) {
-		th = 1;
-	} else if(tok.lc() == TH2) {
-		th = 2;
-	} else if(tok.lc() == TH3) {
-		th = 3;
-	} else if(tok.lc() == TH4) {
-		th = 4;
-	} else if(tok.lc() == TH5) {
-		th = 5;
-	} else if(tok.lc() == TH6) {
-		th = 6;
-	} else if(tok.lc() == TH7) {
-		th = 7;
-	} else {
+	if(!to_index(tok.lc(), TH, MAX_THREADS, th)) {
 		std::string msg = std::string("invalid destination thread '")
 			+ tok.tok + "'. Must be 'th[0-7]'.";
 		throw std::runtime_error(tok.err_msg(msg));
@@ -551,7 +552,7 @@ uint64_t code_gen_prod(const command& cmd)
 {
 	if(cmd.operands.size() > 1)
 		throw std::runtime_error(g_err_msg(cmd.opcode.line, cmd.opcode.start_col,
-			PROD + " instruction can have only one optional operand 'vpu[0-1]'."));
+			PROD + " instruction can have only one optional operand 'vpu[0-31]'."));
 
 	if(!cmd.operands.empty())
 		return prod(to_vpu_no(cmd.operands[0]));
@@ -564,7 +565,7 @@ uint64_t code_gen_store(const command& cmd)
 {
 	if(cmd.operands.size() > 1)
 		throw std::runtime_error(g_err_msg(cmd.opcode.line, cmd.opcode.start_col,
-			STORE + " instruction can have only one optional operand 'vpu[0-1]'."));
+			STORE + " instruction can have only one optional operand 'vpu[0-31]'."));
 
 	if(!cmd.operands.empty())
 		return store(to_vpu_no(cmd.operands[0]));
@@ -599,7 +600,7 @@ uint64_t code_gen_relu(const command& cmd)
 {
 	if(cmd.operands.size() > 1)
 		throw std::runtime_error(g_err_msg(cmd.opcode.line, cmd.opcode.start_col,
-			RELU + " instruction can have only one optional operand 'vpu[0-1]'."));
+			RELU + " instruction can have only one optional operand 'vpu[0-31]'."));
 
 	if(!cmd.operands.empty())
 		return relu(to_vpu_no(cmd.operands[0]));
@@ -613,7 +614,7 @@ uint64_t code_gen_lrelu(const command& cmd)
 	if(cmd.operands.empty() || cmd.operands.size() > 2)
 		throw std::runtime_error(g_err_msg(cmd.opcode.line, cmd.opcode.start_col,
 			LRELU +
-			" instruction can have one optional operand 'vpu[0-1]' and one mandatory operand '-exp'."));
+			" instruction can have one optional operand 'vpu[0-31]' and one mandatory operand '-exp'."));
 
 	if(cmd.operands.size() == 1) {
 		int exp = cmd.operands[0].to_int(true);